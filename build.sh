@@ -12,9 +12,12 @@ export CCACHE_COMPRESS=1
 export CCACHE_COMPRESSLEVEL=6
 export CCACHE_SLOPPINESS=file_macro,time_macros,include_file_mtime,include_file_ctime
 
-# Build from NCS directory with project source
+PROJECT_DIR=$(cd "$(dirname "$0")" && pwd)
+
+# Build from NCS directory with project source. Sysbuild builds the app
+# core and the net core (sysbuild/ipc_radio.conf) together
 cd $ZEPHYR_BASE/../ && \
-west build -p always -b nrf5340dk_nrf5340_cpuapp -s /Users/danroblewis/projects/my5340-app && \
+west build -p always -b nrf5340dk/nrf5340/cpuapp --sysbuild -s "$PROJECT_DIR" && \
 echo "Build successful!" && \
 echo "To flash, run: cd $ZEPHYR_BASE/../ && west flash" && \
 echo "Build successful!"
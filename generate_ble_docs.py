@@ -20,6 +20,8 @@ class PacketField:
     size: int
     offset: int
     description: str = ""
+    base_type: str = ""
+    count: int = 0          # Array length, 0 for a scalar
 
 @dataclass
 class PacketStruct:
@@ -37,6 +39,22 @@ class Characteristic:
     read_packet: Optional[str] = None
     write_packet: Optional[str] = None
     description: str = ""
+    uuid_name: str = ""
+    read_handler: Optional[str] = None
+    write_handler: Optional[str] = None
+
+@dataclass
+class HandlerWrapper:
+    handler: str
+    macro: str
+    packet: Optional[str]
+    min_size: int
+    max_size: int
+    ctx_lookup: Optional[str] = None
+
+    @property
+    def variable(self) -> bool:
+        return self.min_size != self.max_size
 
 @dataclass
 class Service:
@@ -51,15 +69,19 @@ class BLEProtocolParser:
         self.services: List[Service] = []
         self.packet_structs: Dict[str, PacketStruct] = {}
         self.uuid_definitions: Dict[str, str] = {}
+        self.defines: Dict[str, str] = {}
+        self.wrappers: Dict[str, HandlerWrapper] = {}
         
         # Type size mapping
         self.type_sizes = {
             'uint8_t': 1,
             'uint16_t': 2,  
             'uint32_t': 4,
+            'uint64_t': 8,
             'int8_t': 1,
             'int16_t': 2,
             'int32_t': 4,
+            'int64_t': 8,
             'char': 1,
             'bool': 1
         }
@@ -80,7 +102,7 @@ class BLEProtocolParser:
         self.parse_uuid_definitions()
         self.parse_packet_structures_from_headers()
         
-        service_files = list(self.services_dir.glob("*_service.c"))
+        service_files = sorted(self.services_dir.glob("*_service.c"))
         
         for file_path in service_files:
             print(f"Parsing {file_path.name}...")
@@ -88,14 +110,59 @@ class BLEProtocolParser:
     
     def parse_packet_structures_from_headers(self):
         """Parse packet structures from header files."""
-        header_files = list(self.services_dir.glob("*_service.h"))
+        header_files = sorted(self.services_dir.glob("*.h"))
+        
+        # Array sizes refer to constants from any header
+        for file_path in header_files:
+            with open(file_path, 'r') as f:
+                self.extract_defines(f.read())
         
         for file_path in header_files:
-            print(f"Parsing packet structures from {file_path.name}...")
             with open(file_path, 'r') as f:
                 content = f.read()
+            if '__attribute__((packed))' not in content:
+                continue
+            print(f"Parsing packet structures from {file_path.name}...")
             self.extract_packet_structs(content)
     
+    def extract_defines(self, content: str):
+        """Collect object-like #defines, joining continuation lines."""
+        content = content.replace('\\\n', ' ')
+        for match in re.finditer(r'^#define\s+([A-Z_][A-Z0-9_]*)[ \t]+([^\n]+)$', content, re.MULTILINE):
+            value = re.sub(r'/\*.*?\*/|//.*$', '', match.group(2)).strip()
+            if value:
+                self.defines[match.group(1)] = value
+    
+    def evaluate(self, expr: str, depth: int = 0) -> Optional[int]:
+        """Evaluate an integer constant expression using the collected #defines."""
+        if depth > 16:
+            return None
+        
+        def sizeof(m):
+            struct = self.packet_structs.get(m.group(1).strip())
+            if struct:
+                return str(struct.total_size)
+            size = self.type_sizes.get(m.group(1).strip())
+            return str(size) if size else m.group(0)
+        
+        expr = re.sub(r'sizeof\s*\(\s*([A-Za-z_][A-Za-z0-9_ ]*)\)', sizeof, expr)
+        expr = re.sub(r'\bBIT\s*\(\s*([0-9]+)\s*\)', r'(1 << \1)', expr)
+        
+        def name(m):
+            if m.group(0) in self.defines:
+                value = self.evaluate(self.defines[m.group(0)], depth + 1)
+                return str(value) if value is not None else m.group(0)
+            return m.group(0)
+        
+        expr = re.sub(r'\b[A-Za-z_][A-Za-z0-9_]*\b', name, expr)
+        expr = re.sub(r'\b(0[xX][0-9a-fA-F]+|[0-9]+)[uUlL]+\b', r'\1', expr)
+        if not re.fullmatch(r'[0-9a-fA-FxX+\-*/%()<>|&~ ]+', expr):
+            return None
+        try:
+            return int(eval(expr.replace('/', '//'), {'__builtins__': {}}))
+        except Exception:
+            return None
+    
     def parse_uuid_definitions(self):
         """Parse UUID definitions from header files."""
         header_files = list(self.services_dir.glob("*_service.h"))
@@ -125,6 +192,13 @@ class BLEProtocolParser:
                     # If parsing fails, keep the raw definition
                     self.uuid_definitions[uuid_name] = f"BT_UUID_128({uuid_params})"
         
+        # Pattern for static const struct bt_uuid_16 name = BT_UUID_INIT_16(0xXXXX);
+        # referenced as #define UUID_NAME (&name.uuid)
+        init_16 = dict(re.findall(r'struct\s+bt_uuid_16\s+([a-z_0-9]+)\s*=\s*BT_UUID_INIT_16\(([^)]+)\)', content))
+        for match in re.finditer(r'#define\s+([A-Z_0-9]+UUID)\s+\(&([a-z_0-9]+)\.uuid\)', content):
+            if match.group(2) in init_16:
+                self.uuid_definitions[match.group(1)] = init_16[match.group(2)].strip()
+        
         # Pattern for #define UUID_NAME BT_UUID_16(0xXXXX)
         uuid_16_pattern = r'#define\s+([A-Z_]+UUID[A-Z_]*)\s+BT_UUID_16\(([^)]+)\)'
         
@@ -178,6 +252,7 @@ class BLEProtocolParser:
         
         # Extract packet structures
         self.extract_packet_structs(content)
+        self.extract_wrappers(content)
         
         # Extract service definition
         service = self.extract_service_definition(content, file_path.stem)
@@ -186,12 +261,15 @@ class BLEProtocolParser:
     
     def extract_packet_structs(self, content: str):
         """Extract typed packet structures from the file content."""
-        # Pattern to match typedef struct definitions
-        struct_pattern = r'typedef\s+struct\s*\{([^}]+)\}\s*__attribute__\(\(packed\)\)\s*([a-zA-Z_][a-zA-Z0-9_]*);'
+        # Pattern to match typedef struct definitions, attribute before or after the body
+        struct_pattern = (r'typedef\s+struct\s*(__attribute__\(\(packed\)\))?\s*\{([^}]+)\}\s*'
+                          r'(__attribute__\(\(packed\)\))?\s*([a-zA-Z_][a-zA-Z0-9_]*);')
         
         for match in re.finditer(struct_pattern, content, re.MULTILINE | re.DOTALL):
-            struct_body = match.group(1).strip()
-            struct_name = match.group(2).strip()
+            if not (match.group(1) or match.group(3)):
+                continue
+            struct_body = match.group(2).strip()
+            struct_name = match.group(4).strip()
             
             fields = self.parse_struct_fields(struct_body)
             total_size = sum(field.size for field in fields)
@@ -221,41 +299,51 @@ class BLEProtocolParser:
             if line.startswith('//') or line.startswith('/*'):
                 continue
             
+            # Extract description from inline comment
+            description = ""
+            comment_match = re.search(r'(?://+<?|/\*+<?)\s*(.*?)\s*(?:\*/)?$', line)
+            if comment_match:
+                description = comment_match.group(1).strip()
+            
             # Remove trailing comment and semicolon
-            line = re.sub(r'//.*$', '', line).strip()
+            line = re.sub(r'//.*$|/\*.*$', '', line).strip()
             line = line.rstrip(';')
             
             if not line:
                 continue
             
             # Parse field: type name[size]; or type name;
-            field_match = re.match(r'([a-zA-Z_][a-zA-Z0-9_]*)\s+([a-zA-Z_][a-zA-Z0-9_]*)\s*(?:\[([0-9]+)\])?', line)
+            field_match = re.match(r'([a-zA-Z_][a-zA-Z0-9_]*)\s+([a-zA-Z_][a-zA-Z0-9_]*)\s*(?:\[([^\]]+)\])?', line)
             if field_match:
                 field_type = field_match.group(1)
                 field_name = field_match.group(2)
                 array_size = field_match.group(3)
                 
-                # Calculate field size
-                base_size = self.type_sizes.get(field_type, 1)
+                # Calculate field size; nested packed structs must be defined first
+                if field_type in self.packet_structs:
+                    base_size = self.packet_structs[field_type].total_size
+                else:
+                    base_size = self.type_sizes.get(field_type, 1)
+                count = 0
                 if array_size:
-                    field_size = base_size * int(array_size)
-                    field_type = f"{field_type}[{array_size}]"
+                    count = self.evaluate(array_size)
+                    if count is None:
+                        raise ValueError(f"Cannot evaluate array size '{array_size}' of {field_name}")
+                    field_size = base_size * count
+                    base_type = field_type
+                    field_type = f"{field_type}[{array_size.strip()}]"
                 else:
                     field_size = base_size
-                
-                # Extract description from inline comment
-                original_line = line
-                description = ""
-                comment_match = re.search(r'//\s*(.+)$', original_line)
-                if comment_match:
-                    description = comment_match.group(1).strip()
+                    base_type = field_type
                 
                 field = PacketField(
                     name=field_name,
                     type=field_type,
                     size=field_size,
                     offset=current_offset,
-                    description=description
+                    description=description,
+                    base_type=base_type,
+                    count=count
                 )
                 
                 fields.append(field)
@@ -301,12 +389,52 @@ class BLEProtocolParser:
             description=description
         )
     
+    def extract_wrappers(self, content: str):
+        """Map each *_ble handler to its packet type and length limits."""
+        wrapper_pattern = r'^(BLE_(?:READ|WRITE)_WRAPPER\w*)\s*\(([^()]*(?:\([^()]*\)[^()]*)*)\)'
+        
+        for match in re.finditer(wrapper_pattern, content, re.MULTILINE):
+            macro = match.group(1)
+            args = [a.strip() for a in re.split(r',(?![^(]*\))', match.group(2))]
+            handler = args[0]
+            ctx_lookup = args[-1] if macro.endswith('_CTX') else None
+            
+            if macro.startswith('BLE_WRITE_WRAPPER_VARIABLE'):
+                # The upper bound names the packet type: sizeof(type)
+                packet_match = re.match(r'sizeof\s*\(\s*(\w+)\s*\)', args[2])
+                packet = packet_match.group(1) if packet_match else None
+                min_size = self.evaluate(args[1])
+                max_size = self.evaluate(args[2])
+            else:
+                packet = args[1]
+                struct = self.packet_structs.get(packet)
+                min_size = max_size = struct.total_size if struct else 0
+            
+            if min_size is None or max_size is None:
+                raise ValueError(f"Cannot evaluate length limits of {handler}")
+            
+            self.wrappers[handler] = HandlerWrapper(
+                handler=handler,
+                macro=macro,
+                packet=packet,
+                min_size=min_size,
+                max_size=max_size,
+                ctx_lookup=ctx_lookup
+            )
+    
+    def wrapper_for(self, ble_function: str) -> Optional[HandlerWrapper]:
+        """Find the wrapper that generated a *_ble GATT callback."""
+        if not ble_function or ble_function == 'NULL':
+            return None
+        return self.wrappers.get(re.sub(r'_ble$', '', ble_function))
+    
     def extract_characteristics(self, service_body: str, full_content: str) -> List[Characteristic]:
         """Extract characteristics from service definition."""
         characteristics = []
+        service_body = re.sub(r'/\*.*?\*/|//[^\n]*', '', service_body, flags=re.DOTALL)
         
-        # Pattern to match BT_GATT_CHARACTERISTIC_SIMPLE
-        char_pattern = r'BT_GATT_CHARACTERISTIC_SIMPLE\s*\(\s*([^,]+),\s*([^,]+),\s*([^,]+),\s*([^,]+),\s*([^,]+),\s*([^,]+),\s*([^,]+),\s*([^)]+)\s*\)'
+        # BT_GATT_CHARACTERISTIC(uuid, props, perms, read, write, user_data)
+        char_pattern = r'BT_GATT_CHARACTERISTIC\s*\(\s*([^,]+),\s*([^,]+),\s*([^,]+),\s*([^,]+),\s*([^,]+),\s*([^)]+)\)'
         
         for match in re.finditer(char_pattern, service_body):
             uuid_ref = match.group(1).strip()
@@ -314,9 +442,6 @@ class BLEProtocolParser:
             permissions = match.group(3).strip()
             read_func = match.group(4).strip()
             write_func = match.group(5).strip()
-            user_data = match.group(6).strip()
-            read_packet = match.group(7).strip()
-            write_packet = match.group(8).strip()
             
             # Resolve UUID reference to actual value
             uuid = self.resolve_uuid(uuid_ref)
@@ -325,13 +450,14 @@ class BLEProtocolParser:
             props = self.parse_ble_flags(properties)
             perms = self.parse_ble_flags(permissions)
             
-            # Clean up packet types
-            read_packet = read_packet if read_packet != 'void' else None
-            write_packet = write_packet if write_packet != 'void' else None
+            # Packet types come from the wrapper macros behind the callbacks
+            read_wrapper = self.wrapper_for(read_func)
+            write_wrapper = self.wrapper_for(write_func)
+            read_packet = read_wrapper.packet if read_wrapper else None
+            write_packet = write_wrapper.packet if write_wrapper else None
             
-            # Generate characteristic name from function name
-            char_name = write_func if write_func != 'NULL' else read_func
-            char_name = char_name.replace('_write', '').replace('_read', '').replace('_', ' ').title()
+            # Generate characteristic name from the UUID name
+            char_name = re.sub(r'^BT_UUID_|_UUID$', '', uuid_ref).replace('_', ' ').title()
             
             characteristic = Characteristic(
                 name=char_name,
@@ -340,7 +466,10 @@ class BLEProtocolParser:
                 permissions=perms,
                 read_packet=read_packet,
                 write_packet=write_packet,
-                description=f"Characteristic for {char_name.lower()} operations"
+                description=f"Characteristic for {char_name.lower()} operations",
+                uuid_name=uuid_ref,
+                read_handler=read_wrapper.handler if read_wrapper else None,
+                write_handler=write_wrapper.handler if write_wrapper else None
             )
             
             characteristics.append(characteristic)
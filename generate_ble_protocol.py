@@ -0,0 +1,867 @@
+#!/usr/bin/env python3
+"""
+BLE Protocol Code Generator
+
+Generates protocol code from the same sources generate_ble_docs.py reads:
+the packed packet structs in the service headers, the BLE_*_WRAPPER macros
+that bind handlers to them and the BT_GATT_SERVICE_DEFINE blocks. The C
+headers stay the single source of truth; everything derived from them is
+generated, so a protocol change ships in one step.
+
+Outputs:
+  src/services/ble_protocol_gen.h  Layout asserts, length validators and
+                                   length helpers for variable packets
+  tests/ble_protocol.py            Typed packet classes, constants, UUIDs
+                                   and an async client on top of bleak
+
+Usage:
+  python3 generate_ble_protocol.py            Regenerate both outputs
+  python3 generate_ble_protocol.py --check    Fail if an output is stale
+  python3 generate_ble_protocol.py --stub write control_foo_t --ctx control_ctx_get
+                                              Print a handler skeleton
+
+Variable-length fields: the last field of a packet may be an array that is
+sent only as far as it is filled. Writes do so when the characteristic uses
+a BLE_WRITE_WRAPPER_VARIABLE* macro whose upper bound is sizeof(type); reads
+are always decoded up to the received length. A field named count or
+*_count ahead of such an array holds its element count and is filled in
+from the array. A field named length, *_len or chunk_size ahead of a byte
+array holds the number of bytes sent. The generated <prefix>_validate()
+checks a write against both, and the wrapper macro calls it before the
+handler runs.
+
+Compact encoding: a packet whose header defines <PREFIX>_FIELD_<FIELD>
+numbers (PREFIX is the struct name without _packet_t) also gets a decoder,
+<prefix>_decode(), for BLE_WRITE_WRAPPER_COMPACT_CTX, and pack_compact() on
+the Python side. See compact_codec.h for the wire format.
+"""
+
+import argparse
+import re
+import sys
+import zlib
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+from generate_ble_docs import BLEProtocolParser, PacketField, PacketStruct
+
+SERVICES_DIR = Path("src/services")
+C_OUTPUT = SERVICES_DIR / "ble_protocol_gen.h"
+CODEC_HEADER = "compact_codec.h"
+PY_OUTPUT = Path("tests/ble_protocol.py")
+
+STRUCT_FORMATS = {
+    'uint8_t': 'B', 'uint16_t': 'H', 'uint32_t': 'I', 'uint64_t': 'Q',
+    'int8_t': 'b', 'int16_t': 'h', 'int32_t': 'i', 'int64_t': 'q',
+    'bool': '?',
+}
+
+BASE_UUID = "0000{:04x}-0000-1000-8000-00805f9b34fb"
+
+
+# ============================================================================
+# SCHEMA
+# ============================================================================
+
+class ProtocolSchema:
+    """Packet layouts and characteristics resolved from the parser."""
+
+    def __init__(self, services_dir: Path):
+        self.parser = BLEProtocolParser(str(services_dir))
+        self.parser.parse_all_services()
+        self.services_dir = services_dir
+        self.structs = self.parser.packet_structs
+        self.variable_writes = {w.packet: w for w in self.parser.wrappers.values()
+                                if w.macro.startswith('BLE_WRITE_WRAPPER_VARIABLE') and w.packet}
+        self.read_packets = {c.read_packet for s in self.parser.services
+                             for c in s.characteristics if c.read_packet}
+        self.headers = sorted(p.name for p in services_dir.glob("*.h")
+                              if p.name == CODEC_HEADER or
+                              (p.name != C_OUTPUT.name and '__attribute__((packed))' in p.read_text()))
+
+    def trailing_array(self, struct: PacketStruct) -> Optional[PacketField]:
+        """Last field if it is a data array, i.e. may arrive shorter than declared."""
+        last = struct.fields[-1] if struct.fields else None
+        if last and last.count and not is_reserved(last):
+            return last
+        return None
+
+    def counter(self, struct: PacketStruct) -> Optional[PacketField]:
+        """Field holding the element count of the trailing array, if any."""
+        array = self.trailing_array(struct)
+        if not array or array.base_type in ('uint8_t', 'char'):
+            return None
+        for field in struct.fields[:-1]:
+            if field.count == 0 and (field.name == 'count' or field.name.endswith('_count')):
+                return field
+        return None
+
+    def length_field(self, struct: PacketStruct) -> Optional[PacketField]:
+        """Field holding the byte length of a trailing byte array, if any."""
+        array = self.trailing_array(struct)
+        if not array or array.base_type not in ('uint8_t', 'char'):
+            return None
+        for field in struct.fields[:-1]:
+            if field.count == 0 and (field.name in ('length', 'chunk_size') or field.name.endswith('_len')):
+                return field
+        return None
+
+    def compact_fields(self, struct: PacketStruct) -> List[Tuple[PacketField, str, int]]:
+        """(field, define, number) for every field the compact encoding carries."""
+        prefix = re.sub(r'_packet$', '', c_prefix(struct.name)).upper() + "_FIELD_"
+        defines = {name for name in self.parser.defines if name.startswith(prefix)}
+        result = []
+        for field in struct.fields:
+            define = prefix + field.name.upper()
+            if define not in defines:
+                continue
+            defines.discard(define)
+            if is_reserved(field) or field.base_type in self.structs or field is self.counter(struct):
+                raise ValueError(f"{define}: {struct.name}.{field.name} cannot be encoded")
+            result.append((field, define, self.parser.evaluate(define)))
+        if defines:
+            raise ValueError(f"{', '.join(sorted(defines))}: no such field in {struct.name}")
+        return result
+
+    def header_size(self, struct: PacketStruct) -> int:
+        array = self.trailing_array(struct)
+        return array.offset if array else struct.total_size
+
+    def min_size(self, struct: PacketStruct) -> int:
+        wrapper = self.variable_writes.get(struct.name)
+        return wrapper.min_size if wrapper else struct.total_size
+
+    def element_size(self, field: PacketField) -> int:
+        return field.size // field.count if field.count else field.size
+
+    def constants(self) -> List[Tuple[str, List[Tuple[str, str]]]]:
+        """Integer #defines per header, in file order."""
+        result = []
+        for header in self.headers:
+            content = (self.services_dir / header).read_text().replace('\\\n', ' ')
+            values = []
+            for match in re.finditer(r'^#define\s+([A-Z][A-Z0-9_]*)[ \t]+([^\n]+)$', content, re.MULTILINE):
+                raw = re.sub(r'/\*.*?\*/|//.*$', '', match.group(2)).strip()
+                value = self.parser.evaluate(raw)
+                if value is None:
+                    continue
+                literal = raw if re.fullmatch(r'0[xX][0-9a-fA-F]+', raw) else str(value)
+                values.append((match.group(1), literal.replace('0X', '0x')))
+            if values:
+                result.append((header, values))
+        return result
+
+    def fingerprint(self) -> int:
+        """CRC-32 over every layout and characteristic binding."""
+        text = []
+        for struct in self.structs.values():
+            text.append(f"{struct.name}:{struct.total_size}")
+            text += [f" {f.name}:{f.type}@{f.offset}" for f in struct.fields]
+        for service in self.parser.services:
+            for char in service.characteristics:
+                text.append(f"{char.uuid}:{','.join(char.properties)}:"
+                            f"{char.read_packet}:{char.write_packet}")
+        for packet, wrapper in sorted(self.variable_writes.items()):
+            text.append(f"{packet}:{wrapper.min_size}-{wrapper.max_size}")
+        for struct in self.structs.values():
+            text += [f"{define}={number}" for _, define, number in self.compact_fields(struct)]
+        return zlib.crc32('\n'.join(text).encode())
+
+
+def is_reserved(field: PacketField) -> bool:
+    return field.name.startswith('reserved')
+
+
+def c_prefix(struct_name: str) -> str:
+    return re.sub(r'_t$', '', struct_name)
+
+
+def class_name(struct_name: str) -> str:
+    return ''.join(part.capitalize() for part in c_prefix(struct_name).split('_'))
+
+
+def char_name(uuid_name: str) -> str:
+    return re.sub(r'^BT_UUID_|_UUID$', '', uuid_name).lower()
+
+
+def uuid_string(uuid: str) -> str:
+    if '-' in uuid:
+        return uuid.lower()
+    return BASE_UUID.format(int(uuid, 16))
+
+
+# ============================================================================
+# C OUTPUT
+# ============================================================================
+
+def generate_c(schema: ProtocolSchema) -> str:
+    out = [f"""#ifndef BLE_PROTOCOL_GEN_H
+#define BLE_PROTOCOL_GEN_H
+
+/* Generated by generate_ble_protocol.py - do not edit. Regenerate after
+ * changing a packet struct, characteristic or wrapper macro. */
+
+"""]
+    out += [f'#include "{header}"\n' for header in schema.headers]
+    out.append("""#include <zephyr/sys/util.h>
+#include <zephyr/toolchain.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file ble_protocol_gen.h
+ * @brief Packet layout checks and validators generated from the packet structs
+ *
+ * The asserts pin every size and offset the generated Python client
+ * encodes, so a struct edited without regenerating fails the build instead
+ * of silently changing the wire format.
+ */
+
+""")
+    out.append(f"#define BLE_PROTOCOL_FINGERPRINT    0x{schema.fingerprint():08X}u  "
+               f"/* CRC-32 of layouts and characteristics */\n\n")
+
+    out.append(banner("LAYOUT"))
+    for struct in schema.structs.values():
+        out.append(f"BUILD_ASSERT(sizeof({struct.name}) == {struct.total_size}, "
+                   f"\"run generate_ble_protocol.py\");\n")
+        for field in struct.fields[1:]:
+            out.append(f"BUILD_ASSERT(offsetof({struct.name}, {field.name}) == {field.offset}, "
+                       f"\"run generate_ble_protocol.py\");\n")
+        out.append("\n")
+
+    out.append(banner("VALIDATORS AND LENGTHS"))
+    for struct in schema.structs.values():
+        array = schema.trailing_array(struct)
+        counter = schema.counter(struct)
+        length = schema.length_field(struct)
+        wrapper = schema.variable_writes.get(struct.name)
+        prefix = c_prefix(struct.name)
+
+        if counter and (wrapper or struct.name in schema.read_packets):
+            out.append(f"""/**
+ * @brief Length of a {struct.name} carrying @p count {array.name}
+ */
+static inline uint16_t {prefix}_len(uint8_t count)
+{{
+    return offsetof({struct.name}, {array.name}) +
+           count * sizeof((({struct.name} *)0)->{array.name}[0]);
+}}
+
+""")
+
+        if not wrapper:
+            continue
+
+        checks = [f"""    if (len < {wrapper.min_size} || len > sizeof({struct.name})) {{
+        return -EMSGSIZE;
+    }}
+"""]
+        if counter:
+            checks.append(f"""    if (packet->{counter.name} > ARRAY_SIZE(packet->{array.name}) ||
+        len != {prefix}_len(packet->{counter.name})) {{
+        return -EMSGSIZE;
+    }}
+""")
+        elif length:
+            checks.append(f"""    if (len < offsetof({struct.name}, {array.name}) + packet->{length.name}) {{
+        return -EMSGSIZE;
+    }}
+""")
+        elif array and schema.element_size(array) > 1:
+            checks.append(f"""    if ((len - offsetof({struct.name}, {array.name})) % sizeof(packet->{array.name}[0]) != 0) {{
+        return -EMSGSIZE;
+    }}
+""")
+        detail = (f"within {wrapper.min_size}..{struct.total_size} bytes"
+                  + (f" and hold exactly {counter.name} {array.name}" if counter else "")
+                  + (f" and hold at least {length.name} bytes of {array.name}" if length else ""))
+        uses_packet = any('packet->' in check for check in checks)
+        out.append(f"""/**
+ * @brief Check the length of a {struct.name} write
+ *
+ * The length must be {detail}.
+ *
+ * @return 0 if valid, -EMSGSIZE otherwise
+ */
+static inline int {prefix}_validate(const void *buf, uint16_t len)
+{{
+""")
+        if uses_packet:
+            out.append(f"    const {struct.name} *packet = buf;\n\n")
+        else:
+            out.append("    ARG_UNUSED(buf);\n\n")
+        out.append(''.join(checks))
+        out.append("    return 0;\n}\n\n")
+
+    out.append(banner("COMPACT DECODERS"))
+    for struct in schema.structs.values():
+        fields = schema.compact_fields(struct)
+        if fields:
+            out.append(generate_decoder(schema, struct, fields))
+
+    out.append("#endif /* BLE_PROTOCOL_GEN_H */\n")
+    return ''.join(out)
+
+
+C_LIMITS = {
+    'uint8_t': 'UINT8_MAX', 'uint16_t': 'UINT16_MAX', 'uint32_t': 'UINT32_MAX', 'uint64_t': 'UINT64_MAX',
+    'int8_t': 'INT8', 'int16_t': 'INT16', 'int32_t': 'INT32', 'int64_t': 'INT64', 'bool': '1',
+}
+
+
+def generate_decoder(schema: ProtocolSchema, struct: PacketStruct,
+                     fields: List[Tuple[PacketField, str, int]]) -> str:
+    prefix = c_prefix(struct.name)
+    counter = schema.counter(struct)
+    scalars = [f for f, _, _ in fields if not (f.count and f.base_type in ('uint8_t', 'char'))]
+    signed = any(f.base_type.startswith('int') for f in scalars)
+    unsigned = any(not f.base_type.startswith('int') for f in scalars)
+    repeated = [f for f in scalars if f.count]
+
+    cases = []
+    for field, define, _ in fields:
+        target = f"packet->{field.name}"
+        if field.count and field.base_type in ('uint8_t', 'char'):
+            terminate = 'true' if field.base_type == 'char' else 'false'
+            cases.append(f"""        case {define}:
+            err = compact_get_bytes(&field, {target}, sizeof({target}), {terminate});
+            break;
+""")
+            continue
+        if field.count:
+            index = f"{field.name}_count"
+            cases.append(f"""        case {define}:
+            if ({index} >= ARRAY_SIZE({target})) {{
+                return -EMSGSIZE;
+            }}
+""")
+            target = f"{target}[{index}++]"
+        else:
+            cases.append(f"        case {define}:\n")
+        if field.base_type.startswith('int'):
+            limit = C_LIMITS[field.base_type]
+            cases.append(f"""            err = compact_get_int(&field, {limit}_MIN, {limit}_MAX, &svalue);
+            {target} = svalue;
+            break;
+""")
+        else:
+            cases.append(f"""            err = compact_get_uint(&field, {C_LIMITS[field.base_type]}, &value);
+            {target} = value;
+            break;
+""")
+
+    locals_ = []
+    if unsigned:
+        locals_.append("    uint64_t value = 0;\n")
+    if signed:
+        locals_.append("    int64_t svalue = 0;\n")
+    locals_ += [f"    uint8_t {f.name}_count = 0;\n" for f in repeated]
+    finish = ""
+    if counter and any(f.name == schema.trailing_array(struct).name for f in repeated):
+        finish = f"    packet->{counter.name} = {schema.trailing_array(struct).name}_count;\n"
+
+    indent = ' ' * len(f"static inline int {prefix}_decode(")
+    return f"""/**
+ * @brief Decode a compact encoded {struct.name}
+ *
+ * Fields not present stay as they are in @p packet, which should be zeroed.
+ *
+ * @param buf Encoded packet
+ * @param len Length of the encoded packet in bytes
+ * @param packet Packet to fill in
+ * @return 0 on success, -EBADMSG if malformed, -ERANGE or -EMSGSIZE if a
+ *         value does not fit the struct
+ */
+static inline int {prefix}_decode(const void *buf, uint16_t len,
+{indent}{struct.name} *packet)
+{{
+    compact_reader_t reader;
+    compact_field_t field;
+{''.join(locals_)}    int err;
+
+    compact_reader_init(&reader, buf, len);
+    while ((err = compact_reader_next(&reader, &field)) > 0) {{
+        switch (field.id) {{
+{''.join(cases)}        default:
+            /* Added by a later version */
+            break;
+        }}
+        if (err < 0) {{
+            return err;
+        }}
+    }}
+{finish}    return err;
+}}
+
+"""
+
+
+def banner(title: str) -> str:
+    rule = "=" * 76
+    return f"/* {rule}\n * {title}\n * {rule} */\n\n"
+
+
+# ============================================================================
+# PYTHON OUTPUT
+# ============================================================================
+
+PY_RUNTIME = '''
+class Packet:
+    """Base of the generated packet classes
+
+    LAYOUT lists (name, kind, format, length) per field. Kinds: int, pad,
+    count (element count of the list field named in length), str, bytes,
+    ints, packet and packets.
+    """
+
+    SIZE: ClassVar[int] = 0
+    MIN_SIZE: ClassVar[int] = 0        # Shortest valid write
+    HEADER_SIZE: ClassVar[int] = 0     # Bytes ahead of the trailing array
+    VARIABLE: ClassVar[bool] = False   # Trailing array is sent only as far as it is filled
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = ()
+    COMPACT: ClassVar[Tuple[Tuple[str, int], ...]] = ()  # (field, number) in the compact encoding
+
+    def encode(self, encoding: int) -> bytes:
+        """Encode for a connection using encoding (COMPACT_ENCODING_*)"""
+        if encoding != COMPACT_ENCODING_LEGACY and self.COMPACT:
+            return self.pack_compact()
+        return self.pack()
+
+    def pack_compact(self) -> bytes:
+        """Encode as tagged fields, leaving out zero and empty ones (see compact_codec.h)"""
+        layout = {name: (kind, fmt, length) for name, kind, fmt, length in self.LAYOUT}
+        out = bytearray()
+        for name, number in self.COMPACT:
+            kind, fmt, length = layout[name]
+            value = getattr(self, name)
+            if kind in ('str', 'bytes'):
+                value = value.encode() if kind == 'str' else bytes(value)
+                _check_length(self, name, len(value) + (kind == 'str'), length)
+                if value:
+                    out += _varint(number << COMPACT_TAG_SHIFT | COMPACT_WIRE_BYTES)
+                    out += _varint(len(value)) + value
+                continue
+            values = list(value) if kind == 'ints' else [value] if value else []
+            _check_length(self, name, len(values), length or 1)
+            for item in values:
+                out += _varint(number << COMPACT_TAG_SHIFT | COMPACT_WIRE_VARINT)
+                out += _varint(_zigzag(item) if fmt.islower() else int(item))
+        return bytes(out)
+
+    def pack(self) -> bytes:
+        out = bytearray()
+        for index, (name, kind, fmt, length) in enumerate(self.LAYOUT):
+            trailing = self.VARIABLE and index == len(self.LAYOUT) - 1
+            if kind == 'pad':
+                out += bytes(length)
+            elif kind == 'count':
+                out += struct.pack('<' + fmt, len(getattr(self, length)))
+            elif kind == 'int':
+                out += struct.pack('<' + fmt, getattr(self, name))
+            elif kind in ('str', 'bytes'):
+                value = getattr(self, name)
+                value = value.encode() if kind == 'str' else bytes(value)
+                _check_length(self, name, len(value), length)
+                out += value if trailing else value.ljust(length, b'\\0')
+            elif kind == 'ints':
+                values = list(getattr(self, name))
+                _check_length(self, name, len(values), length)
+                if not trailing:
+                    values += [0] * (length - len(values))
+                out += struct.pack(f'<{len(values)}{fmt}', *values)
+            elif kind == 'packet':
+                out += getattr(self, name).pack()
+            elif kind == 'packets':
+                items = list(getattr(self, name))
+                _check_length(self, name, len(items), length)
+                if not trailing:
+                    items += [fmt() for _ in range(length - len(items))]
+                out += b''.join(item.pack() for item in items)
+        if len(out) < self.MIN_SIZE:
+            raise ValueError(f"{type(self).__name__}: {len(out)} bytes, need {self.MIN_SIZE}")
+        return bytes(out)
+
+    @classmethod
+    def unpack(cls, data: bytes):
+        data = bytes(data)
+        if len(data) < cls.HEADER_SIZE:
+            raise ValueError(f"{cls.__name__}: {len(data)} bytes, need {cls.HEADER_SIZE}")
+        values: Dict[str, Any] = {}
+        counts: Dict[str, int] = {}
+        offset = 0
+        for name, kind, fmt, length in cls.LAYOUT:
+            if kind == 'pad':
+                offset += length
+            elif kind in ('int', 'count'):
+                (value,) = struct.unpack_from('<' + fmt, data, offset)
+                offset += struct.calcsize(fmt)
+                if kind == 'count':
+                    counts[length] = value
+                else:
+                    values[name] = value
+            elif kind in ('str', 'bytes'):
+                value = data[offset:offset + length]
+                offset += len(value)
+                if kind == 'str':
+                    value = value.split(b'\\0', 1)[0].decode('utf-8', errors='replace')
+                values[name] = value
+            elif kind == 'ints':
+                size = struct.calcsize(fmt)
+                n = min(length, (len(data) - offset) // size)
+                values[name] = list(struct.unpack_from(f'<{n}{fmt}', data, offset))
+                offset += n * size
+            elif kind == 'packet':
+                values[name] = fmt.unpack(data[offset:offset + fmt.SIZE])
+                offset += fmt.SIZE
+            elif kind == 'packets':
+                n = min(length, (len(data) - offset) // fmt.SIZE)
+                values[name] = [fmt.unpack(data[offset + i * fmt.SIZE:offset + (i + 1) * fmt.SIZE])
+                                for i in range(n)]
+                offset += n * fmt.SIZE
+        for name, count in counts.items():
+            values[name] = values[name][:count]
+        return cls(**values)
+
+    @classmethod
+    def batches(cls, items: Iterable[Any], **fields) -> Iterator['Packet']:
+        """Split items over as many packets as needed
+
+        Only for packets with a counted trailing array; fields are copied
+        into every packet.
+        """
+        name, capacity = cls._counted_array()
+        items = list(items)
+        for start in range(0, len(items), capacity):
+            yield cls(**fields, **{name: items[start:start + capacity]})
+
+    @classmethod
+    def _counted_array(cls) -> Tuple[str, int]:
+        for _, kind, _, target in cls.LAYOUT:
+            if kind == 'count':
+                for name, _, _, length in cls.LAYOUT:
+                    if name == target:
+                        return name, length
+        raise TypeError(f"{cls.__name__} has no counted array")
+
+
+def _check_length(packet: Packet, name: str, length: int, capacity: int) -> None:
+    if length > capacity:
+        raise ValueError(f"{type(packet).__name__}.{name}: {length} > {capacity}")
+
+
+def _varint(value: int) -> bytes:
+    out = bytearray()
+    while value > 0x7F:
+        out.append(value & 0x7F | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def _zigzag(value: int) -> int:
+    return (value << 1) ^ (value >> 63)
+'''
+
+PY_CLIENT = '''
+class BLEProtocolClient:
+    """Typed access to every characteristic of a connected BleakClient"""
+
+    def __init__(self, client: BleakClient):
+        self.client = client
+        self.encoding = COMPACT_ENCODING_LEGACY     # Every connection starts out legacy
+        self.capabilities = None
+
+    async def configure(self) -> 'DeviceCapabilities':
+        """Read the device capabilities once and switch to the best paths it supports"""
+        self.capabilities = await self.read_device_capabilities()
+        if self.capabilities.protocol_fingerprint != FINGERPRINT:
+            warnings.warn(f"Firmware protocol 0x{self.capabilities.protocol_fingerprint:08X}, "
+                          f"client generated for 0x{FINGERPRINT:08X}")
+        if self.capabilities.encodings & (1 << COMPACT_ENCODING_LATEST):
+            await self.set_encoding(COMPACT_ENCODING_LATEST)
+        return self.capabilities
+
+    async def set_encoding(self, encoding: int) -> int:
+        """Switch this connection's writes to encoding (CMD_SET_ENCODING)
+
+        Returns the highest encoding the firmware supports.
+        """
+        await self.write_control_command(ControlCommandPacket(cmd_id=CMD_SET_ENCODING,
+                                                              param1=encoding))
+        response = await self.read_control_response()
+        if response.cmd_id != CMD_SET_ENCODING or response.status != RESPONSE_SUCCESS:
+            raise ValueError(f"Encoding {encoding} refused (status {response.status})")
+        self.encoding = response.result[ENCODING_RESULT_ACTIVE]
+        return response.result[ENCODING_RESULT_LATEST]
+
+    async def _read(self, uuid: str, packet_type):
+        return packet_type.unpack(await self.client.read_gatt_char(uuid))
+
+    async def _write(self, uuid: str, packet: Packet, response: bool) -> None:
+        await self.client.write_gatt_char(uuid, packet.encode(self.encoding), response=response)
+
+    async def _write_batches(self, uuid: str, packet_type, items, response: bool,
+                             fields: Dict[str, Any]) -> int:
+        count = 0
+        for packet in packet_type.batches(items, **fields):
+            await self._write(uuid, packet, response)
+            count += 1
+        return count
+
+    async def _subscribe(self, uuid: str, packet_type, callback: Callable[[Any], None]) -> None:
+        await self.client.start_notify(uuid, lambda _, data: callback(packet_type.unpack(data)))
+'''
+
+
+def py_field_spec(schema: ProtocolSchema, struct: PacketStruct,
+                  field: PacketField) -> Tuple[Optional[str], Optional[str], str]:
+    """Return (annotation, default, layout entry); annotation None for derived fields."""
+    counter = schema.counter(struct)
+    array = schema.trailing_array(struct)
+
+    if is_reserved(field):
+        return None, None, f"('{field.name}', 'pad', None, {field.size})"
+    if counter and field is counter:
+        fmt = STRUCT_FORMATS[field.base_type]
+        return None, None, f"('{field.name}', 'count', '{fmt}', '{array.name}')"
+    if field.base_type in schema.structs:
+        nested = class_name(field.base_type)
+        if field.count:
+            return (f"List[{nested}]", "field(default_factory=list)",
+                    f"('{field.name}', 'packets', {nested}, {field.count})")
+        return (nested, f"field(default_factory={nested})",
+                f"('{field.name}', 'packet', {nested}, None)")
+    if field.base_type == 'char':
+        return "str", "''", f"('{field.name}', 'str', None, {field.count or 1})"
+    fmt = STRUCT_FORMATS.get(field.base_type)
+    if fmt is None:
+        raise ValueError(f"{struct.name}.{field.name}: unsupported type {field.base_type}")
+    if field.count and field.base_type == 'uint8_t':
+        return "bytes", "b''", f"('{field.name}', 'bytes', None, {field.count})"
+    if field.count:
+        return ("List[int]", "field(default_factory=list)",
+                f"('{field.name}', 'ints', '{fmt}', {field.count})")
+    return "int", "0", f"('{field.name}', 'int', '{fmt}', None)"
+
+
+def generate_python(schema: ProtocolSchema) -> str:
+    out = [f'''"""
+BLE protocol definitions for the tests
+
+Generated by generate_ble_protocol.py from the service headers - do not edit.
+Regenerate after changing a packet struct, characteristic or wrapper macro.
+"""
+
+import struct
+import warnings
+from dataclasses import dataclass, field
+from typing import Any, Callable, ClassVar, Dict, Iterable, Iterator, List, Tuple
+
+from bleak import BleakClient
+
+FINGERPRINT = 0x{schema.fingerprint():08X}  # Matches BLE_PROTOCOL_FINGERPRINT in ble_protocol_gen.h
+''']
+
+    out.append("\n# " + "=" * 76 + "\n# CONSTANTS\n# " + "=" * 76 + "\n")
+    seen: Dict[str, str] = {}
+    for header, values in schema.constants():
+        out.append(f"\n# {header}\n")
+        for name, literal in values:
+            if name in seen:
+                continue
+            seen[name] = literal
+            out.append(f"{name} = {literal}\n")
+
+    out.append("\n# " + "=" * 76 + "\n# UUIDS\n# " + "=" * 76 + "\n\n")
+    for service in schema.parser.services:
+        out.append(f"{service.name.upper()}_UUID = \"{uuid_string(service.uuid)}\"\n")
+        for char in service.characteristics:
+            out.append(f"{char_name(char.uuid_name).upper()}_UUID = \"{uuid_string(char.uuid)}\"\n")
+
+    out.append("\n# " + "=" * 76 + "\n# PACKETS\n# " + "=" * 76 + "\n")
+    out.append(PY_RUNTIME)
+
+    for struct in schema.structs.values():
+        name = class_name(struct.name)
+        annotations = []
+        layout = []
+        for f in struct.fields:
+            annotation, default, entry = py_field_spec(schema, struct, f)
+            layout.append(entry)
+            if annotation:
+                comment = f"  # {f.description}" if f.description else ""
+                annotations.append(f"    {f.name}: {annotation} = {default}{comment}\n")
+        variable = struct.name in schema.variable_writes
+
+        out.append(f"\n\n@dataclass\nclass {name}(Packet):\n")
+        doc = f"{struct.name}, {struct.total_size} bytes"
+        out.append(f'    """{doc}"""\n\n')
+        out.append(f"    SIZE: ClassVar[int] = {struct.total_size}\n")
+        out.append(f"    MIN_SIZE: ClassVar[int] = {schema.min_size(struct)}\n")
+        out.append(f"    HEADER_SIZE: ClassVar[int] = {schema.header_size(struct)}\n")
+        if variable:
+            out.append("    VARIABLE: ClassVar[bool] = True\n")
+        out.append("    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (\n")
+        out += [f"        {entry},\n" for entry in layout]
+        out.append("    )\n")
+        compact = schema.compact_fields(struct)
+        if compact:
+            out.append("    COMPACT: ClassVar[Tuple[Tuple[str, int], ...]] = (\n")
+            out += [f"        ('{f.name}', {define}),\n" for f, define, _ in compact]
+            out.append("    )\n")
+        out.append("\n")
+        out += annotations
+
+    out.append("\n\n# " + "=" * 76 + "\n# CLIENT\n# " + "=" * 76 + "\n")
+    out.append(PY_CLIENT)
+    for service in schema.parser.services:
+        for char in service.characteristics:
+            out.append(generate_client_methods(schema, char))
+
+    return ''.join(out)
+
+
+def generate_client_methods(schema: ProtocolSchema, char) -> str:
+    name = char_name(char.uuid_name)
+    uuid = f"{name.upper()}_UUID"
+    out = []
+
+    if char.read_packet and 'READ' in char.properties:
+        packet = class_name(char.read_packet)
+        out.append(f"""
+    async def read_{name}(self) -> {packet}:
+        return await self._read({uuid}, {packet})
+""")
+    if char.write_packet and ('WRITE' in char.properties or 'WRITE_WITHOUT_RESP' in char.properties):
+        packet = class_name(char.write_packet)
+        response = 'WRITE' in char.properties
+        out.append(f"""
+    async def write_{name}(self, packet: {packet}, response: bool = {response}) -> None:
+        await self._write({uuid}, packet, response)
+""")
+        struct = schema.structs[char.write_packet]
+        if schema.counter(struct) and struct.name in schema.variable_writes:
+            array = schema.trailing_array(struct)
+            item = class_name(array.base_type)
+            out.append(f"""
+    async def write_{name}_all(self, {array.name}: Iterable[{item}], response: bool = {response},
+                               **fields) -> int:
+        \"\"\"Write {array.name} in as few packets as possible, return the packet count\"\"\"
+        return await self._write_batches({uuid}, {packet}, {array.name}, response, fields)
+""")
+    if char.read_packet and ('NOTIFY' in char.properties or 'INDICATE' in char.properties):
+        packet = class_name(char.read_packet)
+        out.append(f"""
+    async def subscribe_{name}(self, callback: Callable[[{packet}], None]) -> None:
+        await self._subscribe({uuid}, {packet}, callback)
+
+    async def unsubscribe_{name}(self) -> None:
+        await self.client.stop_notify({uuid})
+""")
+    return ''.join(out)
+
+
+# ============================================================================
+# HANDLER STUBS
+# ============================================================================
+
+def context_types(services_dir: Path) -> Dict[str, str]:
+    """Map lookup functions from BLE_CONN_CONTEXT_DEFINE() to context types."""
+    types = {}
+    for path in services_dir.glob("*.c"):
+        for ctx_type, array in re.findall(r'BLE_CONN_CONTEXT_DEFINE\((\w+),\s*(\w+)\)', path.read_text()):
+            types[f"{array}_get"] = ctx_type
+    return types
+
+
+def generate_stub(schema: ProtocolSchema, kind: str, packet: str, ctx_lookup: Optional[str]) -> str:
+    struct = schema.structs.get(packet)
+    if not struct:
+        raise SystemExit(f"Unknown packet type {packet}")
+
+    handler = re.sub(r'(_packet)?_t$', '', packet) + "_handler"
+    ctx_param = ""
+    ctx_arg = ""
+    if ctx_lookup:
+        ctx_type = context_types(schema.services_dir).get(ctx_lookup)
+        if not ctx_type:
+            raise SystemExit(f"No BLE_CONN_CONTEXT_DEFINE() provides {ctx_lookup}")
+        ctx_param = f"{ctx_type} *ctx, "
+        ctx_arg = f", {ctx_lookup}"
+    suffix = "_CTX" if ctx_lookup else ""
+    uuid = c_prefix(handler).upper().replace('_HANDLER', '') + "_UUID"
+
+    if kind == 'write':
+        body = [f"static ssize_t {handler}({ctx_param}const {packet} *packet)\n{{\n"]
+        body.append(f"    LOG_DBG(\"{handler} called\");\n\n")
+        body += [f"    /* packet->{f.name}: {f.description or f.type} */\n"
+                 for f in struct.fields if not is_reserved(f)]
+        body.append("\n    return sizeof(*packet);\n}\n\n")
+        body.append(f"BLE_WRITE_WRAPPER{suffix}({handler}, {packet}{ctx_arg})\n\n")
+        body.append(f"""    BT_GATT_CHARACTERISTIC({uuid},
+                          BT_GATT_CHRC_WRITE,
+                          BT_GATT_PERM_WRITE,
+                          NULL, {handler}_ble, NULL),
+""")
+    else:
+        body = [f"static ssize_t {handler}({ctx_param}{packet} *response)\n{{\n"]
+        body.append(f"    LOG_DBG(\"{handler} called\");\n\n")
+        body += [f"    response->{f.name} = 0;    /* {f.description or f.type} */\n"
+                 for f in struct.fields if not is_reserved(f) and not f.count]
+        body.append("\n    return sizeof(*response);\n}\n\n")
+        body.append(f"BLE_READ_WRAPPER{suffix}({handler}, {packet}{ctx_arg})\n\n")
+        body.append(f"""    BT_GATT_CHARACTERISTIC({uuid},
+                          BT_GATT_CHRC_READ,
+                          BT_GATT_PERM_READ,
+                          {handler}_ble, NULL, NULL),
+""")
+    return ''.join(body)
+
+
+# ============================================================================
+# MAIN
+# ============================================================================
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate BLE protocol code from the service headers")
+    parser.add_argument('--check', action='store_true', help="fail if a generated file is stale")
+    parser.add_argument('--stub', nargs=2, metavar=('KIND', 'PACKET'),
+                        help="print a read or write handler skeleton for PACKET")
+    parser.add_argument('--ctx', metavar='LOOKUP', help="context lookup for --stub, e.g. control_ctx_get")
+    args = parser.parse_args()
+
+    # The parser reports progress on stdout; keep it out of stub output
+    stdout = sys.stdout
+    sys.stdout = sys.stderr
+    schema = ProtocolSchema(SERVICES_DIR)
+    sys.stdout = stdout
+
+    if args.stub:
+        kind, packet = args.stub
+        if kind not in ('read', 'write'):
+            raise SystemExit("KIND must be read or write")
+        print(generate_stub(schema, kind, packet, args.ctx), end='')
+        return
+
+    outputs = {C_OUTPUT: generate_c(schema), PY_OUTPUT: generate_python(schema)}
+    stale = []
+    for path, content in outputs.items():
+        current = path.read_text() if path.exists() else None
+        if current == content:
+            continue
+        if args.check:
+            stale.append(str(path))
+        else:
+            path.write_text(content)
+            print(f"Generated {path}")
+
+    if stale:
+        print(f"Stale, run generate_ble_protocol.py: {', '.join(stale)}", file=sys.stderr)
+        sys.exit(1)
+    print(f"Protocol fingerprint 0x{schema.fingerprint():08X}")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,5 +1,6 @@
 #include <zephyr/kernel.h>
 #include <zephyr/sys/printk.h>
+#include <zephyr/logging/log.h>
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/hci.h>
 #include <zephyr/bluetooth/conn.h>
@@ -8,6 +9,12 @@
 
 /* Include our modular BLE services */
 #include "services/ble_services.h"
+#include "services/bonding.h"
+#include "services/conn_sched.h"
+#include "services/event_bus.h"
+#include "services/link_profile.h"
+#include "services/mem_budget.h"
+#include "services/status_broadcast.h"
 
 /**
  * @file main.c
@@ -17,47 +24,110 @@
  * with proper separation of concerns across multiple service modules.
  */
 
+LOG_MODULE_REGISTER(main, CONFIG_APP_LOG_LEVEL);
+
 /* ============================================================================
  * BLE CONNECTION MANAGEMENT
  * ============================================================================ */
 
+/**
+ * @brief Start connectable advertising
+ * 
+ * Advertising stops whenever a central connects, so this is called again
+ * after each connection and whenever a connection slot is freed, letting
+ * up to CONFIG_BT_MAX_CONN centrals connect at once. The advertising set
+ * also carries the status broadcast for clients that never connect.
+ */
+static void advertising_start(void)
+{
+    int err = status_broadcast_start();
+    
+    if (err) {
+        /* -ENOMEM: all connection slots in use, retried from recycled() */
+        LOG_ERR("Advertising failed to start (err %d)", err);
+        return;
+    }
+    
+    LOG_INF("Advertising successfully started");
+}
+
+/**
+ * @brief Check whether a connection was made to us by a central
+ * 
+ * Outgoing connections opened by the relay are handled in relay.c and
+ * must not be counted or served as clients here.
+ */
+static bool is_client_connection(struct bt_conn *conn)
+{
+    struct bt_conn_info info;
+    
+    return bt_conn_get_info(conn, &info) == 0 && info.role == BT_CONN_ROLE_PERIPHERAL;
+}
+
 static void connected(struct bt_conn *conn, uint8_t err)
 {
+    if (!is_client_connection(conn)) {
+        return;
+    }
+    
     if (err) {
-        printk("Connection failed (err %u)\n", err);
+        LOG_ERR("Connection failed (err %u)", err);
         return;
     }
     
     char addr[BT_ADDR_LE_STR_LEN];
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
     
-    printk("Connected to %s\n", addr);
-    printk("Connection handle: %d\n", bt_conn_index(conn));
+    LOG_INF("Connected to %s", addr);
+    LOG_INF("Connection handle: %d", bt_conn_index(conn));
     
     /* Notify all services of connection */
     ble_services_connection_event(conn, true);
     
+    /* Encrypt the link: bonded clients reuse their keys and cached handles */
+    bonding_connection_event(conn, true);
+    
     /* Request MTU exchange for large packet support */
     int mtu_err = ble_services_request_mtu_exchange(conn);
     if (mtu_err) {
-        printk("MTU exchange request failed (err %d)\n", mtu_err);
+        LOG_ERR("MTU exchange request failed (err %d)", mtu_err);
     }
+    
+    /* Ask for 2M PHY, long LL packets and a short interval up front */
+    link_profile_apply(conn, LINK_PROFILE_DEFAULT);
+    
+    /* Keep advertising so further centrals can connect */
+    advertising_start();
 }
 
 static void disconnected(struct bt_conn *conn, uint8_t reason)
 {
+    if (!is_client_connection(conn)) {
+        return;
+    }
+    
     char addr[BT_ADDR_LE_STR_LEN];
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
     
-    printk("Disconnected from %s (reason %u)\n", addr, reason);
+    LOG_INF("Disconnected from %s (reason %u)", addr, reason);
     
     /* Notify all services of disconnection */
     ble_services_connection_event(conn, false);
+    
+    /* Advertise fast for a while if a bonded client left */
+    bonding_connection_event(conn, false);
+}
+
+static void recycled(void)
+{
+    /* A connection slot is free again */
+    advertising_start();
 }
 
 static struct bt_conn_cb conn_callbacks = {
     .connected = connected,
     .disconnected = disconnected,
+    .recycled = recycled,
 };
 
 /* ============================================================================
@@ -67,29 +137,42 @@ static struct bt_conn_cb conn_callbacks = {
 static void bt_ready(int err)
 {
     if (err) {
-        printk("Bluetooth init failed (err %d)\n", err);
+        LOG_ERR("Bluetooth init failed (err %d)", err);
         return;
     }
 
-    printk("Bluetooth initialized\n");
+    LOG_INF("Bluetooth initialized");
+    
+    /* Restore the identity and bonds before anything is advertised */
+    err = bonding_init();
+    if (err) {
+        LOG_ERR("Failed to initialize bonding (err %d)", err);
+        return;
+    }
+    
+    /* Align notification fills and heavy work to connection events */
+    err = conn_sched_init();
+    if (err) {
+        LOG_WRN("Connection event scheduling unavailable (err %d)", err);
+    }
     
     /* Initialize all BLE services */
     err = ble_services_init();
     if (err) {
-        printk("Failed to initialize BLE services (err %d)\n", err);
+        LOG_ERR("Failed to initialize BLE services (err %d)", err);
         return;
     }
 
-    /* Start advertising */
-    err = bt_le_adv_start(BT_LE_ADV_CONN_NAME, NULL, 0, NULL, 0);
+    /* Start advertising with the status block in the service data */
+    err = status_broadcast_init();
     if (err) {
-        printk("Advertising failed to start (err %d)\n", err);
+        LOG_ERR("Failed to initialize status broadcast (err %d)", err);
         return;
     }
+    advertising_start();
 
-    printk("Advertising successfully started\n");
-    printk("Device name: nRF5340-BLE-Multi-Service\n");
-    printk("Ready for connections...\n");
+    LOG_INF("Device name: nRF5340-BLE-Multi-Service");
+    LOG_INF("Ready for connections...");
 }
 
 /* ============================================================================
@@ -116,10 +199,25 @@ static void print_status_summary(void)
         break;
     }
     
-    printk("Status: Device=%s, Uptime=%lld seconds\n",
-           status_str, k_uptime_get() / 1000);
+    LOG_INF("Status: Device=%s, Uptime=%lld seconds",
+            status_str, k_uptime_get() / 1000);
+    ble_services_print_stats();
+    event_bus_print_stats();
+    conn_sched_print_stats();
+    mem_budget_print_stats();
 }
 
+/**
+ * @brief Log a status summary when the device state changes
+ */
+static void status_log_handler(uint32_t events)
+{
+    print_status_summary();
+}
+
+EVENT_SUBSCRIBER_DEFINE(status_log, EVENT_CONNECTION | EVENT_DEVICE_STATUS | EVENT_RELAY_STATE |
+                        EVENT_BOND, status_log_handler);
+
 /* ============================================================================
  * MAIN APPLICATION
  * ============================================================================ */
@@ -141,21 +239,21 @@ int main(void)
     /* Initialize the Bluetooth subsystem */
     err = bt_enable(bt_ready);
     if (err) {
-        printk("Bluetooth init failed (err %d)\n", err);
+        LOG_ERR("Bluetooth init failed (err %d)", err);
         return 0;
     }
 
     /* Register connection callbacks */
     bt_conn_cb_register(&conn_callbacks);
 
-    printk("BLE device initialization complete\n");
-    printk("Waiting for connections...\n");
+    LOG_INF("BLE device initialization complete");
+    LOG_INF("Waiting for connections...");
 
-    /* Main application loop */
+    /* Main application loop: sleep until a service publishes a state change */
     while (1) {
-        /* Periodic status updates every 30 seconds */
-        k_sleep(K_SECONDS(30));
-        print_status_summary();
+        uint32_t events = event_bus_wait(K_FOREVER);
+        
+        event_bus_dispatch(events);
     }
 
     return 0;
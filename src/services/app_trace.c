@@ -0,0 +1,263 @@
+#include "app_trace.h"
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/tracing/tracing.h>
+#include <errno.h>
+#include <string.h>
+
+/**
+ * @file app_trace.c
+ * @brief Trace markers implementation
+ */
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+#if defined(CONFIG_APP_TRACE) || defined(CONFIG_TRACING_CTF)
+
+typedef struct {
+    const char *name;
+    const char *ctf[3];         /* Named event per APP_TRACE_PHASE_* */
+} app_trace_marker_t;
+
+/* CTF named events carry no phase, so it goes into the name */
+#define MARKER(_name) { .name = _name, .ctf = { _name ":B", _name ":E", _name } }
+
+static const app_trace_marker_t markers[] = {
+    [APP_TRACE_GATT_WRITE] = MARKER("gatt_write"),
+    [APP_TRACE_GATT_READ] = MARKER("gatt_read"),
+    [APP_TRACE_MSGQ_PUT] = MARKER("msgq_put"),
+    [APP_TRACE_MSGQ_GET] = MARKER("msgq_get"),
+    [APP_TRACE_WASM_PARSE] = MARKER("wasm_parse"),
+    [APP_TRACE_WASM_LOAD] = MARKER("wasm_load"),
+    [APP_TRACE_WASM_COMPILE] = MARKER("wasm_compile"),
+    [APP_TRACE_WASM_CALL] = MARKER("wasm_call"),
+    [APP_TRACE_FLASH_WRITE] = MARKER("flash_write"),
+    [APP_TRACE_NOTIFY] = MARKER("notify"),
+};
+
+BUILD_ASSERT(ARRAY_SIZE(markers) == APP_TRACE_MARKER_COUNT, "marker without a name");
+
+#endif /* CONFIG_APP_TRACE || CONFIG_TRACING_CTF */
+
+#if defined(CONFIG_APP_TRACE)
+
+static app_trace_record_t ring[CONFIG_APP_TRACE_RECORDS];
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_APP_TRACE_RECORDS), "ring index must survive the head wrapping");
+static uint32_t ring_head;              /* Records written since the last clear */
+static uint32_t frozen_dropped;         /* Markers hit while frozen */
+static bool frozen;
+static struct k_spinlock ring_lock;
+
+/* Header, marker names and thread table - built when the trace is frozen */
+#define DUMP_HEAD_MAX_SIZE  (sizeof(app_trace_header_t) + \
+                             APP_TRACE_MARKER_COUNT * APP_TRACE_MARKER_NAME_LEN + \
+                             APP_TRACE_MAX_THREADS * sizeof(app_trace_thread_t))
+
+static uint8_t dump_head[DUMP_HEAD_MAX_SIZE];
+static uint16_t dump_head_size;
+
+#endif /* CONFIG_APP_TRACE */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+#if defined(CONFIG_APP_TRACE)
+
+static void thread_cb(const struct k_thread *thread, void *user_data)
+{
+    app_trace_header_t *header = user_data;
+    app_trace_thread_t *entry;
+
+    if (header->thread_count >= APP_TRACE_MAX_THREADS) {
+        return;
+    }
+
+    entry = (app_trace_thread_t *)&dump_head[dump_head_size];
+    memset(entry, 0, sizeof(*entry));
+    entry->id = (uint32_t)(uintptr_t)thread;
+    strncpy(entry->name, k_thread_name_get((k_tid_t)thread) ?: "", sizeof(entry->name) - 1);
+
+    dump_head_size += sizeof(*entry);
+    header->thread_count++;
+}
+
+/**
+ * @brief Build the dump header for the records in the ring
+ *
+ * Called with the ring frozen, so the counts cannot change.
+ */
+static void build_dump_head(void)
+{
+    app_trace_header_t header = {
+        .magic = APP_TRACE_DUMP_MAGIC,
+        .version = APP_TRACE_DUMP_VERSION,
+        .marker_count = APP_TRACE_MARKER_COUNT,
+        .record_size = sizeof(app_trace_record_t),
+        .timer_freq_hz = sys_clock_hw_cycles_per_sec(),
+        .record_count = MIN(ring_head, CONFIG_APP_TRACE_RECORDS),
+    };
+
+    header.dropped = ring_head - header.record_count + frozen_dropped;
+
+    dump_head_size = sizeof(header);
+    for (int i = 0; i < APP_TRACE_MARKER_COUNT; i++) {
+        char *name = (char *)&dump_head[dump_head_size];
+
+        strncpy(name, markers[i].name, APP_TRACE_MARKER_NAME_LEN - 1);
+        name[APP_TRACE_MARKER_NAME_LEN - 1] = '\0';
+        dump_head_size += APP_TRACE_MARKER_NAME_LEN;
+    }
+    k_thread_foreach_unlocked(thread_cb, &header);
+
+    memcpy(dump_head, &header, sizeof(header));
+}
+
+/**
+ * @brief Copy the part of one dump section that overlaps the request
+ * @return Bytes copied
+ */
+static uint16_t copy_section(uint8_t *dest, uint32_t offset, uint16_t len,
+                             uint32_t section_start, const void *section, uint32_t section_size)
+{
+    uint32_t start = MAX(offset, section_start);
+    uint32_t end = MIN(offset + len, section_start + section_size);
+
+    if (start >= end) {
+        return 0;
+    }
+    memcpy(&dest[start - offset], (const uint8_t *)section + (start - section_start), end - start);
+    return end - start;
+}
+
+#endif /* CONFIG_APP_TRACE */
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+#if defined(CONFIG_APP_TRACE) || defined(CONFIG_TRACING_CTF)
+
+void app_trace_record(uint8_t marker, uint8_t phase, uint32_t arg0, uint32_t arg1)
+{
+#if defined(CONFIG_TRACING_CTF)
+    sys_trace_named_event(markers[marker].ctf[phase], arg0, arg1);
+#endif
+
+#if defined(CONFIG_APP_TRACE)
+    uint32_t timestamp = k_cycle_get_32();
+    uint32_t thread = k_is_in_isr() ? 0 : (uint32_t)(uintptr_t)k_current_get();
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+
+    if (frozen) {
+        frozen_dropped++;
+    } else {
+        app_trace_record_t *record = &ring[ring_head++ % CONFIG_APP_TRACE_RECORDS];
+
+        record->timestamp = timestamp;
+        record->thread = thread;
+        record->marker = marker;
+        record->phase = phase;
+        record->reserved = 0;
+        record->arg0 = arg0;
+        record->arg1 = arg1;
+    }
+    k_spin_unlock(&ring_lock, key);
+#endif
+}
+
+#endif /* CONFIG_APP_TRACE || CONFIG_TRACING_CTF */
+
+#if defined(CONFIG_APP_TRACE)
+
+void app_trace_freeze(bool freeze)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+    frozen = freeze;
+    k_spin_unlock(&ring_lock, key);
+
+    if (freeze) {
+        build_dump_head();
+    }
+}
+
+bool app_trace_is_frozen(void)
+{
+    return frozen;
+}
+
+void app_trace_clear(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+    ring_head = 0;
+    frozen_dropped = 0;
+    k_spin_unlock(&ring_lock, key);
+
+    if (frozen) {
+        build_dump_head();
+    }
+}
+
+uint32_t app_trace_dump_size(void)
+{
+    if (!frozen) {
+        return 0;
+    }
+    return dump_head_size + MIN(ring_head, CONFIG_APP_TRACE_RECORDS) * sizeof(app_trace_record_t);
+}
+
+int app_trace_dump_read(uint32_t offset, void *buf, uint16_t len)
+{
+    if (!frozen) {
+        return -EBUSY;
+    }
+
+    uint32_t count = MIN(ring_head, CONFIG_APP_TRACE_RECORDS);
+    uint32_t oldest = (ring_head - count) % CONFIG_APP_TRACE_RECORDS;
+    uint32_t first_part = MIN(count, CONFIG_APP_TRACE_RECORDS - oldest) * sizeof(app_trace_record_t);
+    uint32_t second_part = count * sizeof(app_trace_record_t) - first_part;
+    uint32_t total = dump_head_size + first_part + second_part;
+    uint16_t copied = 0;
+
+    if (offset >= total) {
+        return 0;
+    }
+    len = MIN(len, total - offset);
+
+    /* Oldest record first: from the write position to the end of the ring, then the start */
+    copied += copy_section(buf, offset, len, 0, dump_head, dump_head_size);
+    copied += copy_section(buf, offset, len, dump_head_size, &ring[oldest], first_part);
+    copied += copy_section(buf, offset, len, dump_head_size + first_part, ring, second_part);
+
+    return copied;
+}
+
+#else
+
+void app_trace_freeze(bool freeze)
+{
+    ARG_UNUSED(freeze);
+}
+
+bool app_trace_is_frozen(void)
+{
+    return false;
+}
+
+void app_trace_clear(void)
+{
+}
+
+uint32_t app_trace_dump_size(void)
+{
+    return 0;
+}
+
+int app_trace_dump_read(uint32_t offset, void *buf, uint16_t len)
+{
+    return -ENOTSUP;
+}
+
+#endif /* CONFIG_APP_TRACE */
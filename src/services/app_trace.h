@@ -0,0 +1,178 @@
+#ifndef APP_TRACE_H
+#define APP_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file app_trace.h
+ * @brief Trace markers on the service hot paths
+ *
+ * Markers bracket the GATT handler wrappers, message queue hand-offs,
+ * the wasm3 parse/load/compile/call phases and notification submission. With CONFIG_APP_TRACE each marker is stored in a RAM ring
+ * of fixed-size records that a client downloads page by page through the
+ * Control Service trace characteristic. With CONFIG_TRACING_CTF the same
+ * markers are also emitted as Zephyr named events, so on native_sim they
+ * land in the CTF file of the POSIX tracing backend. tests/trace_tool.py
+ * turns either into a Perfetto / Chrome JSON trace or a CTF trace for
+ * babeltrace.
+ *
+ * Without either option the marker macros compile to nothing.
+ */
+
+/* ============================================================================
+ * MARKERS
+ * ============================================================================ */
+
+/* Marker IDs - names are in app_trace.c and in the trace dump */
+#define APP_TRACE_GATT_WRITE        0       /* arg0: handler, arg1: length / result */
+#define APP_TRACE_GATT_READ         1       /* arg0: handler, arg1: offset / result */
+#define APP_TRACE_MSGQ_PUT          2       /* arg0: queue, arg1: messages queued */
+#define APP_TRACE_MSGQ_GET          3       /* arg0: queue, arg1: messages queued */
+#define APP_TRACE_WASM_PARSE        4       /* arg0: module size, arg1: 0 / error */
+#define APP_TRACE_WASM_LOAD         5
+#define APP_TRACE_WASM_COMPILE      6
+#define APP_TRACE_WASM_CALL         7       /* arg0: argument count, arg1: 0 / error */
+#define APP_TRACE_FLASH_WRITE       8       /* Reserved for DFU image writes; the mock DFU has none */
+#define APP_TRACE_NOTIFY            9       /* arg0: attribute handle, arg1: length / result */
+#define APP_TRACE_MARKER_COUNT      10
+
+#define APP_TRACE_MARKER_NAME_LEN   16      /* Marker names in the dump, NUL terminated */
+#define APP_TRACE_THREAD_NAME_LEN   16      /* Thread names in the dump, NUL terminated */
+#define APP_TRACE_MAX_THREADS       16      /* Threads listed in the dump */
+
+/* Record phases */
+#define APP_TRACE_PHASE_BEGIN       0
+#define APP_TRACE_PHASE_END         1
+#define APP_TRACE_PHASE_INSTANT     2
+
+/* ============================================================================
+ * TRACE DUMP
+ * ============================================================================ */
+
+#define APP_TRACE_DUMP_MAGIC        0x43525441  /* "ATRC" */
+#define APP_TRACE_DUMP_VERSION      1
+
+/**
+ * @brief Trace dump header
+ *
+ * The dump is the header, marker_count marker names of
+ * APP_TRACE_MARKER_NAME_LEN bytes, thread_count app_trace_thread_t and
+ * record_count app_trace_record_t, oldest record first.
+ * Total size: 20 bytes
+ */
+typedef struct {
+    uint32_t magic;              ///< APP_TRACE_DUMP_MAGIC
+    uint8_t version;             ///< APP_TRACE_DUMP_VERSION
+    uint8_t marker_count;        ///< Marker names that follow
+    uint8_t thread_count;        ///< Thread entries that follow the names
+    uint8_t record_size;         ///< sizeof(app_trace_record_t)
+    uint32_t timer_freq_hz;      ///< Frequency of the record timestamps
+    uint32_t record_count;       ///< Records in the dump
+    uint32_t dropped;            ///< Records overwritten or lost while frozen
+} __attribute__((packed)) app_trace_header_t;
+
+/**
+ * @brief Thread that existed when the trace was frozen
+ * Total size: 20 bytes
+ */
+typedef struct {
+    uint32_t id;                 ///< Thread ID as stored in the records
+    char name[APP_TRACE_THREAD_NAME_LEN]; ///< Thread name, truncated, NUL terminated
+} __attribute__((packed)) app_trace_thread_t;
+
+/**
+ * @brief One trace record
+ *
+ * Timestamps are k_cycle_get_32() and wrap; records are in order, so a
+ * reader unwraps them by adding 2^32 whenever one goes backwards.
+ * Total size: 20 bytes
+ */
+typedef struct {
+    uint32_t timestamp;          ///< Cycle counter at the marker
+    uint32_t thread;             ///< Thread that hit the marker, 0 in an ISR
+    uint8_t marker;              ///< APP_TRACE_* marker ID
+    uint8_t phase;               ///< APP_TRACE_PHASE_*
+    uint16_t reserved;           ///< Reserved for future use
+    uint32_t arg0;               ///< Marker specific
+    uint32_t arg1;               ///< Marker specific
+} __attribute__((packed)) app_trace_record_t;
+
+/* ============================================================================
+ * MARKER MACROS
+ * ============================================================================ */
+
+#if defined(CONFIG_APP_TRACE) || defined(CONFIG_TRACING_CTF)
+
+/**
+ * @brief Record one marker (used by the APP_TRACE_* macros)
+ * @param marker APP_TRACE_* marker ID
+ * @param phase APP_TRACE_PHASE_*
+ * @param arg0 Marker specific
+ * @param arg1 Marker specific
+ */
+void app_trace_record(uint8_t marker, uint8_t phase, uint32_t arg0, uint32_t arg1);
+
+#define APP_TRACE_BEGIN(marker, arg0, arg1) \
+    app_trace_record(marker, APP_TRACE_PHASE_BEGIN, (uint32_t)(uintptr_t)(arg0), (uint32_t)(arg1))
+#define APP_TRACE_END(marker, arg0, arg1) \
+    app_trace_record(marker, APP_TRACE_PHASE_END, (uint32_t)(uintptr_t)(arg0), (uint32_t)(arg1))
+#define APP_TRACE_INSTANT(marker, arg0, arg1) \
+    app_trace_record(marker, APP_TRACE_PHASE_INSTANT, (uint32_t)(uintptr_t)(arg0), (uint32_t)(arg1))
+
+#else
+
+#define APP_TRACE_BEGIN(marker, arg0, arg1)     do { } while (0)
+#define APP_TRACE_END(marker, arg0, arg1)       do { } while (0)
+#define APP_TRACE_INSTANT(marker, arg0, arg1)   do { } while (0)
+
+#endif /* CONFIG_APP_TRACE || CONFIG_TRACING_CTF */
+
+/* Message queue hand-off, after a successful k_msgq_put() / k_msgq_get() */
+#define APP_TRACE_MSGQ_PUT_DONE(queue) \
+    APP_TRACE_INSTANT(APP_TRACE_MSGQ_PUT, queue, k_msgq_num_used_get(queue))
+#define APP_TRACE_MSGQ_GET_DONE(queue) \
+    APP_TRACE_INSTANT(APP_TRACE_MSGQ_GET, queue, k_msgq_num_used_get(queue))
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Stop or resume recording
+ *
+ * Freezing takes a snapshot of the thread names so the dump can be read
+ * while nothing is written to the ring. Markers hit while frozen are
+ * counted as dropped.
+ *
+ * @param freeze True to stop recording, false to resume
+ */
+void app_trace_freeze(bool freeze);
+
+/**
+ * @brief Check whether recording is stopped
+ */
+bool app_trace_is_frozen(void);
+
+/**
+ * @brief Empty the ring and reset the dropped count
+ */
+void app_trace_clear(void);
+
+/**
+ * @brief Size of the trace dump
+ * @return Bytes in the dump, 0 unless frozen or without CONFIG_APP_TRACE
+ */
+uint32_t app_trace_dump_size(void);
+
+/**
+ * @brief Copy part of the trace dump
+ * @param offset Offset into the dump
+ * @param buf Destination
+ * @param len Bytes wanted
+ * @return Bytes copied, less than len at the end of the dump, -EBUSY
+ *         unless frozen, -ENOTSUP without CONFIG_APP_TRACE
+ */
+int app_trace_dump_read(uint32_t offset, void *buf, uint16_t len);
+
+#endif /* APP_TRACE_H */
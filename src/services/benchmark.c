@@ -0,0 +1,225 @@
+#include "benchmark.h"
+#include "sprite_service.h"
+#include "wasm_service.h"
+#include "data_service.h"
+#include <zephyr/kernel.h>
+#include <zephyr/timing/timing.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+/**
+ * @file benchmark.c
+ * @brief On-device microbenchmark suite implementation
+ */
+
+LOG_MODULE_REGISTER(benchmark, CONFIG_BENCHMARK_LOG_LEVEL);
+
+/* ============================================================================
+ * CONFIGURATION
+ * ============================================================================ */
+
+#define BENCHMARK_BUFFER_SIZE       4096    /* CRC input is this buffer, repeated */
+#define BENCHMARK_MEMCPY_CHUNK      (BENCHMARK_BUFFER_SIZE / 2)
+#define BENCHMARK_MEMCPY_ROUNDS     16
+#define BENCHMARK_SPRITE_COUNT      SPRITE_MAX_COUNT
+#define BENCHMARK_WASM_CALLS        1000
+#define BENCHMARK_NOTIFY_COUNT      4       /* Stay well below the ACL TX buffer count */
+#define BENCHMARK_HANDLER_PACKETS   32
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+static uint8_t benchmark_buffer[BENCHMARK_BUFFER_SIZE] __aligned(4);
+static bool timing_ready = false;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint32_t cycles_since(timing_t *start)
+{
+    timing_t end = timing_counter_get();
+    uint64_t cycles = timing_cycles_get(start, &end);
+
+    return (cycles > UINT32_MAX) ? UINT32_MAX : (uint32_t)cycles;
+}
+
+static void fill_pattern(uint8_t *data, size_t len, uint32_t seed)
+{
+    /* xorshift32 - deterministic, so every run hashes the same input */
+    uint32_t x = seed ? seed : 0x12345678;
+
+    for (size_t i = 0; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (uint8_t)x;
+    }
+}
+
+static void bench_crc16(uint8_t crc_kb, control_benchmark_result_t *result)
+{
+    volatile uint16_t crc = 0;
+    uint32_t remaining = crc_kb * 1024;
+
+    timing_t start = timing_counter_get();
+    while (remaining > 0) {
+        uint16_t chunk = MIN(remaining, BENCHMARK_BUFFER_SIZE);
+        crc ^= sprite_service_calculate_crc16(benchmark_buffer, chunk);
+        remaining -= chunk;
+    }
+    result->crc16_cycles = cycles_since(&start);
+}
+
+static void bench_sprites(control_benchmark_result_t *result)
+{
+    /* Only runs on an empty registry, and uploads are rejected until the
+     * release, so a client's sprites are never touched */
+    int err = sprite_service_reserve_empty();
+    if (err) {
+        LOG_WRN("Sprite registry not available (err %d), skipping sprite test", err);
+        result->skipped |= CONTROL_BENCHMARK_SKIP_SPRITE;
+        return;
+    }
+
+    static uint16_t crcs[BENCHMARK_SPRITE_COUNT];
+    for (uint16_t id = 0; id < BENCHMARK_SPRITE_COUNT; id++) {
+        crcs[id] = sprite_service_calculate_crc16(&benchmark_buffer[id % 64], SPRITE_DATA_SIZE);
+    }
+
+    timing_t start = timing_counter_get();
+    for (uint16_t id = 0; id < BENCHMARK_SPRITE_COUNT; id++) {
+        sprite_service_store_sprite(id, &benchmark_buffer[id % 64], crcs[id]);
+    }
+    result->sprite_store_cycles = cycles_since(&start);
+
+    volatile uint16_t found = 0;
+    start = timing_counter_get();
+    for (uint16_t id = 0; id < BENCHMARK_SPRITE_COUNT; id++) {
+        found += sprite_service_sprite_exists(id);
+    }
+    result->sprite_lookup_cycles = cycles_since(&start);
+
+    if (found != BENCHMARK_SPRITE_COUNT) {
+        LOG_WRN("Sprite lookup found %d of %d", found, BENCHMARK_SPRITE_COUNT);
+    }
+
+    sprite_service_release();
+}
+
+static void bench_wasm_call(control_benchmark_result_t *result)
+{
+    uint32_t cycles = 0;
+
+    int err = wasm_service_benchmark_call(BENCHMARK_WASM_CALLS, &cycles);
+    if (err) {
+        LOG_ERR("WASM call test failed (err %d)", err);
+        result->skipped |= CONTROL_BENCHMARK_SKIP_WASM;
+        return;
+    }
+
+    result->wasm_call_cycles = cycles;
+}
+
+static void bench_memcpy(control_benchmark_result_t *result)
+{
+    uint8_t *src = benchmark_buffer;
+    uint8_t *dst = benchmark_buffer + BENCHMARK_MEMCPY_CHUNK;
+
+    timing_t start = timing_counter_get();
+    for (int i = 0; i < BENCHMARK_MEMCPY_ROUNDS; i++) {
+        memcpy(dst, src, BENCHMARK_MEMCPY_CHUNK);
+        /* Keep the compiler from merging the copies */
+        __asm__ volatile("" ::: "memory");
+    }
+    result->memcpy_cycles = cycles_since(&start);
+    result->memcpy_bytes = BENCHMARK_MEMCPY_CHUNK * BENCHMARK_MEMCPY_ROUNDS;
+}
+
+static void bench_handler(control_benchmark_result_t *result)
+{
+    uint32_t cycles = 0;
+
+    int err = data_service_benchmark_upload(BENCHMARK_HANDLER_PACKETS, &cycles);
+    if (err) {
+        LOG_ERR("Handler test failed (err %d)", err);
+        return;
+    }
+
+    result->handler_cycles = cycles;
+}
+
+static void bench_notify(benchmark_notify_fn_t notify, control_benchmark_result_t *result)
+{
+    uint64_t total = 0;
+
+    if (!notify) {
+        result->skipped |= CONTROL_BENCHMARK_SKIP_NOTIFY;
+        return;
+    }
+
+    /* The payload is the in-progress result, so subscribers can ignore it */
+    for (int i = 0; i < BENCHMARK_NOTIFY_COUNT; i++) {
+        timing_t start = timing_counter_get();
+        int err = notify(result, sizeof(*result));
+        total += cycles_since(&start);
+
+        if (err) {
+            result->skipped |= CONTROL_BENCHMARK_SKIP_NOTIFY;
+            return;
+        }
+    }
+
+    result->notify_cycles = (uint32_t)(total / BENCHMARK_NOTIFY_COUNT);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int benchmark_run(uint8_t crc_kb, benchmark_notify_fn_t notify,
+                  control_benchmark_result_t *result)
+{
+    if (!result || crc_kb == 0 || crc_kb > CONTROL_BENCHMARK_CRC_KB_MAX) {
+        return -EINVAL;
+    }
+
+    if (!timing_ready) {
+        timing_init();
+        timing_ready = true;
+    }
+
+    LOG_INF("Running suite (CRC16 over %d KB)", crc_kb);
+
+    result->skipped = 0;
+    result->crc_kb = crc_kb;
+    result->timer_freq_hz = (uint32_t)timing_freq_get();
+    result->crc16_cycles = 0;
+    result->sprite_store_cycles = 0;
+    result->sprite_lookup_cycles = 0;
+    result->wasm_call_cycles = 0;
+    result->memcpy_cycles = 0;
+    result->memcpy_bytes = 0;
+    result->notify_cycles = 0;
+    result->handler_cycles = 0;
+
+    fill_pattern(benchmark_buffer, sizeof(benchmark_buffer), 0);
+
+    timing_start();
+    bench_crc16(crc_kb, result);
+    bench_sprites(result);
+    bench_wasm_call(result);
+    bench_memcpy(result);
+    bench_handler(result);
+    bench_notify(notify, result);
+    timing_stop();
+
+    LOG_INF("Done (crc16 %u, sprite store %u, lookup %u, wasm call %u, "
+            "memcpy %u, notify %u, handler %u cycles, skipped 0x%02x)",
+            result->crc16_cycles, result->sprite_store_cycles, result->sprite_lookup_cycles,
+            result->wasm_call_cycles, result->memcpy_cycles, result->notify_cycles,
+            result->handler_cycles, result->skipped);
+
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "control_service.h"
+#include <stdint.h>
+
+/**
+ * @file benchmark.h
+ * @brief On-device microbenchmark suite
+ *
+ * Runs a fixed set of cycle-counted microbenchmarks (CRC16, sprite
+ * registry, WASM call overhead, memcpy, notification enqueue) so every
+ * firmware build can be checked for performance regressions on hardware.
+ */
+
+/**
+ * @brief Notification hook used by the enqueue-cost test
+ *
+ * Should queue one notification carrying data and return the result of
+ * bt_gatt_notify(), or a negative error code if nobody is subscribed.
+ */
+typedef int (*benchmark_notify_fn_t)(const void *data, uint16_t len);
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Run the benchmark suite
+ *
+ * Blocks until every test has run; call it from a work item, never from a
+ * BLE callback. Tests that cannot run are flagged in result->skipped.
+ *
+ * @param crc_kb CRC16 input size in KB (1 to CONTROL_BENCHMARK_CRC_KB_MAX)
+ * @param notify Notification hook for the enqueue-cost test
+ * @param result Result to fill in; status and run_id are left to the caller
+ * @return 0 on success, negative error code on failure
+ */
+int benchmark_run(uint8_t crc_kb, benchmark_notify_fn_t notify,
+                  control_benchmark_result_t *result);
+
+#endif /* BENCHMARK_H */
@@ -1,8 +1,16 @@
 #ifndef BLE_PACKET_HANDLERS_H
 #define BLE_PACKET_HANDLERS_H
 
+#include "app_trace.h"
+#include "ble_services.h"
+#include "compact_codec.h"
+#include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/gatt.h>
-#include <zephyr/sys/printk.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/iterable_sections.h>
+#include <string.h>
 
 /**
  * @file ble_packet_handlers.h
@@ -12,6 +20,115 @@
  * type safety by automatically generating wrapper functions.
  */
 
+/* ============================================================================
+ * HANDLER STATISTICS
+ * ============================================================================ */
+
+#define BLE_HANDLER_STATS_BUCKETS       8       /* Cycle histogram buckets */
+#define BLE_HANDLER_STATS_BUCKET0_CYCLES 256    /* Bucket n ends at 256 * 4^n cycles */
+
+/**
+ * @brief Statistics of one characteristic handler
+ *
+ * Every wrapper generated by the BLE_*_WRAPPER macros below owns one,
+ * allocated in an iterable section, and records each ATT request it
+ * serves: calls, payload bytes, error returns (including requests the
+ * wrapper rejects before the handler runs) and a histogram of the cycles
+ * spent in the wrapper. Compiled out unless CONFIG_BLE_HANDLER_STATS is
+ * set. Only the BT RX thread updates it.
+ */
+struct ble_handler_stats {
+    const char *name;                   /* Handler function name */
+    uint32_t calls;
+    uint32_t bytes;                     /* Written or read payload bytes */
+    uint32_t errors;                    /* ATT error returns */
+    uint32_t max_cycles;
+    uint32_t hist[BLE_HANDLER_STATS_BUCKETS];
+};
+
+#if defined(CONFIG_BLE_HANDLER_STATS)
+
+#include <zephyr/timing/timing.h>
+
+/**
+ * @brief Record one call (used by the wrapper macros)
+ * @param stats Statistics of the handler
+ * @param start Cycle counter when the request came in
+ * @param result Value returned to the ATT layer
+ * @param bytes Payload bytes, counted only if result is not an error
+ */
+void ble_handler_stats_record(struct ble_handler_stats *stats, timing_t *start,
+                              ssize_t result, uint16_t bytes);
+
+#define _BLE_STATS_DEFINE(handler_name) \
+    static STRUCT_SECTION_ITERABLE(ble_handler_stats, handler_name##_stats) = { \
+        .name = #handler_name, \
+    };
+#define _BLE_STATS_START(start) \
+    timing_t start = timing_counter_get()
+#define _BLE_STATS_RECORD(handler_name, start, result, bytes) \
+    ble_handler_stats_record(&handler_name##_stats, &start, result, bytes)
+
+#else
+
+#define _BLE_STATS_DEFINE(handler_name)
+#define _BLE_STATS_START(start)                                 do { } while (0)
+#define _BLE_STATS_RECORD(handler_name, start, result, bytes)   do { } while (0)
+
+#endif /* CONFIG_BLE_HANDLER_STATS */
+
+#if defined(CONFIG_BLE_HANDLER_STATS) || defined(CONFIG_APP_TRACE) || defined(CONFIG_TRACING_CTF)
+
+/* Open a write wrapper definition; the body that follows is timed and traced */
+#define _BLE_WRITE_FUNCTION(handler_name) \
+    static ssize_t handler_name##_ble_impl(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
+                                           const void *buf, uint16_t len, uint16_t offset, \
+                                           uint8_t flags); \
+    _BLE_STATS_DEFINE(handler_name) \
+    static ssize_t handler_name##_ble(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
+                                      const void *buf, uint16_t len, uint16_t offset, uint8_t flags) \
+    { \
+        APP_TRACE_BEGIN(APP_TRACE_GATT_WRITE, handler_name##_ble_impl, len); \
+        _BLE_STATS_START(start); \
+        ssize_t result = handler_name##_ble_impl(conn, attr, buf, len, offset, flags); \
+        _BLE_STATS_RECORD(handler_name, start, result, len); \
+        APP_TRACE_END(APP_TRACE_GATT_WRITE, handler_name##_ble_impl, result); \
+        return result; \
+    } \
+    static ssize_t handler_name##_ble_impl(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
+                                           const void *buf, uint16_t len, uint16_t offset, \
+                                           uint8_t flags)
+
+/* Open a read wrapper definition; the body that follows is timed and traced */
+#define _BLE_READ_FUNCTION(handler_name) \
+    static ssize_t handler_name##_ble_impl(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
+                                           void *buf, uint16_t len, uint16_t offset); \
+    _BLE_STATS_DEFINE(handler_name) \
+    static ssize_t handler_name##_ble(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
+                                      void *buf, uint16_t len, uint16_t offset) \
+    { \
+        APP_TRACE_BEGIN(APP_TRACE_GATT_READ, handler_name##_ble_impl, offset); \
+        _BLE_STATS_START(start); \
+        ssize_t result = handler_name##_ble_impl(conn, attr, buf, len, offset); \
+        _BLE_STATS_RECORD(handler_name, start, result, result); \
+        APP_TRACE_END(APP_TRACE_GATT_READ, handler_name##_ble_impl, result); \
+        return result; \
+    } \
+    static ssize_t handler_name##_ble_impl(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
+                                           void *buf, uint16_t len, uint16_t offset)
+
+#else
+
+#define _BLE_WRITE_FUNCTION(handler_name) \
+    static ssize_t handler_name##_ble(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
+                                      const void *buf, uint16_t len, uint16_t offset, uint8_t flags)
+
+#define _BLE_READ_FUNCTION(handler_name) \
+    static ssize_t handler_name##_ble(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
+                                      void *buf, uint16_t len, uint16_t offset)
+
+#endif /* CONFIG_BLE_HANDLER_STATS || CONFIG_APP_TRACE || CONFIG_TRACING_CTF */
+
 /* ============================================================================
  * TYPED CHARACTERISTIC MACRO
  * ============================================================================ */
@@ -44,7 +161,7 @@
                              uint16_t offset, uint8_t flags) \
     { \
         if (len < sizeof(write_type)) { \
-            printk(#write_func ": Packet too small (%d < %zu)\n", len, sizeof(write_type)); \
+            LOG_WRN(#write_func ": Packet too small (%d < %zu)", len, sizeof(write_type)); \
             return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN); \
         } \
         const write_type *packet = (const write_type *)buf; \
@@ -70,28 +187,25 @@
 
 /* Generate a BLE write wrapper for a clean handler function */
 #define BLE_WRITE_WRAPPER(handler_name, struct_type) \
-    static ssize_t handler_name##_ble(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
-                                      const void *buf, uint16_t len, uint16_t offset, uint8_t flags) \
+    _BLE_WRITE_FUNCTION(handler_name) \
     { \
         if (len < sizeof(struct_type)) { \
-            printk(#handler_name ": Packet too small (%d < %zu)\n", len, sizeof(struct_type)); \
+            LOG_WRN(#handler_name ": Packet too small (%d < %zu)", len, sizeof(struct_type)); \
             return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN); \
         } \
         const struct_type *packet = (const struct_type *)buf; \
         return handler_name(packet); \
     }
 
-/* Generate a BLE write wrapper for variable-length data */
-#define BLE_WRITE_WRAPPER_VARIABLE(handler_name, min_size, max_size) \
-    static ssize_t handler_name##_ble(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
-                                      const void *buf, uint16_t len, uint16_t offset, uint8_t flags) \
+/* Generate a BLE write wrapper for variable-length data. validator is the
+ * generated <prefix>_validate() of the packet type; it checks the limits
+ * and any length or count field against len, which generate_ble_protocol.py
+ * reads from min_size and max_size = sizeof(type). */
+#define BLE_WRITE_WRAPPER_VARIABLE(handler_name, min_size, max_size, validator) \
+    _BLE_WRITE_FUNCTION(handler_name) \
     { \
-        if (len < min_size) { \
-            printk(#handler_name ": Packet too small (%d < %d)\n", len, min_size); \
-            return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN); \
-        } \
-        if (len > max_size) { \
-            printk(#handler_name ": Packet too large (%d > %d)\n", len, max_size); \
+        if (validator(buf, len) != 0) { \
+            LOG_WRN(#handler_name ": Bad packet length %d (%d..%d)", len, (int)(min_size), (int)(max_size)); \
             return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN); \
         } \
         return handler_name(buf, len); \
@@ -99,8 +213,7 @@
 
 /* Generate a BLE read wrapper for a clean handler function */
 #define BLE_READ_WRAPPER(handler_name, struct_type) \
-    static ssize_t handler_name##_ble(struct bt_conn *conn, const struct bt_gatt_attr *attr, \
-                                      void *buf, uint16_t len, uint16_t offset) \
+    _BLE_READ_FUNCTION(handler_name) \
     { \
         struct_type response; \
         memset(&response, 0, sizeof(response)); \
@@ -109,6 +222,251 @@
         return bt_gatt_attr_read(conn, attr, buf, len, offset, &response, result); \
     }
 
+/* ============================================================================
+ * PER-CONNECTION CONTEXT HANDLERS
+ * ============================================================================ */
+
+/**
+ * @brief Define a per-connection context array and its lookup function
+ *
+ * Creates array_name[CONFIG_BT_MAX_CONN] indexed by bt_conn_index() and
+ * array_name_get(conn), which returns NULL for a NULL or unknown connection.
+ */
+#define BLE_CONN_CONTEXT_DEFINE(ctx_type, array_name) \
+    static ctx_type array_name[CONFIG_BT_MAX_CONN]; \
+    static inline ctx_type *array_name##_get(struct bt_conn *conn) \
+    { \
+        if (!conn) { \
+            return NULL; \
+        } \
+        uint8_t index = bt_conn_index(conn); \
+        return (index < CONFIG_BT_MAX_CONN) ? &array_name[index] : NULL; \
+    }
+
+/* Resolve the connection context or fail the ATT request */
+#define _BLE_CTX_LOOKUP(handler_name, ctx_lookup) \
+    __typeof__(ctx_lookup(conn)) ctx = ctx_lookup(conn); \
+    if (!ctx) { \
+        LOG_WRN(#handler_name ": No context for connection"); \
+        return BT_GATT_ERR(BT_ATT_ERR_UNLIKELY); \
+    }
+
+/* Generate a BLE write wrapper that also passes the connection context */
+#define BLE_WRITE_WRAPPER_CTX(handler_name, struct_type, ctx_lookup) \
+    _BLE_WRITE_FUNCTION(handler_name) \
+    { \
+        if (len < sizeof(struct_type)) { \
+            LOG_WRN(#handler_name ": Packet too small (%d < %zu)", len, sizeof(struct_type)); \
+            return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN); \
+        } \
+        _BLE_CTX_LOOKUP(handler_name, ctx_lookup) \
+        const struct_type *packet = (const struct_type *)buf; \
+        return handler_name(ctx, packet); \
+    }
+
+/* Generate a variable-length BLE write wrapper that also passes the connection context */
+#define BLE_WRITE_WRAPPER_VARIABLE_CTX(handler_name, min_size, max_size, validator, ctx_lookup) \
+    _BLE_WRITE_FUNCTION(handler_name) \
+    { \
+        if (validator(buf, len) != 0) { \
+            LOG_WRN(#handler_name ": Bad packet length %d (%d..%d)", len, (int)(min_size), (int)(max_size)); \
+            return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN); \
+        } \
+        _BLE_CTX_LOOKUP(handler_name, ctx_lookup) \
+        return handler_name(ctx, buf, len); \
+    }
+
+/* Generate a BLE write wrapper that also passes the connection context and
+ * accepts the compact encoding on connections that negotiated it. decoder
+ * is the generated <prefix>_decode() of struct_type; the handler sees the
+ * same struct either way. */
+#define BLE_WRITE_WRAPPER_COMPACT_CTX(handler_name, struct_type, decoder, ctx_lookup) \
+    _BLE_WRITE_FUNCTION(handler_name) \
+    { \
+        if (ble_services_get_encoding(conn) == COMPACT_ENCODING_LEGACY) { \
+            if (len < sizeof(struct_type)) { \
+                LOG_WRN(#handler_name ": Packet too small (%d < %zu)", len, sizeof(struct_type)); \
+                return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN); \
+            } \
+            _BLE_CTX_LOOKUP(handler_name, ctx_lookup) \
+            return handler_name(ctx, (const struct_type *)buf); \
+        } \
+        _BLE_CTX_LOOKUP(handler_name, ctx_lookup) \
+        struct_type packet; \
+        memset(&packet, 0, sizeof(packet)); \
+        int err = decoder(buf, len, &packet); \
+        if (err) { \
+            LOG_WRN(#handler_name ": Malformed compact packet (err %d)", err); \
+            return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED); \
+        } \
+        /* The ATT layer expects the written length back */ \
+        ssize_t result = handler_name(ctx, &packet); \
+        return result < 0 ? result : len; \
+    }
+
+/* Generate a BLE read wrapper that also passes the connection context */
+#define BLE_READ_WRAPPER_CTX(handler_name, struct_type, ctx_lookup) \
+    _BLE_READ_FUNCTION(handler_name) \
+    { \
+        _BLE_CTX_LOOKUP(handler_name, ctx_lookup) \
+        struct_type response; \
+        memset(&response, 0, sizeof(response)); \
+        ssize_t result = handler_name(ctx, &response); \
+        if (result < 0) return result; \
+        return bt_gatt_attr_read(conn, attr, buf, len, offset, &response, result); \
+    }
+
+/* ============================================================================
+ * SNAPSHOT AND CACHED READ HANDLERS
+ * ============================================================================ */
+
+/**
+ * A value longer than the ATT MTU is read as a Read followed by Read Blob
+ * requests at increasing offsets. The plain read wrappers call the handler
+ * for every one of them, so a value that changes in between comes back
+ * torn. The wrappers below call the handler only at offset 0, keep the
+ * result per connection and serve the following offsets from that
+ * snapshot.
+ *
+ * BLE_READ_WRAPPER_CACHED() additionally lets the handler mark its value
+ * cacheable with ble_read_cache_keep(); later reads are then served from
+ * the cache without calling the handler until ble_read_cache_invalidate()
+ * is called or the value expires. Reads all run on the BT RX thread;
+ * invalidation may come from any context.
+ */
+typedef struct {
+    atomic_t generation;            /* Bumped by ble_read_cache_invalidate() */
+    uint32_t cached_generation;     /* Generation the cached value belongs to */
+    int64_t expires_ms;             /* Uptime the cached value expires at, 0 for never */
+    bool cached;                    /* A cached value is held */
+    bool keep;                      /* Set by the handler during the current call */
+    uint32_t keep_ms;               /* Lifetime requested by the handler */
+} ble_read_cache_t;
+
+/* Define the cache state of a BLE_READ_WRAPPER_CACHED() characteristic */
+#define BLE_READ_CACHE_DEFINE(cache_name) \
+    static ble_read_cache_t cache_name
+
+/**
+ * @brief Mark the value being returned as cacheable
+ *
+ * Call from the read handler.
+ *
+ * @param cache Cache of the characteristic
+ * @param max_age_ms Longest time the value stays valid, 0 until invalidated
+ */
+static inline void ble_read_cache_keep(ble_read_cache_t *cache, uint32_t max_age_ms)
+{
+    cache->keep = true;
+    cache->keep_ms = max_age_ms;
+}
+
+/**
+ * @brief Drop a cached value after the state behind it changed
+ * @param cache Cache of the characteristic
+ */
+static inline void ble_read_cache_invalidate(ble_read_cache_t *cache)
+{
+    atomic_inc(&cache->generation);
+}
+
+static inline bool _ble_read_cache_hit(ble_read_cache_t *cache)
+{
+    if (!cache->cached ||
+        cache->cached_generation != (uint32_t)atomic_get(&cache->generation) ||
+        (cache->expires_ms && k_uptime_get() >= cache->expires_ms)) {
+        cache->cached = false;
+        return false;
+    }
+    return true;
+}
+
+static inline uint32_t _ble_read_cache_begin(ble_read_cache_t *cache)
+{
+    cache->keep = false;
+    return (uint32_t)atomic_get(&cache->generation);
+}
+
+/* Cache the value only if nothing invalidated it while the handler ran */
+static inline bool _ble_read_cache_end(ble_read_cache_t *cache, uint32_t generation)
+{
+    if (!cache->keep || generation != (uint32_t)atomic_get(&cache->generation)) {
+        return false;
+    }
+    cache->cached = true;
+    cache->cached_generation = generation;
+    cache->expires_ms = cache->keep_ms ? k_uptime_get() + cache->keep_ms : 0;
+    return true;
+}
+
+/* Snapshot slot of the connection, or fail the ATT request */
+#define _BLE_SNAPSHOT_INDEX(handler_name) \
+    uint8_t index = conn ? bt_conn_index(conn) : CONFIG_BT_MAX_CONN; \
+    if (index >= CONFIG_BT_MAX_CONN) { \
+        LOG_WRN(#handler_name ": No snapshot for connection"); \
+        return BT_GATT_ERR(BT_ATT_ERR_UNLIKELY); \
+    }
+
+/* Generate a cached BLE read wrapper for a clean handler function */
+#define BLE_READ_WRAPPER_CACHED(handler_name, struct_type, cache) \
+    _BLE_READ_FUNCTION(handler_name) \
+    { \
+        static struct_type cached_value; \
+        static ssize_t cached_len; \
+        static struct_type snapshot[CONFIG_BT_MAX_CONN]; \
+        static ssize_t snapshot_len[CONFIG_BT_MAX_CONN]; \
+        static bt_addr_le_t snapshot_peer[CONFIG_BT_MAX_CONN]; \
+        _BLE_SNAPSHOT_INDEX(handler_name) \
+        /* A blob read from a peer that did not take this slot's snapshot \
+         * gets a fresh one rather than another peer's value */ \
+        if (offset == 0 || !bt_addr_le_eq(&snapshot_peer[index], bt_conn_get_dst(conn))) { \
+            bt_addr_le_copy(&snapshot_peer[index], bt_conn_get_dst(conn)); \
+            if (_ble_read_cache_hit(&(cache))) { \
+                if (offset == 0 && cached_len <= len) { \
+                    /* Fits in this response, no blob reads will follow */ \
+                    snapshot_len[index] = 0; \
+                    return bt_gatt_attr_read(conn, attr, buf, len, 0, &cached_value, cached_len); \
+                } \
+                snapshot[index] = cached_value; \
+                snapshot_len[index] = cached_len; \
+            } else { \
+                uint32_t generation = _ble_read_cache_begin(&(cache)); \
+                memset(&snapshot[index], 0, sizeof(struct_type)); \
+                ssize_t result = handler_name(&snapshot[index]); \
+                if (result < 0) return result; \
+                snapshot_len[index] = result; \
+                if (_ble_read_cache_end(&(cache), generation)) { \
+                    cached_value = snapshot[index]; \
+                    cached_len = result; \
+                } \
+            } \
+        } \
+        return bt_gatt_attr_read(conn, attr, buf, len, offset, &snapshot[index], snapshot_len[index]); \
+    }
+
+/* Generate a BLE read wrapper that passes the connection context and
+ * serves Read Blob offsets from a snapshot taken at offset 0 */
+#define BLE_READ_WRAPPER_SNAPSHOT_CTX(handler_name, struct_type, ctx_lookup) \
+    _BLE_READ_FUNCTION(handler_name) \
+    { \
+        static struct_type snapshot[CONFIG_BT_MAX_CONN]; \
+        static ssize_t snapshot_len[CONFIG_BT_MAX_CONN]; \
+        static bt_addr_le_t snapshot_peer[CONFIG_BT_MAX_CONN]; \
+        _BLE_SNAPSHOT_INDEX(handler_name) \
+        if (offset == 0) { \
+            _BLE_CTX_LOOKUP(handler_name, ctx_lookup) \
+            memset(&snapshot[index], 0, sizeof(struct_type)); \
+            ssize_t result = handler_name(ctx, &snapshot[index]); \
+            if (result < 0) return result; \
+            snapshot_len[index] = result; \
+            bt_addr_le_copy(&snapshot_peer[index], bt_conn_get_dst(conn)); \
+        } else if (!bt_addr_le_eq(&snapshot_peer[index], bt_conn_get_dst(conn))) { \
+            /* Blob read without a Read from this peer first */ \
+            return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET); \
+        } \
+        return bt_gatt_attr_read(conn, attr, buf, len, offset, &snapshot[index], snapshot_len[index]); \
+    }
+
 /* Declare clean handler function signatures */
 #define DECLARE_WRITE_HANDLER(handler_name, struct_type) \
     static ssize_t handler_name(const struct_type *packet)
@@ -0,0 +1,509 @@
+#ifndef BLE_PROTOCOL_GEN_H
+#define BLE_PROTOCOL_GEN_H
+
+/* Generated by generate_ble_protocol.py - do not edit. Regenerate after
+ * changing a packet struct, characteristic or wrapper macro. */
+
+#include "app_trace.h"
+#include "broadcast_service.h"
+#include "compact_codec.h"
+#include "control_service.h"
+#include "data_service.h"
+#include "device_info_service.h"
+#include "dfu_service.h"
+#include "sprite_service.h"
+#include "status_broadcast.h"
+#include "wasm_service.h"
+#include <zephyr/sys/util.h>
+#include <zephyr/toolchain.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file ble_protocol_gen.h
+ * @brief Packet layout checks and validators generated from the packet structs
+ *
+ * The asserts pin every size and offset the generated Python client
+ * encodes, so a struct edited without regenerating fails the build instead
+ * of silently changing the wire format.
+ */
+
+#define BLE_PROTOCOL_FINGERPRINT    0x4048F689u  /* CRC-32 of layouts and characteristics */
+
+/* ============================================================================
+ * LAYOUT
+ * ============================================================================ */
+
+BUILD_ASSERT(sizeof(app_trace_header_t) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_header_t, version) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_header_t, marker_count) == 5, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_header_t, thread_count) == 6, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_header_t, record_size) == 7, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_header_t, timer_freq_hz) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_header_t, record_count) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_header_t, dropped) == 16, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(app_trace_thread_t) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_thread_t, name) == 4, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(app_trace_record_t) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_record_t, thread) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_record_t, marker) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_record_t, phase) == 9, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_record_t, reserved) == 10, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_record_t, arg0) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(app_trace_record_t, arg1) == 16, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(broadcast_frame_packet_t) == 201, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(broadcast_frame_packet_t, payload) == 1, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(broadcast_frame_header_t) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(broadcast_frame_header_t, type) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(broadcast_frame_header_t, seq) == 2, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(broadcast_status_packet_t) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(broadcast_status_packet_t, queued) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(broadcast_status_packet_t, seq) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(broadcast_status_packet_t, frames_sent) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(broadcast_status_packet_t, frames_dropped) == 8, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_command_packet_t) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_command_packet_t, param1) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_command_packet_t, param2) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_command_packet_t, reserved) == 3, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_response_packet_t) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_response_packet_t, status) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_response_packet_t, result) == 2, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_status_packet_t) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_status_packet_t, uptime) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_status_packet_t, reserved) == 5, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_batch_record_t) == 3, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_batch_record_t, param1) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_batch_record_t, param2) == 2, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_batch_packet_t) == 92, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_batch_packet_t, count) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_batch_packet_t, records) == 2, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_batch_response_t) == 243, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_batch_response_t, count) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_batch_response_t, failed) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_batch_response_t, results) == 3, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_telemetry_thread_t) == 6, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_thread_t, stack_unused) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_thread_t, cpu_permille) == 4, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_telemetry_packet_t) == 48, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, cpu_load_permille) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, idle_permille) == 6, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, threads) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, wasm3_heap_size) == 26, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, wasm3_heap_used) == 30, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, bt_tx_bufs_total) == 34, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, bt_tx_bufs_free) == 35, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, bt_rx_bufs_total) == 36, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, bt_rx_bufs_free) == 37, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, thread_count) == 38, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, reserved) == 39, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_telemetry_packet_t, timestamp_us) == 40, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_benchmark_result_t) == 48, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, run_id) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, skipped) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, crc_kb) == 3, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, timer_freq_hz) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, crc16_cycles) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, sprite_store_cycles) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, sprite_lookup_cycles) == 16, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, wasm_call_cycles) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, memcpy_cycles) == 24, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, memcpy_bytes) == 28, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, notify_cycles) == 32, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, handler_cycles) == 36, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_benchmark_result_t, timestamp_us) == 40, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_time_sync_request_t) == 18, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_request_t, reserved) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_request_t, client_t1_us) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_request_t, prev_client_t4_us) == 10, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_time_sync_response_t) == 44, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, flags) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, sample_count) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, reserved) == 3, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, client_t1_us) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, device_t2_us) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, device_t3_us) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, offset_us) == 28, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, drift_ppb) == 36, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_time_sync_response_t, rtt_us) == 40, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_handler_stats_select_t) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_select_t, flags) == 1, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_handler_stats_entry_t) == 56, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_entry_t, calls) == 24, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_entry_t, bytes) == 28, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_entry_t, errors) == 32, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_entry_t, max_cycles) == 36, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_entry_t, hist) == 40, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_handler_stats_page_t) == 232, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_page_t, first) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_page_t, count) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_page_t, flags) == 3, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_page_t, timer_freq_hz) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_handler_stats_page_t, entries) == 8, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_trace_select_t) == 5, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_trace_select_t, flags) == 4, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_trace_page_t) == 244, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_trace_page_t, offset) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_trace_page_t, flags) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_trace_page_t, reserved) == 9, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_trace_page_t, data) == 12, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_memory_select_t) == 1, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_memory_client_t) == 24, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_client_t, quota) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_client_t, used) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_client_t, peak) == 16, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_client_t, failures) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_client_t, reserved) == 22, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(control_memory_packet_t) == 88, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_packet_t, used) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_packet_t, peak) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_packet_t, block_size) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_packet_t, count) == 14, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_packet_t, reserved) == 15, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(control_memory_packet_t, clients) == 16, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(data_upload_packet_t) == 244, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(data_download_packet_t) == 244, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(data_transfer_status_packet_t) == 6, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(data_transfer_status_packet_t, buffer_size) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(data_transfer_status_packet_t, reserved) == 3, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(device_info_string_t) == 64, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(device_capabilities_t) == 32, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, build_profile) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, max_mtu) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, features) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, protocol_fingerprint) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, max_module_size) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, max_upload_chunk) == 16, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, sprite_capacity) == 18, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, encodings) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, max_connections) == 21, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, batch_max_commands) == 22, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, broadcast_queue_depth) == 23, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, wasm_queue_depth) == 24, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(device_capabilities_t, reserved) == 25, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(dfu_control_packet_t) == 20, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(dfu_control_packet_t, param) == 1, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(dfu_packet_t) == 20, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(sprite_upload_packet_t) == 36, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_upload_packet_t, bitmap_data) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_upload_packet_t, crc16) == 34, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(sprite_download_request_t) == 2, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(sprite_download_packet_t) == 37, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_download_packet_t, bitmap_data) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_download_packet_t, crc16) == 34, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_download_packet_t, status) == 36, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(sprite_registry_status_t) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_registry_status_t, free_slots) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_registry_status_t, last_sprite_id) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_registry_status_t, registry_status) == 6, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_registry_status_t, last_operation) == 7, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_registry_status_t, crc_errors) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_registry_status_t, reserved) == 10, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(sprite_verify_request_t) == 2, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(sprite_verify_response_t) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_verify_response_t, stored_crc16) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_verify_response_t, calculated_crc16) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_verify_response_t, verification_status) == 6, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(sprite_verify_response_t, reserved) == 7, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(status_broadcast_block_t) == 16, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, seq) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, device_status) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, flags) == 3, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, connections) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, wasm_status) == 5, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, last_result) == 6, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, registry_generation) == 10, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, sprite_count) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, dfu_state) == 14, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(status_broadcast_block_t, dfu_kb) == 15, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(wasm_upload_packet_t) == 252, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_upload_packet_t, sequence) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_upload_packet_t, chunk_size) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_upload_packet_t, total_size) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_upload_packet_t, data) == 8, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(wasm_execute_packet_t) == 52, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_execute_packet_t, arg_count) == 32, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_execute_packet_t, args) == 36, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(wasm_status_packet_t) == 18, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_status_packet_t, error_code) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_status_packet_t, bytes_received) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_status_packet_t, total_size) == 4, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_status_packet_t, uptime) == 8, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_status_packet_t, module_crc32) == 12, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_status_packet_t, reserved) == 16, "run generate_ble_protocol.py");
+
+BUILD_ASSERT(sizeof(wasm_result_packet_t) == 50, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_result_packet_t, error_code) == 1, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_result_packet_t, return_value) == 2, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_result_packet_t, execution_time_us) == 6, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_result_packet_t, result_data) == 10, "run generate_ble_protocol.py");
+BUILD_ASSERT(offsetof(wasm_result_packet_t, timestamp_us) == 42, "run generate_ble_protocol.py");
+
+/* ============================================================================
+ * VALIDATORS AND LENGTHS
+ * ============================================================================ */
+
+/**
+ * @brief Check the length of a broadcast_frame_packet_t write
+ *
+ * The length must be within 2..201 bytes.
+ *
+ * @return 0 if valid, -EMSGSIZE otherwise
+ */
+static inline int broadcast_frame_packet_validate(const void *buf, uint16_t len)
+{
+    ARG_UNUSED(buf);
+
+    if (len < 2 || len > sizeof(broadcast_frame_packet_t)) {
+        return -EMSGSIZE;
+    }
+    return 0;
+}
+
+/**
+ * @brief Length of a control_batch_packet_t carrying @p count records
+ */
+static inline uint16_t control_batch_packet_len(uint8_t count)
+{
+    return offsetof(control_batch_packet_t, records) +
+           count * sizeof(((control_batch_packet_t *)0)->records[0]);
+}
+
+/**
+ * @brief Check the length of a control_batch_packet_t write
+ *
+ * The length must be within 5..92 bytes and hold exactly count records.
+ *
+ * @return 0 if valid, -EMSGSIZE otherwise
+ */
+static inline int control_batch_packet_validate(const void *buf, uint16_t len)
+{
+    const control_batch_packet_t *packet = buf;
+
+    if (len < 5 || len > sizeof(control_batch_packet_t)) {
+        return -EMSGSIZE;
+    }
+    if (packet->count > ARRAY_SIZE(packet->records) ||
+        len != control_batch_packet_len(packet->count)) {
+        return -EMSGSIZE;
+    }
+    return 0;
+}
+
+/**
+ * @brief Length of a control_batch_response_t carrying @p count results
+ */
+static inline uint16_t control_batch_response_len(uint8_t count)
+{
+    return offsetof(control_batch_response_t, results) +
+           count * sizeof(((control_batch_response_t *)0)->results[0]);
+}
+
+/**
+ * @brief Length of a control_handler_stats_page_t carrying @p count entries
+ */
+static inline uint16_t control_handler_stats_page_len(uint8_t count)
+{
+    return offsetof(control_handler_stats_page_t, entries) +
+           count * sizeof(((control_handler_stats_page_t *)0)->entries[0]);
+}
+
+/**
+ * @brief Length of a control_memory_packet_t carrying @p count clients
+ */
+static inline uint16_t control_memory_packet_len(uint8_t count)
+{
+    return offsetof(control_memory_packet_t, clients) +
+           count * sizeof(((control_memory_packet_t *)0)->clients[0]);
+}
+
+/**
+ * @brief Check the length of a data_upload_packet_t write
+ *
+ * The length must be within 1..244 bytes.
+ *
+ * @return 0 if valid, -EMSGSIZE otherwise
+ */
+static inline int data_upload_packet_validate(const void *buf, uint16_t len)
+{
+    ARG_UNUSED(buf);
+
+    if (len < 1 || len > sizeof(data_upload_packet_t)) {
+        return -EMSGSIZE;
+    }
+    return 0;
+}
+
+/**
+ * @brief Check the length of a dfu_packet_t write
+ *
+ * The length must be within 1..20 bytes.
+ *
+ * @return 0 if valid, -EMSGSIZE otherwise
+ */
+static inline int dfu_packet_validate(const void *buf, uint16_t len)
+{
+    ARG_UNUSED(buf);
+
+    if (len < 1 || len > sizeof(dfu_packet_t)) {
+        return -EMSGSIZE;
+    }
+    return 0;
+}
+
+/**
+ * @brief Check the length of a wasm_upload_packet_t write
+ *
+ * The length must be within 8..252 bytes and hold at least chunk_size bytes of data.
+ *
+ * @return 0 if valid, -EMSGSIZE otherwise
+ */
+static inline int wasm_upload_packet_validate(const void *buf, uint16_t len)
+{
+    const wasm_upload_packet_t *packet = buf;
+
+    if (len < 8 || len > sizeof(wasm_upload_packet_t)) {
+        return -EMSGSIZE;
+    }
+    if (len < offsetof(wasm_upload_packet_t, data) + packet->chunk_size) {
+        return -EMSGSIZE;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * COMPACT DECODERS
+ * ============================================================================ */
+
+/**
+ * @brief Decode a compact encoded control_command_packet_t
+ *
+ * Fields not present stay as they are in @p packet, which should be zeroed.
+ *
+ * @param buf Encoded packet
+ * @param len Length of the encoded packet in bytes
+ * @param packet Packet to fill in
+ * @return 0 on success, -EBADMSG if malformed, -ERANGE or -EMSGSIZE if a
+ *         value does not fit the struct
+ */
+static inline int control_command_packet_decode(const void *buf, uint16_t len,
+                                                control_command_packet_t *packet)
+{
+    compact_reader_t reader;
+    compact_field_t field;
+    uint64_t value = 0;
+    int err;
+
+    compact_reader_init(&reader, buf, len);
+    while ((err = compact_reader_next(&reader, &field)) > 0) {
+        switch (field.id) {
+        case CONTROL_COMMAND_FIELD_CMD_ID:
+            err = compact_get_uint(&field, UINT8_MAX, &value);
+            packet->cmd_id = value;
+            break;
+        case CONTROL_COMMAND_FIELD_PARAM1:
+            err = compact_get_uint(&field, UINT8_MAX, &value);
+            packet->param1 = value;
+            break;
+        case CONTROL_COMMAND_FIELD_PARAM2:
+            err = compact_get_uint(&field, UINT8_MAX, &value);
+            packet->param2 = value;
+            break;
+        default:
+            /* Added by a later version */
+            break;
+        }
+        if (err < 0) {
+            return err;
+        }
+    }
+    return err;
+}
+
+/**
+ * @brief Decode a compact encoded wasm_execute_packet_t
+ *
+ * Fields not present stay as they are in @p packet, which should be zeroed.
+ *
+ * @param buf Encoded packet
+ * @param len Length of the encoded packet in bytes
+ * @param packet Packet to fill in
+ * @return 0 on success, -EBADMSG if malformed, -ERANGE or -EMSGSIZE if a
+ *         value does not fit the struct
+ */
+static inline int wasm_execute_packet_decode(const void *buf, uint16_t len,
+                                             wasm_execute_packet_t *packet)
+{
+    compact_reader_t reader;
+    compact_field_t field;
+    int64_t svalue = 0;
+    uint8_t args_count = 0;
+    int err;
+
+    compact_reader_init(&reader, buf, len);
+    while ((err = compact_reader_next(&reader, &field)) > 0) {
+        switch (field.id) {
+        case WASM_EXECUTE_FIELD_FUNCTION_NAME:
+            err = compact_get_bytes(&field, packet->function_name, sizeof(packet->function_name), true);
+            break;
+        case WASM_EXECUTE_FIELD_ARGS:
+            if (args_count >= ARRAY_SIZE(packet->args)) {
+                return -EMSGSIZE;
+            }
+            err = compact_get_int(&field, INT32_MIN, INT32_MAX, &svalue);
+            packet->args[args_count++] = svalue;
+            break;
+        default:
+            /* Added by a later version */
+            break;
+        }
+        if (err < 0) {
+            return err;
+        }
+    }
+    packet->arg_count = args_count;
+    return err;
+}
+
+#endif /* BLE_PROTOCOL_GEN_H */
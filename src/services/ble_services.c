@@ -1,12 +1,10 @@
 #include "ble_services.h"
-#include "device_info_service.h"
-/* Re-enabling services with fixed UUID approach */
 #include "control_service.h"
-#include "data_service.h"
-#include "dfu_service.h"
-#include "sprite_service.h"
-#include "wasm_service.h"
-#include <zephyr/sys/printk.h>
+#include "ble_packet_handlers.h"
+#include "compact_codec.h"
+#include "link_profile.h"
+#include "event_bus.h"
+#include <zephyr/logging/log.h>
 #include <zephyr/bluetooth/gatt.h>
 
 /**
@@ -14,13 +12,78 @@
  * @brief Common BLE services management and coordination
  */
 
+LOG_MODULE_REGISTER(ble_services, CONFIG_BLE_SERVICES_LOG_LEVEL);
+
 /* ============================================================================
  * STATIC DATA
  * ============================================================================ */
 
 static bool services_initialized = false;
 static uint8_t active_connections = 0;
-static uint16_t current_mtu = 23;  /* Default BLE MTU */
+
+/* Link parameters per connection - each central negotiates its own */
+typedef struct {
+    struct bt_conn *conn;
+    ble_link_info_t info;
+    uint8_t encoding;               /* COMPACT_ENCODING_* for writes */
+    struct bt_gatt_exchange_params mtu_exchange_params;
+} ble_link_state_t;
+
+BLE_CONN_CONTEXT_DEFINE(ble_link_state_t, link_state)
+
+/* ============================================================================
+ * FORWARD DECLARATIONS
+ * ============================================================================ */
+
+static void link_state_open(struct bt_conn *conn);
+static void link_state_close(struct bt_conn *conn);
+static struct bt_gatt_cb gatt_callbacks;
+
+/* ============================================================================
+ * SERVICE REGISTRY
+ * ============================================================================ */
+
+static void print_service_list(void)
+{
+    LOG_INF("Available services:");
+    STRUCT_SECTION_FOREACH(ble_service_desc, svc) {
+        LOG_INF("  - %s (0x%04X)", svc->name, svc->uuid);
+    }
+}
+
+static void fan_out_connection(struct bt_conn *conn, bool connected)
+{
+    struct ble_service_desc *svc;
+    int count;
+    
+    STRUCT_SECTION_COUNT(ble_service_desc, &count);
+    
+    /* Tear down in reverse init order so later services can rely on earlier ones */
+    for (int i = 0; i < count; i++) {
+        STRUCT_SECTION_GET(ble_service_desc, connected ? i : count - 1 - i, &svc);
+        if (svc->connection) {
+            svc->connection(conn, connected);
+        }
+    }
+}
+
+static void fan_out_mtu_changed(struct bt_conn *conn, uint16_t mtu)
+{
+    STRUCT_SECTION_FOREACH(ble_service_desc, svc) {
+        if (svc->mtu_changed) {
+            svc->mtu_changed(conn, mtu);
+        }
+    }
+}
+
+static void fan_out_link_changed(struct bt_conn *conn, const ble_link_info_t *info)
+{
+    STRUCT_SECTION_FOREACH(ble_service_desc, svc) {
+        if (svc->link_changed) {
+            svc->link_changed(conn, info);
+        }
+    }
+}
 
 /* ============================================================================
  * PUBLIC FUNCTIONS
@@ -31,72 +94,43 @@ int ble_services_init(void)
     int err;
     
     if (services_initialized) {
-        printk("BLE Services: Already initialized\n");
+        LOG_INF("Already initialized");
         return 0;
     }
     
-    printk("BLE Services: Initializing all services...\n");
-    
-    /* Initialize Device Information Service */
-    printk("BLE Services: Initializing Device Information Service...\n");
-    err = device_info_service_init();
-    if (err) {
-        printk("BLE Services: Failed to initialize Device Info Service (err %d)\n", err);
-        return err;
-    }
-    printk("BLE Services: ✅ Device Information Service initialized\n");
-    
-    /* Re-enabling custom services with fixed UUID approach */
-    printk("BLE Services: Initializing Control Service...\n");
-    err = control_service_init();
-    if (err) {
-        printk("BLE Services: Failed to initialize Control Service (err %d)\n", err);
-        return err;
-    }
-    printk("BLE Services: ✅ Control Service initialized\n");
+    LOG_INF("Initializing all services...");
     
-    printk("BLE Services: Initializing Data Service...\n");
-    err = data_service_init();
-    if (err) {
-        printk("BLE Services: Failed to initialize Data Service (err %d)\n", err);
-        return err;
-    }
-    printk("BLE Services: ✅ Data Service initialized\n");
+#if defined(CONFIG_BLE_HANDLER_STATS)
+    /* Handler timing uses the cycle counter from the first ATT request on */
+    timing_init();
+    timing_start();
+#endif
     
-    printk("BLE Services: Initializing DFU Service...\n");
-    err = dfu_service_init();
-    if (err) {
-        printk("BLE Services: Failed to initialize DFU Service (err %d)\n", err);
-        return err;
-    }
-    printk("BLE Services: ✅ DFU Service initialized\n");
-    
-    printk("BLE Services: Initializing Sprite Service...\n");
-    err = sprite_service_init();
-    if (err) {
-        printk("BLE Services: Failed to initialize Sprite Service (err %d)\n", err);
-        return err;
-    }
-    printk("BLE Services: ✅ Sprite Service initialized\n");
+    memset(link_state, 0, sizeof(link_state));
+    bt_gatt_cb_register(&gatt_callbacks);
     
-    printk("BLE Services: Initializing WASM Service...\n");
-    err = wasm_service_init();
-    if (err) {
-        printk("BLE Services: Failed to initialize WASM Service (err %d)\n", err);
-        return err;
+    STRUCT_SECTION_FOREACH(ble_service_desc, svc) {
+        if (!svc->init) {
+            continue;
+        }
+        
+        LOG_INF("Initializing %s...", svc->name);
+        uint32_t start = k_cycle_get_32();
+        err = svc->init();
+        svc->runtime->init_time_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+        svc->runtime->init_err = err;
+        if (err) {
+            LOG_ERR("Failed to initialize %s (err %d)", svc->name, err);
+            return err;
+        }
+        LOG_INF("✅ %s initialized (%u us)",
+                svc->name, svc->runtime->init_time_us);
     }
-    printk("BLE Services: ✅ WASM Service initialized\n");
     
     services_initialized = true;
     
-    printk("BLE Services: All services initialized successfully\n");
-            printk("BLE Services: Available services:\n");
-        printk("  - Device Information Service (0x180A)\n");
-        printk("  - Control Service (0xFFE0)\n");
-        printk("  - Data Service (0xFFF0)\n");
-        printk("  - DFU Service (0xFE59)\n");
-        printk("  - Sprite Service (0xFFF8)\n");
-        printk("  - WASM Service (0xFFF7)\n");
+    LOG_INF("All services initialized successfully");
+    print_service_list();
     
     return 0;
 }
@@ -109,29 +143,27 @@ void ble_services_connection_event(struct bt_conn *conn, bool connected)
     
     /* Update connection count */
     if (connected) {
+        link_state_open(conn);
+        link_profile_reset(conn);
         active_connections++;
-        printk("BLE Services: 📱 New client connected! (active: %d)\n", active_connections);
-        printk("BLE Services: Available services:\n");
-        printk("  - Device Information Service (0x180A)\n");
-        printk("  - Control Service (0xFFE0)\n");
-        printk("  - Data Service (0xFFF0)\n");
-        printk("  - DFU Service (0xFE59)\n");
+        LOG_INF("📱 New client connected! (active: %d)", active_connections);
+        print_service_list();
     } else {
+        link_state_close(conn);
+        link_profile_reset(conn);
         if (active_connections > 0) {
             active_connections--;
         }
-        printk("BLE Services: 📱 Client disconnected (active: %d)\n", active_connections);
+        LOG_INF("📱 Client disconnected (active: %d)", active_connections);
     }
     
-    printk("BLE Services: Connection event - %s (active: %d)\n", 
-           connected ? "connected" : "disconnected", active_connections);
+    LOG_INF("Connection event - %s (active: %d)", 
+            connected ? "connected" : "disconnected", active_connections);
     
     /* Notify all services of connection events */
-    control_service_connection_event(conn, connected);
-    data_service_connection_event(conn, connected);
-    dfu_service_connection_event(conn, connected);
-    sprite_service_connection_event(conn, connected);
-    wasm_service_connection_event(conn, connected);
+    fan_out_connection(conn, connected);
+    
+    event_bus_publish(EVENT_CONNECTION);
 }
 
 uint8_t ble_services_get_device_status(void)
@@ -149,6 +181,17 @@ uint8_t ble_services_get_connection_count(void)
     return active_connections;
 }
 
+void ble_services_print_stats(void)
+{
+    STRUCT_SECTION_FOREACH(ble_service_desc, svc) {
+        LOG_INF("%s - init %u us (err %d)",
+                svc->name, svc->runtime->init_time_us, svc->runtime->init_err);
+        if (svc->stats) {
+            svc->stats();
+        }
+    }
+}
+
 bool ble_services_are_initialized(void)
 {
     return services_initialized;
@@ -166,10 +209,188 @@ uint8_t ble_services_get_wasm_status(void)
     return 0; // Service disabled
 }
 
-uint16_t ble_services_get_current_mtu(void)
+int ble_services_get_link_info(struct bt_conn *conn, ble_link_info_t *info)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state || !state->conn || !info) {
+        return -EINVAL;
+    }
+    
+    *info = state->info;
+    return 0;
+}
+
+uint16_t ble_services_get_mtu(struct bt_conn *conn)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state || !state->conn) {
+        return BLE_DEFAULT_MTU;
+    }
+    
+    return state->info.mtu;
+}
+
+uint16_t ble_services_get_max_payload(struct bt_conn *conn)
+{
+    return ble_services_get_mtu(conn) - BLE_ATT_HEADER_SIZE;
+}
+
+uint8_t ble_services_get_encoding(struct bt_conn *conn)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state || !state->conn) {
+        return COMPACT_ENCODING_LEGACY;
+    }
+    
+    return state->encoding;
+}
+
+int ble_services_set_encoding(struct bt_conn *conn, uint8_t encoding)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state || !state->conn || encoding > COMPACT_ENCODING_LATEST) {
+        return -EINVAL;
+    }
+    
+    if (state->encoding != encoding) {
+        LOG_INF("Link %d encoding %d", bt_conn_index(conn), encoding);
+        state->encoding = encoding;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * LINK STATE TRACKING
+ * ============================================================================ */
+
+static void link_state_open(struct bt_conn *conn)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    struct bt_conn_info conn_info;
+    
+    if (!state) {
+        return;
+    }
+    
+    memset(state, 0, sizeof(*state));
+    state->conn = conn;
+    state->info.mtu = bt_gatt_get_mtu(conn);
+    state->info.tx_data_len = BLE_DEFAULT_DATA_LEN;
+    state->info.rx_data_len = BLE_DEFAULT_DATA_LEN;
+    state->info.tx_phy = BT_GAP_LE_PHY_1M;
+    state->info.rx_phy = BT_GAP_LE_PHY_1M;
+    
+    if (bt_conn_get_info(conn, &conn_info) == 0) {
+        state->info.interval = conn_info.le.interval;
+        state->info.latency = conn_info.le.latency;
+        state->info.timeout = conn_info.le.timeout;
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+        state->info.tx_phy = conn_info.le.phy->tx_phy;
+        state->info.rx_phy = conn_info.le.phy->rx_phy;
+#endif
+#if defined(CONFIG_BT_USER_DATA_LEN_UPDATE)
+        state->info.tx_data_len = conn_info.le.data_len->tx_max_len;
+        state->info.rx_data_len = conn_info.le.data_len->rx_max_len;
+#endif
+    }
+    
+    LOG_INF("Link %d - MTU %d, interval %d, PHY %d/%d, data length %d/%d",
+            bt_conn_index(conn), state->info.mtu, state->info.interval,
+            state->info.tx_phy, state->info.rx_phy,
+            state->info.tx_data_len, state->info.rx_data_len);
+}
+
+static void link_state_close(struct bt_conn *conn)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (state) {
+        memset(state, 0, sizeof(*state));
+    }
+}
+
+static void link_mtu_updated(struct bt_conn *conn, uint16_t tx, uint16_t rx)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state || !state->conn) {
+        return;
+    }
+    
+    /* The usable ATT MTU is the smaller of both directions */
+    state->info.mtu = MIN(tx, rx);
+    LOG_INF("Link %d MTU updated (tx %d, rx %d)", bt_conn_index(conn), tx, rx);
+    fan_out_mtu_changed(conn, state->info.mtu);
+}
+
+static void link_param_updated(struct bt_conn *conn, uint16_t interval,
+                               uint16_t latency, uint16_t timeout)
 {
-    return current_mtu;
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state || !state->conn) {
+        return;
+    }
+    
+    state->info.interval = interval;
+    state->info.latency = latency;
+    state->info.timeout = timeout;
+    LOG_INF("Link %d parameters updated (interval %d, latency %d, timeout %d)",
+            bt_conn_index(conn), interval, latency, timeout);
+    fan_out_link_changed(conn, &state->info);
+}
+
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+static void link_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state || !state->conn) {
+        return;
+    }
+    
+    state->info.tx_phy = param->tx_phy;
+    state->info.rx_phy = param->rx_phy;
+    LOG_INF("Link %d PHY updated (tx %d, rx %d)",
+            bt_conn_index(conn), param->tx_phy, param->rx_phy);
+    fan_out_link_changed(conn, &state->info);
 }
+#endif
+
+#if defined(CONFIG_BT_USER_DATA_LEN_UPDATE)
+static void link_data_len_updated(struct bt_conn *conn, struct bt_conn_le_data_len_info *info)
+{
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state || !state->conn) {
+        return;
+    }
+    
+    state->info.tx_data_len = info->tx_max_len;
+    state->info.rx_data_len = info->rx_max_len;
+    LOG_INF("Link %d data length updated (tx %d, rx %d)",
+            bt_conn_index(conn), info->tx_max_len, info->rx_max_len);
+    fan_out_link_changed(conn, &state->info);
+}
+#endif
+
+static struct bt_gatt_cb gatt_callbacks = {
+    .att_mtu_updated = link_mtu_updated,
+};
+
+BT_CONN_CB_DEFINE(link_conn_callbacks) = {
+    .le_param_updated = link_param_updated,
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+    .le_phy_updated = link_phy_updated,
+#endif
+#if defined(CONFIG_BT_USER_DATA_LEN_UPDATE)
+    .le_data_len_updated = link_data_len_updated,
+#endif
+};
 
 /* ============================================================================
  * MTU EXCHANGE CALLBACK
@@ -178,36 +399,118 @@ uint16_t ble_services_get_current_mtu(void)
 static void mtu_exchange_cb(struct bt_conn *conn, uint8_t err, struct bt_gatt_exchange_params *params)
 {
     if (err) {
-        printk("BLE Services: MTU exchange failed (err %d)\n", err);
+        LOG_ERR("MTU exchange failed (err %d)", err);
         return;
     }
     
-    current_mtu = bt_gatt_get_mtu(conn);
-    printk("BLE Services: 🔄 MTU negotiated: %d bytes\n", current_mtu);
-    printk("BLE Services: 📦 Max payload size: %d bytes\n", current_mtu - 3); /* ATT header is 3 bytes */
+    uint16_t mtu = bt_gatt_get_mtu(conn);
+    ble_link_state_t *state = link_state_get(conn);
+    if (state && state->conn) {
+        state->info.mtu = mtu;
+    }
+    
+    LOG_INF("🔄 Link %d MTU negotiated: %d bytes", bt_conn_index(conn), mtu);
+    LOG_INF("📦 Max payload size: %d bytes", mtu - BLE_ATT_HEADER_SIZE);
     
     /* Log what this enables */
-    if (current_mtu >= 247) {
-        printk("BLE Services: ✅ Large packet support enabled (244+ byte payloads)\n");
-        printk("BLE Services: 🚀 WASM service can use full-size packets\n");
-    } else if (current_mtu >= 50) {
-        printk("BLE Services: ✅ Medium packet support enabled (%d byte payloads)\n", current_mtu - 3);
+    if (mtu >= 247) {
+        LOG_INF("✅ Large packet support enabled (244+ byte payloads)");
+        LOG_INF("🚀 WASM service can use full-size packets");
+    } else if (mtu >= 50) {
+        LOG_INF("✅ Medium packet support enabled (%d byte payloads)", mtu - BLE_ATT_HEADER_SIZE);
     } else {
-        printk("BLE Services: ⚠️  Using minimum MTU - limited to %d byte payloads\n", current_mtu - 3);
+        LOG_WRN("⚠️  Using minimum MTU - limited to %d byte payloads", mtu - BLE_ATT_HEADER_SIZE);
     }
 }
 
-static struct bt_gatt_exchange_params mtu_exchange_params = {
-    .func = mtu_exchange_cb
-};
-
 int ble_services_request_mtu_exchange(struct bt_conn *conn)
 {
-    if (!conn) {
-        printk("BLE Services: Cannot request MTU exchange - no connection\n");
+    ble_link_state_t *state = link_state_get(conn);
+    
+    if (!state) {
+        LOG_ERR("Cannot request MTU exchange - no connection");
         return -EINVAL;
     }
     
-    printk("BLE Services: 📡 Requesting MTU exchange...\n");
-    return bt_gatt_exchange_mtu(conn, &mtu_exchange_params);
+    /* Params must stay valid until the callback, so each connection has its own */
+    state->mtu_exchange_params.func = mtu_exchange_cb;
+    
+    LOG_INF("📡 Requesting MTU exchange...");
+    return bt_gatt_exchange_mtu(conn, &state->mtu_exchange_params);
+}
+
+/* ============================================================================
+ * HANDLER STATISTICS
+ * ============================================================================ */
+
+#if defined(CONFIG_BLE_HANDLER_STATS)
+
+void ble_handler_stats_record(struct ble_handler_stats *stats, timing_t *start,
+                              ssize_t result, uint16_t bytes)
+{
+    timing_t end = timing_counter_get();
+    uint64_t cycles = timing_cycles_get(start, &end);
+    int bucket = 0;
+    
+    while (bucket < BLE_HANDLER_STATS_BUCKETS - 1 &&
+           cycles >= ((uint64_t)BLE_HANDLER_STATS_BUCKET0_CYCLES << (2 * bucket))) {
+        bucket++;
+    }
+    
+    stats->calls++;
+    if (result < 0) {
+        stats->errors++;
+    } else {
+        stats->bytes += bytes;
+    }
+    stats->hist[bucket]++;
+    stats->max_cycles = MAX(stats->max_cycles, (uint32_t)MIN(cycles, UINT32_MAX));
+}
+
+uint8_t ble_services_get_handler_stats_count(void)
+{
+    int count;
+    
+    STRUCT_SECTION_COUNT(ble_handler_stats, &count);
+    return MIN(count, UINT8_MAX);
+}
+
+const struct ble_handler_stats *ble_services_get_handler_stats(uint8_t index)
+{
+    struct ble_handler_stats *stats;
+    
+    if (index >= ble_services_get_handler_stats_count()) {
+        return NULL;
+    }
+    
+    STRUCT_SECTION_GET(ble_handler_stats, index, &stats);
+    return stats;
+}
+
+void ble_services_reset_handler_stats(void)
+{
+    STRUCT_SECTION_FOREACH(ble_handler_stats, stats) {
+        const char *name = stats->name;
+        
+        memset(stats, 0, sizeof(*stats));
+        stats->name = name;
+    }
+}
+
+#else
+
+uint8_t ble_services_get_handler_stats_count(void)
+{
+    return 0;
 }
+
+const struct ble_handler_stats *ble_services_get_handler_stats(uint8_t index)
+{
+    return NULL;
+}
+
+void ble_services_reset_handler_stats(void)
+{
+}
+
+#endif /* CONFIG_BLE_HANDLER_STATS */
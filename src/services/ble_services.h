@@ -6,6 +6,7 @@
 #include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/uuid.h>
+#include <zephyr/sys/iterable_sections.h>
 #include <stdbool.h>
 
 /**
@@ -58,11 +59,71 @@ uint8_t ble_services_get_connection_count(void);
  */
 bool ble_services_are_initialized(void);
 
+/* ============================================================================
+ * PER-CONNECTION LINK STATE
+ * ============================================================================ */
+
+#define BLE_ATT_HEADER_SIZE         3       /* Opcode + handle */
+#define BLE_DEFAULT_MTU             23      /* ATT MTU before exchange */
+#define BLE_DEFAULT_DATA_LEN        27      /* LL payload before data length update */
+
+/**
+ * @brief Link parameters of one connection
+ *
+ * Filled in on connect and kept current from the MTU, PHY, data length
+ * and connection parameter update callbacks.
+ */
+typedef struct {
+    uint16_t mtu;               /* ATT MTU */
+    uint16_t tx_data_len;       /* LL TX payload octets */
+    uint16_t rx_data_len;       /* LL RX payload octets */
+    uint8_t tx_phy;             /* BT_GAP_LE_PHY_* */
+    uint8_t rx_phy;             /* BT_GAP_LE_PHY_* */
+    uint16_t interval;          /* Connection interval (1.25 ms units) */
+    uint16_t latency;           /* Peripheral latency (events) */
+    uint16_t timeout;           /* Supervision timeout (10 ms units) */
+} ble_link_info_t;
+
+/**
+ * @brief Get the link parameters of a connection
+ * @param conn Connection handle
+ * @param info Link parameters to fill in
+ * @return 0 on success, -EINVAL if the connection is unknown
+ */
+int ble_services_get_link_info(struct bt_conn *conn, ble_link_info_t *info);
+
+/**
+ * @brief Get the negotiated MTU of a connection
+ * @param conn Connection handle
+ * @return MTU in bytes, or BLE_DEFAULT_MTU if the connection is unknown
+ */
+uint16_t ble_services_get_mtu(struct bt_conn *conn);
+
 /**
- * @brief Get current negotiated MTU size
- * @return Current MTU in bytes
+ * @brief Get the largest notification or write payload for a connection
+ * @param conn Connection handle
+ * @return MTU minus the ATT header, in bytes
+ */
+uint16_t ble_services_get_max_payload(struct bt_conn *conn);
+
+/**
+ * @brief Get the write encoding a connection negotiated
+ * @param conn Connection handle
+ * @return COMPACT_ENCODING_*, COMPACT_ENCODING_LEGACY if the connection is unknown
  */
-uint16_t ble_services_get_current_mtu(void);
+uint8_t ble_services_get_encoding(struct bt_conn *conn);
+
+/**
+ * @brief Switch the write encoding of a connection
+ *
+ * Applies from the next write on. Every connection starts out with
+ * COMPACT_ENCODING_LEGACY.
+ *
+ * @param conn Connection handle
+ * @param encoding COMPACT_ENCODING_*
+ * @return 0 on success, -EINVAL if the connection or encoding is unknown
+ */
+int ble_services_set_encoding(struct bt_conn *conn, uint8_t encoding);
 
 /**
  * @brief Request MTU exchange with connected client
@@ -71,4 +132,83 @@ uint16_t ble_services_get_current_mtu(void);
  */
 int ble_services_request_mtu_exchange(struct bt_conn *conn);
 
+/* ============================================================================
+ * SERVICE REGISTRY
+ * ============================================================================ */
+
+/**
+ * @brief Bookkeeping the registry keeps for each service
+ */
+typedef struct {
+    uint32_t init_time_us;      /* Time spent in the init hook */
+    int init_err;               /* Result of the init hook */
+} ble_service_runtime_t;
+
+/**
+ * @brief Service descriptor
+ *
+ * Each service defines one with BLE_SERVICE_DEFINE() next to its GATT table.
+ * ble_services.c walks the descriptors to run init and to fan out
+ * connection and link events, so adding a service needs no edits here.
+ * Every hook is optional.
+ */
+struct ble_service_desc {
+    const char *name;                   /* Printable name */
+    uint16_t uuid;                      /* 16-bit service UUID, for the listing */
+    int (*init)(void);
+    void (*connection)(struct bt_conn *conn, bool connected);
+    void (*mtu_changed)(struct bt_conn *conn, uint16_t mtu);
+    void (*link_changed)(struct bt_conn *conn, const ble_link_info_t *info);
+    void (*stats)(void);                /* Print service statistics */
+    ble_service_runtime_t *runtime;
+};
+
+/**
+ * @brief Register a service descriptor
+ *
+ * Descriptors are sorted by name in the linker section, so @p _prio (a
+ * two-digit literal) sets the init order. Connection events are delivered
+ * in the same order on connect and in reverse order on disconnect.
+ *
+ * @param _name Service identifier
+ * @param _prio Two-digit init priority, lower first
+ * @param ... Designated initializers for struct ble_service_desc
+ */
+#define BLE_SERVICE_DEFINE(_name, _prio, ...)                                   \
+    static ble_service_runtime_t _name##_service_runtime;                       \
+    const STRUCT_SECTION_ITERABLE(ble_service_desc,                             \
+                                  ble_service_##_prio##_##_name) = {            \
+        .runtime = &_name##_service_runtime,                                    \
+        __VA_ARGS__                                                             \
+    }
+
+/**
+ * @brief Print init time and statistics of every registered service
+ */
+void ble_services_print_stats(void);
+
+/* ============================================================================
+ * HANDLER STATISTICS
+ * ============================================================================ */
+
+struct ble_handler_stats;
+
+/**
+ * @brief Get the number of instrumented characteristic handlers
+ * @return Entries in the handler statistics table, 0 if compiled out
+ */
+uint8_t ble_services_get_handler_stats_count(void);
+
+/**
+ * @brief Get one entry of the handler statistics table
+ * @param index Entry index, below ble_services_get_handler_stats_count()
+ * @return Statistics, or NULL if out of range
+ */
+const struct ble_handler_stats *ble_services_get_handler_stats(uint8_t index);
+
+/**
+ * @brief Zero every entry of the handler statistics table
+ */
+void ble_services_reset_handler_stats(void);
+
 #endif /* BLE_SERVICES_H */
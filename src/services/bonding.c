@@ -0,0 +1,144 @@
+#include "bonding.h"
+#include "event_bus.h"
+#include "status_broadcast.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+
+/**
+ * @file bonding.c
+ * @brief Bonding and fast reconnect implementation
+ */
+
+LOG_MODULE_REGISTER(bonding, CONFIG_BONDING_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+static void fast_adv_end_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(fast_adv_end_work, fast_adv_end_work_handler);
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void count_bond(const struct bt_bond_info *info, void *user_data)
+{
+    uint8_t *count = user_data;
+
+    (*count)++;
+}
+
+static void fast_adv_end_work_handler(struct k_work *work)
+{
+    LOG_DBG("Fast advertising window over");
+    status_broadcast_set_fast(false);
+}
+
+static void pairing_complete(struct bt_conn *conn, bool bonded)
+{
+    char addr[BT_ADDR_LE_STR_LEN];
+    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
+
+    LOG_INF("Paired with %s (%s, %d bonds)", addr, bonded ? "bonded" : "not bonded",
+            bonding_get_bond_count());
+    if (bonded) {
+        event_bus_publish(EVENT_BOND);
+    }
+}
+
+static void pairing_failed(struct bt_conn *conn, enum bt_security_err reason)
+{
+    char addr[BT_ADDR_LE_STR_LEN];
+    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
+
+    /* The link stays up unencrypted; no characteristic requires encryption */
+    LOG_WRN("Pairing with %s failed (reason %d)", addr, reason);
+}
+
+static void bond_deleted(uint8_t id, const bt_addr_le_t *peer)
+{
+    char addr[BT_ADDR_LE_STR_LEN];
+    bt_addr_le_to_str(peer, addr, sizeof(addr));
+
+    LOG_INF("Bond with %s deleted", addr);
+    event_bus_publish(EVENT_BOND);
+}
+
+static struct bt_conn_auth_info_cb auth_info_callbacks = {
+    .pairing_complete = pairing_complete,
+    .pairing_failed = pairing_failed,
+    .bond_deleted = bond_deleted,
+};
+
+static void security_changed(struct bt_conn *conn, bt_security_t level,
+                             enum bt_security_err err)
+{
+    if (err) {
+        LOG_DBG("Connection %d security failed (err %d)", bt_conn_index(conn), err);
+        return;
+    }
+    LOG_DBG("Connection %d security level %d", bt_conn_index(conn), level);
+}
+
+BT_CONN_CB_DEFINE(bonding_conn_callbacks) = {
+    .security_changed = security_changed,
+};
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int bonding_init(void)
+{
+    int err = bt_conn_auth_info_cb_register(&auth_info_callbacks);
+    if (err) {
+        LOG_ERR("Failed to register auth callbacks (err %d)", err);
+        return err;
+    }
+
+    /* Restores the identity address, keys, CCC values and the database hash.
+     * A changed hash marks bonded clients change-unaware, so they get a
+     * Service Changed indication on their next connection. */
+    err = settings_load();
+    if (err) {
+        LOG_ERR("Failed to load settings (err %d)", err);
+        return err;
+    }
+
+    LOG_INF("Initialized (%d bonds)", bonding_get_bond_count());
+    return 0;
+}
+
+void bonding_connection_event(struct bt_conn *conn, bool connected)
+{
+    bool bonded = bt_addr_le_is_bonded(BT_ID_DEFAULT, bt_conn_get_dst(conn));
+
+    if (!connected) {
+        if (bonded) {
+            status_broadcast_set_fast(true);
+            k_work_reschedule(&fast_adv_end_work, K_MSEC(BONDING_FAST_ADV_MS));
+        }
+        return;
+    }
+
+    if (bonded) {
+        k_work_cancel_delayable(&fast_adv_end_work);
+        status_broadcast_set_fast(false);
+    }
+
+    /* Bonded clients re-encrypt with the stored key, others pair once */
+    int err = bt_conn_set_security(conn, BT_SECURITY_L2);
+    if (err) {
+        LOG_WRN("Failed to request security (err %d)", err);
+    }
+}
+
+uint8_t bonding_get_bond_count(void)
+{
+    uint8_t count = 0;
+
+    bt_foreach_bond(BT_ID_DEFAULT, count_bond, &count);
+    return count;
+}
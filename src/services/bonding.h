@@ -0,0 +1,59 @@
+#ifndef BONDING_H
+#define BONDING_H
+
+#include <zephyr/bluetooth/conn.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file bonding.h
+ * @brief Bonding and fast reconnect for returning clients
+ *
+ * Keys, the identity address and the GATT database hash persist in
+ * settings (NVS). Every client is asked for an encrypted link on connect;
+ * a new client pairs once (Just Works) and is bonded, a bonded client
+ * just re-encrypts and, being change-aware through the Database Hash and
+ * Service Changed characteristics, reuses its cached attribute handles
+ * instead of rediscovering all services. While a bonded client is away
+ * the device advertises at the fast interval so it reconnects quickly.
+ * Relay links between devices pair without bonding, so they neither use
+ * up bond slots nor start the fast advertising window.
+ */
+
+/* ============================================================================
+ * CONFIGURATION
+ * ============================================================================ */
+
+#define BONDING_FAST_ADV_MS         30000   /* Fast advertising after a bonded client leaves */
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Load the stored identity, keys and GATT hash and register callbacks
+ *
+ * Must be called after bt_enable() and before advertising starts.
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int bonding_init(void);
+
+/**
+ * @brief Handle a client connecting or disconnecting
+ *
+ * On connect, requests encryption and leaves fast advertising. On
+ * disconnect of a bonded client, advertises fast for BONDING_FAST_ADV_MS.
+ *
+ * @param conn Connection handle
+ * @param connected true if connected, false if disconnected
+ */
+void bonding_connection_event(struct bt_conn *conn, bool connected);
+
+/**
+ * @brief Get the number of stored bonds
+ * @return Bonds on the default identity
+ */
+uint8_t bonding_get_bond_count(void);
+
+#endif /* BONDING_H */
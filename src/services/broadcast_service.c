@@ -0,0 +1,311 @@
+#include "broadcast_service.h"
+#include "app_trace.h"
+#include "ble_packet_handlers.h"
+#include "ble_protocol_gen.h"
+#include "ble_services.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+/**
+ * @file broadcast_service.c
+ * @brief Periodic advertising frame broadcast implementation
+ */
+
+LOG_MODULE_REGISTER(broadcast_service, CONFIG_BROADCAST_SERVICE_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+/* PA interval in 1.25 ms units; min == max keeps the frame rate fixed */
+#define BROADCAST_INTERVAL_UNITS    (BROADCAST_INTERVAL_MS * 4 / 5)
+
+/* Queued frame, sequence number is assigned when it goes on air */
+typedef struct {
+    uint8_t type;
+    uint8_t len;
+    uint8_t payload[BROADCAST_FRAME_PAYLOAD_MAX];
+} broadcast_frame_t;
+
+K_MSGQ_DEFINE(frame_queue, sizeof(broadcast_frame_t), BROADCAST_QUEUE_DEPTH, 4);
+
+static struct bt_le_ext_adv *adv_set;
+static uint8_t broadcast_state = BROADCAST_STATE_IDLE;
+static uint16_t frame_seq;
+static uint32_t frames_sent;
+static uint32_t frames_dropped;
+static uint32_t idle_ms;
+
+/* Periodic advertising payload: 16-bit UUID, header, frame payload */
+static uint8_t pa_buffer[sizeof(uint16_t) + sizeof(broadcast_frame_header_t) +
+                         BROADCAST_FRAME_PAYLOAD_MAX];
+
+/* The extended set only advertises the UUID so receivers can find the train */
+static const uint8_t ad_uuid[] = { BT_UUID_16_ENCODE(BROADCAST_AD_UUID) };
+static const struct bt_data ad[] = {
+    BT_DATA(BT_DATA_SVC_DATA16, ad_uuid, sizeof(ad_uuid)),
+};
+
+static void frame_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(frame_work, frame_work_handler);
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int put_frame_on_air(const broadcast_frame_t *frame)
+{
+    broadcast_frame_header_t header = {
+        .version = BROADCAST_FRAME_VERSION,
+        .type = frame->type,
+        .seq = sys_cpu_to_le16(frame_seq + 1),
+    };
+    uint16_t offset = 0;
+
+    sys_put_le16(BROADCAST_AD_UUID, pa_buffer);
+    offset += sizeof(uint16_t);
+    memcpy(&pa_buffer[offset], &header, sizeof(header));
+    offset += sizeof(header);
+    memcpy(&pa_buffer[offset], frame->payload, frame->len);
+    offset += frame->len;
+
+    const struct bt_data pa_data = BT_DATA(BT_DATA_SVC_DATA16, pa_buffer, offset);
+
+    int err = bt_le_per_adv_set_data(adv_set, &pa_data, 1);
+    if (err) {
+        return err;
+    }
+
+    frame_seq++;
+    frames_sent++;
+    LOG_DBG("Frame %d on air (type %d, %d bytes)", frame_seq, frame->type, frame->len);
+    return 0;
+}
+
+static int start_train(void)
+{
+    int err = bt_le_ext_adv_start(adv_set, BT_LE_EXT_ADV_START_DEFAULT);
+    if (err && err != -EALREADY) {
+        return err;
+    }
+
+    err = bt_le_per_adv_start(adv_set);
+    if (err && err != -EALREADY) {
+        bt_le_ext_adv_stop(adv_set);
+        return err;
+    }
+
+    broadcast_state = BROADCAST_STATE_ACTIVE;
+    LOG_INF("Periodic advertising started (%d ms interval)", BROADCAST_INTERVAL_MS);
+    return 0;
+}
+
+static void stop_train(void)
+{
+    bt_le_per_adv_stop(adv_set);
+    bt_le_ext_adv_stop(adv_set);
+
+    broadcast_state = BROADCAST_STATE_IDLE;
+    LOG_INF("Periodic advertising stopped after %d ms idle", BROADCAST_IDLE_TIMEOUT_MS);
+}
+
+/**
+ * @brief Put the next queued frame on air, once per PA interval
+ *
+ * Runs only while frames are queued or the train is active. The controller
+ * keeps repeating the last frame until it is replaced, which gives late
+ * receivers and receivers that missed an event another chance.
+ */
+static void frame_work_handler(struct k_work *work)
+{
+    broadcast_frame_t frame;
+    int err;
+
+    if (k_msgq_get(&frame_queue, &frame, K_NO_WAIT) == 0) {
+        APP_TRACE_MSGQ_GET_DONE(&frame_queue);
+        idle_ms = 0;
+
+        err = put_frame_on_air(&frame);
+        if (err) {
+            LOG_ERR("Failed to set periodic advertising data (err %d)", err);
+        }
+
+        if (!err && broadcast_state != BROADCAST_STATE_ACTIVE) {
+            err = start_train();
+            if (err) {
+                LOG_ERR("Failed to start periodic advertising (err %d)", err);
+            }
+        }
+
+        if (err) {
+            broadcast_state = BROADCAST_STATE_ERROR;
+            k_msgq_purge(&frame_queue);
+            return;
+        }
+    } else if (broadcast_state == BROADCAST_STATE_ACTIVE) {
+        idle_ms += BROADCAST_INTERVAL_MS;
+        if (idle_ms >= BROADCAST_IDLE_TIMEOUT_MS) {
+            stop_train();
+            return;
+        }
+    } else {
+        return;
+    }
+
+    k_work_schedule(&frame_work, K_MSEC(BROADCAST_INTERVAL_MS));
+}
+
+/* ============================================================================
+ * SIMPLIFIED CHARACTERISTIC HANDLERS
+ * ============================================================================ */
+
+static ssize_t broadcast_frame_handler(const void *data, uint16_t len)
+{
+    const broadcast_frame_packet_t *packet = data;
+    int err = broadcast_service_submit(packet->type, packet->payload, len - 1);
+
+    if (err == -ENOMEM) {
+        return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+    }
+    if (err) {
+        return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+    }
+
+    return len;
+}
+
+static ssize_t broadcast_status_handler(broadcast_status_packet_t *status)
+{
+    status->state = broadcast_state;
+    status->queued = k_msgq_num_used_get(&frame_queue);
+    status->seq = frame_seq;
+    status->frames_sent = frames_sent;
+    status->frames_dropped = frames_dropped;
+
+    return sizeof(*status);
+}
+
+/* ============================================================================
+ * SERVICE DEFINITION
+ * ============================================================================ */
+
+BLE_WRITE_WRAPPER_VARIABLE(broadcast_frame_handler, 2, sizeof(broadcast_frame_packet_t),
+                           broadcast_frame_packet_validate)
+BLE_READ_WRAPPER(broadcast_status_handler, broadcast_status_packet_t)
+
+BT_GATT_SERVICE_DEFINE(broadcast_service,
+    BT_GATT_PRIMARY_SERVICE(BROADCAST_SERVICE_UUID),
+    BT_GATT_CHARACTERISTIC(BROADCAST_FRAME_UUID,
+                          BT_GATT_CHRC_WRITE | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                          BT_GATT_PERM_WRITE,
+                          NULL, broadcast_frame_handler_ble, NULL),
+    BT_GATT_CHARACTERISTIC(BROADCAST_STATUS_UUID,
+                          BT_GATT_CHRC_READ,
+                          BT_GATT_PERM_READ,
+                          broadcast_status_handler_ble, NULL, NULL),
+);
+
+static void broadcast_service_print_stats(void)
+{
+    LOG_INF("  %d frames sent, %d dropped, %d queued",
+            frames_sent, frames_dropped, k_msgq_num_used_get(&frame_queue));
+}
+
+BLE_SERVICE_DEFINE(broadcast, 55,
+    .name = "Broadcast Service",
+    .uuid = 0xFFD8,
+    .init = broadcast_service_init,
+    .stats = broadcast_service_print_stats);
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int broadcast_service_init(void)
+{
+    int err = bt_le_ext_adv_create(BT_LE_ADV_PARAM(BT_LE_ADV_OPT_EXT_ADV,
+                                                   BT_GAP_ADV_FAST_INT_MIN_2,
+                                                   BT_GAP_ADV_FAST_INT_MAX_2,
+                                                   NULL),
+                                   NULL, &adv_set);
+    if (err) {
+        LOG_ERR("Failed to create advertising set (err %d)", err);
+        return err;
+    }
+
+    err = bt_le_ext_adv_set_data(adv_set, ad, ARRAY_SIZE(ad), NULL, 0);
+    if (err) {
+        LOG_ERR("Failed to set advertising data (err %d)", err);
+        return err;
+    }
+
+    err = bt_le_per_adv_set_param(adv_set, BT_LE_PER_ADV_PARAM(BROADCAST_INTERVAL_UNITS,
+                                                               BROADCAST_INTERVAL_UNITS,
+                                                               BT_LE_PER_ADV_OPT_NONE));
+    if (err) {
+        LOG_ERR("Failed to set periodic advertising parameters (err %d)", err);
+        return err;
+    }
+
+    k_msgq_purge(&frame_queue);
+    broadcast_state = BROADCAST_STATE_IDLE;
+    frame_seq = 0;
+    frames_sent = 0;
+    frames_dropped = 0;
+
+    LOG_INF("Initialized");
+    LOG_INF("  Frame characteristic: WRITE + WRITE_WITHOUT_RESP");
+    LOG_INF("  Status characteristic: READ");
+    LOG_INF("  %d frames queued, one every %d ms", BROADCAST_QUEUE_DEPTH, BROADCAST_INTERVAL_MS);
+
+    return 0;
+}
+
+int broadcast_service_submit(uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    broadcast_frame_t frame;
+
+    if (!payload || len == 0 || len > BROADCAST_FRAME_PAYLOAD_MAX) {
+        return -EINVAL;
+    }
+
+    switch (type) {
+    case BROADCAST_FRAME_DATA:
+        break;
+    case BROADCAST_FRAME_SPRITE:
+        if (len != BROADCAST_SPRITE_PAYLOAD_SIZE) {
+            return -EINVAL;
+        }
+        break;
+    case BROADCAST_FRAME_DISPLAY_LIST:
+        if (len % BROADCAST_DISPLAY_ENTRY_SIZE != 0) {
+            return -EINVAL;
+        }
+        break;
+    default:
+        LOG_WRN("Unknown frame type %d", type);
+        return -EINVAL;
+    }
+
+    frame.type = type;
+    frame.len = len;
+    memcpy(frame.payload, payload, len);
+
+    if (k_msgq_put(&frame_queue, &frame, K_NO_WAIT) != 0) {
+        frames_dropped++;
+        LOG_DBG("Queue full, frame dropped");
+        return -ENOMEM;
+    }
+    APP_TRACE_MSGQ_PUT_DONE(&frame_queue);
+
+    /* No-op while the train is running; the handler picks the frame up */
+    k_work_schedule(&frame_work, K_NO_WAIT);
+    return 0;
+}
+
+uint8_t broadcast_service_get_state(void)
+{
+    return broadcast_state;
+}
@@ -0,0 +1,126 @@
+#ifndef BROADCAST_SERVICE_H
+#define BROADCAST_SERVICE_H
+
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/conn.h>
+#include <stdint.h>
+
+/**
+ * @file broadcast_service.h
+ * @brief Periodic advertising frame broadcast
+ *
+ * Frames written to the Broadcast Frame characteristic are queued and sent
+ * one per periodic advertising event on a separate, non-connectable
+ * advertising set. Any number of receivers can sync to the train without
+ * connecting. Every frame carries a sequence number so receivers can
+ * detect missed frames; the controller repeats the last frame until the
+ * next one is queued.
+ */
+
+/* ============================================================================
+ * FRAME DEFINITIONS
+ * ============================================================================ */
+
+#define BROADCAST_FRAME_VERSION         0x01
+#define BROADCAST_FRAME_PAYLOAD_MAX     200     /* Fits one AD structure in one PA PDU */
+#define BROADCAST_QUEUE_DEPTH           8       /* Frames waiting for a PA event */
+#define BROADCAST_INTERVAL_MS           100     /* PA interval, one frame per event */
+#define BROADCAST_IDLE_TIMEOUT_MS       5000    /* Stop the train after this long without frames */
+
+/* Frame types (payload is not interpreted by the device) */
+#define BROADCAST_FRAME_DATA            0x00    /* Opaque data frame */
+#define BROADCAST_FRAME_SPRITE          0x01    /* sprite_id (2) + 1bpp bitmap (32) */
+#define BROADCAST_FRAME_DISPLAY_LIST    0x02    /* Entries of sprite_id (2), x (2), y (2) */
+#define BROADCAST_FRAME_TYPE_COUNT      3
+
+#define BROADCAST_SPRITE_PAYLOAD_SIZE   34
+#define BROADCAST_DISPLAY_ENTRY_SIZE    6
+
+/**
+ * @brief Frame written by a client
+ *
+ * Write size: 1 + payload bytes (payload up to BROADCAST_FRAME_PAYLOAD_MAX)
+ */
+typedef struct {
+    uint8_t type;                                   ///< BROADCAST_FRAME_*
+    uint8_t payload[BROADCAST_FRAME_PAYLOAD_MAX];   ///< Frame payload
+} __attribute__((packed)) broadcast_frame_packet_t;
+
+/**
+ * @brief Header in front of every frame on air
+ *
+ * Follows the 16-bit service UUID in the periodic advertising service
+ * data; the payload follows the header.
+ * Total size: 4 bytes
+ */
+typedef struct {
+    uint8_t version;        ///< BROADCAST_FRAME_VERSION
+    uint8_t type;           ///< BROADCAST_FRAME_*
+    uint16_t seq;           ///< Incremented for every frame put on air
+} __attribute__((packed)) broadcast_frame_header_t;
+
+/**
+ * @brief Broadcast status packet
+ * Total size: 12 bytes
+ */
+typedef struct {
+    uint8_t state;          ///< BROADCAST_STATE_*
+    uint8_t queued;         ///< Frames waiting for a PA event
+    uint16_t seq;           ///< Sequence number of the frame on air
+    uint32_t frames_sent;   ///< Frames put on air since boot
+    uint32_t frames_dropped; ///< Frames rejected because the queue was full
+} __attribute__((packed)) broadcast_status_packet_t;
+
+/* ============================================================================
+ * BROADCAST SERVICE DEFINITIONS
+ * ============================================================================ */
+
+static const struct bt_uuid_16 broadcast_service_uuid = BT_UUID_INIT_16(0xFFD8);
+static const struct bt_uuid_16 broadcast_frame_uuid = BT_UUID_INIT_16(0xFFD9);
+static const struct bt_uuid_16 broadcast_status_uuid = BT_UUID_INIT_16(0xFFDA);
+
+#define BROADCAST_SERVICE_UUID      (&broadcast_service_uuid.uuid)
+#define BROADCAST_FRAME_UUID        (&broadcast_frame_uuid.uuid)
+#define BROADCAST_STATUS_UUID       (&broadcast_status_uuid.uuid)
+
+/* Service data UUID on air, also advertised on the extended set for discovery */
+#define BROADCAST_AD_UUID           0xFFD8
+
+/* ============================================================================
+ * BROADCAST STATE CODES
+ * ============================================================================ */
+
+#define BROADCAST_STATE_IDLE        0x00    /* Train stopped */
+#define BROADCAST_STATE_ACTIVE      0x01    /* Periodic advertising running */
+#define BROADCAST_STATE_ERROR       0x02    /* Controller rejected the train */
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize Broadcast Service
+ *
+ * Creates the non-connectable advertising set used for periodic
+ * advertising. The train is started on the first frame.
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int broadcast_service_init(void);
+
+/**
+ * @brief Queue a frame for broadcast
+ * @param type BROADCAST_FRAME_*
+ * @param payload Frame payload
+ * @param len Payload length (up to BROADCAST_FRAME_PAYLOAD_MAX)
+ * @return 0 on success, -EINVAL for a malformed frame, -ENOMEM if the queue is full
+ */
+int broadcast_service_submit(uint8_t type, const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief Get the broadcast state
+ * @return BROADCAST_STATE_*
+ */
+uint8_t broadcast_service_get_state(void);
+
+#endif /* BROADCAST_SERVICE_H */
@@ -0,0 +1,125 @@
+#include "compact_codec.h"
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <string.h>
+
+/**
+ * @file compact_codec.c
+ * @brief Compact tagged encoding implementation
+ */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int read_varint(compact_reader_t *reader, uint64_t *value)
+{
+    uint64_t result = 0;
+
+    for (int i = 0; i < COMPACT_VARINT_MAX_SIZE; i++) {
+        if (reader->pos >= reader->len) {
+            return -EBADMSG;
+        }
+        uint8_t byte = reader->buf[reader->pos++];
+
+        result |= (uint64_t)(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+    return -EBADMSG;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void compact_reader_init(compact_reader_t *reader, const void *buf, uint16_t len)
+{
+    reader->buf = buf;
+    reader->len = len;
+    reader->pos = 0;
+}
+
+int compact_reader_next(compact_reader_t *reader, compact_field_t *field)
+{
+    uint64_t tag;
+
+    if (reader->pos >= reader->len) {
+        return 0;
+    }
+    if (read_varint(reader, &tag) || (tag >> COMPACT_TAG_SHIFT) > UINT32_MAX) {
+        return -EBADMSG;
+    }
+
+    field->id = tag >> COMPACT_TAG_SHIFT;
+    field->wire = tag & BIT_MASK(COMPACT_TAG_SHIFT);
+    field->data = NULL;
+
+    if (read_varint(reader, &field->value)) {
+        return -EBADMSG;
+    }
+
+    switch (field->wire) {
+    case COMPACT_WIRE_VARINT:
+        return 1;
+
+    case COMPACT_WIRE_BYTES:
+        if (field->value > reader->len - reader->pos) {
+            return -EBADMSG;
+        }
+        field->data = &reader->buf[reader->pos];
+        reader->pos += field->value;
+        return 1;
+
+    default:
+        /* Without knowing its length the rest of the packet is lost */
+        return -EBADMSG;
+    }
+}
+
+int compact_get_uint(const compact_field_t *field, uint64_t max, uint64_t *value)
+{
+    if (field->wire != COMPACT_WIRE_VARINT) {
+        return -EBADMSG;
+    }
+    if (field->value > max) {
+        return -ERANGE;
+    }
+    *value = field->value;
+    return 0;
+}
+
+int compact_get_int(const compact_field_t *field, int64_t min, int64_t max, int64_t *value)
+{
+    if (field->wire != COMPACT_WIRE_VARINT) {
+        return -EBADMSG;
+    }
+
+    /* Zigzag: 0, -1, 1, -2, ... map to 0, 1, 2, 3, ... */
+    int64_t decoded = (int64_t)(field->value >> 1) ^ -(int64_t)(field->value & 1);
+
+    if (decoded < min || decoded > max) {
+        return -ERANGE;
+    }
+    *value = decoded;
+    return 0;
+}
+
+int compact_get_bytes(const compact_field_t *field, void *dest, size_t size, bool terminate)
+{
+    size_t capacity = terminate ? size - 1 : size;
+
+    if (field->wire != COMPACT_WIRE_BYTES) {
+        return -EBADMSG;
+    }
+    if (field->value > capacity) {
+        return -EMSGSIZE;
+    }
+    memcpy(dest, field->data, field->value);
+    if (terminate) {
+        ((uint8_t *)dest)[field->value] = 0;
+    }
+    return field->value;
+}
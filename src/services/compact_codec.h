@@ -0,0 +1,115 @@
+#ifndef COMPACT_CODEC_H
+#define COMPACT_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file compact_codec.h
+ * @brief Compact tagged encoding of write packets
+ *
+ * The legacy wire format is the packed struct itself, padding and reserved
+ * bytes included. A connection can switch to the compact encoding with
+ * CMD_SET_ENCODING instead; packets that define field numbers
+ * (<PREFIX>_FIELD_<FIELD> next to the struct) are then sent as a sequence
+ * of fields, each a varint tag (field number << 3 | wire type) followed by
+ * the value:
+ *
+ *  - COMPACT_WIRE_VARINT: LEB128 varint, zigzag mapped for signed fields
+ *  - COMPACT_WIRE_BYTES: varint length, then the bytes (strings without
+ *    terminator)
+ *
+ * Every field is optional and defaults to zero, array fields repeat their
+ * tag once per element, and fields a receiver does not know are skipped,
+ * so later versions can add fields without breaking older firmware. The
+ * decoders are generated into ble_protocol_gen.h.
+ */
+
+/* ============================================================================
+ * ENCODINGS
+ * ============================================================================ */
+
+#define COMPACT_ENCODING_LEGACY     0       /* Packed structs, zero padded */
+#define COMPACT_ENCODING_V1         1       /* Tagged varint fields */
+#define COMPACT_ENCODING_LATEST     COMPACT_ENCODING_V1
+
+/* ============================================================================
+ * WIRE FORMAT
+ * ============================================================================ */
+
+#define COMPACT_WIRE_VARINT         0
+#define COMPACT_WIRE_BYTES          2
+#define COMPACT_TAG_SHIFT           3
+#define COMPACT_VARINT_MAX_SIZE     10      /* Bytes of a 64-bit varint */
+
+/**
+ * @brief One decoded field
+ */
+typedef struct {
+    uint32_t id;                /* Field number */
+    uint8_t wire;               /* COMPACT_WIRE_* */
+    uint64_t value;             /* Varint value, or length of a bytes field */
+    const uint8_t *data;        /* Bytes field contents */
+} compact_field_t;
+
+/**
+ * @brief Cursor over an encoded packet
+ */
+typedef struct {
+    const uint8_t *buf;
+    uint16_t len;
+    uint16_t pos;
+} compact_reader_t;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start reading an encoded packet
+ * @param reader Reader to initialize
+ * @param buf Encoded packet
+ * @param len Length of the packet in bytes
+ */
+void compact_reader_init(compact_reader_t *reader, const void *buf, uint16_t len);
+
+/**
+ * @brief Read the next field
+ * @param reader Reader
+ * @param field Field to fill in
+ * @return 1 if a field was read, 0 at the end of the packet, -EBADMSG if
+ *         the packet is truncated or uses an unknown wire type
+ */
+int compact_reader_next(compact_reader_t *reader, compact_field_t *field);
+
+/**
+ * @brief Get an unsigned varint field
+ * @param field Field read by compact_reader_next()
+ * @param max Largest value the destination holds
+ * @param value Decoded value
+ * @return 0 on success, -EBADMSG on a wire type mismatch, -ERANGE above max
+ */
+int compact_get_uint(const compact_field_t *field, uint64_t max, uint64_t *value);
+
+/**
+ * @brief Get a zigzag encoded signed varint field
+ * @param field Field read by compact_reader_next()
+ * @param min Smallest value the destination holds
+ * @param max Largest value the destination holds
+ * @param value Decoded value
+ * @return 0 on success, -EBADMSG on a wire type mismatch, -ERANGE out of range
+ */
+int compact_get_int(const compact_field_t *field, int64_t min, int64_t max, int64_t *value);
+
+/**
+ * @brief Copy a bytes field
+ * @param field Field read by compact_reader_next()
+ * @param dest Destination
+ * @param size Size of the destination
+ * @param terminate Keep room for and write a terminating zero
+ * @return Bytes copied, -EBADMSG on a wire type mismatch, -EMSGSIZE if too long
+ */
+int compact_get_bytes(const compact_field_t *field, void *dest, size_t size, bool terminate);
+
+#endif /* COMPACT_CODEC_H */
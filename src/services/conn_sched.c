@@ -0,0 +1,387 @@
+#include "conn_sched.h"
+#include "ble_packet_handlers.h"
+#if defined(CONFIG_CONN_SCHED_RADIO_NOTIFICATION)
+#include <bluetooth/radio_notification_cb.h>
+#endif
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+/**
+ * @file conn_sched.c
+ * @brief Connection event aligned work scheduling implementation
+ */
+
+LOG_MODULE_REGISTER(conn_sched, CONFIG_CONN_SCHED_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+#define CONN_SCHED_GAP              BIT(0)
+
+/* Per connection slot - fill_work is initialized once and never cleared */
+typedef struct {
+    struct bt_conn *conn;                   /* Referenced while connected, under slot_lock */
+    bool aligned;                           /* Fills wait for this connection's events */
+    atomic_t pending;                       /* Producers to fill, bit per section index */
+    struct k_work fill_work;
+} conn_sched_slot_t;
+
+BLE_CONN_CONTEXT_DEFINE(conn_sched_slot_t, sched_slot)
+static struct k_spinlock slot_lock;
+
+/* Connection events are reported, i.e. the radio notification callback is registered */
+static bool sched_available;
+
+K_THREAD_STACK_DEFINE(sched_stack, CONN_SCHED_STACK_SIZE);
+static struct k_work_q sched_work_q;
+
+static void fallback_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(fallback_work, fallback_work_handler);
+
+/* Deferred work - released on the system work queue when the gap starts */
+static struct k_work *deferred[CONN_SCHED_DEFER_MAX];
+static struct k_spinlock defer_lock;
+static atomic_t gap_wanted;
+static void gap_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(gap_work, gap_work_handler);
+static K_EVENT_DEFINE(gap_event);
+
+static atomic_t stat_events;
+static atomic_t stat_aligned_fills;
+static atomic_t stat_fallback_fills;
+static atomic_t stat_immediate_fills;
+static atomic_t stat_gap_runs;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int producer_index(const struct conn_sched_producer *producer)
+{
+    int index = 0;
+
+    STRUCT_SECTION_FOREACH(conn_sched_producer, entry) {
+        if (entry == producer) {
+            return index;
+        }
+        index++;
+    }
+    return -ENOENT;
+}
+
+/**
+ * @brief Check whether deferred work should wait for a gap
+ *
+ * True while any connection has scheduling on; the gap after its events
+ * is the one worth protecting.
+ */
+static bool any_aligned(void)
+{
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        if (sched_slot[i].conn && sched_slot[i].aligned) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void fill_work_handler(struct k_work *work)
+{
+    conn_sched_slot_t *s = CONTAINER_OF(work, conn_sched_slot_t, fill_work);
+    uint32_t pending = (uint32_t)atomic_clear(&s->pending);
+    int index = 0;
+
+    /* Own reference, so a disconnect during the fills cannot free the conn */
+    k_spinlock_key_t key = k_spin_lock(&slot_lock);
+    struct bt_conn *conn = s->conn ? bt_conn_ref(s->conn) : NULL;
+    k_spin_unlock(&slot_lock, key);
+
+    if (!conn) {
+        return;
+    }
+
+    STRUCT_SECTION_FOREACH(conn_sched_producer, producer) {
+        if (pending & BIT(index)) {
+            producer->fill(conn);
+        }
+        index++;
+    }
+    bt_conn_unref(conn);
+}
+
+static void fallback_work_handler(struct k_work *work)
+{
+    /* No event reported in time, e.g. events skipped with peripheral latency */
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        if (atomic_get(&sched_slot[i].pending)) {
+            k_work_submit_to_queue(&sched_work_q, &sched_slot[i].fill_work);
+            atomic_inc(&stat_fallback_fills);
+        }
+    }
+}
+
+static void gap_work_handler(struct k_work *work)
+{
+    struct k_work *ready[CONN_SCHED_DEFER_MAX];
+    int count = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&defer_lock);
+    for (int i = 0; i < CONN_SCHED_DEFER_MAX; i++) {
+        if (deferred[i]) {
+            ready[count++] = deferred[i];
+            deferred[i] = NULL;
+        }
+    }
+    atomic_clear(&gap_wanted);
+    k_spin_unlock(&defer_lock, key);
+
+    k_event_post(&gap_event, CONN_SCHED_GAP);
+
+    for (int i = 0; i < count; i++) {
+        k_work_submit(ready[i]);
+    }
+    if (count) {
+        atomic_inc(&stat_gap_runs);
+    }
+}
+
+/**
+ * @brief Wait for a gap, with CONN_SCHED_FALLBACK_MS as the upper bound
+ */
+static void gap_request(void)
+{
+    atomic_set(&gap_wanted, 1);
+    k_work_schedule(&gap_work, K_MSEC(CONN_SCHED_FALLBACK_MS));
+}
+
+#if defined(CONFIG_CONN_SCHED_RADIO_NOTIFICATION)
+
+/**
+ * @brief A connection event starts in CONN_SCHED_PREPARE_US
+ *
+ * Called by the radio notification library, possibly from an ISR.
+ */
+static void radio_prepare(struct bt_conn *conn)
+{
+    conn_sched_slot_t *s = sched_slot_get(conn);
+
+    atomic_inc(&stat_events);
+
+    if (!s || !s->aligned) {
+        return;
+    }
+
+    if (atomic_get(&s->pending)) {
+        k_work_submit_to_queue(&sched_work_q, &s->fill_work);
+        atomic_inc(&stat_aligned_fills);
+    }
+
+    /* Bring the gap forward to just after this event; never push it back,
+     * or events of several connections could keep postponing it */
+    if (atomic_get(&gap_wanted)) {
+        k_ticks_t gap = k_us_to_ticks_ceil64(CONN_SCHED_PREPARE_US + CONN_SCHED_EVENT_US);
+
+        if (k_work_delayable_remaining_get(&gap_work) > gap) {
+            k_work_reschedule(&gap_work, K_TICKS(gap));
+        }
+    }
+}
+
+static const struct bt_radio_notification_conn_cb radio_callbacks = {
+    .prepare = radio_prepare,
+};
+
+#endif /* CONFIG_CONN_SCHED_RADIO_NOTIFICATION */
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    conn_sched_slot_t *s = sched_slot_get(conn);
+
+    if (err || !s) {
+        return;
+    }
+
+    atomic_clear(&s->pending);
+    s->aligned = sched_available;
+    k_spinlock_key_t key = k_spin_lock(&slot_lock);
+    s->conn = bt_conn_ref(conn);
+    k_spin_unlock(&slot_lock, key);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    conn_sched_slot_t *s = sched_slot_get(conn);
+
+    if (!s || !s->conn) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&slot_lock);
+    struct bt_conn *old = s->conn;
+    s->conn = NULL;
+    k_spin_unlock(&slot_lock, key);
+    bt_conn_unref(old);
+    atomic_clear(&s->pending);
+
+    /* No more events to wait for - release deferred work now */
+    if (!any_aligned()) {
+        k_work_reschedule(&gap_work, K_NO_WAIT);
+    }
+}
+
+BT_CONN_CB_DEFINE(conn_sched_conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+};
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int conn_sched_init(void)
+{
+    const struct k_work_queue_config cfg = {
+        .name = "conn_sched",
+    };
+
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        sched_slot[i].conn = NULL;
+        sched_slot[i].aligned = false;
+        atomic_clear(&sched_slot[i].pending);
+        k_work_init(&sched_slot[i].fill_work, fill_work_handler);
+    }
+
+    k_work_queue_init(&sched_work_q);
+    k_work_queue_start(&sched_work_q, sched_stack, K_THREAD_STACK_SIZEOF(sched_stack),
+                       CONN_SCHED_PRIORITY, &cfg);
+
+#if defined(CONFIG_CONN_SCHED_RADIO_NOTIFICATION)
+    int err = bt_radio_notification_conn_cb_register(&radio_callbacks, CONN_SCHED_PREPARE_US);
+    if (err) {
+        /* Requests still work, they just run unaligned */
+        LOG_ERR("Failed to register radio notification (err %d)", err);
+        return err;
+    }
+
+    sched_available = true;
+    LOG_INF("Initialized (fill %d us before each event)", CONN_SCHED_PREPARE_US);
+#else
+    /* No connection event reports: the controller is on another core
+     * (nRF5340 network core) or another process (native_sim) */
+    LOG_INF("Initialized without radio notifications, filling on request");
+#endif
+    return 0;
+}
+
+void conn_sched_request(struct bt_conn *conn, const struct conn_sched_producer *producer)
+{
+    conn_sched_slot_t *s = sched_slot_get(conn);
+    int index = producer_index(producer);
+
+    if (!s || index < 0) {
+        return;
+    }
+
+    atomic_set_bit(&s->pending, index);
+
+    if (!s->aligned) {
+        k_work_submit_to_queue(&sched_work_q, &s->fill_work);
+        atomic_inc(&stat_immediate_fills);
+        return;
+    }
+
+    /* Starts the clock on the first request only */
+    k_work_schedule_for_queue(&sched_work_q, &fallback_work, K_MSEC(CONN_SCHED_FALLBACK_MS));
+}
+
+void conn_sched_defer(struct k_work *work)
+{
+    if (any_aligned()) {
+        k_spinlock_key_t key = k_spin_lock(&defer_lock);
+        int free_index = -1;
+        bool queued = false;
+
+        for (int i = 0; i < CONN_SCHED_DEFER_MAX; i++) {
+            if (deferred[i] == work) {
+                queued = true;
+            } else if (!deferred[i] && free_index < 0) {
+                free_index = i;
+            }
+        }
+        if (!queued && free_index >= 0) {
+            deferred[free_index] = work;
+            queued = true;
+        }
+        k_spin_unlock(&defer_lock, key);
+
+        if (queued) {
+            gap_request();
+            return;
+        }
+        LOG_WRN("Deferred work full, running at once");
+    }
+
+    k_work_submit(work);
+}
+
+int conn_sched_wait_gap(k_timeout_t timeout)
+{
+    if (!any_aligned()) {
+        return 0;
+    }
+
+    /* Clear first, so only a gap that starts after this call counts */
+    k_event_clear(&gap_event, CONN_SCHED_GAP);
+    gap_request();
+
+    return k_event_wait(&gap_event, CONN_SCHED_GAP, false, timeout) ? 0 : -EAGAIN;
+}
+
+void conn_sched_set_enabled(struct bt_conn *conn, bool enabled)
+{
+    conn_sched_slot_t *s = sched_slot_get(conn);
+
+    if (!s || enabled == s->aligned || (enabled && !sched_available)) {
+        return;
+    }
+
+    s->aligned = enabled;
+    LOG_INF("Connection %d event scheduling %s", bt_conn_index(conn), enabled ? "on" : "off");
+
+    /* This connection no longer waits for events - flush what it has queued */
+    if (!enabled) {
+        if (atomic_get(&s->pending)) {
+            k_work_submit_to_queue(&sched_work_q, &s->fill_work);
+        }
+        if (!any_aligned()) {
+            k_work_reschedule(&gap_work, K_NO_WAIT);
+        }
+    }
+}
+
+bool conn_sched_is_enabled(struct bt_conn *conn)
+{
+    conn_sched_slot_t *s = sched_slot_get(conn);
+
+    return s && s->aligned;
+}
+
+void conn_sched_get_stats(conn_sched_stats_t *stats)
+{
+    stats->events = atomic_get(&stat_events);
+    stats->aligned_fills = atomic_get(&stat_aligned_fills);
+    stats->fallback_fills = atomic_get(&stat_fallback_fills);
+    stats->immediate_fills = atomic_get(&stat_immediate_fills);
+    stats->gap_runs = atomic_get(&stat_gap_runs);
+}
+
+void conn_sched_print_stats(void)
+{
+    conn_sched_stats_t stats;
+
+    conn_sched_get_stats(&stats);
+    LOG_INF("Scheduling %s: %u events, fills %u aligned / %u fallback / %u immediate, "
+            "%u gap runs", sched_available ? "available" : "unavailable", stats.events, stats.aligned_fills,
+            stats.fallback_fills, stats.immediate_fills, stats.gap_runs);
+}
@@ -0,0 +1,160 @@
+#ifndef CONN_SCHED_H
+#define CONN_SCHED_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/conn.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file conn_sched.h
+ * @brief Work scheduling aligned to connection events
+ *
+ * The controller reports each upcoming connection event through the radio
+ * notification callback CONN_SCHED_PREPARE_US ahead of it. Notification
+ * producers register a fill callback with CONN_SCHED_PRODUCER_DEFINE() and
+ * request it per connection; the callback runs on a dedicated high
+ * priority work queue in that window, so data is sampled late and lands in
+ * the TX buffers just before the event that sends it. Heavy CPU work is
+ * deferred to the gap after the event instead, where it cannot delay a
+ * fill.
+ *
+ * Scheduling is on per connection and can be switched off for one
+ * connection at run time (CMD_SET_TX_SCHEDULING) to compare against
+ * unaligned behaviour: that connection's requests then run at once. Other
+ * clients keep their setting. Deferred work waits for a gap while any
+ * connection has scheduling on.
+ *
+ * Not active on the nRF5340 DK: the application core only runs the host,
+ * the controller runs on the network core and its radio notifications are
+ * not forwarded, so CONFIG_CONN_SCHED_RADIO_NOTIFICATION cannot be
+ * enabled. The same holds for native_sim. Such builds fill on request,
+ * never hold back deferred work and refuse to turn scheduling on; the
+ * aligned versus unaligned comparison needs a single-core SoftDevice
+ * Controller target such as the nRF52 series.
+ */
+
+/* ============================================================================
+ * CONFIGURATION
+ * ============================================================================ */
+
+#define CONN_SCHED_PREPARE_US       1500    /* Fill lead time before each connection event */
+#define CONN_SCHED_EVENT_US         2500    /* Assumed event length; the gap starts after it */
+#define CONN_SCHED_FALLBACK_MS      50      /* Fill anyway if no event is reported (peripheral latency) */
+#define CONN_SCHED_DEFER_MAX        4       /* Work items waiting for the gap */
+#define CONN_SCHED_STACK_SIZE       2048
+#define CONN_SCHED_PRIORITY         K_PRIO_COOP(6)  /* Above the system work queue */
+
+/* ============================================================================
+ * PRODUCERS
+ * ============================================================================ */
+
+/**
+ * @brief Notification producer descriptor
+ *
+ * fill() runs on the scheduler's work queue just before a connection event
+ * of a connection the producer requested with conn_sched_request(). It
+ * should sample its data and queue the notification right away.
+ */
+struct conn_sched_producer {
+    const char *name;
+    void (*fill)(struct bt_conn *conn);
+};
+
+/**
+ * @brief Register a notification producer
+ * @param _name Producer identifier
+ * @param _fill Fill callback
+ */
+#define CONN_SCHED_PRODUCER_DEFINE(_name, _fill)                                     \
+    const STRUCT_SECTION_ITERABLE(conn_sched_producer, conn_sched_producer_##_name) = { \
+        .name = #_name,                                                              \
+        .fill = (_fill),                                                             \
+    }
+
+/* ============================================================================
+ * STATISTICS
+ * ============================================================================ */
+
+typedef struct {
+    uint32_t events;            /* Connection events reported by the controller */
+    uint32_t aligned_fills;     /* Fills run just before an event */
+    uint32_t fallback_fills;    /* Fills run after CONN_SCHED_FALLBACK_MS without an event */
+    uint32_t immediate_fills;   /* Fills run at once, scheduling off for the connection */
+    uint32_t gap_runs;          /* Deferred work released into a gap */
+} conn_sched_stats_t;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start the work queue and, if available, register the radio notification callback
+ *
+ * Must be called after bt_enable().
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int conn_sched_init(void);
+
+/**
+ * @brief Ask a producer to fill before the next event of a connection
+ *
+ * Repeated requests before the event coalesce into one fill. Callable from
+ * any context.
+ *
+ * @param conn Connection to send on
+ * @param producer Producer registered with CONN_SCHED_PRODUCER_DEFINE()
+ */
+void conn_sched_request(struct bt_conn *conn, const struct conn_sched_producer *producer);
+
+/**
+ * @brief Submit work to the system work queue in the next gap
+ *
+ * Runs at once if no connection has scheduling on or too much work is
+ * already waiting.
+ *
+ * @param work Work item
+ */
+void conn_sched_defer(struct k_work *work);
+
+/**
+ * @brief Block until the gap after the next connection event
+ *
+ * For threads about to start a long computation. Returns at once if no
+ * connection has scheduling on.
+ *
+ * @param timeout Longest wait
+ * @return 0 in a gap, -EAGAIN on timeout
+ */
+int conn_sched_wait_gap(k_timeout_t timeout);
+
+/**
+ * @brief Switch scheduling on or off for one connection
+ *
+ * Turning it on has no effect without connection event reports.
+ *
+ * @param conn Connection whose fills to align or not
+ * @param enabled false to run the connection's requests at once
+ */
+void conn_sched_set_enabled(struct bt_conn *conn, bool enabled);
+
+/**
+ * @brief Check whether scheduling is on for a connection
+ * @param conn Connection to check
+ * @return true if the connection's fills are aligned to its events
+ */
+bool conn_sched_is_enabled(struct bt_conn *conn);
+
+/**
+ * @brief Get the scheduling counters
+ * @param stats Counters to fill in
+ */
+void conn_sched_get_stats(conn_sched_stats_t *stats);
+
+/**
+ * @brief Print the scheduling counters
+ */
+void conn_sched_print_stats(void);
+
+#endif /* CONN_SCHED_H */
@@ -1,6 +1,18 @@
 #include "control_service.h"
+#include "app_trace.h"
 #include "ble_packet_handlers.h"
-#include <zephyr/sys/printk.h>
+#include "ble_protocol_gen.h"
+#include "ble_services.h"
+#include "telemetry.h"
+#include "benchmark.h"
+#include "time_sync.h"
+#include "link_profile.h"
+#include "relay.h"
+#include "event_bus.h"
+#include "conn_sched.h"
+#include "mem_budget.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
 #include <string.h>
 
 /**
@@ -8,99 +20,336 @@
  * @brief Custom Control Service implementation
  */
 
+LOG_MODULE_REGISTER(control_service, CONFIG_CONTROL_SERVICE_LOG_LEVEL);
+
 /* ============================================================================
  * STATIC DATA
  * ============================================================================ */
 
 static uint8_t device_status = DEVICE_STATUS_IDLE;
-static control_response_packet_t last_response;
-static bool last_response_valid = false;
-static struct bt_conn *control_conn = NULL;
+
+/* Status and benchmark reads are served from a cache until these change */
+BLE_READ_CACHE_DEFINE(control_status_cache);
+BLE_READ_CACHE_DEFINE(control_benchmark_cache);
+
+/* Per-connection state - every central gets its own responses */
+typedef struct {
+    struct bt_conn *conn;
+    control_response_packet_t last_response;
+    bool last_response_valid;
+
+    /* Last batch response - kept for clients that read instead of subscribing */
+    control_batch_response_t batch_response;
+    uint16_t batch_response_len;
+
+    /* Last time sync response - kept for clients that read instead of subscribing */
+    control_time_sync_response_t time_sync_response;
+
+    /* First handler stats entry returned by reads */
+    uint8_t handler_stats_first;
+
+    /* Trace dump offset returned by reads */
+    uint32_t trace_offset;
+} control_conn_ctx_t;
+
+BLE_CONN_CONTEXT_DEFINE(control_conn_ctx_t, control_ctx)
+
+/* Telemetry streaming - sampled periodically while a client is subscribed */
+static bool telemetry_notify_enabled = false;
+static void telemetry_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(telemetry_work, telemetry_work_handler);
+static void telemetry_fill(struct bt_conn *conn);
+CONN_SCHED_PRODUCER_DEFINE(telemetry, telemetry_fill);
+
+/* One sample per interval, taken by the first connection to fill */
+static atomic_t telemetry_round;
+static uint32_t telemetry_sampled_round;
+static control_telemetry_packet_t telemetry_round_sample;
+
+/* Benchmark - runs on the system workqueue, results kept for reads */
+static control_benchmark_result_t benchmark_result;
+static struct bt_conn *benchmark_conn = NULL;   /* Requester, referenced until the run completes */
+static void benchmark_work_handler(struct k_work *work);
+static K_WORK_DEFINE(benchmark_work, benchmark_work_handler);
+
+/* ============================================================================
+ * FORWARD DECLARATIONS
+ * ============================================================================ */
+
+static void control_notify_batch_response(control_conn_ctx_t *ctx);
+static void control_notify_telemetry(control_conn_ctx_t *ctx, const control_telemetry_packet_t *packet);
+static int control_notify_benchmark(const void *data, uint16_t len);
+static void control_notify_time_sync(control_conn_ctx_t *ctx);
 
 /* ============================================================================
  * PRIVATE FUNCTIONS
  * ============================================================================ */
 
-static void control_notify_response(void)
+static void control_notify_response(control_conn_ctx_t *ctx)
 {
-    if (!control_conn || !last_response_valid) {
+    if (!ctx->conn || !ctx->last_response_valid) {
         return;
     }
     
-    printk("Control Service: Notifying response (cmd: 0x%02x, status: 0x%02x)\n", 
-           last_response.cmd_id, last_response.status);
+    LOG_DBG("Notifying response (cmd: 0x%02x, status: 0x%02x)", 
+            ctx->last_response.cmd_id, ctx->last_response.status);
     /* In real implementation, would use bt_gatt_notify() */
 }
 
+static bool control_any_connected(void)
+{
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        if (control_ctx[i].conn) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Fill the device status packet
+ * @return Uptime the packet was filled at, in milliseconds
+ */
+static int64_t fill_status(control_status_packet_t *status)
+{
+    int64_t uptime_ms = k_uptime_get();
+
+    status->device_status = device_status;
+    status->uptime = uptime_ms / 1000;
+    memset(status->reserved, 0, sizeof(status->reserved));
+    return uptime_ms;
+}
+
 /* ============================================================================
  * SIMPLIFIED CHARACTERISTIC HANDLERS
  * ============================================================================ */
 
-// The macro will generate control_command_write() wrapper that calls this
 /**
- * @brief Handle control command requests - CLEAN VERSION!
- * This function takes your struct directly, no BLE boilerplate needed.
+ * @brief Execute a single control command
+ * 
+ * Shared by the single-command and batch characteristics so both paths
+ * behave identically.
+ * 
+ * @param ctx Context of the requesting connection
+ * @param cmd_id Command identifier (CMD_*)
+ * @param param1 First parameter
+ * @param param2 Second parameter
+ * @param response Response to fill in
  */
-static ssize_t control_command_handler(const control_command_packet_t *packet)
+static void control_execute_command(control_conn_ctx_t *ctx,
+                                    uint8_t cmd_id, uint8_t param1, uint8_t param2,
+                                    control_response_packet_t *response)
 {
-    printk("\n=== Control Service: control_command_handler called ===\n");
-    printk("Control Service: Command received: 0x%02x\n", packet->cmd_id);
-    
-    last_response.cmd_id = packet->cmd_id;
-    last_response.status = RESPONSE_SUCCESS;
+    response->cmd_id = cmd_id;
+    response->status = RESPONSE_SUCCESS;
+    memset(response->result, 0, sizeof(response->result));
 
-    switch (packet->cmd_id) {
+    switch (cmd_id) {
     case CMD_GET_STATUS:
-        printk("Control Service: Get status (param1: 0x%02x)\n", packet->param1);
-        last_response.result[0] = device_status;
-        memset(&last_response.result[1], 0, sizeof(last_response.result) - 1);
+        LOG_DBG("Get status (param1: 0x%02x)", param1);
+        response->result[0] = device_status;
         break;
         
     case CMD_RESET_DEVICE:
-        printk("Control Service: Reset device command (mock)\n");
+        LOG_INF("Reset device command (mock)");
         device_status = DEVICE_STATUS_IDLE;
-        memset(last_response.result, 0, sizeof(last_response.result));
+        ble_read_cache_invalidate(&control_status_cache);
+        event_bus_publish(EVENT_DEVICE_STATUS);
         break;
         
     case CMD_SET_CONFIG:
-        printk("Control Service: Set config (value: 0x%02x)\n", packet->param1);
-        memset(last_response.result, 0, sizeof(last_response.result));
+        LOG_DBG("Set config (value: 0x%02x)", param1);
         break;
         
     case CMD_GET_VERSION:
-        printk("Control Service: Get version command\n");
-        last_response.result[0] = 1; // Major
-        last_response.result[1] = 0; // Minor
-        last_response.result[2] = 0; // Patch
-        memset(&last_response.result[3], 0, sizeof(last_response.result) - 3);
+        LOG_DBG("Get version command");
+        response->result[0] = 1; // Major
+        response->result[1] = 0; // Minor
+        response->result[2] = 0; // Patch
+        break;
+        
+    case CMD_RUN_BENCHMARK:
+        if (benchmark_result.status == CONTROL_BENCHMARK_STATUS_RUNNING) {
+            LOG_WRN("Benchmark already running");
+            response->status = RESPONSE_ERROR_BUSY;
+            break;
+        }
+        if (param1 > CONTROL_BENCHMARK_CRC_KB_MAX) {
+            LOG_WRN("Benchmark CRC size too large (%d KB)", param1);
+            response->status = RESPONSE_ERROR_INVALID_DATA;
+            break;
+        }
+        
+        benchmark_result.status = CONTROL_BENCHMARK_STATUS_RUNNING;
+        benchmark_result.run_id++;
+        benchmark_result.crc_kb = param1 ? param1 : CONTROL_BENCHMARK_CRC_KB_DEFAULT;
+        ble_read_cache_invalidate(&control_benchmark_cache);
+        benchmark_conn = ctx->conn ? bt_conn_ref(ctx->conn) : NULL;
+        conn_sched_defer(&benchmark_work);
+        
+        LOG_INF("Benchmark run %d queued", benchmark_result.run_id);
+        response->result[0] = benchmark_result.run_id;
+        break;
+        
+    case CMD_SET_LINK_PROFILE:
+        if (param1 >= LINK_PROFILE_COUNT) {
+            LOG_WRN("Unknown link profile %d", param1);
+            response->status = RESPONSE_ERROR_INVALID_DATA;
+            break;
+        }
+        if (link_profile_apply(ctx->conn, param1) != 0) {
+            response->status = RESPONSE_ERROR_BUSY;
+        }
+        response->result[0] = param1;
+        break;
+        
+    case CMD_GET_LINK_INFO: {
+        ble_link_info_t info;
+        
+        if (ble_services_get_link_info(ctx->conn, &info) != 0) {
+            response->status = RESPONSE_ERROR_INVALID_DATA;
+            break;
+        }
+        response->result[LINK_INFO_RESULT_PROFILE] = link_profile_get(ctx->conn);
+        response->result[LINK_INFO_RESULT_TX_PHY] = info.tx_phy;
+        response->result[LINK_INFO_RESULT_INTERVAL] = info.interval & 0xFF;
+        response->result[LINK_INFO_RESULT_INTERVAL + 1] = info.interval >> 8;
+        response->result[LINK_INFO_RESULT_TX_DATA_LEN] = MIN(info.tx_data_len, UINT8_MAX);
+        response->result[LINK_INFO_RESULT_MTU] = MIN(info.mtu, UINT8_MAX);
+        break;
+    }
+        
+    case CMD_START_RELAY: {
+        int err = relay_start(param1, param2);
+        
+        if (err == -EBUSY) {
+            response->status = RESPONSE_ERROR_BUSY;
+        } else if (err) {
+            LOG_WRN("Relay not started (err %d)", err);
+            response->status = RESPONSE_ERROR_INVALID_DATA;
+        }
+        break;
+    }
+        
+    case CMD_GET_RELAY_STATUS: {
+        relay_status_t relay;
+        
+        relay_get_status(&relay);
+        response->result[RELAY_RESULT_STATE] = relay.state;
+        response->result[RELAY_RESULT_UPDATED] = relay.updated;
+        response->result[RELAY_RESULT_SKIPPED] = relay.skipped;
+        response->result[RELAY_RESULT_FAILED] = relay.failed;
+        response->result[RELAY_RESULT_ACTIVE] = relay.active;
+        response->result[RELAY_RESULT_ELAPSED_S] = MIN(relay.elapsed_ms / 1000, UINT8_MAX);
+        break;
+    }
+        
+    case CMD_SET_TX_SCHEDULING:
+        if (param1 > 1) {
+            response->status = RESPONSE_ERROR_INVALID_DATA;
+            break;
+        }
+        /* Only this client's notifications change timing */
+        conn_sched_set_enabled(ctx->conn, param1);
+        response->result[0] = conn_sched_is_enabled(ctx->conn);
+        break;
+        
+    case CMD_SET_ENCODING:
+        if (ble_services_set_encoding(ctx->conn, param1)) {
+            response->status = RESPONSE_ERROR_INVALID_DATA;
+        }
+        response->result[ENCODING_RESULT_ACTIVE] = ble_services_get_encoding(ctx->conn);
+        response->result[ENCODING_RESULT_LATEST] = COMPACT_ENCODING_LATEST;
         break;
         
     default:
-        printk("Control Service: Unknown command: 0x%02x\n", packet->cmd_id);
-        last_response.status = RESPONSE_ERROR_UNKNOWN_CMD;
-        memset(last_response.result, 0, sizeof(last_response.result));
+        LOG_WRN("Unknown command: 0x%02x", cmd_id);
+        response->status = RESPONSE_ERROR_UNKNOWN_CMD;
         break;
     }
+}
+
+// The macro will generate control_command_write() wrapper that calls this
+/**
+ * @brief Handle control command requests - CLEAN VERSION!
+ * This function takes your struct directly, no BLE boilerplate needed.
+ */
+static ssize_t control_command_handler(control_conn_ctx_t *ctx,
+                                       const control_command_packet_t *packet)
+{
+    LOG_DBG("control_command_handler called");
+    LOG_DBG("Command received: 0x%02x", packet->cmd_id);
+    
+    control_execute_command(ctx, packet->cmd_id, packet->param1, packet->param2,
+                            &ctx->last_response);
 
-    last_response_valid = true;
-    control_notify_response();
+    ctx->last_response_valid = true;
+    control_notify_response(ctx);
     
     return sizeof(*packet);
 }
 
+// The macro will generate control_batch_write() wrapper that calls this
+/**
+ * @brief Handle batch command requests - VARIABLE LENGTH VERSION!
+ * 
+ * Executes every record in order and returns all results in a single
+ * notification on the batch response characteristic.
+ */
+static ssize_t control_batch_handler(control_conn_ctx_t *ctx, const void *data, uint16_t len)
+{
+    control_batch_response_t *batch_response = &ctx->batch_response;
+    const control_batch_packet_t *packet = (const control_batch_packet_t *)data;
+    
+    LOG_DBG("control_batch_handler called");
+    
+    /* The wrapper already checked len against count */
+    /* The whole response has to fit in one notification on this link */
+    uint16_t response_len = control_batch_response_len(packet->count);
+    uint16_t max_payload = ble_services_get_max_payload(ctx->conn);
+    if (response_len > max_payload) {
+        LOG_WRN("Batch response too large for MTU (%d > %d)",
+                response_len, max_payload);
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+    
+    LOG_DBG("Batch 0x%02x with %d commands", packet->batch_id, packet->count);
+    
+    batch_response->batch_id = packet->batch_id;
+    batch_response->count = packet->count;
+    batch_response->failed = 0;
+    
+    for (uint8_t i = 0; i < packet->count; i++) {
+        const control_batch_record_t *record = &packet->records[i];
+        
+        control_execute_command(ctx, record->cmd_id, record->param1, record->param2,
+                                &batch_response->results[i]);
+        if (batch_response->results[i].status != RESPONSE_SUCCESS) {
+            batch_response->failed++;
+        }
+    }
+    
+    ctx->batch_response_len = response_len;
+    LOG_DBG("Batch complete (%d failed)", batch_response->failed);
+    control_notify_batch_response(ctx);
+    
+    return len;
+}
+
 // The macro will generate control_response_read() wrapper that calls this
 /**
  * @brief Get control response - CLEAN VERSION!
  * This function fills your struct directly, no BLE boilerplate needed.
  */
-static ssize_t control_response_handler(control_response_packet_t *response)
+static ssize_t control_response_handler(control_conn_ctx_t *ctx,
+                                        control_response_packet_t *response)
 {
-    printk("\n=== Control Service: control_response_handler called ===\n");
-    printk("Control Service: Response read request\n");
+    LOG_DBG("control_response_handler called");
+    LOG_DBG("Response read request");
     
-    if (last_response_valid) {
+    if (ctx->last_response_valid) {
         // Copy the typed response struct
-        *response = last_response;
+        *response = ctx->last_response;
         return sizeof(*response);
     }
     
@@ -116,16 +365,320 @@ static ssize_t control_response_handler(control_response_packet_t *response)
  */
 static ssize_t control_status_handler(control_status_packet_t *status)
 {
-    printk("\n=== Control Service: control_status_handler called ===\n");
-    printk("Control Service: Status read request (status: %d)\n", device_status);
+    LOG_DBG("control_status_handler called");
+    LOG_DBG("Status read request (status: %d)", device_status);
     
-    status->device_status = device_status;
-    status->uptime = k_uptime_get() / 1000;
-    memset(status->reserved, 0, sizeof(status->reserved));
+    int64_t uptime_ms = fill_status(status);
     
+    /* Valid until the uptime ticks over to the next second */
+    ble_read_cache_keep(&control_status_cache, 1000 - (uptime_ms % 1000));
     return sizeof(*status);
 }
 
+// The macro will generate control_batch_response_read() wrapper that calls this
+/**
+ * @brief Get the last batch response - CLEAN VERSION!
+ * Lets clients without notifications enabled fetch batch results.
+ */
+static ssize_t control_batch_response_handler(control_conn_ctx_t *ctx,
+                                              control_batch_response_t *response)
+{
+    LOG_DBG("control_batch_response_handler called");
+    
+    if (ctx->batch_response_len == 0) {
+        /* No batch executed yet: empty header only */
+        return control_batch_response_len(0);
+    }
+    
+    memcpy(response, &ctx->batch_response, ctx->batch_response_len);
+    return ctx->batch_response_len;
+}
+
+// The macro will generate control_telemetry_read() wrapper that calls this
+/**
+ * @brief Get a telemetry snapshot - CLEAN VERSION!
+ * CPU figures cover the time since the previous sample (read or notification).
+ */
+static ssize_t control_telemetry_handler(control_conn_ctx_t *ctx,
+                                         control_telemetry_packet_t *telemetry)
+{
+    LOG_DBG("control_telemetry_handler called");
+    
+    int err = telemetry_sample(telemetry);
+    if (err) {
+        LOG_ERR("Telemetry sample failed (err %d)", err);
+        return BT_GATT_ERR(BT_ATT_ERR_UNLIKELY);
+    }
+    telemetry->timestamp_us = time_sync_to_client_us(ctx->conn, telemetry->timestamp_us);
+    
+    return sizeof(*telemetry);
+}
+
+// The macro will generate control_time_sync_write() wrapper that calls this
+/**
+ * @brief Handle a time sync probe - CLEAN VERSION!
+ * Answers with device receive/send times in a notification on the same
+ * characteristic.
+ */
+static ssize_t control_time_sync_handler(control_conn_ctx_t *ctx,
+                                         const control_time_sync_request_t *request)
+{
+    uint64_t t2_us = time_sync_now_us();
+    
+    int err = time_sync_handle_request(ctx->conn, request, t2_us, &ctx->time_sync_response);
+    if (err) {
+        LOG_ERR("Time sync request failed (err %d)", err);
+        return BT_GATT_ERR(BT_ATT_ERR_UNLIKELY);
+    }
+    control_notify_time_sync(ctx);
+    
+    return sizeof(*request);
+}
+
+// The macro will generate control_time_sync_read() wrapper that calls this
+/**
+ * @brief Get the last time sync response - CLEAN VERSION!
+ */
+static ssize_t control_time_sync_read_handler(control_conn_ctx_t *ctx,
+                                              control_time_sync_response_t *response)
+{
+    *response = ctx->time_sync_response;
+    return sizeof(*response);
+}
+
+// The macro will generate control_handler_stats_select_write() wrapper that calls this
+/**
+ * @brief Select the handler stats page - CLEAN VERSION!
+ * Optionally zeroes the table so a client can profile one workload.
+ */
+static ssize_t control_handler_stats_select_handler(control_conn_ctx_t *ctx,
+                                                    const control_handler_stats_select_t *select)
+{
+    ctx->handler_stats_first = select->first;
+    
+    if (select->flags & CONTROL_HANDLER_STATS_FLAG_RESET) {
+        ble_services_reset_handler_stats();
+        LOG_INF("Handler stats reset");
+    }
+    
+    return sizeof(*select);
+}
+
+// The macro will generate control_handler_stats_read() wrapper that calls this
+/**
+ * @brief Get one page of the handler stats table - CLEAN VERSION!
+ */
+static ssize_t control_handler_stats_handler(control_conn_ctx_t *ctx,
+                                             control_handler_stats_page_t *page)
+{
+    uint8_t total = ble_services_get_handler_stats_count();
+    
+    page->total = total;
+    page->first = ctx->handler_stats_first;
+    page->count = 0;
+    page->flags = IS_ENABLED(CONFIG_BLE_HANDLER_STATS) ? CONTROL_HANDLER_STATS_FLAG_ENABLED : 0;
+    page->timer_freq_hz = IS_ENABLED(CONFIG_BLE_HANDLER_STATS) ? (uint32_t)timing_freq_get() : 0;
+    
+    for (uint8_t index = page->first;
+         index < total && page->count < CONTROL_HANDLER_STATS_PAGE_SIZE; index++) {
+        const struct ble_handler_stats *stats = ble_services_get_handler_stats(index);
+        control_handler_stats_entry_t *entry = &page->entries[page->count++];
+        
+        strncpy(entry->name, stats->name, sizeof(entry->name) - 1);
+        entry->name[sizeof(entry->name) - 1] = '\0';
+        entry->calls = stats->calls;
+        entry->bytes = stats->bytes;
+        entry->errors = stats->errors;
+        entry->max_cycles = stats->max_cycles;
+        for (int i = 0; i < ARRAY_SIZE(entry->hist); i++) {
+            entry->hist[i] = MIN(stats->hist[i], UINT16_MAX);
+        }
+    }
+    
+    return control_handler_stats_page_len(page->count);
+}
+
+// The macro will generate control_trace_select_write() wrapper that calls this
+/**
+ * @brief Select the trace dump page - CLEAN VERSION!
+ * Freezes, clears or resumes recording first if asked to.
+ */
+static ssize_t control_trace_select_handler(control_conn_ctx_t *ctx,
+                                            const control_trace_select_t *select)
+{
+    ctx->trace_offset = select->offset;
+    
+    if (select->flags & CONTROL_TRACE_FLAG_FREEZE) {
+        app_trace_freeze(true);
+    }
+    if (select->flags & CONTROL_TRACE_FLAG_CLEAR) {
+        app_trace_clear();
+    }
+    if (select->flags & CONTROL_TRACE_FLAG_RESUME) {
+        app_trace_freeze(false);
+    }
+    if (select->flags) {
+        LOG_INF("Trace %s, %u dump bytes", app_trace_is_frozen() ? "frozen" : "recording",
+                app_trace_dump_size());
+    }
+    
+    return sizeof(*select);
+}
+
+// The macro will generate control_trace_read() wrapper that calls this
+/**
+ * @brief Get one page of the trace dump - CLEAN VERSION!
+ */
+static ssize_t control_trace_handler(control_conn_ctx_t *ctx, control_trace_page_t *page)
+{
+    int len = app_trace_dump_read(ctx->trace_offset, page->data, sizeof(page->data));
+    
+    page->total_len = app_trace_dump_size();
+    page->offset = ctx->trace_offset;
+    page->flags = (IS_ENABLED(CONFIG_APP_TRACE) ? CONTROL_TRACE_FLAG_ENABLED : 0) |
+                  (app_trace_is_frozen() ? CONTROL_TRACE_FLAG_FROZEN : 0);
+    
+    return offsetof(control_trace_page_t, data) + MAX(len, 0);
+}
+
+// The macro will generate control_memory_select_write() wrapper that calls this
+/**
+ * @brief Reset memory budget peaks - CLEAN VERSION!
+ */
+static ssize_t control_memory_select_handler(control_conn_ctx_t *ctx,
+                                             const control_memory_select_t *select)
+{
+    if (select->flags & CONTROL_MEMORY_FLAG_RESET_PEAKS) {
+        mem_budget_reset_peaks();
+        LOG_INF("Memory budget peaks reset");
+    }
+    
+    return sizeof(*select);
+}
+
+// The macro will generate control_memory_read() wrapper that calls this
+/**
+ * @brief Get memory budget usage - CLEAN VERSION!
+ */
+static ssize_t control_memory_handler(control_conn_ctx_t *ctx, control_memory_packet_t *packet)
+{
+    mem_budget_usage_t usage;
+    
+    mem_budget_get_pool_usage(&usage);
+    packet->pool_size = usage.quota;
+    packet->used = usage.used;
+    packet->peak = usage.peak;
+    packet->block_size = CONFIG_MEM_BUDGET_BLOCK_SIZE;
+    
+    for (uint8_t i = 0; i < MEM_BUDGET_CLIENT_COUNT; i++) {
+        control_memory_client_t *client = &packet->clients[packet->count++];
+        
+        mem_budget_get_usage(i, &usage);
+        strncpy(client->name, mem_budget_client_name(i), sizeof(client->name) - 1);
+        client->name[sizeof(client->name) - 1] = '\0';
+        client->quota = usage.quota;
+        client->used = usage.used;
+        client->peak = usage.peak;
+        client->failures = MIN(usage.failures, UINT16_MAX);
+    }
+    
+    return control_memory_packet_len(packet->count);
+}
+
+// The macro will generate control_benchmark_read() wrapper that calls this
+/**
+ * @brief Get the last benchmark result - CLEAN VERSION!
+ * Status is RUNNING while a run is in progress.
+ */
+static ssize_t control_benchmark_handler(control_benchmark_result_t *result)
+{
+    LOG_DBG("control_benchmark_handler called");
+    
+    *result = benchmark_result;
+    ble_read_cache_keep(&control_benchmark_cache, 0);
+    return sizeof(*result);
+}
+
+/* ============================================================================
+ * BENCHMARK
+ * ============================================================================ */
+
+static void benchmark_work_handler(struct k_work *work)
+{
+    control_benchmark_result_t result = benchmark_result;
+    
+    int err = benchmark_run(result.crc_kb, control_notify_benchmark, &result);
+    result.status = err ? CONTROL_BENCHMARK_STATUS_ERROR : CONTROL_BENCHMARK_STATUS_COMPLETE;
+    result.timestamp_us = time_sync_to_client_us(benchmark_conn, time_sync_now_us());
+    control_notify_benchmark(&result, sizeof(result));
+    
+    /* Release the requester before the status lets a new run take its place */
+    if (benchmark_conn) {
+        bt_conn_unref(benchmark_conn);
+        benchmark_conn = NULL;
+    }
+    benchmark_result = result;
+    ble_read_cache_invalidate(&control_benchmark_cache);
+}
+
+/* ============================================================================
+ * TELEMETRY STREAMING
+ * ============================================================================ */
+
+static void telemetry_work_handler(struct k_work *work)
+{
+    if (!telemetry_notify_enabled || !control_any_connected()) {
+        return;
+    }
+    
+    /* Sampled and sent from telemetry_fill() just before each subscriber's
+     * next connection event, so the sample is fresh when it goes on air */
+    atomic_inc(&telemetry_round);
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        if (control_ctx[i].conn) {
+            conn_sched_request(control_ctx[i].conn, &conn_sched_producer_telemetry);
+        }
+    }
+    
+    k_work_schedule(&telemetry_work, K_MSEC(CONTROL_TELEMETRY_INTERVAL_MS));
+}
+
+static void telemetry_fill(struct bt_conn *conn)
+{
+    control_conn_ctx_t *ctx = control_ctx_get(conn);
+    uint32_t round = atomic_get(&telemetry_round);
+    
+    if (!ctx || ctx->conn != conn) {
+        return;
+    }
+    
+    /* Load figures are deltas since the previous sample, so sample once per
+     * round and stamp the shared sample in each subscriber's own timebase */
+    if (round != telemetry_sampled_round) {
+        if (telemetry_sample(&telemetry_round_sample) != 0) {
+            return;
+        }
+        telemetry_sampled_round = round;
+    }
+    
+    control_telemetry_packet_t packet = telemetry_round_sample;
+    packet.timestamp_us = time_sync_to_client_us(conn, telemetry_round_sample.timestamp_us);
+    control_notify_telemetry(ctx, &packet);
+}
+
+static void control_telemetry_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    telemetry_notify_enabled = (value == BT_GATT_CCC_NOTIFY);
+    LOG_INF("Telemetry notifications %s",
+            telemetry_notify_enabled ? "enabled" : "disabled");
+    
+    if (telemetry_notify_enabled) {
+        k_work_schedule(&telemetry_work, K_NO_WAIT);
+    } else {
+        k_work_cancel_delayable(&telemetry_work);
+    }
+}
+
 
 
 /* ============================================================================
@@ -137,9 +690,28 @@ static ssize_t control_status_handler(control_status_packet_t *status)
  * ============================================================================ */
 
 /* Generate BLE wrappers automatically */
-BLE_WRITE_WRAPPER(control_command_handler, control_command_packet_t)
-BLE_READ_WRAPPER(control_response_handler, control_response_packet_t)  
-BLE_READ_WRAPPER(control_status_handler, control_status_packet_t)
+BLE_WRITE_WRAPPER_COMPACT_CTX(control_command_handler, control_command_packet_t,
+                              control_command_packet_decode, control_ctx_get)
+BLE_READ_WRAPPER_CTX(control_response_handler, control_response_packet_t, control_ctx_get)
+BLE_READ_WRAPPER_CACHED(control_status_handler, control_status_packet_t, control_status_cache)
+BLE_WRITE_WRAPPER_VARIABLE_CTX(control_batch_handler, CONTROL_BATCH_PACKET_MIN_SIZE,
+                               sizeof(control_batch_packet_t), control_batch_packet_validate,
+                               control_ctx_get)
+BLE_READ_WRAPPER_SNAPSHOT_CTX(control_batch_response_handler, control_batch_response_t,
+                              control_ctx_get)
+BLE_READ_WRAPPER_SNAPSHOT_CTX(control_telemetry_handler, control_telemetry_packet_t, control_ctx_get)
+BLE_READ_WRAPPER_CACHED(control_benchmark_handler, control_benchmark_result_t,
+                        control_benchmark_cache)
+BLE_WRITE_WRAPPER_CTX(control_time_sync_handler, control_time_sync_request_t, control_ctx_get)
+BLE_READ_WRAPPER_CTX(control_time_sync_read_handler, control_time_sync_response_t, control_ctx_get)
+BLE_WRITE_WRAPPER_CTX(control_handler_stats_select_handler, control_handler_stats_select_t,
+                      control_ctx_get)
+BLE_READ_WRAPPER_SNAPSHOT_CTX(control_handler_stats_handler, control_handler_stats_page_t,
+                              control_ctx_get)
+BLE_WRITE_WRAPPER_CTX(control_trace_select_handler, control_trace_select_t, control_ctx_get)
+BLE_READ_WRAPPER_SNAPSHOT_CTX(control_trace_handler, control_trace_page_t, control_ctx_get)
+BLE_WRITE_WRAPPER_CTX(control_memory_select_handler, control_memory_select_t, control_ctx_get)
+BLE_READ_WRAPPER_SNAPSHOT_CTX(control_memory_handler, control_memory_packet_t, control_ctx_get)
 
 /* ============================================================================
  * SERVICE DEFINITION
@@ -161,8 +733,232 @@ BT_GATT_SERVICE_DEFINE(control_service,
                           BT_GATT_PERM_READ,
                           control_status_handler_ble, NULL, NULL),
     BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(CONTROL_BATCH_UUID,
+                          BT_GATT_CHRC_WRITE | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                          BT_GATT_PERM_WRITE,
+                          NULL, control_batch_handler_ble, NULL),
+    BT_GATT_CHARACTERISTIC(CONTROL_BATCH_RESPONSE_UUID,
+                          BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                          BT_GATT_PERM_READ,
+                          control_batch_response_handler_ble, NULL, NULL),
+    BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(CONTROL_TELEMETRY_UUID,
+                          BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                          BT_GATT_PERM_READ,
+                          control_telemetry_handler_ble, NULL, NULL),
+    BT_GATT_CCC(control_telemetry_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(CONTROL_BENCHMARK_UUID,
+                          BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                          BT_GATT_PERM_READ,
+                          control_benchmark_handler_ble, NULL, NULL),
+    BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(CONTROL_TIME_SYNC_UUID,
+                          BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE | BT_GATT_CHRC_WRITE_WITHOUT_RESP |
+                          BT_GATT_CHRC_NOTIFY,
+                          BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+                          control_time_sync_read_handler_ble, control_time_sync_handler_ble, NULL),
+    BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(CONTROL_HANDLER_STATS_UUID,
+                          BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+                          BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+                          control_handler_stats_handler_ble,
+                          control_handler_stats_select_handler_ble, NULL),
+    BT_GATT_CHARACTERISTIC(CONTROL_TRACE_UUID,
+                          BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+                          BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+                          control_trace_handler_ble, control_trace_select_handler_ble, NULL),
+    BT_GATT_CHARACTERISTIC(CONTROL_MEMORY_UUID,
+                          BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+                          BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+                          control_memory_handler_ble, control_memory_select_handler_ble, NULL),
 );
 
+BLE_SERVICE_DEFINE(control, 20,
+    .name = "Control Service",
+    .uuid = 0xFFE0,
+    .init = control_service_init,
+    .connection = control_service_connection_event);
+
+/* ============================================================================
+ * NOTIFICATION HELPERS
+ * ============================================================================ */
+
+/**
+ * @brief bt_gatt_notify() with trace markers around the submission
+ */
+static int control_notify(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                          const void *data, uint16_t len)
+{
+    APP_TRACE_BEGIN(APP_TRACE_NOTIFY, bt_gatt_attr_get_handle(attr), len);
+    int err = bt_gatt_notify(conn, attr, data, len);
+    APP_TRACE_END(APP_TRACE_NOTIFY, bt_gatt_attr_get_handle(attr), err);
+    
+    return err;
+}
+
+/**
+ * @brief Send a connection's last batch response as a notification
+ * @param ctx Context of the connection that sent the batch
+ */
+static void control_notify_batch_response(control_conn_ctx_t *ctx)
+{
+    if (!ctx->conn) {
+        return;
+    }
+    
+    const struct bt_gatt_attr *attr = bt_gatt_find_by_uuid(control_service.attrs,
+                                                           control_service.attr_count,
+                                                           CONTROL_BATCH_RESPONSE_UUID);
+    if (!attr || !bt_gatt_is_subscribed(ctx->conn, attr, BT_GATT_CCC_NOTIFY)) {
+        LOG_DBG("Batch response ready (notifications disabled)");
+        return;
+    }
+    
+    int err = control_notify(ctx->conn, attr, &ctx->batch_response, ctx->batch_response_len);
+    if (err) {
+        LOG_ERR("Batch response notification failed (err %d)", err);
+    }
+}
+
+/**
+ * @brief Send a telemetry snapshot as a notification
+ * @param ctx Context of the connection to notify
+ * @param packet Telemetry snapshot to send
+ */
+static void control_notify_telemetry(control_conn_ctx_t *ctx, const control_telemetry_packet_t *packet)
+{
+    const struct bt_gatt_attr *attr = bt_gatt_find_by_uuid(control_service.attrs,
+                                                           control_service.attr_count,
+                                                           CONTROL_TELEMETRY_UUID);
+    if (!attr || !bt_gatt_is_subscribed(ctx->conn, attr, BT_GATT_CCC_NOTIFY)) {
+        return;
+    }
+    
+    /* Notifications are never fragmented; short-MTU clients have to read */
+    if (sizeof(*packet) > ble_services_get_max_payload(ctx->conn)) {
+        return;
+    }
+    
+    int err = control_notify(ctx->conn, attr, packet, sizeof(*packet));
+    if (err) {
+        LOG_ERR("Telemetry notification failed (err %d)", err);
+    }
+}
+
+/**
+ * @brief Send a benchmark result as a notification
+ * 
+ * Goes to the connection that started the run. Also used by the benchmark
+ * itself to time notification enqueue cost.
+ * 
+ * @param data Result to send
+ * @param len Length of data
+ * @return 0 on success, -ENOTCONN if the requester is not subscribed, -EMSGSIZE if
+ *         the requester's MTU is too small, or bt_gatt_notify() error
+ */
+static int control_notify_benchmark(const void *data, uint16_t len)
+{
+    struct bt_conn_info info;
+    
+    /* The reference outlives the link if the requester disconnected mid-run */
+    if (!benchmark_conn || bt_conn_get_info(benchmark_conn, &info) != 0 ||
+        info.state != BT_CONN_STATE_CONNECTED) {
+        return -ENOTCONN;
+    }
+    
+    const struct bt_gatt_attr *attr = bt_gatt_find_by_uuid(control_service.attrs,
+                                                           control_service.attr_count,
+                                                           CONTROL_BENCHMARK_UUID);
+    if (!attr || !bt_gatt_is_subscribed(benchmark_conn, attr, BT_GATT_CCC_NOTIFY)) {
+        return -ENOTCONN;
+    }
+    if (len > ble_services_get_max_payload(benchmark_conn)) {
+        return -EMSGSIZE;
+    }
+    
+    return control_notify(benchmark_conn, attr, data, len);
+}
+
+/**
+ * @brief Send a connection's last time sync response as a notification
+ * @param ctx Context of the connection that sent the probe
+ */
+static void control_notify_time_sync(control_conn_ctx_t *ctx)
+{
+    const struct bt_gatt_attr *attr = bt_gatt_find_by_uuid(control_service.attrs,
+                                                           control_service.attr_count,
+                                                           CONTROL_TIME_SYNC_UUID);
+    if (!attr || !bt_gatt_is_subscribed(ctx->conn, attr, BT_GATT_CCC_NOTIFY)) {
+        return;
+    }
+    if (sizeof(ctx->time_sync_response) > ble_services_get_max_payload(ctx->conn)) {
+        LOG_WRN("Time sync response exceeds MTU, client must read");
+        return;
+    }
+    
+    int err = control_notify(ctx->conn, attr, &ctx->time_sync_response,
+                             sizeof(ctx->time_sync_response));
+    if (err) {
+        LOG_ERR("Time sync notification failed (err %d)", err);
+    }
+}
+
+/**
+ * @brief Send the device status to every subscribed client
+ */
+static void control_notify_status(void)
+{
+    control_status_packet_t status;
+    
+    const struct bt_gatt_attr *attr = bt_gatt_find_by_uuid(control_service.attrs,
+                                                           control_service.attr_count,
+                                                           CONTROL_STATUS_UUID);
+    if (!attr) {
+        return;
+    }
+    
+    /* Not through the read handler - the read cache belongs to the BT RX thread */
+    fill_status(&status);
+    
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        control_conn_ctx_t *ctx = &control_ctx[i];
+        
+        if (!ctx->conn || !bt_gatt_is_subscribed(ctx->conn, attr, BT_GATT_CCC_NOTIFY)) {
+            continue;
+        }
+        
+        int err = control_notify(ctx->conn, attr, &status, sizeof(status));
+        if (err) {
+            LOG_ERR("Status notification failed (err %d)", err);
+        }
+    }
+}
+
+/* ============================================================================
+ * EVENT SUBSCRIBER
+ * ============================================================================ */
+
+/**
+ * @brief Push state changes to subscribed clients
+ * 
+ * Device status changes go out on the status characteristic; any change
+ * also brings the next telemetry sample forward so streaming clients see
+ * it without waiting for the interval.
+ */
+static void control_event_handler(uint32_t events)
+{
+    if (events & (EVENT_CONNECTION | EVENT_DEVICE_STATUS)) {
+        control_notify_status();
+    }
+    
+    if (telemetry_notify_enabled) {
+        k_work_reschedule(&telemetry_work, K_NO_WAIT);
+    }
+}
+
+EVENT_SUBSCRIBER_DEFINE(control, EVENT_CONNECTION | EVENT_DEVICE_STATUS | EVENT_WASM_STATUS |
+                        EVENT_DFU_STATE | EVENT_RELAY_STATE, control_event_handler);
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
@@ -170,29 +966,66 @@ BT_GATT_SERVICE_DEFINE(control_service,
 int control_service_init(void)
 {
     device_status = DEVICE_STATUS_IDLE;
-    last_response_valid = false;
-    memset(&last_response, 0, sizeof(last_response));
-    control_conn = NULL;
+    memset(control_ctx, 0, sizeof(control_ctx));
+    telemetry_notify_enabled = false;
+    memset(&benchmark_result, 0, sizeof(benchmark_result));
+    benchmark_conn = NULL;
+    
+    int err = telemetry_init();
+    if (err) {
+        return err;
+    }
+    
+    err = time_sync_init();
+    if (err) {
+        return err;
+    }
     
-    printk("Control Service: Initialized\n");
-    printk("  Command characteristic: WRITE\n");
-    printk("  Response characteristic: READ + NOTIFY\n");
-    printk("  Status characteristic: READ + NOTIFY\n");
+    LOG_INF("Initialized");
+    LOG_INF("  Command characteristic: WRITE");
+    LOG_INF("  Response characteristic: READ + NOTIFY");
+    LOG_INF("  Status characteristic: READ + NOTIFY");
+    LOG_INF("  Batch characteristic: WRITE + WRITE_WITHOUT_RESP (max %d commands)",
+            CONTROL_BATCH_MAX_COMMANDS);
+    LOG_INF("  Batch response characteristic: READ + NOTIFY");
+    LOG_INF("  Telemetry characteristic: READ + NOTIFY (every %d ms)",
+            CONTROL_TELEMETRY_INTERVAL_MS);
+    LOG_INF("  Benchmark characteristic: READ + NOTIFY");
+    LOG_INF("  Time sync characteristic: READ + WRITE + NOTIFY");
+    LOG_INF("  Handler stats characteristic: READ + WRITE (%d handlers)",
+            ble_services_get_handler_stats_count());
+    LOG_INF("  Trace characteristic: READ + WRITE (%s)",
+            IS_ENABLED(CONFIG_APP_TRACE) ? "recording" : "disabled");
+    LOG_INF("  Memory characteristic: READ + WRITE (%d byte pool)", CONFIG_MEM_BUDGET_POOL_SIZE);
+    LOG_INF("  Connection contexts: %d", CONFIG_BT_MAX_CONN);
     
     return 0;
 }
 
 void control_service_connection_event(struct bt_conn *conn, bool connected)
 {
+    control_conn_ctx_t *ctx = control_ctx_get(conn);
+    
+    if (!ctx) {
+        return;
+    }
+    
     if (connected) {
-        printk("Control Service: Client connected\n");
-        control_conn = conn;
+        LOG_INF("Client connected");
+        memset(ctx, 0, sizeof(*ctx));
+        ctx->conn = conn;
         device_status = DEVICE_STATUS_BUSY; // Device is now busy (connected)
+        ble_read_cache_invalidate(&control_status_cache);
     } else {
-        printk("Control Service: Client disconnected\n");
-        if (conn == control_conn) {
-            control_conn = NULL;
+        LOG_INF("Client disconnected");
+        time_sync_reset(conn);
+        memset(ctx, 0, sizeof(*ctx));
+        /* A running benchmark keeps its reference until it completes */
+        if (!control_any_connected()) {
+            telemetry_notify_enabled = false;
+            k_work_cancel_delayable(&telemetry_work);
             device_status = DEVICE_STATUS_IDLE; // Device is now idle
+            ble_read_cache_invalidate(&control_status_cache);
         }
     }
 }
@@ -205,51 +1038,61 @@ uint8_t control_service_get_device_status(void)
 void control_service_set_device_status(uint8_t status)
 {
     if (status != device_status) {
-        printk("Control Service: Device status changed from %d to %d\n", 
-               device_status, status);
+        LOG_INF("Device status changed from %d to %d", 
+                device_status, status);
         device_status = status;
+        ble_read_cache_invalidate(&control_status_cache);
+        event_bus_publish(EVENT_DEVICE_STATUS);
     }
 }
 
 int control_service_send_response(const uint8_t *response_data, uint16_t length)
 {
-    if (!response_data || length == 0 || length > sizeof(last_response)) {
+    control_response_packet_t response;
+    
+    if (!response_data || length == 0 || length > sizeof(response)) {
         return -EINVAL;
     }
     
     // For backwards compatibility, copy raw data into response struct
     if (length >= 2) {
-        last_response.cmd_id = response_data[0];
-        last_response.status = response_data[1];
+        memset(&response, 0, sizeof(response));
+        response.cmd_id = response_data[0];
+        response.status = response_data[1];
         
         // Copy remaining data into result field
         uint16_t result_len = length - 2;
-        if (result_len > sizeof(last_response.result)) {
-            result_len = sizeof(last_response.result);
+        if (result_len > sizeof(response.result)) {
+            result_len = sizeof(response.result);
         }
-        memcpy(last_response.result, &response_data[2], result_len);
+        memcpy(response.result, &response_data[2], result_len);
         
-        // Clear remaining result bytes
-        if (result_len < sizeof(last_response.result)) {
-            memset(&last_response.result[result_len], 0, sizeof(last_response.result) - result_len);
+        // Unsolicited responses go to every connected client
+        for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+            control_conn_ctx_t *ctx = &control_ctx[i];
+            if (!ctx->conn) {
+                continue;
+            }
+            ctx->last_response = response;
+            ctx->last_response_valid = true;
+            control_notify_response(ctx);
         }
-        
-        last_response_valid = true;
-        control_notify_response();
         return 0;
     }
     
     return -EINVAL;
 }
 
-int control_service_get_last_response(uint8_t *buffer, uint16_t max_length)
+int control_service_get_last_response(struct bt_conn *conn, uint8_t *buffer, uint16_t max_length)
 {
-    if (!buffer || max_length == 0 || !last_response_valid) {
+    control_conn_ctx_t *ctx = control_ctx_get(conn);
+    
+    if (!ctx || !buffer || max_length == 0 || !ctx->last_response_valid) {
         return -EINVAL;
     }
     
-    uint16_t copy_len = (sizeof(last_response) < max_length) ? sizeof(last_response) : max_length;
-    memcpy(buffer, &last_response, copy_len);
+    uint16_t copy_len = (sizeof(ctx->last_response) < max_length) ? sizeof(ctx->last_response) : max_length;
+    memcpy(buffer, &ctx->last_response, copy_len);
     
     return copy_len;
 }
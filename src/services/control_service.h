@@ -4,6 +4,7 @@
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/conn.h>
 #include <stdint.h>
+#include "mem_budget.h"
 
 /**
  * @file control_service.h
@@ -31,6 +32,11 @@ typedef struct {
     uint8_t reserved[17]; ///< Reserved for future use
 } __attribute__((packed)) control_command_packet_t;
 
+/* Field numbers in the compact encoding (compact_codec.h), all varints */
+#define CONTROL_COMMAND_FIELD_CMD_ID    1
+#define CONTROL_COMMAND_FIELD_PARAM1    2
+#define CONTROL_COMMAND_FIELD_PARAM2    3
+
 /**
  * @brief Control response packet structure
  * 
@@ -55,6 +61,313 @@ typedef struct {
     uint8_t reserved[3];   ///< Reserved for future use
 } __attribute__((packed)) control_status_packet_t;
 
+/* Batch limits: the response notification (3 + 8 * count bytes) must fit in
+ * a single ATT payload at the largest supported MTU (247 - 3 = 244 bytes). */
+#define CONTROL_BATCH_MAX_COMMANDS      30
+#define CONTROL_BATCH_HEADER_SIZE       2
+#define CONTROL_BATCH_RECORD_SIZE       3
+#define CONTROL_BATCH_PACKET_MIN_SIZE   (CONTROL_BATCH_HEADER_SIZE + CONTROL_BATCH_RECORD_SIZE)
+#define CONTROL_BATCH_PACKET_MAX_SIZE   (CONTROL_BATCH_HEADER_SIZE + \
+                                         CONTROL_BATCH_MAX_COMMANDS * CONTROL_BATCH_RECORD_SIZE)
+#define CONTROL_BATCH_RESPONSE_HEADER_SIZE 3
+
+/**
+ * @brief Control batch record structure
+ * 
+ * One (opcode, params) entry inside a batch command packet.
+ * Total size: 3 bytes
+ */
+typedef struct {
+    uint8_t cmd_id;      ///< Command identifier (CMD_*)
+    uint8_t param1;      ///< First parameter
+    uint8_t param2;      ///< Second parameter
+} __attribute__((packed)) control_batch_record_t;
+
+/**
+ * @brief Control batch command packet structure (variable size)
+ * 
+ * Packs several command records into a single write so a provisioning
+ * sequence costs one round trip instead of one per command.
+ * Size: 2 + count * 3 bytes (5 to 92 bytes)
+ */
+typedef struct {
+    uint8_t batch_id;    ///< Client-chosen tag echoed in the response
+    uint8_t count;       ///< Number of records that follow
+    control_batch_record_t records[CONTROL_BATCH_MAX_COMMANDS]; ///< Command records
+} __attribute__((packed)) control_batch_packet_t;
+
+/**
+ * @brief Control batch response packet structure (variable size)
+ * 
+ * Carries the results of every record of a batch in one notification,
+ * in the same order as the records were sent.
+ * Size: 3 + count * 8 bytes (11 to 243 bytes)
+ */
+typedef struct {
+    uint8_t batch_id;    ///< Tag copied from the batch command
+    uint8_t count;       ///< Number of results that follow
+    uint8_t failed;      ///< Number of results with a non-success status
+    control_response_packet_t results[CONTROL_BATCH_MAX_COMMANDS]; ///< Per-record results
+} __attribute__((packed)) control_batch_response_t;
+
+/* Telemetry tracks these threads, in this order */
+#define CONTROL_TELEMETRY_THREAD_BT_RX      0
+#define CONTROL_TELEMETRY_THREAD_SYSWORKQ   1
+#define CONTROL_TELEMETRY_THREAD_WASM       2
+#define CONTROL_TELEMETRY_THREAD_COUNT      3
+
+/* Telemetry notification period while a client is subscribed */
+#define CONTROL_TELEMETRY_INTERVAL_MS       1000
+
+/**
+ * @brief Per-thread telemetry record
+ *
+ * Stack high-water mark and CPU share of one tracked thread.
+ * Total size: 6 bytes
+ */
+typedef struct {
+    uint16_t stack_size;     ///< Stack size in bytes
+    uint16_t stack_unused;   ///< Stack bytes never touched since boot
+    uint16_t cpu_permille;   ///< CPU share since the previous sample (0-1000)
+} __attribute__((packed)) control_telemetry_thread_t;
+
+/**
+ * @brief Control telemetry packet structure
+ *
+ * System health snapshot used to size stacks, heaps and buffer pools
+ * from measured numbers. CPU figures are deltas since the previous sample.
+ * Total size: 48 bytes
+ */
+typedef struct {
+    uint32_t uptime_ms;          ///< Sample time in milliseconds since boot
+    uint16_t cpu_load_permille;  ///< Non-idle CPU share (0-1000)
+    uint16_t idle_permille;      ///< Idle CPU share (0-1000)
+    control_telemetry_thread_t threads[CONTROL_TELEMETRY_THREAD_COUNT]; ///< BT RX, sysworkq, WASM thread
+    uint32_t wasm3_heap_size;    ///< wasm3 fixed heap size in bytes
+    uint32_t wasm3_heap_used;    ///< wasm3 runtime stack + linear memory in bytes
+    uint8_t bt_tx_bufs_total;    ///< BT TX buffers in all TX pools
+    uint8_t bt_tx_bufs_free;     ///< BT TX buffers currently free
+    uint8_t bt_rx_bufs_total;    ///< BT RX buffers in all RX pools
+    uint8_t bt_rx_bufs_free;     ///< BT RX buffers currently free
+    uint8_t thread_count;        ///< Number of threads in the system
+    uint8_t reserved[1];         ///< Reserved for future use
+    uint64_t timestamp_us;       ///< Sample time in the client timebase (see time sync)
+} __attribute__((packed)) control_telemetry_packet_t;
+
+/* Benchmark run status */
+#define CONTROL_BENCHMARK_STATUS_IDLE       0x00
+#define CONTROL_BENCHMARK_STATUS_RUNNING    0x01
+#define CONTROL_BENCHMARK_STATUS_COMPLETE   0x02
+#define CONTROL_BENCHMARK_STATUS_ERROR      0x03
+
+/* Benchmark skipped-test bits */
+#define CONTROL_BENCHMARK_SKIP_SPRITE       0x01    /* Registry not empty */
+#define CONTROL_BENCHMARK_SKIP_WASM         0x02    /* WASM thread busy or setup failed */
+#define CONTROL_BENCHMARK_SKIP_NOTIFY       0x04    /* Results not subscribed */
+
+/* CMD_RUN_BENCHMARK param1: CRC16 input size in KB (0 = default) */
+#define CONTROL_BENCHMARK_CRC_KB_DEFAULT    4
+#define CONTROL_BENCHMARK_CRC_KB_MAX        64
+
+/**
+ * @brief Control benchmark result packet structure
+ *
+ * Cycle counts from the on-device benchmark suite, measured with the
+ * timing subsystem (DWT cycle counter on the application core).
+ * Total size: 48 bytes
+ */
+typedef struct {
+    uint8_t status;                ///< Run status (CONTROL_BENCHMARK_STATUS_*)
+    uint8_t run_id;                ///< Incremented on every accepted run
+    uint8_t skipped;               ///< Skipped tests (CONTROL_BENCHMARK_SKIP_*)
+    uint8_t crc_kb;                ///< CRC16 input size in KB
+    uint32_t timer_freq_hz;        ///< Cycle counter frequency
+    uint32_t crc16_cycles;         ///< CRC16 over crc_kb KB
+    uint32_t sprite_store_cycles;  ///< Storing 256 sprites into an empty registry
+    uint32_t sprite_lookup_cycles; ///< Looking up all 256 sprites
+    uint32_t wasm_call_cycles;     ///< One call to an empty WASM export
+    uint32_t memcpy_cycles;        ///< Copying memcpy_bytes bytes
+    uint32_t memcpy_bytes;         ///< Bytes copied in the memcpy test
+    uint32_t notify_cycles;        ///< One bt_gatt_notify() enqueue
+    uint32_t handler_cycles;       ///< One data upload handler call, max-size packet
+    uint64_t timestamp_us;         ///< Completion time in the client timebase (see time sync)
+} __attribute__((packed)) control_benchmark_result_t;
+
+/* Time sync response flags */
+#define CONTROL_TIME_SYNC_FLAG_OFFSET_VALID 0x01    /* offset_us is usable */
+#define CONTROL_TIME_SYNC_FLAG_DRIFT_VALID  0x02    /* drift_ppb is usable */
+
+/**
+ * @brief Control time sync request packet structure
+ *
+ * One NTP-style probe. The client stamps t1 just before writing and sends
+ * the receive time t4 of the previous response, which completes that
+ * exchange on the device.
+ * Total size: 18 bytes
+ */
+typedef struct {
+    uint8_t seq;                 ///< Client sequence number, echoed in the response
+    uint8_t reserved;            ///< Reserved for future use
+    uint64_t client_t1_us;       ///< Client send time of this request
+    uint64_t prev_client_t4_us;  ///< Client receive time of the previous response (0 = none)
+} __attribute__((packed)) control_time_sync_request_t;
+
+/**
+ * @brief Control time sync response packet structure
+ *
+ * Device timestamps for the probe plus the current estimate, where
+ * client_us = device_us + offset_us + drift_ppb * (device_us - t2 of the
+ * latest sample) / 1e9.
+ * Total size: 44 bytes
+ */
+typedef struct {
+    uint8_t seq;                 ///< Sequence number from the request
+    uint8_t flags;               ///< CONTROL_TIME_SYNC_FLAG_*
+    uint8_t sample_count;        ///< Completed exchanges in the estimate window
+    uint8_t reserved;            ///< Reserved for future use
+    uint64_t client_t1_us;       ///< Echo of the request's client_t1_us
+    uint64_t device_t2_us;       ///< Device receive time of the request
+    uint64_t device_t3_us;       ///< Device send time of this response
+    int64_t offset_us;           ///< Estimated client minus device time
+    int32_t drift_ppb;           ///< Estimated client clock rate relative to the device
+    uint32_t rtt_us;             ///< Round trip of the best sample in the window
+} __attribute__((packed)) control_time_sync_response_t;
+
+/* Handler stats select flags */
+#define CONTROL_HANDLER_STATS_FLAG_RESET    0x01    /* Zero the table after selecting */
+
+/* Handler stats page flags */
+#define CONTROL_HANDLER_STATS_FLAG_ENABLED  0x01    /* Built with CONFIG_BLE_HANDLER_STATS */
+
+#define CONTROL_HANDLER_STATS_NAME_LEN      24
+#define CONTROL_HANDLER_STATS_PAGE_SIZE     4       /* Entries per read */
+#define CONTROL_HANDLER_STATS_HEADER_SIZE   8
+
+/**
+ * @brief Control handler stats select packet structure
+ *
+ * Selects the first table entry returned by the next reads.
+ * Total size: 2 bytes
+ */
+typedef struct {
+    uint8_t first;               ///< Index of the first entry on the page
+    uint8_t flags;               ///< CONTROL_HANDLER_STATS_FLAG_RESET
+} __attribute__((packed)) control_handler_stats_select_t;
+
+/**
+ * @brief One characteristic handler's statistics
+ *
+ * Histogram bucket n counts calls that took less than 256 * 4^n cycles;
+ * the last bucket takes the rest. Counts saturate at 0xFFFF.
+ * Total size: 56 bytes
+ */
+typedef struct {
+    char name[CONTROL_HANDLER_STATS_NAME_LEN]; ///< Handler name, truncated to fit, NUL terminated
+    uint32_t calls;              ///< ATT requests served
+    uint32_t bytes;              ///< Payload bytes written or read
+    uint32_t errors;             ///< ATT error returns
+    uint32_t max_cycles;         ///< Slowest call
+    uint16_t hist[8];            ///< Cycle histogram
+} __attribute__((packed)) control_handler_stats_entry_t;
+
+/**
+ * @brief Control handler stats page structure
+ *
+ * Read returns the header and count entries starting at first; page
+ * through the table by selecting first + count until it reaches total.
+ * Total size: 8 + count * 56 bytes (232 max)
+ */
+typedef struct {
+    uint8_t total;               ///< Entries in the table
+    uint8_t first;               ///< Index of entries[0]
+    uint8_t count;               ///< Entries on this page
+    uint8_t flags;               ///< CONTROL_HANDLER_STATS_FLAG_ENABLED
+    uint32_t timer_freq_hz;      ///< Cycle counter frequency
+    control_handler_stats_entry_t entries[CONTROL_HANDLER_STATS_PAGE_SIZE];
+} __attribute__((packed)) control_handler_stats_page_t;
+
+/* Trace select flags */
+#define CONTROL_TRACE_FLAG_FREEZE           0x01    /* Stop recording so the dump can be read */
+#define CONTROL_TRACE_FLAG_CLEAR            0x02    /* Empty the ring */
+#define CONTROL_TRACE_FLAG_RESUME           0x04    /* Record again, after clearing if set */
+
+/* Trace page flags */
+#define CONTROL_TRACE_FLAG_ENABLED          0x01    /* Built with CONFIG_APP_TRACE */
+#define CONTROL_TRACE_FLAG_FROZEN           0x02    /* Recording stopped, dump readable */
+
+#define CONTROL_TRACE_PAGE_SIZE             232     /* Dump bytes per read */
+
+/**
+ * @brief Control trace select packet structure
+ *
+ * Selects the dump offset returned by the next reads, after applying the
+ * flags in the order FREEZE, CLEAR, RESUME.
+ * Total size: 5 bytes
+ */
+typedef struct {
+    uint32_t offset;             ///< Offset of the first dump byte on the page
+    uint8_t flags;               ///< CONTROL_TRACE_FLAG_FREEZE / CLEAR / RESUME
+} __attribute__((packed)) control_trace_select_t;
+
+/**
+ * @brief Control trace page structure
+ *
+ * Read returns the header and up to CONTROL_TRACE_PAGE_SIZE bytes of the
+ * trace dump (app_trace.h) starting at offset; page through the dump by
+ * selecting offset + length until it reaches total_len. The dump is
+ * empty unless recording is frozen.
+ * Total size: 12 + data bytes (244 max)
+ */
+typedef struct {
+    uint32_t total_len;          ///< Bytes in the dump
+    uint32_t offset;             ///< Offset of data[0] in the dump
+    uint8_t flags;               ///< CONTROL_TRACE_FLAG_ENABLED / FROZEN
+    uint8_t reserved[3];         ///< Reserved for future use
+    uint8_t data[CONTROL_TRACE_PAGE_SIZE]; ///< Dump bytes
+} __attribute__((packed)) control_trace_page_t;
+
+/* Memory select flags */
+#define CONTROL_MEMORY_FLAG_RESET_PEAKS     0x01    /* Restart peaks from current usage, zero refusals */
+
+/**
+ * @brief Control memory select packet structure
+ * Total size: 1 byte
+ */
+typedef struct {
+    uint8_t flags;               ///< CONTROL_MEMORY_FLAG_RESET_PEAKS
+} __attribute__((packed)) control_memory_select_t;
+
+/**
+ * @brief One memory budget client's usage
+ * Total size: 24 bytes
+ */
+typedef struct {
+    char name[MEM_BUDGET_NAME_LEN]; ///< Client name, NUL terminated
+    uint32_t quota;              ///< Bytes the client may hold
+    uint32_t used;               ///< Bytes held now, in whole blocks
+    uint32_t peak;               ///< Most bytes held at once
+    uint16_t failures;           ///< Borrows refused, saturates at 0xFFFF
+    uint16_t reserved;           ///< Reserved for future use
+} __attribute__((packed)) control_memory_client_t;
+
+/**
+ * @brief Control memory packet structure
+ *
+ * Usage of the shared buffer pool (mem_budget.h) followed by one entry
+ * per client, indexed by MEM_BUDGET_*. Client quotas may add up to more
+ * than the pool.
+ * Total size: 16 + count * 24 bytes (88 max)
+ */
+typedef struct {
+    uint32_t pool_size;          ///< Bytes in the pool
+    uint32_t used;               ///< Bytes borrowed now
+    uint32_t peak;               ///< Most bytes borrowed at once
+    uint16_t block_size;         ///< Allocation unit
+    uint8_t count;               ///< Client entries that follow
+    uint8_t reserved;            ///< Reserved for future use
+    control_memory_client_t clients[MEM_BUDGET_CLIENT_COUNT];
+} __attribute__((packed)) control_memory_packet_t;
+
 /* ============================================================================
  * CONTROL SERVICE DEFINITIONS
  * ============================================================================ */
@@ -64,11 +377,27 @@ static const struct bt_uuid_16 control_service_uuid = BT_UUID_INIT_16(0xFFE0);
 static const struct bt_uuid_16 control_command_uuid = BT_UUID_INIT_16(0xFFE1);
 static const struct bt_uuid_16 control_response_uuid = BT_UUID_INIT_16(0xFFE2);
 static const struct bt_uuid_16 control_status_uuid = BT_UUID_INIT_16(0xFFE3);
+static const struct bt_uuid_16 control_batch_uuid = BT_UUID_INIT_16(0xFFE4);
+static const struct bt_uuid_16 control_batch_response_uuid = BT_UUID_INIT_16(0xFFE5);
+static const struct bt_uuid_16 control_telemetry_uuid = BT_UUID_INIT_16(0xFFE6);
+static const struct bt_uuid_16 control_benchmark_uuid = BT_UUID_INIT_16(0xFFE7);
+static const struct bt_uuid_16 control_time_sync_uuid = BT_UUID_INIT_16(0xFFE8);
+static const struct bt_uuid_16 control_handler_stats_uuid = BT_UUID_INIT_16(0xFFE9);
+static const struct bt_uuid_16 control_trace_uuid = BT_UUID_INIT_16(0xFFEA);
+static const struct bt_uuid_16 control_memory_uuid = BT_UUID_INIT_16(0xFFEB);
 
 #define CONTROL_SERVICE_UUID        (&control_service_uuid.uuid)
 #define CONTROL_COMMAND_UUID        (&control_command_uuid.uuid)
 #define CONTROL_RESPONSE_UUID       (&control_response_uuid.uuid)
 #define CONTROL_STATUS_UUID         (&control_status_uuid.uuid)
+#define CONTROL_BATCH_UUID          (&control_batch_uuid.uuid)
+#define CONTROL_BATCH_RESPONSE_UUID (&control_batch_response_uuid.uuid)
+#define CONTROL_TELEMETRY_UUID      (&control_telemetry_uuid.uuid)
+#define CONTROL_BENCHMARK_UUID      (&control_benchmark_uuid.uuid)
+#define CONTROL_TIME_SYNC_UUID      (&control_time_sync_uuid.uuid)
+#define CONTROL_HANDLER_STATS_UUID  (&control_handler_stats_uuid.uuid)
+#define CONTROL_TRACE_UUID          (&control_trace_uuid.uuid)
+#define CONTROL_MEMORY_UUID         (&control_memory_uuid.uuid)
 
 /* ============================================================================
  * CONTROL COMMANDS
@@ -78,6 +407,32 @@ static const struct bt_uuid_16 control_status_uuid = BT_UUID_INIT_16(0xFFE3);
 #define CMD_RESET_DEVICE            0x02
 #define CMD_SET_CONFIG              0x03
 #define CMD_GET_VERSION             0x04
+#define CMD_RUN_BENCHMARK           0x05
+#define CMD_SET_LINK_PROFILE        0x06    /* param1: LINK_PROFILE_* */
+#define CMD_GET_LINK_INFO           0x07
+#define CMD_START_RELAY             0x08    /* param1: RELAY_CONTENT_*, param2: hops */
+#define CMD_GET_RELAY_STATUS        0x09
+#define CMD_SET_TX_SCHEDULING       0x0A    /* param1: 1 to align this connection's notifications, 0 not to */
+#define CMD_SET_ENCODING            0x0B    /* param1: COMPACT_ENCODING_* for this connection's writes */
+
+/* CMD_GET_LINK_INFO result layout */
+#define LINK_INFO_RESULT_PROFILE        0   /* LINK_PROFILE_* last requested */
+#define LINK_INFO_RESULT_TX_PHY         1   /* BT_GAP_LE_PHY_* */
+#define LINK_INFO_RESULT_INTERVAL       2   /* 2 bytes LE, 1.25 ms units */
+#define LINK_INFO_RESULT_TX_DATA_LEN    4   /* LL TX payload octets */
+#define LINK_INFO_RESULT_MTU            5   /* ATT MTU, capped at 255 */
+
+/* CMD_SET_ENCODING result layout */
+#define ENCODING_RESULT_ACTIVE          0   /* COMPACT_ENCODING_* in use from the next write */
+#define ENCODING_RESULT_LATEST          1   /* Highest encoding the firmware supports */
+
+/* CMD_GET_RELAY_STATUS result layout */
+#define RELAY_RESULT_STATE              0   /* RELAY_STATE_* */
+#define RELAY_RESULT_UPDATED            1   /* Peers that received content */
+#define RELAY_RESULT_SKIPPED            2   /* Peers already up to date */
+#define RELAY_RESULT_FAILED             3   /* Peers that could not be updated */
+#define RELAY_RESULT_ACTIVE             4   /* Peers being forwarded to */
+#define RELAY_RESULT_ELAPSED_S          5   /* Seconds since start, capped at 255 */
 
 /* ============================================================================
  * DEVICE STATUS CODES
@@ -93,6 +448,7 @@ static const struct bt_uuid_16 control_status_uuid = BT_UUID_INIT_16(0xFFE3);
 
 #define RESPONSE_SUCCESS            0x00
 #define RESPONSE_ERROR_INVALID_DATA 0x01
+#define RESPONSE_ERROR_BUSY         0x02
 #define RESPONSE_ERROR_UNKNOWN_CMD  0xFF
 
 /* ============================================================================
@@ -102,8 +458,9 @@ static const struct bt_uuid_16 control_status_uuid = BT_UUID_INIT_16(0xFFE3);
 /**
  * @brief Initialize Control Service
  * 
- * Registers the Control Service with command, response, and status
- * characteristics for device control operations.
+ * Registers the Control Service with command, response, status, batch,
+ * telemetry, benchmark and time sync characteristics for device control
+ * operations.
  * 
  * @return 0 on success, negative error code on failure
  */
@@ -132,9 +489,9 @@ uint8_t control_service_get_device_status(void);
 void control_service_set_device_status(uint8_t status);
 
 /**
- * @brief Send asynchronous response to connected client
+ * @brief Send asynchronous response to connected clients
  * 
- * Sends a response via notification to the connected client.
+ * Sends a response via notification to every connected client.
  * Used for responses that don't directly correspond to a command.
  * 
  * @param response_data Response data buffer
@@ -144,11 +501,12 @@ void control_service_set_device_status(uint8_t status);
 int control_service_send_response(const uint8_t *response_data, uint16_t length);
 
 /**
- * @brief Get last response data
+ * @brief Get last response data for a connection
+ * @param conn Connection whose last response to return
  * @param buffer Buffer to copy response data to
  * @param max_length Maximum buffer size
  * @return Number of bytes copied, or negative error code
  */
-int control_service_get_last_response(uint8_t *buffer, uint16_t max_length);
+int control_service_get_last_response(struct bt_conn *conn, uint8_t *buffer, uint16_t max_length);
 
 #endif /* CONTROL_SERVICE_H */
@@ -1,7 +1,10 @@
 #include "data_service.h"
 #include "ble_packet_handlers.h"
+#include "ble_protocol_gen.h"
 #include "ble_services.h"
-#include <zephyr/sys/printk.h>
+#include "mem_budget.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
 #include <string.h>
 
 /**
@@ -9,23 +12,48 @@
  * @brief Custom Data Service implementation
  */
 
+LOG_MODULE_REGISTER(data_service, CONFIG_DATA_SERVICE_LOG_LEVEL);
+
 /* ============================================================================
  * STATIC DATA
  * ============================================================================ */
 
-static uint8_t data_buffer[DATA_BUFFER_SIZE];
-static uint16_t data_buffer_size = 0;
-static uint8_t transfer_status = TRANSFER_STATUS_IDLE;
-static struct bt_conn *data_conn = NULL;
+/* Per-connection transfer state - uploads from one central never reach another.
+ * Each write is a complete message and lands directly in the echo buffer,
+ * DATA_BUFFER_SIZE bytes borrowed from the memory budget on the first
+ * upload and held until disconnect, so the write path never allocates. */
+typedef struct {
+    struct bt_conn *conn;
+    uint8_t transfer_status;
+
+    /* Echo buffer - the last uploaded data, echoed back on download */
+    uint8_t *echo_buffer;
+    uint16_t echo_buffer_size;
+} data_conn_ctx_t;
+
+BLE_CONN_CONTEXT_DEFINE(data_conn_ctx_t, data_ctx)
 
-/* Echo buffer - stores the last uploaded data to echo back */
-static uint8_t echo_buffer[DATA_BUFFER_SIZE];
-static uint16_t echo_buffer_size = 0;
+BUILD_ASSERT(CONFIG_MEM_BUDGET_DATA_QUOTA >= ROUND_UP(DATA_BUFFER_SIZE, CONFIG_MEM_BUDGET_BLOCK_SIZE),
+             "Data quota must hold one connection's echo buffer");
+BUILD_ASSERT(DATA_PACKET_SIZE_MAX <= DATA_BUFFER_SIZE, "An upload must fit the echo buffer");
 
-/* Static download data */
+/* Static download data - returned to clients that have not uploaded anything */
 static const char *download_data = "Sample data from nRF5340 device";
 static uint16_t download_data_length = 0;
 
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Return a borrowed buffer to the memory budget
+ */
+static void release_buffer(uint8_t **buffer)
+{
+    mem_budget_free(MEM_BUDGET_DATA, *buffer, DATA_BUFFER_SIZE);
+    *buffer = NULL;
+}
+
 /* ============================================================================
  * SIMPLIFIED CHARACTERISTIC HANDLERS
  * ============================================================================ */
@@ -35,38 +63,26 @@ static uint16_t download_data_length = 0;
  * @brief Handle data upload requests - VARIABLE LENGTH VERSION!
  * This function receives raw data with variable length.
  */
-static ssize_t data_upload_handler(const void *data, uint16_t len)
+static ssize_t data_upload_handler(data_conn_ctx_t *ctx, const void *data, uint16_t len)
 {
-    printk("\n=== Data Service: data_upload_handler called ===\n");
-    printk("Data Service: Upload received %d bytes\n", len);
+    LOG_DBG("data_upload_handler called");
+    LOG_DBG("Upload received %d bytes", len);
     
-    if (data_buffer_size + len > DATA_BUFFER_SIZE) {
-        printk("Data Service: Buffer overflow, resetting\n");
-        data_buffer_size = 0;
-        transfer_status = TRANSFER_STATUS_ERROR;
-        return -1;
+    /* Borrowed once per connection, not per write */
+    if (!ctx->echo_buffer &&
+        mem_budget_alloc(MEM_BUDGET_DATA, DATA_BUFFER_SIZE, (void **)&ctx->echo_buffer) != 0) {
+        LOG_WRN("No memory for the upload");
+        ctx->transfer_status = TRANSFER_STATUS_ERROR;
+        return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
     }
     
-    memcpy(data_buffer + data_buffer_size, data, len);
-    data_buffer_size += len;
-    transfer_status = TRANSFER_STATUS_RECEIVING;
-    
-    printk("Data Service: Total received: %d bytes\n", data_buffer_size);
-    
     /* For testing, assume each write is a complete message */
-    transfer_status = TRANSFER_STATUS_COMPLETE;
-    printk("Data Service: Transfer complete\n");
-    
-    /* Save data for echo - copy to echo buffer */
-    memcpy(echo_buffer, data_buffer, data_buffer_size);
-    echo_buffer_size = data_buffer_size;
-    printk("Data Service: Saved %d bytes for echo\n", echo_buffer_size);
-    
-    /* Process received data */
-    data_service_process_data(data_buffer, data_buffer_size);
+    memcpy(ctx->echo_buffer, data, len);
+    ctx->echo_buffer_size = len;
+    ctx->transfer_status = TRANSFER_STATUS_COMPLETE;
+    LOG_DBG("Transfer complete, %d bytes saved for echo", len);
     
-    /* Reset buffer for next transfer */
-    data_buffer_size = 0;
+    data_service_process_data(ctx->echo_buffer, ctx->echo_buffer_size);
     
     return len;
 }
@@ -76,18 +92,18 @@ static ssize_t data_upload_handler(const void *data, uint16_t len)
  * @brief Get data download - CLEAN VERSION!
  * This function fills your struct directly, no BLE boilerplate needed.
  */
-static ssize_t data_download_handler(data_download_packet_t *response)
+static ssize_t data_download_handler(data_conn_ctx_t *ctx, data_download_packet_t *response)
 {
-    printk("\n=== Data Service: data_download_handler called ===\n");
-    printk("Data Service: Download request\n");
+    LOG_DBG("data_download_handler called");
+    LOG_DBG("Download request");
     
-    if (echo_buffer_size > 0) {
-        /* Echo back the last uploaded data */
-        uint16_t copy_len = (echo_buffer_size < sizeof(response->data)) ? 
-                            echo_buffer_size : sizeof(response->data);
+    if (ctx->echo_buffer_size > 0) {
+        /* Echo back the last data this connection uploaded */
+        uint16_t copy_len = (ctx->echo_buffer_size < sizeof(response->data)) ? 
+                            ctx->echo_buffer_size : sizeof(response->data);
         
-        memcpy(response->data, echo_buffer, copy_len);
-        printk("Data Service: Echoing %d bytes\n", copy_len);
+        memcpy(response->data, ctx->echo_buffer, copy_len);
+        LOG_DBG("Echoing %d bytes", copy_len);
         
         return copy_len;
     } else {
@@ -100,7 +116,7 @@ static ssize_t data_download_handler(data_download_packet_t *response)
                             download_data_length : sizeof(response->data);
         
         memcpy(response->data, download_data, copy_len);
-        printk("Data Service: Returning default %d bytes\n", copy_len);
+        LOG_DBG("Returning default %d bytes", copy_len);
         
         return copy_len;
     }
@@ -111,14 +127,15 @@ static ssize_t data_download_handler(data_download_packet_t *response)
  * @brief Get data transfer status - CLEAN VERSION!
  * This function fills your struct directly, no BLE boilerplate needed.
  */
-static ssize_t data_transfer_status_handler(data_transfer_status_packet_t *status)
+static ssize_t data_transfer_status_handler(data_conn_ctx_t *ctx,
+                                            data_transfer_status_packet_t *status)
 {
-    printk("\n=== Data Service: data_transfer_status_handler called ===\n");
-    printk("Data Service: Transfer status read (status: %d, size: %d)\n", 
-           transfer_status, data_buffer_size);
+    LOG_DBG("data_transfer_status_handler called");
+    LOG_DBG("Transfer status read (status: %d, size: %d)", 
+            ctx->transfer_status, ctx->echo_buffer_size);
     
-    status->transfer_status = transfer_status;
-    status->buffer_size = data_buffer_size;
+    status->transfer_status = ctx->transfer_status;
+    status->buffer_size = ctx->echo_buffer_size;
     memset(status->reserved, 0, sizeof(status->reserved));
     
     return sizeof(*status);
@@ -133,9 +150,10 @@ static ssize_t data_transfer_status_handler(data_transfer_status_packet_t *statu
  * ============================================================================ */
 
 /* Generate BLE wrappers automatically */
-BLE_WRITE_WRAPPER_VARIABLE(data_upload_handler, 1, DATA_PACKET_SIZE_MAX)
-BLE_READ_WRAPPER(data_download_handler, data_download_packet_t)
-BLE_READ_WRAPPER(data_transfer_status_handler, data_transfer_status_packet_t)
+BLE_WRITE_WRAPPER_VARIABLE_CTX(data_upload_handler, 1, sizeof(data_upload_packet_t),
+                               data_upload_packet_validate, data_ctx_get)
+BLE_READ_WRAPPER_SNAPSHOT_CTX(data_download_handler, data_download_packet_t, data_ctx_get)
+BLE_READ_WRAPPER_CTX(data_transfer_status_handler, data_transfer_status_packet_t, data_ctx_get)
 
 BT_GATT_SERVICE_DEFINE(data_service,
     BT_GATT_PRIMARY_SERVICE(DATA_SERVICE_UUID),
@@ -155,71 +173,103 @@ BT_GATT_SERVICE_DEFINE(data_service,
     BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
 );
 
+static void data_service_mtu_changed(struct bt_conn *conn, uint16_t mtu)
+{
+    LOG_INF("Connection %d packets up to %d bytes",
+            bt_conn_index(conn), data_service_get_packet_size(conn));
+}
+
+BLE_SERVICE_DEFINE(data, 30,
+    .name = "Data Service",
+    .uuid = 0xFFF0,
+    .init = data_service_init,
+    .connection = data_service_connection_event,
+    .mtu_changed = data_service_mtu_changed);
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
 
 int data_service_init(void)
 {
-    data_buffer_size = 0;
-    echo_buffer_size = 0;
-    transfer_status = TRANSFER_STATUS_IDLE;
-    data_conn = NULL;
+    memset(data_ctx, 0, sizeof(data_ctx));
     download_data_length = strlen(download_data);
     
-    printk("Data Service: Initialized\n");
-    printk("  Upload characteristic: WRITE + WRITE_WITHOUT_RESP\n");
-    printk("  Download characteristic: READ + NOTIFY\n");
-    printk("  Transfer Status characteristic: READ + NOTIFY\n");
-    printk("  Buffer size: %d bytes\n", DATA_BUFFER_SIZE);
-    printk("  Echo functionality: ENABLED\n");
+    LOG_INF("Initialized");
+    LOG_INF("  Upload characteristic: WRITE + WRITE_WITHOUT_RESP");
+    LOG_INF("  Download characteristic: READ + NOTIFY");
+    LOG_INF("  Transfer Status characteristic: READ + NOTIFY");
+    LOG_INF("  Buffer size: %d bytes per connection (%d connections), %d byte quota",
+            DATA_BUFFER_SIZE, CONFIG_BT_MAX_CONN, CONFIG_MEM_BUDGET_DATA_QUOTA);
+    LOG_INF("  Echo functionality: ENABLED");
     
     return 0;
 }
 
 void data_service_connection_event(struct bt_conn *conn, bool connected)
 {
+    data_conn_ctx_t *ctx = data_ctx_get(conn);
+    
+    if (!ctx) {
+        return;
+    }
+    
+    /* Transfer and echo state never outlive the connection */
+    release_buffer(&ctx->echo_buffer);
+    memset(ctx, 0, sizeof(*ctx));
+    
     if (connected) {
-        printk("Data Service: Client connected\n");
-        data_conn = conn;
+        LOG_INF("Client connected");
+        ctx->conn = conn;
     } else {
-        printk("Data Service: Client disconnected\n");
-        if (conn == data_conn) {
-            data_conn = NULL;
-            /* Optionally reset transfer state on disconnect */
-            data_buffer_size = 0;
-            transfer_status = TRANSFER_STATUS_IDLE;
-        }
+        LOG_INF("Client disconnected");
     }
 }
 
-uint8_t data_service_get_transfer_status(void)
+uint8_t data_service_get_transfer_status(struct bt_conn *conn)
 {
-    return transfer_status;
+    data_conn_ctx_t *ctx = data_ctx_get(conn);
+    
+    return ctx ? ctx->transfer_status : TRANSFER_STATUS_IDLE;
 }
 
-uint16_t data_service_get_buffer_size(void)
+uint16_t data_service_get_buffer_size(struct bt_conn *conn)
 {
-    return data_buffer_size;
+    data_conn_ctx_t *ctx = data_ctx_get(conn);
+    
+    return ctx ? ctx->echo_buffer_size : 0;
 }
 
-int data_service_get_buffer_data(uint8_t *buffer, uint16_t max_length)
+int data_service_get_buffer_data(struct bt_conn *conn, uint8_t *buffer, uint16_t max_length)
 {
-    if (!buffer || max_length == 0) {
+    data_conn_ctx_t *ctx = data_ctx_get(conn);
+    
+    if (!ctx || !buffer || max_length == 0) {
         return -EINVAL;
     }
     
-    uint16_t copy_len = (data_buffer_size < max_length) ? data_buffer_size : max_length;
-    memcpy(buffer, data_buffer, copy_len);
+    if (!ctx->echo_buffer) {
+        return 0;
+    }
+    
+    uint16_t copy_len = (ctx->echo_buffer_size < max_length) ? ctx->echo_buffer_size : max_length;
+    memcpy(buffer, ctx->echo_buffer, copy_len);
     
     return copy_len;
 }
 
-void data_service_clear_buffer(void)
+void data_service_clear_buffer(struct bt_conn *conn)
 {
-    data_buffer_size = 0;
-    transfer_status = TRANSFER_STATUS_IDLE;
-    printk("Data Service: Buffer cleared\n");
+    data_conn_ctx_t *ctx = data_ctx_get(conn);
+    
+    if (!ctx) {
+        return;
+    }
+    
+    ctx->echo_buffer_size = 0;
+    release_buffer(&ctx->echo_buffer);
+    ctx->transfer_status = TRANSFER_STATUS_IDLE;
+    LOG_INF("Buffer cleared");
 }
 
 int data_service_set_download_data(const uint8_t *data, uint16_t length)
@@ -233,26 +283,21 @@ int data_service_set_download_data(const uint8_t *data, uint16_t length)
     download_data = (const char *)data;
     download_data_length = length;
     
-    printk("Data Service: Download data set (%d bytes)\n", length);
+    LOG_INF("Download data set (%d bytes)", length);
     return 0;
 }
 
 void data_service_process_data(const uint8_t *data, uint16_t length)
 {
-    printk("Data Service: Processing %d bytes of data\n", length);
+    LOG_DBG("Processing %d bytes of data", length);
     
     /* Mock processing - just echo first few bytes */
     if (length > 0) {
-        printk("Data Service: First bytes: ");
-        for (int i = 0; i < (length > 8 ? 8 : length); i++) {
-            printk("%02x ", data[i]);
-        }
-        printk("\n");
+        LOG_HEXDUMP_DBG(data, MIN(length, 8), "First bytes");
     }
     
-    /* Store the uploaded data for download - this enables round-trip testing */
-    data_service_set_download_data(data, length);
-    printk("Data Service: Data stored for download\n");
+    /* Round-trip testing is served from the uploader's own echo buffer;
+     * the shared download data is left alone so other clients never see it */
     
     /* Custom processing can be added here */
     /* For example: parse commands, store to flash, etc. */
@@ -262,10 +307,9 @@ void data_service_process_data(const uint8_t *data, uint16_t length)
  * MTU-AWARE PACKET SIZE HELPERS
  * ============================================================================ */
 
-uint16_t data_service_get_packet_size(void)
+uint16_t data_service_get_packet_size(struct bt_conn *conn)
 {
-    uint16_t mtu = ble_services_get_current_mtu();
-    uint16_t payload_size = mtu - 3;  /* ATT header is 3 bytes */
+    uint16_t payload_size = ble_services_get_max_payload(conn);
     
     if (payload_size >= DATA_PACKET_SIZE_LARGE) {
         return DATA_PACKET_SIZE_LARGE;  /* 244 bytes */
@@ -276,7 +320,34 @@ uint16_t data_service_get_packet_size(void)
     }
 }
 
-bool data_service_supports_large_packets(void)
+bool data_service_supports_large_packets(struct bt_conn *conn)
 {
-    return data_service_get_packet_size() >= DATA_PACKET_SIZE_LARGE;
+    return data_service_get_packet_size(conn) >= DATA_PACKET_SIZE_LARGE;
+}
+
+int data_service_benchmark_upload(uint32_t iterations, uint32_t *cycles_per_packet)
+{
+    static data_conn_ctx_t scratch;
+    static uint8_t packet[DATA_PACKET_SIZE_MAX];
+    
+    if (iterations == 0 || !cycles_per_packet) {
+        return -EINVAL;
+    }
+    
+    memset(&scratch, 0, sizeof(scratch));
+    for (size_t i = 0; i < sizeof(packet); i++) {
+        packet[i] = (uint8_t)i;
+    }
+    
+    timing_t start = timing_counter_get();
+    for (uint32_t i = 0; i < iterations; i++) {
+        data_upload_handler(&scratch, packet, sizeof(packet));
+    }
+    timing_t end = timing_counter_get();
+
+    /* The handler keeps the echo buffer, as it would until a disconnect */
+    release_buffer(&scratch.echo_buffer);
+
+    *cycles_per_packet = (uint32_t)(timing_cycles_get(&start, &end) / iterations);
+    return 0;
 }
@@ -55,7 +55,7 @@ typedef struct {
  */
 typedef struct {
     uint8_t transfer_status;  ///< Transfer status (TRANSFER_STATUS_*)
-    uint16_t buffer_size;     ///< Current buffer size in bytes
+    uint16_t buffer_size;     ///< Bytes of the last upload held for echo
     uint8_t reserved[3];      ///< Reserved for future use
 } __attribute__((packed)) data_transfer_status_packet_t;
 
@@ -114,32 +114,36 @@ int data_service_init(void);
 void data_service_connection_event(struct bt_conn *conn, bool connected);
 
 /**
- * @brief Get current transfer status
+ * @brief Get current transfer status of a connection
+ * @param conn Connection handle
  * @return Current transfer status (TRANSFER_STATUS_*)
  */
-uint8_t data_service_get_transfer_status(void);
+uint8_t data_service_get_transfer_status(struct bt_conn *conn);
 
 /**
- * @brief Get number of bytes in data buffer
- * @return Number of bytes currently in buffer
+ * @brief Get number of bytes in a connection's data buffer
+ * @param conn Connection handle
+ * @return Size of the connection's last upload, 0 if none
  */
-uint16_t data_service_get_buffer_size(void);
+uint16_t data_service_get_buffer_size(struct bt_conn *conn);
 
 /**
- * @brief Get data from buffer
+ * @brief Get a connection's last upload
+ * @param conn Connection handle
  * @param buffer Buffer to copy data to
  * @param max_length Maximum buffer size
  * @return Number of bytes copied, or negative error code
  */
-int data_service_get_buffer_data(uint8_t *buffer, uint16_t max_length);
+int data_service_get_buffer_data(struct bt_conn *conn, uint8_t *buffer, uint16_t max_length);
 
 /**
- * @brief Clear data buffer and reset transfer status
+ * @brief Drop a connection's last upload, free its buffer and reset its transfer status
+ * @param conn Connection handle
  */
-void data_service_clear_buffer(void);
+void data_service_clear_buffer(struct bt_conn *conn);
 
 /**
- * @brief Set download data for clients to read
+ * @brief Set download data for clients that have not uploaded anything
  * @param data Data to make available for download
  * @param length Length of data
  * @return 0 on success, negative error code on failure
@@ -162,15 +166,30 @@ void data_service_process_data(const uint8_t *data, uint16_t length);
  * ============================================================================ */
 
 /**
- * @brief Get optimal packet size based on current MTU
+ * @brief Get optimal packet size based on a connection's MTU
+ * @param conn Connection handle
  * @return Packet size in bytes (20, 47, or 244)
  */
-uint16_t data_service_get_packet_size(void);
+uint16_t data_service_get_packet_size(struct bt_conn *conn);
 
 /**
- * @brief Check if large packets are supported
+ * @brief Check if large packets are supported on a connection
+ * @param conn Connection handle
  * @return True if MTU supports 244+ byte packets
  */
-bool data_service_supports_large_packets(void);
+bool data_service_supports_large_packets(struct bt_conn *conn);
+
+/**
+ * @brief Measure the cost of the data upload handler
+ * 
+ * Feeds max-size packets straight into the upload handler, logging
+ * included, using a scratch context that no connection owns.
+ * The caller must have started the timing subsystem (timing_start()).
+ * 
+ * @param iterations Number of packets to average over
+ * @param cycles_per_packet Pointer to store the average cycles per packet
+ * @return 0 on success, negative error code on failure
+ */
+int data_service_benchmark_upload(uint32_t iterations, uint32_t *cycles_per_packet);
 
 #endif /* DATA_SERVICE_H */
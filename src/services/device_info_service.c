@@ -1,6 +1,14 @@
 #include "device_info_service.h"
 #include "ble_packet_handlers.h"
-#include <zephyr/sys/printk.h>
+#include "ble_protocol_gen.h"
+#include "ble_services.h"
+#include "compact_codec.h"
+#include "control_service.h"
+#include "data_service.h"
+#include "wasm_service.h"
+#include "sprite_service.h"
+#include "broadcast_service.h"
+#include <zephyr/logging/log.h>
 #include <string.h>
 
 /**
@@ -8,6 +16,8 @@
  * @brief Device Information Service (0x180A) implementation
  */
 
+LOG_MODULE_REGISTER(device_info_service, CONFIG_DEVICE_INFO_SERVICE_LOG_LEVEL);
+
 /* ============================================================================
  * STATIC DATA
  * ============================================================================ */
@@ -15,6 +25,62 @@
 static char firmware_revision[32] = DEVICE_FIRMWARE_REVISION;
 static char software_revision[32] = DEVICE_SOFTWARE_REVISION;
 
+/* The strings only change through the update functions below */
+BLE_READ_CACHE_DEFINE(manufacturer_name_cache);
+BLE_READ_CACHE_DEFINE(model_number_cache);
+BLE_READ_CACHE_DEFINE(firmware_revision_cache);
+BLE_READ_CACHE_DEFINE(hardware_revision_cache);
+BLE_READ_CACHE_DEFINE(software_revision_cache);
+BLE_READ_CACHE_DEFINE(capabilities_cache);
+
+#if defined(CONFIG_SPEED_OPTIMIZATIONS)
+#define DEVICE_BUILD_PROFILE        DEVICE_BUILD_SPEED
+#elif defined(CONFIG_SIZE_OPTIMIZATIONS)
+#define DEVICE_BUILD_PROFILE        DEVICE_BUILD_SIZE
+#else
+#define DEVICE_BUILD_PROFILE        DEVICE_BUILD_DEBUG
+#endif
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint32_t capability_features(void)
+{
+    /* Present in every build */
+    uint32_t features = DEVICE_CAP_CONTROL_BATCH | DEVICE_CAP_COMPACT_ENCODING |
+                        DEVICE_CAP_TIME_SYNC | DEVICE_CAP_TELEMETRY | DEVICE_CAP_WASM;
+    
+    if (CONFIG_BT_L2CAP_TX_MTU > BLE_DEFAULT_MTU) {
+        features |= DEVICE_CAP_LARGE_MTU;
+    }
+    if (IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)) {
+        features |= DEVICE_CAP_2M_PHY;
+    }
+    if (IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE)) {
+        features |= DEVICE_CAP_DATA_LEN_EXT;
+    }
+    if (IS_ENABLED(CONFIG_CONN_SCHED_RADIO_NOTIFICATION)) {
+        features |= DEVICE_CAP_TX_SCHEDULING;
+    }
+    if (IS_ENABLED(CONFIG_BLE_HANDLER_STATS)) {
+        features |= DEVICE_CAP_HANDLER_STATS;
+    }
+    if (IS_ENABLED(CONFIG_BT_CENTRAL)) {
+        features |= DEVICE_CAP_RELAY;
+    }
+    if (IS_ENABLED(CONFIG_BT_PER_ADV)) {
+        features |= DEVICE_CAP_PERIODIC_BROADCAST;
+    }
+    if (IS_ENABLED(CONFIG_BT_SMP)) {
+        features |= DEVICE_CAP_BONDING;
+    }
+    if (IS_ENABLED(CONFIG_APP_TRACE)) {
+        features |= DEVICE_CAP_TRACE;
+    }
+    return features;
+}
+
 /* ============================================================================
  * SIMPLIFIED CHARACTERISTIC HANDLERS
  * ============================================================================ */
@@ -22,58 +88,86 @@ static char software_revision[32] = DEVICE_SOFTWARE_REVISION;
 // The macro will generate read_manufacturer_name() wrapper that calls this
 static ssize_t manufacturer_name_handler(device_info_string_t *response)
 {
-    printk("\n=== Device Info Service: manufacturer_name_handler called ===\n");
-    printk("Device Info: Reading manufacturer name\n");
+    LOG_DBG("manufacturer_name_handler called");
+    LOG_DBG("Reading manufacturer name");
     strncpy(response->text, DEVICE_MANUFACTURER_NAME, sizeof(response->text) - 1);
     response->text[sizeof(response->text) - 1] = '\0';
-    printk("Device Info: Returning manufacturer: %s\n", response->text);
+    LOG_DBG("Returning manufacturer: %s", response->text);
+    ble_read_cache_keep(&manufacturer_name_cache, 0);
     return strlen(response->text);
 }
 
 // The macro will generate read_model_number() wrapper that calls this
 static ssize_t model_number_handler(device_info_string_t *response)
 {
-    printk("\n=== Device Info Service: model_number_handler called ===\n");
-    printk("Device Info: Reading model number\n");
+    LOG_DBG("model_number_handler called");
+    LOG_DBG("Reading model number");
     strncpy(response->text, DEVICE_MODEL_NUMBER, sizeof(response->text) - 1);
     response->text[sizeof(response->text) - 1] = '\0';
-    printk("Device Info: Returning model: %s\n", response->text);
+    LOG_DBG("Returning model: %s", response->text);
+    ble_read_cache_keep(&model_number_cache, 0);
     return strlen(response->text);
 }
 
 // The macro will generate read_firmware_revision() wrapper that calls this
 static ssize_t firmware_revision_handler(device_info_string_t *response)
 {
-    printk("\n=== Device Info Service: firmware_revision_handler called ===\n");
-    printk("Device Info: Reading firmware revision\n");
+    LOG_DBG("firmware_revision_handler called");
+    LOG_DBG("Reading firmware revision");
     strncpy(response->text, firmware_revision, sizeof(response->text) - 1);
     response->text[sizeof(response->text) - 1] = '\0';
-    printk("Device Info: Returning firmware: %s\n", response->text);
+    LOG_DBG("Returning firmware: %s", response->text);
+    ble_read_cache_keep(&firmware_revision_cache, 0);
     return strlen(response->text);
 }
 
 // The macro will generate read_hardware_revision() wrapper that calls this
 static ssize_t hardware_revision_handler(device_info_string_t *response)
 {
-    printk("\n=== Device Info Service: hardware_revision_handler called ===\n");
-    printk("Device Info: Reading hardware revision\n");
+    LOG_DBG("hardware_revision_handler called");
+    LOG_DBG("Reading hardware revision");
     strncpy(response->text, DEVICE_HARDWARE_REVISION, sizeof(response->text) - 1);
     response->text[sizeof(response->text) - 1] = '\0';
-    printk("Device Info: Returning hardware: %s\n", response->text);
+    LOG_DBG("Returning hardware: %s", response->text);
+    ble_read_cache_keep(&hardware_revision_cache, 0);
     return strlen(response->text);
 }
 
 // The macro will generate read_software_revision() wrapper that calls this
 static ssize_t software_revision_handler(device_info_string_t *response)
 {
-    printk("\n=== Device Info Service: software_revision_handler called ===\n");
-    printk("Device Info: Reading software revision\n");
+    LOG_DBG("software_revision_handler called");
+    LOG_DBG("Reading software revision");
     strncpy(response->text, software_revision, sizeof(response->text) - 1);
     response->text[sizeof(response->text) - 1] = '\0';
-    printk("Device Info: Returning software: %s\n", response->text);
+    LOG_DBG("Returning software: %s", response->text);
+    ble_read_cache_keep(&software_revision_cache, 0);
     return strlen(response->text);
 }
 
+// The macro will generate read_capabilities() wrapper that calls this
+static ssize_t capabilities_handler(device_capabilities_t *response)
+{
+    LOG_DBG("capabilities_handler called");
+    response->version = DEVICE_CAPS_VERSION;
+    response->build_profile = DEVICE_BUILD_PROFILE;
+    response->max_mtu = CONFIG_BT_L2CAP_TX_MTU;
+    response->features = capability_features();
+    response->protocol_fingerprint = BLE_PROTOCOL_FINGERPRINT;
+    response->max_module_size = WASM_CODE_BUFFER_SIZE;
+    response->max_upload_chunk = MIN(WASM_UPLOAD_CHUNK_SIZE, DATA_PACKET_SIZE_MAX);
+    response->sprite_capacity = SPRITE_MAX_COUNT;
+    response->encodings = BIT_MASK(COMPACT_ENCODING_LATEST + 1);
+    response->max_connections = CONFIG_BT_MAX_CONN;
+    response->batch_max_commands = CONTROL_BATCH_MAX_COMMANDS;
+    response->broadcast_queue_depth = BROADCAST_QUEUE_DEPTH;
+    response->wasm_queue_depth = WASM_WORK_QUEUE_DEPTH;
+    
+    /* Fixed at build time */
+    ble_read_cache_keep(&capabilities_cache, 0);
+    return sizeof(*response);
+}
+
 /* ============================================================================
  * SERVICE DEFINITION
  * ============================================================================ */
@@ -88,13 +182,15 @@ DECLARE_READ_HANDLER(model_number_handler, device_info_string_t);
 DECLARE_READ_HANDLER(firmware_revision_handler, device_info_string_t);
 DECLARE_READ_HANDLER(hardware_revision_handler, device_info_string_t);
 DECLARE_READ_HANDLER(software_revision_handler, device_info_string_t);
+DECLARE_READ_HANDLER(capabilities_handler, device_capabilities_t);
 
 /* Generate BLE wrappers automatically */
-BLE_READ_WRAPPER(manufacturer_name_handler, device_info_string_t)
-BLE_READ_WRAPPER(model_number_handler, device_info_string_t)
-BLE_READ_WRAPPER(firmware_revision_handler, device_info_string_t)
-BLE_READ_WRAPPER(hardware_revision_handler, device_info_string_t)
-BLE_READ_WRAPPER(software_revision_handler, device_info_string_t)
+BLE_READ_WRAPPER_CACHED(manufacturer_name_handler, device_info_string_t, manufacturer_name_cache)
+BLE_READ_WRAPPER_CACHED(model_number_handler, device_info_string_t, model_number_cache)
+BLE_READ_WRAPPER_CACHED(firmware_revision_handler, device_info_string_t, firmware_revision_cache)
+BLE_READ_WRAPPER_CACHED(hardware_revision_handler, device_info_string_t, hardware_revision_cache)
+BLE_READ_WRAPPER_CACHED(software_revision_handler, device_info_string_t, software_revision_cache)
+BLE_READ_WRAPPER_CACHED(capabilities_handler, device_capabilities_t, capabilities_cache)
 
 BT_GATT_SERVICE_DEFINE(device_info_service,
     BT_GATT_PRIMARY_SERVICE(BT_UUID_DIS),
@@ -118,22 +214,33 @@ BT_GATT_SERVICE_DEFINE(device_info_service,
                           BT_GATT_CHRC_READ,
                           BT_GATT_PERM_READ,
                           software_revision_handler_ble, NULL, NULL),
+    BT_GATT_CHARACTERISTIC(DEVICE_CAPABILITIES_UUID,
+                          BT_GATT_CHRC_READ,
+                          BT_GATT_PERM_READ,
+                          capabilities_handler_ble, NULL, NULL),
 );
 
+BLE_SERVICE_DEFINE(device_info, 10,
+    .name = "Device Information Service",
+    .uuid = 0x180A,
+    .init = device_info_service_init);
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
 
 int device_info_service_init(void)
 {
-    printk("Device Info Service: 🔧 Initializing Device Information Service...\n");
-    printk("Device Info Service: Registering 5 characteristics:\n");
-    printk("  📝 Manufacturer: %s\n", DEVICE_MANUFACTURER_NAME);
-    printk("  📝 Model: %s\n", DEVICE_MODEL_NUMBER);
-    printk("  📝 Firmware: %s\n", firmware_revision);
-    printk("  📝 Hardware: %s\n", DEVICE_HARDWARE_REVISION);
-    printk("  📝 Software: %s\n", software_revision);
-    printk("Device Info Service: ✅ Service ready for BLE clients\n");
+    LOG_INF("🔧 Initializing Device Information Service...");
+    LOG_INF("Registering 6 characteristics:");
+    LOG_INF("  📝 Manufacturer: %s", DEVICE_MANUFACTURER_NAME);
+    LOG_INF("  📝 Model: %s", DEVICE_MODEL_NUMBER);
+    LOG_INF("  📝 Firmware: %s", firmware_revision);
+    LOG_INF("  📝 Hardware: %s", DEVICE_HARDWARE_REVISION);
+    LOG_INF("  📝 Software: %s", software_revision);
+    LOG_INF("  📝 Capabilities: features 0x%08x, protocol 0x%08x",
+            capability_features(), BLE_PROTOCOL_FINGERPRINT);
+    LOG_INF("✅ Service ready for BLE clients");
     
     return 0;
 }
@@ -147,7 +254,9 @@ int device_info_update_firmware_revision(const char *revision)
     strncpy(firmware_revision, revision, sizeof(firmware_revision) - 1);
     firmware_revision[sizeof(firmware_revision) - 1] = '\0';
     
-    printk("Device Info Service: Firmware revision updated to %s\n", firmware_revision);
+    ble_read_cache_invalidate(&firmware_revision_cache);
+    
+    LOG_INF("Firmware revision updated to %s", firmware_revision);
     return 0;
 }
 
@@ -160,6 +269,8 @@ int device_info_update_software_revision(const char *revision)
     strncpy(software_revision, revision, sizeof(software_revision) - 1);
     software_revision[sizeof(software_revision) - 1] = '\0';
     
-    printk("Device Info Service: Software revision updated to %s\n", software_revision);
+    ble_read_cache_invalidate(&software_revision_cache);
+    
+    LOG_INF("Software revision updated to %s", software_revision);
     return 0;
 }
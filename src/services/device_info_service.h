@@ -25,6 +25,32 @@ typedef struct {
     char text[64];  ///< Null-terminated string (up to 63 chars + null)
 } __attribute__((packed)) device_info_string_t;
 
+/**
+ * @brief Device capabilities packet structure
+ * 
+ * What this firmware build supports and how large its buffers are, so a
+ * client can read it once after connecting and pick the fastest protocol
+ * paths instead of assuming the smallest common denominator. Fields are
+ * only ever appended; clients decode as far as they know.
+ * Total size: 32 bytes
+ */
+typedef struct {
+    uint8_t version;                ///< DEVICE_CAPS_VERSION
+    uint8_t build_profile;          ///< DEVICE_BUILD_* optimization level
+    uint16_t max_mtu;               ///< Largest ATT MTU accepted
+    uint32_t features;              ///< DEVICE_CAP_* bitmap
+    uint32_t protocol_fingerprint;  ///< BLE_PROTOCOL_FINGERPRINT of the packet layouts
+    uint32_t max_module_size;       ///< Largest WASM module in bytes
+    uint16_t max_upload_chunk;      ///< Largest data in one WASM or data upload write
+    uint16_t sprite_capacity;       ///< Sprite registry slots
+    uint8_t encodings;              ///< Bit n set if COMPACT_ENCODING n is supported
+    uint8_t max_connections;        ///< Simultaneous centrals
+    uint8_t batch_max_commands;     ///< Records per control batch write
+    uint8_t broadcast_queue_depth;  ///< Broadcast frames queued ahead of PA events
+    uint8_t wasm_queue_depth;       ///< WASM requests queued ahead of the runtime
+    uint8_t reserved[7];            ///< Reserved for future use
+} __attribute__((packed)) device_capabilities_t;
+
 /* ============================================================================
  * DEVICE INFORMATION CONSTANTS
  * ============================================================================ */
@@ -35,6 +61,38 @@ typedef struct {
 #define DEVICE_HARDWARE_REVISION    "PCA10095"
 #define DEVICE_SOFTWARE_REVISION    "Zephyr 3.5.0"
 
+#define DEVICE_CAPS_VERSION         1
+
+/* device_capabilities_t features */
+#define DEVICE_CAP_LARGE_MTU            BIT(0)  /* MTU exchange above 23 */
+#define DEVICE_CAP_2M_PHY               BIT(1)  /* PHY updates through link profiles */
+#define DEVICE_CAP_DATA_LEN_EXT         BIT(2)  /* LL data length extension */
+#define DEVICE_CAP_CONTROL_BATCH        BIT(3)  /* Control batch characteristic */
+#define DEVICE_CAP_COMPACT_ENCODING     BIT(4)  /* CMD_SET_ENCODING */
+#define DEVICE_CAP_HANDLER_STATS        BIT(5)  /* Handler statistics recorded */
+#define DEVICE_CAP_TIME_SYNC            BIT(6)  /* Control time sync characteristic */
+#define DEVICE_CAP_TELEMETRY            BIT(7)  /* Telemetry notifications */
+#define DEVICE_CAP_TX_SCHEDULING        BIT(8)  /* CMD_SET_TX_SCHEDULING */
+#define DEVICE_CAP_RELAY                BIT(9)  /* CMD_START_RELAY */
+#define DEVICE_CAP_PERIODIC_BROADCAST   BIT(10) /* Broadcast service frames */
+#define DEVICE_CAP_BONDING              BIT(11) /* Pairing and bonding */
+#define DEVICE_CAP_WASM                 BIT(12) /* WASM upload and execution */
+#define DEVICE_CAP_TRACE                BIT(13) /* Trace ring download */
+
+/* device_capabilities_t build profiles */
+#define DEVICE_BUILD_DEBUG          0x00    /* No or debug optimizations */
+#define DEVICE_BUILD_SIZE           0x01    /* Optimized for size */
+#define DEVICE_BUILD_SPEED          0x02    /* Optimized for speed */
+
+/* ============================================================================
+ * DEVICE INFORMATION SERVICE DEFINITIONS
+ * ============================================================================ */
+
+/* Vendor characteristic next to the standard DIS strings */
+static const struct bt_uuid_16 device_capabilities_uuid = BT_UUID_INIT_16(0xFFDC);
+
+#define DEVICE_CAPABILITIES_UUID    (&device_capabilities_uuid.uuid)
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
@@ -1,37 +1,84 @@
 #include "dfu_service.h"
 #include "ble_packet_handlers.h"
-#include <zephyr/sys/printk.h>
+#include "ble_protocol_gen.h"
+#include "ble_services.h"
+#include "link_profile.h"
+#include "event_bus.h"
+#include "mem_budget.h"
+#include <zephyr/logging/log.h>
+#include <string.h>
 
 /**
  * @file dfu_service.c
  * @brief Device Firmware Update Service (0xFE59) implementation
  */
 
+LOG_MODULE_REGISTER(dfu_service, CONFIG_DFU_SERVICE_LOG_LEVEL);
+
 /* ============================================================================
  * STATIC DATA
  * ============================================================================ */
 
+/* There is one image slot, so one connection owns the update at a time */
 static uint8_t dfu_state = DFU_STATE_IDLE;
 static uint32_t dfu_bytes_received = 0;
-static struct bt_conn *dfu_conn = NULL;
+static struct bt_conn *dfu_owner = NULL;
+
+/* Page buffer - borrowed from the memory budget while an update is running */
+static uint8_t *dfu_page = NULL;
+static uint16_t dfu_page_fill = 0;
+static uint32_t dfu_page_offset = 0;           /* Image offset of dfu_page[0] */
+
+BUILD_ASSERT(CONFIG_MEM_BUDGET_DFU_QUOTA >= DFU_PAGE_SIZE, "DFU quota must hold a page");
 
 /* ============================================================================
  * PRIVATE FUNCTIONS
  * ============================================================================ */
 
-static void dfu_control_point_indicate(uint8_t opcode, uint8_t response_code)
+static void dfu_control_point_indicate(struct bt_conn *conn, uint8_t opcode, uint8_t response_code)
 {
-    if (!dfu_conn) {
+    if (!conn) {
         return;
     }
     
-    uint8_t response[3] = {0x60, opcode, response_code}; // 0x60 = Response opcode
+    /* The mock sends no indication; a real one would carry
+     * {0x60 (response), opcode, response_code} via bt_gatt_indicate() */
+    LOG_DBG("Indication - OpCode: 0x%02x, Response: 0x%02x", 
+            opcode, response_code);
+}
+
+/**
+ * @brief Write the staged part of the page to the image
+ */
+static void dfu_flush_page(void)
+{
+    if (dfu_page_fill == 0) {
+        return;
+    }
     
-    printk("DFU Service: Sending indication - OpCode: 0x%02x, Response: 0x%02x\n", 
-           opcode, response_code);
+    /* Mock image write. A real one goes between APP_TRACE_FLASH_WRITE
+     * markers; until then there is nothing to time. */
+    LOG_DBG("Wrote %d bytes at offset %u", dfu_page_fill, dfu_page_offset);
     
-    /* In real implementation, would use bt_gatt_indicate() */
-    /* For mock, we just print the response */
+    dfu_page_offset += dfu_page_fill;
+    dfu_page_fill = 0;
+}
+
+/**
+ * @brief Return the page buffer, dropping anything not yet written
+ */
+static void dfu_release_page(void)
+{
+    mem_budget_free(MEM_BUDGET_DFU, dfu_page, DFU_PAGE_SIZE);
+    dfu_page = NULL;
+    dfu_page_fill = 0;
+    dfu_page_offset = 0;
+}
+
+/* DFU state is device-wide, so the handler context is the connection itself */
+static inline struct bt_conn *dfu_conn_get(struct bt_conn *conn)
+{
+    return conn;
 }
 
 /* ============================================================================
@@ -43,82 +90,137 @@ static void dfu_control_point_indicate(uint8_t opcode, uint8_t response_code)
  * @brief Handle DFU control point commands - CLEAN VERSION!
  * This function takes your struct directly, no BLE boilerplate needed.
  */
-static ssize_t dfu_control_point_handler(const dfu_control_packet_t *packet)
+static ssize_t dfu_control_point_handler(struct bt_conn *conn, const dfu_control_packet_t *packet)
 {
-    printk("\n=== DFU Service: dfu_control_point_handler called ===\n");
-    printk("DFU Service: Control Point command received: 0x%02x\n", packet->command);
+    LOG_DBG("dfu_control_point_handler called");
+    LOG_DBG("Control Point command received: 0x%02x", packet->command);
     
-    // Note: dfu_conn needs to be set via connection event handler
+    /* Another client's update in progress: refuse everything until it ends */
+    if (dfu_owner && dfu_owner != conn) {
+        LOG_WRN("Update owned by another connection");
+        dfu_control_point_indicate(conn, packet->command, DFU_RSP_INVALID_STATE);
+        return sizeof(*packet);
+    }
     
     switch (packet->command) {
     case DFU_CMD_START_DFU:
-        printk("DFU Service: Start DFU command\n");
+        LOG_INF("Start DFU command");
+        if (!dfu_page && mem_budget_alloc(MEM_BUDGET_DFU, DFU_PAGE_SIZE, (void **)&dfu_page) != 0) {
+            LOG_WRN("No memory for the page buffer");
+            dfu_control_point_indicate(conn, DFU_CMD_START_DFU, DFU_RSP_OPERATION_FAILED);
+            break;
+        }
+        if (dfu_owner != conn) {
+            dfu_owner = conn;
+            link_profile_bulk_begin(conn);
+        }
         dfu_state = DFU_STATE_READY;
         dfu_bytes_received = 0;
-        dfu_control_point_indicate(DFU_CMD_START_DFU, DFU_RSP_SUCCESS);
+        dfu_page_fill = 0;
+        dfu_page_offset = 0;
+        dfu_control_point_indicate(conn, DFU_CMD_START_DFU, DFU_RSP_SUCCESS);
         break;
         
     case DFU_CMD_INITIALIZE_DFU:
-        printk("DFU Service: Initialize DFU command\n");
+        LOG_DBG("Initialize DFU command");
         dfu_control_point_indicate(
-            DFU_CMD_INITIALIZE_DFU,
+            conn, DFU_CMD_INITIALIZE_DFU,
             (dfu_state == DFU_STATE_READY) ? DFU_RSP_SUCCESS : DFU_RSP_INVALID_STATE
         );
         break;
         
     case DFU_CMD_RECEIVE_FW:
-        printk("DFU Service: Receive firmware command\n");
+        LOG_DBG("Receive firmware command");
         dfu_state = DFU_STATE_RECEIVING;
-        dfu_control_point_indicate(DFU_CMD_RECEIVE_FW, DFU_RSP_SUCCESS);
+        dfu_control_point_indicate(conn, DFU_CMD_RECEIVE_FW, DFU_RSP_SUCCESS);
         break;
         
     case DFU_CMD_VALIDATE_FW:
-        printk("DFU Service: Validate firmware command\n");
-        printk("DFU Service: Mock validation - received %d bytes\n", dfu_bytes_received);
-        dfu_control_point_indicate(DFU_CMD_VALIDATE_FW, DFU_RSP_SUCCESS);
+        LOG_DBG("Validate firmware command");
+        dfu_flush_page();
+        LOG_DBG("Mock validation - received %d bytes", dfu_bytes_received);
+        dfu_control_point_indicate(conn, DFU_CMD_VALIDATE_FW, DFU_RSP_SUCCESS);
         break;
         
     case DFU_CMD_ACTIVATE_N_RESET:
-        printk("DFU Service: Activate and reset command (mock - not actually resetting)\n");
+        LOG_INF("Activate and reset command (mock - not actually resetting)");
+        dfu_flush_page();
+        dfu_release_page();
         dfu_state = DFU_STATE_IDLE;
-        dfu_control_point_indicate(DFU_CMD_ACTIVATE_N_RESET, DFU_RSP_SUCCESS);
+        link_profile_bulk_end(dfu_owner);
+        dfu_owner = NULL;
+        dfu_control_point_indicate(conn, DFU_CMD_ACTIVATE_N_RESET, DFU_RSP_SUCCESS);
         break;
         
     default:
-        printk("DFU Service: Unknown command: 0x%02x\n", packet->command);
-        dfu_control_point_indicate(packet->command, DFU_RSP_NOT_SUPPORTED);
+        LOG_WRN("Unknown command: 0x%02x", packet->command);
+        dfu_control_point_indicate(conn, packet->command, DFU_RSP_NOT_SUPPORTED);
         break;
     }
     
+    event_bus_publish(EVENT_DFU_STATE);
     return sizeof(*packet);
 }
 
 // The macro will generate dfu_packet_write() wrapper that calls this
 /**
- * @brief Handle DFU packet data - CLEAN VERSION!
- * This function takes your struct directly, no BLE boilerplate needed.
+ * @brief Handle DFU packet data - VARIABLE LENGTH VERSION!
+ * 
+ * Legacy connections write a whole dfu_packet_t, zero padded. Connections
+ * on the compact encoding write just the chunk, so its length is exact and
+ * chunks ending in zero bytes are counted correctly.
  */
-static ssize_t dfu_packet_handler(const dfu_packet_t *packet)
+static ssize_t dfu_packet_handler(struct bt_conn *conn, const void *data, uint16_t len)
 {
-    printk("\n=== DFU Service: dfu_packet_handler called ===\n");
+    const dfu_packet_t *packet = data;
+    uint16_t actual_len = len;
+    
+    LOG_DBG("dfu_packet_handler called");
+    if (conn != dfu_owner) {
+        LOG_WRN("Packet from connection that does not own the update");
+        return BT_GATT_ERR(BT_ATT_ERR_WRITE_NOT_PERMITTED);
+    }
     if (dfu_state != DFU_STATE_RECEIVING) {
-        printk("DFU Service: Packet received but not in receive state\n");
+        LOG_WRN("Packet received but not in receive state");
         return -1;  // Error
     }
     
-    // Find actual data length (exclude padding zeros at end)
-    uint16_t actual_len = sizeof(*packet);
-    while (actual_len > 0 && packet->data[actual_len - 1] == 0) {
-        actual_len--;
+    if (ble_services_get_encoding(conn) == COMPACT_ENCODING_LEGACY) {
+        if (len != sizeof(*packet)) {
+            LOG_WRN("Packet size %d, expected %zu", len, sizeof(*packet));
+            return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+        }
+        // Find actual data length (exclude padding zeros at end)
+        while (actual_len > 0 && packet->data[actual_len - 1] == 0) {
+            actual_len--;
+        }
     }
     
-    dfu_bytes_received += actual_len;
-    printk("DFU Service: Firmware packet received: %d bytes (total: %d)\n", 
-           actual_len, dfu_bytes_received);
+    /* Stage the chunk, writing each page as it fills */
+    const uint8_t *chunk = packet->data;
+    uint16_t remaining = actual_len;
     
-    /* Mock processing - just count bytes */
+    while (remaining > 0) {
+        uint16_t copy_len = MIN(remaining, DFU_PAGE_SIZE - dfu_page_fill);
+        
+        memcpy(&dfu_page[dfu_page_fill], chunk, copy_len);
+        dfu_page_fill += copy_len;
+        chunk += copy_len;
+        remaining -= copy_len;
+        if (dfu_page_fill == DFU_PAGE_SIZE) {
+            dfu_flush_page();
+        }
+    }
     
-    return sizeof(*packet);
+    dfu_bytes_received += actual_len;
+    if (dfu_bytes_received / 1024 != (dfu_bytes_received - actual_len) / 1024) {
+        /* Progress is advertised in whole KB */
+        event_bus_publish(EVENT_DFU_STATE);
+    }
+    LOG_DBG("Firmware packet received: %d bytes (total: %d)", 
+            actual_len, dfu_bytes_received);
+    
+    return len;
 }
 
 /* ============================================================================
@@ -130,8 +232,9 @@ static ssize_t dfu_packet_handler(const dfu_packet_t *packet)
  * ============================================================================ */
 
 /* Generate BLE wrappers automatically */
-BLE_WRITE_WRAPPER(dfu_control_point_handler, dfu_control_packet_t)
-BLE_WRITE_WRAPPER(dfu_packet_handler, dfu_packet_t)
+BLE_WRITE_WRAPPER_CTX(dfu_control_point_handler, dfu_control_packet_t, dfu_conn_get)
+BLE_WRITE_WRAPPER_VARIABLE_CTX(dfu_packet_handler, 1, sizeof(dfu_packet_t), dfu_packet_validate,
+                               dfu_conn_get)
 
 BT_GATT_SERVICE_DEFINE(dfu_service,
     BT_GATT_PRIMARY_SERVICE(DFU_SERVICE_UUID),
@@ -146,6 +249,19 @@ BT_GATT_SERVICE_DEFINE(dfu_service,
                           NULL, dfu_packet_handler_ble, NULL),
 );
 
+static void dfu_service_print_stats(void)
+{
+    LOG_INF("  state %d, %u bytes received, %s", dfu_state, dfu_bytes_received,
+            dfu_owner ? "owned" : "free");
+}
+
+BLE_SERVICE_DEFINE(dfu, 40,
+    .name = "DFU Service",
+    .uuid = 0xFE59,
+    .init = dfu_service_init,
+    .connection = dfu_service_connection_event,
+    .stats = dfu_service_print_stats);
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
@@ -154,12 +270,14 @@ int dfu_service_init(void)
 {
     dfu_state = DFU_STATE_IDLE;
     dfu_bytes_received = 0;
-    dfu_conn = NULL;
+    dfu_owner = NULL;
+    dfu_release_page();
     
-    printk("DFU Service: Initialized (mock implementation)\n");
-    printk("  Service UUID: 0xFE59\n");
-    printk("  Control Point: WRITE + INDICATE\n");
-    printk("  Packet: WRITE_WITHOUT_RESP\n");
+    LOG_INF("Initialized (mock implementation)");
+    LOG_INF("  Service UUID: 0xFE59");
+    LOG_INF("  Control Point: WRITE + INDICATE");
+    LOG_INF("  Packet: WRITE_WITHOUT_RESP");
+    LOG_INF("  Page buffer: %d bytes, borrowed per update", DFU_PAGE_SIZE);
     
     return 0;
 }
@@ -167,14 +285,16 @@ int dfu_service_init(void)
 void dfu_service_connection_event(struct bt_conn *conn, bool connected)
 {
     if (connected) {
-        printk("DFU Service: Client connected\n");
-        dfu_conn = conn;
+        LOG_INF("Client connected");
     } else {
-        printk("DFU Service: Client disconnected\n");
-        if (conn == dfu_conn) {
-            dfu_conn = NULL;
+        LOG_INF("Client disconnected");
+        if (conn == dfu_owner) {
+            /* Abandoned update: free the slot for the next client */
+            dfu_owner = NULL;
             dfu_state = DFU_STATE_IDLE;
             dfu_bytes_received = 0;
+            dfu_release_page();
+            event_bus_publish(EVENT_DFU_STATE);
         }
     }
 }
@@ -191,7 +311,13 @@ uint32_t dfu_service_get_bytes_received(void)
 
 void dfu_service_reset(void)
 {
+    if (dfu_owner) {
+        link_profile_bulk_end(dfu_owner);
+    }
+    dfu_owner = NULL;
     dfu_state = DFU_STATE_IDLE;
     dfu_bytes_received = 0;
-    printk("DFU Service: Reset to idle state\n");
+    dfu_release_page();
+    event_bus_publish(EVENT_DFU_STATE);
+    LOG_INF("Reset to idle state");
 }
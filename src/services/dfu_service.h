@@ -75,6 +75,9 @@ static const struct bt_uuid_16 dfu_packet_uuid = BT_UUID_INIT_16(0xFFD1);
 #define DFU_STATE_READY             0x01
 #define DFU_STATE_RECEIVING         0x02
 
+/* Image data is staged and written in flash page units */
+#define DFU_PAGE_SIZE               4096
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
@@ -0,0 +1,87 @@
+#include "event_bus.h"
+#include <zephyr/logging/log.h>
+
+/**
+ * @file event_bus.c
+ * @brief State change event bus implementation
+ */
+
+LOG_MODULE_REGISTER(event_bus, CONFIG_EVENT_BUS_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+static K_EVENT_DEFINE(bus_events);
+
+static atomic_t published[EVENT_COUNT];    /* Per event bit */
+static uint32_t wakeups;
+static uint32_t dispatched[EVENT_COUNT];   /* Per event bit, after coalescing */
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void event_bus_publish(uint32_t events)
+{
+    events &= EVENT_ALL;
+
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        if (events & BIT(i)) {
+            atomic_inc(&published[i]);
+        }
+    }
+
+    k_event_post(&bus_events, events);
+}
+
+uint32_t event_bus_wait(k_timeout_t timeout)
+{
+    if (k_event_wait(&bus_events, EVENT_ALL, false, timeout) == 0) {
+        return 0;
+    }
+
+    /* Let the rest of a burst arrive, then take everything at once */
+    k_sleep(K_MSEC(EVENT_BUS_COALESCE_MS));
+
+    uint32_t events = k_event_wait(&bus_events, EVENT_ALL, false, K_NO_WAIT);
+
+    /* Bits posted again from here on stay set for the next wakeup; the
+     * subscribers below read current state, so nothing is lost */
+    k_event_clear(&bus_events, events);
+
+    wakeups++;
+    return events;
+}
+
+void event_bus_dispatch(uint32_t events)
+{
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        if (events & BIT(i)) {
+            dispatched[i]++;
+        }
+    }
+
+    STRUCT_SECTION_FOREACH(event_subscriber, sub) {
+        uint32_t matched = events & sub->events;
+
+        if (matched) {
+            LOG_DBG("%s <- 0x%02x", sub->name, matched);
+            sub->handler(matched);
+        }
+    }
+}
+
+void event_bus_print_stats(void)
+{
+    uint32_t total_published = 0;
+    uint32_t total_dispatched = 0;
+
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        total_published += atomic_get(&published[i]);
+        total_dispatched += dispatched[i];
+    }
+
+    LOG_INF("Events: %u published, %u dispatched in %u wakeups",
+            total_published, total_dispatched, wakeups);
+}
@@ -0,0 +1,99 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+/**
+ * @file event_bus.h
+ * @brief State change events from services to subscribers
+ *
+ * Services publish an event bit whenever their state changes; publishing
+ * is ISR-safe and never blocks. The main thread sleeps until a bit is
+ * set, waits EVENT_BUS_COALESCE_MS so a burst of changes is handled once,
+ * and calls every subscriber whose mask matches. Events carry no payload:
+ * subscribers read the current state, so repeated events of one kind
+ * coalesce into a single call.
+ */
+
+/* ============================================================================
+ * EVENTS
+ * ============================================================================ */
+
+#define EVENT_CONNECTION            BIT(0)  /* A client connected or disconnected */
+#define EVENT_DEVICE_STATUS         BIT(1)  /* Control Service device status */
+#define EVENT_WASM_STATUS           BIT(2)  /* WASM upload, load or execution status */
+#define EVENT_WASM_RESULT           BIT(3)  /* A WASM call finished */
+#define EVENT_SPRITE_REGISTRY       BIT(4)  /* Sprite stored or registry cleared */
+#define EVENT_DFU_STATE             BIT(5)  /* DFU state or progress */
+#define EVENT_RELAY_STATE           BIT(6)  /* Relay started, advanced or finished */
+#define EVENT_BOND                  BIT(7)  /* Bond added or deleted */
+#define EVENT_COUNT                 8
+#define EVENT_ALL                   BIT_MASK(EVENT_COUNT)
+
+#define EVENT_BUS_COALESCE_MS       20      /* Batching window after the first event */
+
+/* ============================================================================
+ * SUBSCRIBERS
+ * ============================================================================ */
+
+/**
+ * @brief Subscriber descriptor
+ *
+ * Defined with EVENT_SUBSCRIBER_DEFINE() next to the code that reacts.
+ * Handlers run on the main thread and may block briefly.
+ */
+struct event_subscriber {
+    const char *name;
+    uint32_t events;                        /* EVENT_* mask */
+    void (*handler)(uint32_t events);       /* Called with the matching bits */
+};
+
+/**
+ * @brief Register a subscriber
+ * @param _name Subscriber identifier
+ * @param _events EVENT_* mask
+ * @param _handler Handler, called with the subset of @p _events that fired
+ */
+#define EVENT_SUBSCRIBER_DEFINE(_name, _events, _handler)                       \
+    const STRUCT_SECTION_ITERABLE(event_subscriber, event_subscriber_##_name) = { \
+        .name = #_name,                                                         \
+        .events = (_events),                                                    \
+        .handler = (_handler),                                                  \
+    }
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Publish one or more events
+ *
+ * Callable from any context, including ISRs and the BT RX thread.
+ *
+ * @param events EVENT_* mask
+ */
+void event_bus_publish(uint32_t events);
+
+/**
+ * @brief Sleep until events arrive and take them
+ *
+ * Returns after the coalescing window with every bit set by then.
+ *
+ * @param timeout How long to wait for the first event
+ * @return EVENT_* mask, 0 on timeout
+ */
+uint32_t event_bus_wait(k_timeout_t timeout);
+
+/**
+ * @brief Call every subscriber that matches
+ * @param events EVENT_* mask returned by event_bus_wait()
+ */
+void event_bus_dispatch(uint32_t events);
+
+/**
+ * @brief Print publish and wakeup counters
+ */
+void event_bus_print_stats(void);
+
+#endif /* EVENT_BUS_H */
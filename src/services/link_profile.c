@@ -0,0 +1,161 @@
+#include "link_profile.h"
+#include "ble_packet_handlers.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+/**
+ * @file link_profile.c
+ * @brief Named connection-parameter profiles implementation
+ */
+
+LOG_MODULE_REGISTER(link_profile, CONFIG_LINK_PROFILE_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+typedef struct {
+    const char *name;
+    uint8_t phy;                /* BT_GAP_LE_PHY_* for both directions */
+    uint16_t tx_data_len;       /* LL payload octets */
+    uint16_t tx_data_time;      /* LL payload air time in us */
+    struct bt_le_conn_param conn_param;
+} link_profile_def_t;
+
+/* Indexed by LINK_PROFILE_* */
+static const link_profile_def_t profiles[LINK_PROFILE_COUNT] = {
+    [LINK_PROFILE_BULK] = {
+        .name = "bulk",
+        .phy = BT_GAP_LE_PHY_2M,
+        .tx_data_len = 251,
+        .tx_data_time = 2120,   /* 251 octets on 2M */
+        /* Long events carry many packets each, so a longer interval wins */
+        .conn_param = { .interval_min = 12, .interval_max = 24, .latency = 0, .timeout = 400 },
+    },
+    [LINK_PROFILE_LOW_LATENCY] = {
+        .name = "low-latency",
+        .phy = BT_GAP_LE_PHY_2M,
+        .tx_data_len = 251,
+        .tx_data_time = 2120,
+        .conn_param = { .interval_min = 6, .interval_max = 12, .latency = 0, .timeout = 400 },
+    },
+    [LINK_PROFILE_LOW_POWER] = {
+        .name = "low-power",
+        .phy = BT_GAP_LE_PHY_1M,
+        .tx_data_len = 27,
+        .tx_data_time = 328,    /* 27 octets on 1M */
+        .conn_param = { .interval_min = 80, .interval_max = 160, .latency = 4, .timeout = 600 },
+    },
+};
+
+typedef struct {
+    uint8_t current;            /* Last requested profile */
+    uint8_t saved;              /* Profile to restore after a bulk transfer */
+    uint8_t bulk_depth;         /* Nested bulk transfers in progress */
+} link_profile_state_t;
+
+BLE_CONN_CONTEXT_DEFINE(link_profile_state_t, profile_state)
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int link_profile_apply(struct bt_conn *conn, uint8_t profile)
+{
+    link_profile_state_t *state = profile_state_get(conn);
+    int ret = 0;
+    int err;
+
+    if (!state || profile >= LINK_PROFILE_COUNT) {
+        return -EINVAL;
+    }
+
+    const link_profile_def_t *def = &profiles[profile];
+    const struct bt_conn_le_phy_param phy_param = {
+        .options = BT_CONN_LE_PHY_OPT_NONE,
+        .pref_tx_phy = def->phy,
+        .pref_rx_phy = def->phy,
+    };
+    const struct bt_conn_le_data_len_param data_len_param = {
+        .tx_max_len = def->tx_data_len,
+        .tx_max_time = def->tx_data_time,
+    };
+
+    LOG_INF("Connection %d -> %s", bt_conn_index(conn), def->name);
+    state->current = profile;
+
+    /* Each procedure is independent, so try all of them even if one fails */
+    err = bt_conn_le_phy_update(conn, &phy_param);
+    if (err) {
+        LOG_WRN("PHY update failed (err %d)", err);
+        ret = err;
+    }
+
+    err = bt_conn_le_data_len_update(conn, &data_len_param);
+    if (err) {
+        LOG_WRN("Data length update failed (err %d)", err);
+        ret = err;
+    }
+
+    err = bt_conn_le_param_update(conn, &def->conn_param);
+    if (err) {
+        LOG_WRN("Connection parameter update failed (err %d)", err);
+        ret = err;
+    }
+
+    return ret;
+}
+
+uint8_t link_profile_get(struct bt_conn *conn)
+{
+    link_profile_state_t *state = profile_state_get(conn);
+
+    return state ? state->current : LINK_PROFILE_NONE;
+}
+
+void link_profile_bulk_begin(struct bt_conn *conn)
+{
+    link_profile_state_t *state = profile_state_get(conn);
+
+    if (!state) {
+        return;
+    }
+
+    if (state->bulk_depth++ == 0) {
+        state->saved = state->current;
+        if (state->current != LINK_PROFILE_BULK) {
+            link_profile_apply(conn, LINK_PROFILE_BULK);
+        }
+    }
+}
+
+void link_profile_bulk_end(struct bt_conn *conn)
+{
+    link_profile_state_t *state = profile_state_get(conn);
+
+    if (!state || state->bulk_depth == 0) {
+        return;
+    }
+
+    if (--state->bulk_depth == 0 && state->saved != LINK_PROFILE_BULK &&
+        state->saved < LINK_PROFILE_COUNT) {
+        link_profile_apply(conn, state->saved);
+    }
+}
+
+void link_profile_reset(struct bt_conn *conn)
+{
+    link_profile_state_t *state = profile_state_get(conn);
+
+    if (state) {
+        state->current = LINK_PROFILE_NONE;
+        state->saved = LINK_PROFILE_NONE;
+        state->bulk_depth = 0;
+    }
+}
+
+const char *link_profile_name(uint8_t profile)
+{
+    return (profile < LINK_PROFILE_COUNT) ? profiles[profile].name : "none";
+}
@@ -0,0 +1,83 @@
+#ifndef LINK_PROFILE_H
+#define LINK_PROFILE_H
+
+#include <zephyr/bluetooth/conn.h>
+#include <stdint.h>
+
+/**
+ * @file link_profile.h
+ * @brief Named connection-parameter profiles
+ *
+ * Bundles PHY, LL data length and connection interval into a few named
+ * profiles that are requested together. Every connection starts in
+ * LINK_PROFILE_DEFAULT and is moved to LINK_PROFILE_BULK for the duration
+ * of large transfers.
+ */
+
+/* ============================================================================
+ * PROFILE IDENTIFIERS
+ * ============================================================================ */
+
+#define LINK_PROFILE_BULK           0x00    /* 2M PHY, max data length, 15-30 ms interval */
+#define LINK_PROFILE_LOW_LATENCY    0x01    /* 2M PHY, max data length, 7.5-15 ms interval */
+#define LINK_PROFILE_LOW_POWER      0x02    /* 1M PHY, default data length, 100-200 ms, latency 4 */
+#define LINK_PROFILE_COUNT          3
+#define LINK_PROFILE_NONE           0xFF    /* Not connected or nothing requested */
+
+/* Profile requested right after connect */
+#define LINK_PROFILE_DEFAULT        LINK_PROFILE_LOW_LATENCY
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Request a profile on a connection
+ *
+ * Starts the PHY, data length and connection parameter procedures. The
+ * controller and the central may settle on other values; the outcome is
+ * reported by the link state callbacks in ble_services.c.
+ *
+ * @param conn Connection handle
+ * @param profile LINK_PROFILE_*
+ * @return 0 if all procedures started, negative error code otherwise
+ */
+int link_profile_apply(struct bt_conn *conn, uint8_t profile);
+
+/**
+ * @brief Get the profile last requested on a connection
+ * @param conn Connection handle
+ * @return LINK_PROFILE_*, or LINK_PROFILE_NONE
+ */
+uint8_t link_profile_get(struct bt_conn *conn);
+
+/**
+ * @brief Switch a connection to the bulk profile for a large transfer
+ *
+ * Remembers the current profile so link_profile_bulk_end() can restore
+ * it. Nested calls are counted.
+ *
+ * @param conn Connection handle
+ */
+void link_profile_bulk_begin(struct bt_conn *conn);
+
+/**
+ * @brief End a bulk transfer and restore the previous profile
+ * @param conn Connection handle
+ */
+void link_profile_bulk_end(struct bt_conn *conn);
+
+/**
+ * @brief Forget the profile state of a connection
+ * @param conn Connection handle
+ */
+void link_profile_reset(struct bt_conn *conn);
+
+/**
+ * @brief Get a printable profile name
+ * @param profile LINK_PROFILE_*
+ * @return Profile name
+ */
+const char *link_profile_name(uint8_t profile);
+
+#endif /* LINK_PROFILE_H */
@@ -0,0 +1,176 @@
+#include "mem_budget.h"
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/mem_blocks.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+
+/**
+ * @file mem_budget.c
+ * @brief Shared RAM block pool implementation
+ */
+
+LOG_MODULE_REGISTER(mem_budget, CONFIG_MEM_BUDGET_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+#define BLOCK_SIZE      CONFIG_MEM_BUDGET_BLOCK_SIZE
+#define BLOCK_COUNT     (CONFIG_MEM_BUDGET_POOL_SIZE / CONFIG_MEM_BUDGET_BLOCK_SIZE)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(BLOCK_SIZE), "block size must be a power of two");
+BUILD_ASSERT(CONFIG_MEM_BUDGET_POOL_SIZE % BLOCK_SIZE == 0, "pool must be whole blocks");
+
+SYS_MEM_BLOCKS_DEFINE_STATIC(pool, BLOCK_SIZE, BLOCK_COUNT, 4);
+
+static const char *const client_names[] = {
+    [MEM_BUDGET_WASM] = "wasm",
+    [MEM_BUDGET_DATA] = "data",
+    [MEM_BUDGET_DFU] = "dfu",
+};
+
+BUILD_ASSERT(ARRAY_SIZE(client_names) == MEM_BUDGET_CLIENT_COUNT, "client without a name");
+
+/* Counters and quotas - only changed with budget_lock held */
+static mem_budget_usage_t clients[MEM_BUDGET_CLIENT_COUNT] = {
+    [MEM_BUDGET_WASM] = { .quota = CONFIG_MEM_BUDGET_WASM_QUOTA },
+    [MEM_BUDGET_DATA] = { .quota = CONFIG_MEM_BUDGET_DATA_QUOTA },
+    [MEM_BUDGET_DFU] = { .quota = CONFIG_MEM_BUDGET_DFU_QUOTA },
+};
+
+static mem_budget_usage_t pool_usage = { .quota = CONFIG_MEM_BUDGET_POOL_SIZE };
+static struct k_spinlock budget_lock;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void charge(mem_budget_usage_t *usage, uint32_t bytes)
+{
+    usage->used += bytes;
+    usage->peak = MAX(usage->peak, usage->used);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int mem_budget_alloc(uint8_t client, size_t size, void **ptr)
+{
+    if (client >= MEM_BUDGET_CLIENT_COUNT || size == 0 || !ptr) {
+        return -EINVAL;
+    }
+
+    mem_budget_usage_t *usage = &clients[client];
+    size_t count = DIV_ROUND_UP(size, BLOCK_SIZE);
+    uint32_t bytes = count * BLOCK_SIZE;
+    uint32_t used;
+    int err;
+
+    /* Quota check and pool allocation under one lock, so two borrows cannot both pass */
+    k_spinlock_key_t key = k_spin_lock(&budget_lock);
+
+    if (usage->used + bytes > usage->quota) {
+        err = -EDQUOT;
+    } else {
+        err = sys_mem_blocks_alloc_contiguous(&pool, count, ptr);
+    }
+
+    if (err) {
+        usage->failures++;
+    } else {
+        charge(usage, bytes);
+        charge(&pool_usage, bytes);
+    }
+    used = usage->used;
+    k_spin_unlock(&budget_lock, key);
+
+    if (err) {
+        LOG_WRN("%s: %u bytes refused (%s, %u / %u bytes held)", client_names[client], bytes,
+                err == -EDQUOT ? "over quota" : "pool exhausted", used, usage->quota);
+        return err;
+    }
+
+    LOG_DBG("%s: borrowed %u bytes at %p", client_names[client], bytes, *ptr);
+    return 0;
+}
+
+void mem_budget_free(uint8_t client, void *ptr, size_t size)
+{
+    if (!ptr || client >= MEM_BUDGET_CLIENT_COUNT || size == 0) {
+        return;
+    }
+
+    size_t count = DIV_ROUND_UP(size, BLOCK_SIZE);
+    uint32_t bytes = count * BLOCK_SIZE;
+    int err = sys_mem_blocks_free_contiguous(&pool, ptr, count);
+
+    if (err) {
+        LOG_ERR("%s: cannot return %u bytes at %p (err %d)", client_names[client], bytes, ptr, err);
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&budget_lock);
+    clients[client].used -= bytes;
+    pool_usage.used -= bytes;
+    k_spin_unlock(&budget_lock, key);
+
+    LOG_DBG("%s: returned %u bytes", client_names[client], bytes);
+}
+
+int mem_budget_get_usage(uint8_t client, mem_budget_usage_t *usage)
+{
+    if (client >= MEM_BUDGET_CLIENT_COUNT || !usage) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&budget_lock);
+    *usage = clients[client];
+    k_spin_unlock(&budget_lock, key);
+    return 0;
+}
+
+void mem_budget_get_pool_usage(mem_budget_usage_t *usage)
+{
+    k_spinlock_key_t key = k_spin_lock(&budget_lock);
+
+    *usage = pool_usage;
+    usage->failures = 0;
+    for (int i = 0; i < MEM_BUDGET_CLIENT_COUNT; i++) {
+        usage->failures += clients[i].failures;
+    }
+    k_spin_unlock(&budget_lock, key);
+}
+
+const char *mem_budget_client_name(uint8_t client)
+{
+    return client < MEM_BUDGET_CLIENT_COUNT ? client_names[client] : "?";
+}
+
+void mem_budget_reset_peaks(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&budget_lock);
+
+    for (int i = 0; i < MEM_BUDGET_CLIENT_COUNT; i++) {
+        clients[i].peak = clients[i].used;
+        clients[i].failures = 0;
+    }
+    pool_usage.peak = pool_usage.used;
+    k_spin_unlock(&budget_lock, key);
+}
+
+void mem_budget_print_stats(void)
+{
+    mem_budget_usage_t usage;
+
+    mem_budget_get_pool_usage(&usage);
+    LOG_INF("Memory pool: %u / %u bytes, peak %u, %u refused",
+            usage.used, usage.quota, usage.peak, usage.failures);
+
+    for (int i = 0; i < MEM_BUDGET_CLIENT_COUNT; i++) {
+        mem_budget_get_usage(i, &usage);
+        LOG_INF("  %s: %u / %u bytes, peak %u, %u refused",
+                client_names[i], usage.used, usage.quota, usage.peak, usage.failures);
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file mem_budget.h
+ * @brief Shared RAM block pool with per-service quotas
+ *
+ * Buffers that services need only part of the time - the WASM module
+ * code, the Data Service transfer and echo buffers, the DFU page buffer -
+ * are borrowed from one pool of CONFIG_MEM_BUDGET_BLOCK_SIZE blocks
+ * instead of being reserved per service. Each client may hold up to its
+ * quota, and the quotas may add up to more than the pool, so memory that
+ * an idle service is not using goes to whichever service needs it. A
+ * borrow never blocks: it fails when the quota or the pool runs out.
+ *
+ * Usage, peaks and refused borrows per client are read through the
+ * Control Service memory characteristic.
+ */
+
+/* ============================================================================
+ * CLIENTS
+ * ============================================================================ */
+
+#define MEM_BUDGET_WASM             0       /* WASM module code, held while the module is loaded */
+#define MEM_BUDGET_DATA             1       /* Data Service transfer and echo buffers */
+#define MEM_BUDGET_DFU              2       /* DFU page buffer, held during an update */
+#define MEM_BUDGET_CLIENT_COUNT     3
+
+#define MEM_BUDGET_NAME_LEN         8       /* Client names in the report, NUL terminated */
+
+/* ============================================================================
+ * STATISTICS
+ * ============================================================================ */
+
+typedef struct {
+    uint32_t quota;             /* Bytes the client may hold; pool size for the pool */
+    uint32_t used;              /* Bytes held now, in whole blocks */
+    uint32_t peak;              /* Most bytes held at once since boot or the last reset */
+    uint32_t failures;          /* Borrows refused */
+} mem_budget_usage_t;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Borrow a contiguous buffer
+ *
+ * The size is rounded up to whole blocks and charged to the client.
+ * Callable from any thread, not from ISRs.
+ *
+ * @param client MEM_BUDGET_* client
+ * @param size Bytes needed
+ * @param ptr Set to the buffer on success
+ * @return 0 on success, -EDQUOT over the client's quota, -ENOMEM if the
+ *         pool has no free run that long, -EINVAL for a bad client or size
+ */
+int mem_budget_alloc(uint8_t client, size_t size, void **ptr);
+
+/**
+ * @brief Return a buffer
+ * @param client Client the buffer was borrowed for
+ * @param ptr Buffer from mem_budget_alloc(), NULL is ignored
+ * @param size Size passed to mem_budget_alloc()
+ */
+void mem_budget_free(uint8_t client, void *ptr, size_t size);
+
+/**
+ * @brief Get one client's usage
+ * @param client MEM_BUDGET_* client
+ * @param usage Filled with the client's counters
+ * @return 0 on success, -EINVAL for a bad client
+ */
+int mem_budget_get_usage(uint8_t client, mem_budget_usage_t *usage);
+
+/**
+ * @brief Get usage of the whole pool
+ * @param usage Filled with the pool counters; quota is the pool size
+ */
+void mem_budget_get_pool_usage(mem_budget_usage_t *usage);
+
+/**
+ * @brief Get a client's name
+ * @return Name, "?" for a bad client
+ */
+const char *mem_budget_client_name(uint8_t client);
+
+/**
+ * @brief Restart peaks from current usage and zero the refused counts
+ */
+void mem_budget_reset_peaks(void);
+
+/**
+ * @brief Print pool and per-client usage
+ */
+void mem_budget_print_stats(void);
+
+#endif /* MEM_BUDGET_H */
@@ -0,0 +1,740 @@
+#include "relay.h"
+#include "app_trace.h"
+#include "ble_services.h"
+#include "control_service.h"
+#include "event_bus.h"
+#include "sprite_service.h"
+#include "status_broadcast.h"
+#include "wasm_service.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+/**
+ * @file relay.c
+ * @brief Central-role relay implementation
+ *
+ * Each worker thread owns one outgoing connection and runs the GATT
+ * client procedures of one peer synchronously, so several peers are
+ * served in parallel without a state machine per procedure. Scanning and
+ * connecting never overlap: peers found during a scan window are queued
+ * when the window closes, and the next round starts once every queued
+ * peer is done.
+ */
+
+LOG_MODULE_REGISTER(relay, CONFIG_RELAY_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+#define RELAY_THREAD_STACK_SIZE     2048
+#define RELAY_THREAD_PRIORITY       7
+#define RELAY_STATUS_POLL_MS        100
+
+/* Same interval range as the bulk link profile */
+#define RELAY_CONN_PARAM            BT_LE_CONN_PARAM(12, 24, 0, 400)
+
+/* Bytes in front of the data in a WASM upload packet */
+#define RELAY_WASM_UPLOAD_HEADER    offsetof(wasm_upload_packet_t, data)
+
+/* Peer characteristics the relay uses, indexes into relay_worker_t.handles */
+enum {
+    PEER_WASM_UPLOAD,
+    PEER_WASM_STATUS,
+    PEER_SPRITE_UPLOAD,
+    PEER_SPRITE_VERIFY_REQUEST,
+    PEER_SPRITE_VERIFY_RESPONSE,
+    PEER_CONTROL_COMMAND,
+    PEER_HANDLE_COUNT
+};
+
+static const struct bt_uuid *const peer_uuids[PEER_HANDLE_COUNT] = {
+    [PEER_WASM_UPLOAD] = WASM_UPLOAD_UUID,
+    [PEER_WASM_STATUS] = WASM_STATUS_UUID,
+    [PEER_SPRITE_UPLOAD] = SPRITE_UPLOAD_UUID,
+    [PEER_SPRITE_VERIFY_REQUEST] = SPRITE_VERIFY_REQUEST_UUID,
+    [PEER_SPRITE_VERIFY_RESPONSE] = SPRITE_VERIFY_RESPONSE_UUID,
+    [PEER_CONTROL_COMMAND] = CONTROL_COMMAND_UUID,
+};
+
+/* Outcome of one peer */
+enum {
+    PEER_UPDATED,
+    PEER_SKIPPED,
+    PEER_FAILED,
+};
+
+typedef struct {
+    struct bt_conn *conn;
+    struct k_sem done;          /* Given when the pending connect or GATT procedure ends */
+    int err;                    /* Its result: ATT/HCI error or negative errno */
+    uint16_t handles[PEER_HANDLE_COUNT];
+    struct bt_gatt_exchange_params mtu_params;
+    struct bt_gatt_discover_params discover_params;
+    struct bt_gatt_read_params read_params;
+    struct bt_gatt_write_params write_params;
+    void *read_buf;
+    uint16_t read_len;
+} relay_worker_t;
+
+static relay_worker_t workers[RELAY_PARALLEL_PEERS];
+static K_THREAD_STACK_ARRAY_DEFINE(worker_stacks, RELAY_PARALLEL_PEERS, RELAY_THREAD_STACK_SIZE);
+static struct k_thread worker_threads[RELAY_PARALLEL_PEERS];
+static bool workers_started;
+
+K_MSGQ_DEFINE(peer_queue, sizeof(bt_addr_le_t), RELAY_MAX_PEERS, 4);
+
+/* Peers seen this run; a peer is never handled twice */
+static bt_addr_le_t known_peers[RELAY_MAX_PEERS];
+static uint8_t known_count;
+static uint8_t round_first;     /* First peer of the current round */
+
+static relay_status_t status;
+static int64_t start_time;
+static atomic_t outstanding;    /* Peers queued or in progress this round */
+static atomic_t active;
+static atomic_t results[3];     /* Indexed by PEER_UPDATED/SKIPPED/FAILED */
+
+static void scan_end_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(scan_end_work, scan_end_work_handler);
+static void round_work_handler(struct k_work *work);
+static K_WORK_DEFINE(round_work, round_work_handler);
+
+/* ============================================================================
+ * GATT CLIENT HELPERS
+ * ============================================================================ */
+
+static int wait_done(relay_worker_t *worker, uint32_t timeout_ms)
+{
+    if (k_sem_take(&worker->done, K_MSEC(timeout_ms)) != 0) {
+        return -ETIMEDOUT;
+    }
+    if (worker->err < 0) {
+        return worker->err;
+    }
+    return worker->err ? -EIO : 0;
+}
+
+static void mtu_cb(struct bt_conn *conn, uint8_t err, struct bt_gatt_exchange_params *params)
+{
+    relay_worker_t *worker = CONTAINER_OF(params, relay_worker_t, mtu_params);
+
+    worker->err = err;
+    k_sem_give(&worker->done);
+}
+
+static uint8_t discover_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                           struct bt_gatt_discover_params *params)
+{
+    relay_worker_t *worker = CONTAINER_OF(params, relay_worker_t, discover_params);
+
+    if (!attr) {
+        worker->err = 0;
+        k_sem_give(&worker->done);
+        return BT_GATT_ITER_STOP;
+    }
+
+    const struct bt_gatt_chrc *chrc = attr->user_data;
+    for (int i = 0; i < PEER_HANDLE_COUNT; i++) {
+        if (bt_uuid_cmp(chrc->uuid, peer_uuids[i]) == 0) {
+            worker->handles[i] = chrc->value_handle;
+        }
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t read_cb(struct bt_conn *conn, uint8_t err, struct bt_gatt_read_params *params,
+                       const void *data, uint16_t length)
+{
+    relay_worker_t *worker = CONTAINER_OF(params, relay_worker_t, read_params);
+
+    worker->err = err;
+    if (!err && data) {
+        /* All values read here fit in one ATT response */
+        memcpy(worker->read_buf, data, MIN(length, worker->read_len));
+        if (length < worker->read_len) {
+            worker->err = -EMSGSIZE;
+        }
+    }
+    k_sem_give(&worker->done);
+    return BT_GATT_ITER_STOP;
+}
+
+static void write_cb(struct bt_conn *conn, uint8_t err, struct bt_gatt_write_params *params)
+{
+    relay_worker_t *worker = CONTAINER_OF(params, relay_worker_t, write_params);
+
+    worker->err = err;
+    k_sem_give(&worker->done);
+}
+
+static int peer_read(relay_worker_t *worker, int chrc, void *buf, uint16_t len)
+{
+    worker->read_params.func = read_cb;
+    worker->read_params.handle_count = 1;
+    worker->read_params.single.handle = worker->handles[chrc];
+    worker->read_params.single.offset = 0;
+    worker->read_buf = buf;
+    worker->read_len = len;
+
+    k_sem_reset(&worker->done);
+    int err = bt_gatt_read(worker->conn, &worker->read_params);
+    if (err) {
+        return err;
+    }
+    return wait_done(worker, RELAY_TIMEOUT_MS);
+}
+
+static int peer_write(relay_worker_t *worker, int chrc, const void *data, uint16_t len)
+{
+    worker->write_params.func = write_cb;
+    worker->write_params.handle = worker->handles[chrc];
+    worker->write_params.offset = 0;
+    worker->write_params.data = data;
+    worker->write_params.length = len;
+
+    k_sem_reset(&worker->done);
+    int err = bt_gatt_write(worker->conn, &worker->write_params);
+    if (err) {
+        return err;
+    }
+    return wait_done(worker, RELAY_TIMEOUT_MS);
+}
+
+/* ============================================================================
+ * CONNECTION HANDLING
+ * ============================================================================ */
+
+static relay_worker_t *worker_for_conn(struct bt_conn *conn)
+{
+    for (int i = 0; i < RELAY_PARALLEL_PEERS; i++) {
+        if (workers[i].conn == conn) {
+            return &workers[i];
+        }
+    }
+    return NULL;
+}
+
+static void relay_connected(struct bt_conn *conn, uint8_t err)
+{
+    relay_worker_t *worker = worker_for_conn(conn);
+
+    if (worker) {
+        /* The peer requests security on every incoming link. Answer it
+         * without bonding: a fleet run would otherwise store a bond per
+         * peer on both sides and overwrite the oldest phone bonds. The
+         * SMP channel only exists once connected, and no SMP PDU of this
+         * link has been processed yet. */
+        if (!err && bt_conn_set_bondable(conn, false)) {
+            LOG_WRN("Failed to disable bonding on relay link");
+        }
+        worker->err = err;
+        k_sem_give(&worker->done);
+    }
+}
+
+static void relay_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    relay_worker_t *worker = worker_for_conn(conn);
+
+    if (worker) {
+        worker->err = -ENOTCONN;
+        k_sem_give(&worker->done);
+    }
+}
+
+BT_CONN_CB_DEFINE(relay_conn_callbacks) = {
+    .connected = relay_connected,
+    .disconnected = relay_disconnected,
+};
+
+static void peer_disconnect(relay_worker_t *worker)
+{
+    k_sem_reset(&worker->done);
+    if (bt_conn_disconnect(worker->conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN) == 0) {
+        k_sem_take(&worker->done, K_MSEC(RELAY_TIMEOUT_MS));
+    }
+    bt_conn_unref(worker->conn);
+    worker->conn = NULL;
+}
+
+static int peer_connect(relay_worker_t *worker, const bt_addr_le_t *addr)
+{
+    int err;
+
+    memset(worker->handles, 0, sizeof(worker->handles));
+    k_sem_reset(&worker->done);
+
+    err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, RELAY_CONN_PARAM, &worker->conn);
+    if (err) {
+        worker->conn = NULL;
+        return err;
+    }
+
+    err = wait_done(worker, RELAY_TIMEOUT_MS);
+    if (err) {
+        /* Cancels a pending create; waits for its callback before reuse */
+        peer_disconnect(worker);
+        return err;
+    }
+
+    worker->mtu_params.func = mtu_cb;
+    k_sem_reset(&worker->done);
+    err = bt_gatt_exchange_mtu(worker->conn, &worker->mtu_params);
+    if (!err) {
+        err = wait_done(worker, RELAY_TIMEOUT_MS);
+    }
+    if (err) {
+        LOG_DBG("MTU exchange failed (err %d), using %d", err, bt_gatt_get_mtu(worker->conn));
+    }
+
+    worker->discover_params.uuid = NULL;
+    worker->discover_params.func = discover_cb;
+    worker->discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+    worker->discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+    worker->discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+    k_sem_reset(&worker->done);
+    err = bt_gatt_discover(worker->conn, &worker->discover_params);
+    if (!err) {
+        err = wait_done(worker, RELAY_TIMEOUT_MS);
+    }
+    if (err) {
+        peer_disconnect(worker);
+    }
+    return err;
+}
+
+/* ============================================================================
+ * CONTENT FORWARDING
+ * ============================================================================ */
+
+static bool wasm_status_is_loaded(uint8_t wasm_status)
+{
+    return wasm_status == WASM_STATUS_LOADED || wasm_status == WASM_STATUS_EXECUTING ||
+           wasm_status == WASM_STATUS_COMPLETE;
+}
+
+/**
+ * @brief Reset the peer's WASM Service, which refuses uploads over a loaded module
+ */
+static int reset_peer_wasm(relay_worker_t *worker)
+{
+    wasm_upload_packet_t packet = { .cmd = WASM_CMD_RESET };
+    wasm_status_packet_t peer_status;
+    int err;
+
+    err = bt_gatt_write_without_response(worker->conn, worker->handles[PEER_WASM_UPLOAD],
+                                         &packet, RELAY_WASM_UPLOAD_HEADER, false);
+    if (err) {
+        return err;
+    }
+
+    for (int64_t deadline = k_uptime_get() + RELAY_LOAD_TIMEOUT_MS; k_uptime_get() < deadline;) {
+        k_sleep(K_MSEC(RELAY_STATUS_POLL_MS));
+
+        err = peer_read(worker, PEER_WASM_STATUS, &peer_status, sizeof(peer_status));
+        if (err) {
+            return err;
+        }
+        if (peer_status.status == WASM_STATUS_IDLE) {
+            return 0;
+        }
+    }
+
+    return -ETIMEDOUT;
+}
+
+/**
+ * @brief Stream a module to the peer and wait until it has loaded it
+ *
+ * Chunks go out as writes without response, back to back; the peer's
+ * status (and its CRC-32 of what it received) is the acknowledgement.
+ */
+static int upload_wasm(relay_worker_t *worker, const uint8_t *code, uint32_t size, uint32_t crc32,
+                       int *outcome)
+{
+    wasm_status_packet_t peer_status;
+    wasm_upload_packet_t packet;
+    int err;
+
+    err = peer_read(worker, PEER_WASM_STATUS, &peer_status, sizeof(peer_status));
+    if (err) {
+        return err;
+    }
+    if (peer_status.module_crc32 == crc32 && wasm_status_is_loaded(peer_status.status)) {
+        return 0;
+    }
+    if (peer_status.status != WASM_STATUS_IDLE) {
+        err = reset_peer_wasm(worker);
+        if (err) {
+            return err;
+        }
+    }
+
+    uint16_t chunk_max = MIN(bt_gatt_get_mtu(worker->conn) - BLE_ATT_HEADER_SIZE -
+                             RELAY_WASM_UPLOAD_HEADER, WASM_UPLOAD_CHUNK_SIZE);
+    uint8_t sequence = 0;
+
+    for (uint32_t offset = 0; offset < size; offset += packet.chunk_size) {
+        packet.cmd = (offset == 0) ? WASM_CMD_START_UPLOAD : WASM_CMD_CONTINUE_UPLOAD;
+        packet.sequence = sequence++;
+        packet.chunk_size = MIN(chunk_max, size - offset);
+        packet.total_size = size;
+        memcpy(packet.data, &code[offset], packet.chunk_size);
+
+        /* Blocks while the TX buffers are full, which paces the stream */
+        err = bt_gatt_write_without_response(worker->conn, worker->handles[PEER_WASM_UPLOAD],
+                                             &packet, RELAY_WASM_UPLOAD_HEADER + packet.chunk_size,
+                                             false);
+        if (err) {
+            return err;
+        }
+    }
+
+    for (int64_t deadline = k_uptime_get() + RELAY_LOAD_TIMEOUT_MS; k_uptime_get() < deadline;) {
+        k_sleep(K_MSEC(RELAY_STATUS_POLL_MS));
+
+        err = peer_read(worker, PEER_WASM_STATUS, &peer_status, sizeof(peer_status));
+        if (err) {
+            return err;
+        }
+        if (peer_status.status == WASM_STATUS_ERROR) {
+            LOG_WRN("Peer failed to load module (error %d)", peer_status.error_code);
+            return -EIO;
+        }
+        if (wasm_status_is_loaded(peer_status.status)) {
+            if (peer_status.module_crc32 != crc32) {
+                return -EBADMSG;
+            }
+            *outcome = PEER_UPDATED;
+            return 0;
+        }
+    }
+
+    return -ETIMEDOUT;
+}
+
+/**
+ * @brief Upload the local module unless the peer already runs it
+ */
+static int forward_wasm(relay_worker_t *worker, int *outcome)
+{
+    const uint8_t *code;
+    uint32_t size;
+    uint32_t crc32;
+    int err;
+
+    if (wasm_service_get_module(&code, &size, &crc32) != 0) {
+        return 0;
+    }
+
+    /* The reference keeps the local code buffer alive while it streams */
+    if (!worker->handles[PEER_WASM_UPLOAD] || !worker->handles[PEER_WASM_STATUS]) {
+        err = -ENOENT;
+    } else {
+        err = upload_wasm(worker, code, size, crc32, outcome);
+    }
+    wasm_service_put_module();
+    return err;
+}
+
+/**
+ * @brief Upload every local sprite the peer is missing or holds with another CRC
+ */
+static int forward_sprites(relay_worker_t *worker, int *outcome)
+{
+    sprite_upload_packet_t sprite;
+    sprite_verify_request_t request;
+    sprite_verify_response_t response;
+    int err;
+
+    if (sprite_service_get_sprite_count() == 0) {
+        return 0;
+    }
+    if (!worker->handles[PEER_SPRITE_UPLOAD] || !worker->handles[PEER_SPRITE_VERIFY_REQUEST] ||
+        !worker->handles[PEER_SPRITE_VERIFY_RESPONSE]) {
+        return -ENOENT;
+    }
+
+    for (uint16_t slot = 0; slot < SPRITE_MAX_COUNT; slot++) {
+        if (sprite_service_read_slot(slot, &sprite) != 0) {
+            continue;
+        }
+
+        request.sprite_id = sprite.sprite_id;
+        err = peer_write(worker, PEER_SPRITE_VERIFY_REQUEST, &request, sizeof(request));
+        if (err) {
+            return err;
+        }
+        err = peer_read(worker, PEER_SPRITE_VERIFY_RESPONSE, &response, sizeof(response));
+        if (err) {
+            return err;
+        }
+        if (response.verification_status == VERIFY_STATUS_VALID &&
+            response.stored_crc16 == sprite.crc16) {
+            continue;
+        }
+
+        err = peer_write(worker, PEER_SPRITE_UPLOAD, &sprite, sizeof(sprite));
+        if (err) {
+            return err;
+        }
+        *outcome = PEER_UPDATED;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Ask an updated peer to relay onwards with one hop less
+ */
+static int forward_relay_command(relay_worker_t *worker)
+{
+    control_command_packet_t command = {
+        .cmd_id = CMD_START_RELAY,
+        .param1 = status.content,
+        .param2 = status.hops - 1,
+    };
+
+    if (!worker->handles[PEER_CONTROL_COMMAND]) {
+        return -ENOENT;
+    }
+    return peer_write(worker, PEER_CONTROL_COMMAND, &command, sizeof(command));
+}
+
+static int relay_peer(relay_worker_t *worker, const bt_addr_le_t *addr)
+{
+    char addr_str[BT_ADDR_LE_STR_LEN];
+    int outcome = PEER_SKIPPED;
+    int err;
+
+    bt_addr_le_to_str(addr, addr_str, sizeof(addr_str));
+
+    err = peer_connect(worker, addr);
+    if (err) {
+        LOG_WRN("%s: connect failed (err %d)", addr_str, err);
+        return PEER_FAILED;
+    }
+
+    if (status.content & RELAY_CONTENT_WASM) {
+        err = forward_wasm(worker, &outcome);
+    }
+    if (!err && (status.content & RELAY_CONTENT_SPRITES)) {
+        err = forward_sprites(worker, &outcome);
+    }
+    if (!err && outcome == PEER_UPDATED && status.hops > 0) {
+        err = forward_relay_command(worker);
+    }
+
+    peer_disconnect(worker);
+
+    if (err) {
+        LOG_WRN("%s: relay failed (err %d)", addr_str, err);
+        return PEER_FAILED;
+    }
+
+    LOG_INF("%s: %s", addr_str, outcome == PEER_UPDATED ? "updated" : "already up to date");
+    return outcome;
+}
+
+static void relay_worker_entry(void *arg1, void *arg2, void *arg3)
+{
+    relay_worker_t *worker = arg1;
+    bt_addr_le_t addr;
+
+    while (1) {
+        k_msgq_get(&peer_queue, &addr, K_FOREVER);
+        APP_TRACE_MSGQ_GET_DONE(&peer_queue);
+
+        atomic_inc(&active);
+        atomic_inc(&results[relay_peer(worker, &addr)]);
+        atomic_dec(&active);
+        event_bus_publish(EVENT_RELAY_STATE);
+
+        /* Last peer of the round: scan for more */
+        if (atomic_dec(&outstanding) == 1) {
+            k_work_submit(&round_work);
+        }
+    }
+}
+
+/* ============================================================================
+ * SCAN ROUNDS
+ * ============================================================================ */
+
+static bool match_status_block(struct bt_data *data, void *user_data)
+{
+    bool *found = user_data;
+
+    if (data->type == BT_DATA_SVC_DATA16 &&
+        data->data_len == sizeof(uint16_t) + sizeof(status_broadcast_block_t) &&
+        sys_get_le16(data->data) == STATUS_BROADCAST_UUID &&
+        data->data[sizeof(uint16_t)] == STATUS_BROADCAST_VERSION) {
+        *found = true;
+        return false;
+    }
+    return true;
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+                         struct net_buf_simple *ad)
+{
+    bool found = false;
+
+    if (known_count >= RELAY_MAX_PEERS) {
+        return;
+    }
+
+    bt_data_parse(ad, match_status_block, &found);
+    if (!found) {
+        return;
+    }
+
+    for (int i = 0; i < known_count; i++) {
+        if (bt_addr_le_cmp(&known_peers[i], addr) == 0) {
+            return;
+        }
+    }
+
+    bt_addr_le_copy(&known_peers[known_count++], addr);
+}
+
+static void relay_finish(void)
+{
+    status.state = RELAY_STATE_DONE;
+    status.elapsed_ms = k_uptime_get() - start_time;
+    event_bus_publish(EVENT_RELAY_STATE);
+
+    LOG_INF("Relay done in %u ms: %d updated, %d skipped, %d failed",
+            status.elapsed_ms, (int)atomic_get(&results[PEER_UPDATED]),
+            (int)atomic_get(&results[PEER_SKIPPED]), (int)atomic_get(&results[PEER_FAILED]));
+}
+
+static int start_round(void)
+{
+    round_first = known_count;
+
+    int err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, device_found);
+    if (err) {
+        LOG_ERR("Scanning failed to start (err %d)", err);
+        relay_finish();
+        return err;
+    }
+
+    status.state = RELAY_STATE_SCANNING;
+    event_bus_publish(EVENT_RELAY_STATE);
+    k_work_schedule(&scan_end_work, K_MSEC(RELAY_SCAN_WINDOW_MS));
+    return 0;
+}
+
+static void scan_end_work_handler(struct k_work *work)
+{
+    uint8_t found = known_count - round_first;
+
+    bt_le_scan_stop();
+
+    if (found == 0) {
+        relay_finish();
+        return;
+    }
+
+    LOG_INF("Forwarding to %d peers", found);
+    status.state = RELAY_STATE_FORWARDING;
+    event_bus_publish(EVENT_RELAY_STATE);
+    atomic_set(&outstanding, found);
+    for (uint8_t i = round_first; i < known_count; i++) {
+        k_msgq_put(&peer_queue, &known_peers[i], K_NO_WAIT);
+        APP_TRACE_MSGQ_PUT_DONE(&peer_queue);
+    }
+}
+
+static void round_work_handler(struct k_work *work)
+{
+    if (known_count >= RELAY_MAX_PEERS) {
+        relay_finish();
+        return;
+    }
+    start_round();
+}
+
+static void start_workers(void)
+{
+    if (workers_started) {
+        return;
+    }
+
+    for (int i = 0; i < RELAY_PARALLEL_PEERS; i++) {
+        k_sem_init(&workers[i].done, 0, 1);
+        k_tid_t tid = k_thread_create(&worker_threads[i], worker_stacks[i],
+                                      K_THREAD_STACK_SIZEOF(worker_stacks[i]),
+                                      relay_worker_entry, &workers[i], NULL, NULL,
+                                      RELAY_THREAD_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(tid, "relay");
+    }
+    workers_started = true;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int relay_start(uint8_t content, uint8_t hops)
+{
+    const uint8_t *code;
+    uint32_t size;
+    uint32_t crc32;
+    bool has_content = false;
+
+    if (status.state == RELAY_STATE_SCANNING || status.state == RELAY_STATE_FORWARDING) {
+        return -EBUSY;
+    }
+
+    content &= RELAY_CONTENT_ALL;
+    if (!content) {
+        return -EINVAL;
+    }
+    if ((content & RELAY_CONTENT_WASM) && wasm_service_get_module(&code, &size, &crc32) == 0) {
+        wasm_service_put_module();
+        has_content = true;
+    }
+    if ((content & RELAY_CONTENT_SPRITES) && sprite_service_get_sprite_count() > 0) {
+        has_content = true;
+    }
+    if (!has_content) {
+        return -ENOENT;
+    }
+
+    start_workers();
+
+    memset(&status, 0, sizeof(status));
+    status.content = content;
+    status.hops = hops;
+    known_count = 0;
+    for (int i = 0; i < ARRAY_SIZE(results); i++) {
+        atomic_set(&results[i], 0);
+    }
+    start_time = k_uptime_get();
+
+    LOG_INF("Relay started (content 0x%02x, %d hops)", content, hops);
+    return start_round();
+}
+
+void relay_get_status(relay_status_t *out)
+{
+    if (!out) {
+        return;
+    }
+
+    *out = status;
+    out->updated = atomic_get(&results[PEER_UPDATED]);
+    out->skipped = atomic_get(&results[PEER_SKIPPED]);
+    out->failed = atomic_get(&results[PEER_FAILED]);
+    out->active = atomic_get(&active);
+    if (status.state == RELAY_STATE_SCANNING || status.state == RELAY_STATE_FORWARDING) {
+        out->elapsed_ms = k_uptime_get() - start_time;
+    }
+}
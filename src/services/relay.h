@@ -0,0 +1,77 @@
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <stdint.h>
+
+/**
+ * @file relay.h
+ * @brief Central-role relay of WASM modules and sprites to peer devices
+ *
+ * Scans for peers advertising the status broadcast of this firmware,
+ * connects to several of them at once as a central and forwards the
+ * loaded WASM module and/or the sprite registry. A peer whose module
+ * CRC-32 (WASM status) or sprite CRC16s (sprite verify) already match is
+ * skipped. With hops left, each updated peer is told to relay onwards,
+ * so the content spreads through the fleet as a tree.
+ */
+
+/* ============================================================================
+ * CONFIGURATION
+ * ============================================================================ */
+
+/* Outgoing connections at once; one slot stays free for a phone */
+#define RELAY_PARALLEL_PEERS        (CONFIG_BT_MAX_CONN - 1)
+#define RELAY_MAX_PEERS             32      /* Peers remembered per relay run */
+#define RELAY_SCAN_WINDOW_MS        3000    /* Scan time per round */
+#define RELAY_TIMEOUT_MS            5000    /* Per connect / GATT operation */
+#define RELAY_LOAD_TIMEOUT_MS       10000   /* Peer parsing and compiling a module */
+
+/* Content to forward (CMD_START_RELAY param1) */
+#define RELAY_CONTENT_WASM          0x01
+#define RELAY_CONTENT_SPRITES       0x02
+#define RELAY_CONTENT_ALL           (RELAY_CONTENT_WASM | RELAY_CONTENT_SPRITES)
+
+/* Relay states */
+#define RELAY_STATE_IDLE            0x00
+#define RELAY_STATE_SCANNING        0x01
+#define RELAY_STATE_FORWARDING      0x02
+#define RELAY_STATE_DONE            0x03
+
+/**
+ * @brief Relay progress
+ */
+typedef struct {
+    uint8_t state;              /* RELAY_STATE_* */
+    uint8_t content;            /* RELAY_CONTENT_* being forwarded */
+    uint8_t hops;               /* Hops handed on to updated peers */
+    uint8_t updated;            /* Peers that received content */
+    uint8_t skipped;            /* Peers already up to date */
+    uint8_t failed;             /* Peers that could not be updated */
+    uint8_t active;             /* Peers being forwarded to right now */
+    uint32_t elapsed_ms;        /* Time since start, frozen when done */
+} relay_status_t;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start relaying content to peers
+ *
+ * Runs in scan rounds until a round finds no new peer or RELAY_MAX_PEERS
+ * have been handled.
+ *
+ * @param content RELAY_CONTENT_* mask
+ * @param hops Times each updated peer should relay onwards (0 = stop here)
+ * @return 0 on success, -EBUSY if a relay is running, -EINVAL for an empty
+ *         mask, -ENOENT if there is nothing to forward, or a scan error
+ */
+int relay_start(uint8_t content, uint8_t hops);
+
+/**
+ * @brief Get relay progress
+ * @param status Status to fill in
+ */
+void relay_get_status(relay_status_t *status);
+
+#endif /* RELAY_H */
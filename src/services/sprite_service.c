@@ -1,7 +1,9 @@
 #include "sprite_service.h"
 #include "ble_packet_handlers.h"
 #include "ble_services.h"
-#include <zephyr/sys/printk.h>
+#include "event_bus.h"
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
 #include <string.h>
 
 /**
@@ -11,6 +13,8 @@
  * Manages a registry of 16x16 monochrome bitmap sprites with CRC verification.
  */
 
+LOG_MODULE_REGISTER(sprite_service, CONFIG_SPRITE_SERVICE_LOG_LEVEL);
+
 /* ============================================================================
  * STATIC DATA AND STORAGE
  * ============================================================================ */
@@ -26,11 +30,35 @@ typedef struct {
 /* Registry storage */
 static sprite_slot_t sprite_registry[SPRITE_MAX_COUNT];
 static uint16_t sprite_count = 0;
+static uint16_t registry_generation = 0;   /* Bumped on every registry change */
 static uint16_t crc_error_count = 0;
-static uint8_t registry_status = REGISTRY_STATUS_READY;
-static uint8_t last_operation = OPERATION_NONE;
-static uint16_t last_sprite_id = SPRITE_ID_INVALID;
-static struct bt_conn *sprite_conn = NULL;
+
+/* Held across the reserved check and the store so an upload cannot land
+ * between a reservation's empty check and its first store */
+static K_MUTEX_DEFINE(registry_lock);
+static bool registry_reserved = false;      /* Owned by an on-device user, see reserve_empty() */
+
+/* Per-connection request state - the registry itself is shared */
+typedef struct {
+    struct bt_conn *conn;
+    uint8_t registry_status;    /* Outcome of this client's last operation */
+    uint8_t last_operation;
+    uint16_t last_sprite_id;    /* Target of download/verify response reads */
+} sprite_conn_ctx_t;
+
+BLE_CONN_CONTEXT_DEFINE(sprite_conn_ctx_t, sprite_ctx)
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void sprite_ctx_reset(sprite_conn_ctx_t *ctx, struct bt_conn *conn)
+{
+    ctx->conn = conn;
+    ctx->registry_status = REGISTRY_STATUS_READY;
+    ctx->last_operation = OPERATION_NONE;
+    ctx->last_sprite_id = SPRITE_ID_INVALID;
+}
 
 /* ============================================================================
  * CRC16 IMPLEMENTATION
@@ -104,8 +132,8 @@ static uint8_t store_sprite(uint16_t sprite_id, const uint8_t *bitmap_data, uint
     /* Verify CRC */
     uint16_t calculated_crc = sprite_service_calculate_crc16(bitmap_data, SPRITE_DATA_SIZE);
     if (calculated_crc != crc16) {
-        printk("Sprite Service: CRC mismatch for ID %d (got 0x%04x, expected 0x%04x)\n", 
-               sprite_id, calculated_crc, crc16);
+        LOG_WRN("CRC mismatch for ID %d (got 0x%04x, expected 0x%04x)", 
+                sprite_id, calculated_crc, crc16);
         crc_error_count++;
         return SPRITE_STATUS_CRC_ERROR;
     }
@@ -117,7 +145,7 @@ static uint8_t store_sprite(uint16_t sprite_id, const uint8_t *bitmap_data, uint
     if (!slot) {
         slot = find_free_slot();
         if (!slot) {
-            printk("Sprite Service: Registry full, cannot store sprite %d\n", sprite_id);
+            LOG_WRN("Registry full, cannot store sprite %d", sprite_id);
             return SPRITE_STATUS_REGISTRY_FULL;
         }
     }
@@ -131,11 +159,11 @@ static uint8_t store_sprite(uint16_t sprite_id, const uint8_t *bitmap_data, uint
     if (!is_update) {
         sprite_count++;
     }
+    registry_generation++;
+    event_bus_publish(EVENT_SPRITE_REGISTRY);
     
-    last_sprite_id = sprite_id;
-    
-    printk("Sprite Service: %s sprite %d (CRC: 0x%04x)\n", 
-           is_update ? "Updated" : "Stored", sprite_id, crc16);
+    LOG_DBG("%s sprite %d (CRC: 0x%04x)", 
+            is_update ? "Updated" : "Stored", sprite_id, crc16);
     
     return SPRITE_STATUS_SUCCESS;
 }
@@ -147,31 +175,40 @@ static uint8_t store_sprite(uint16_t sprite_id, const uint8_t *bitmap_data, uint
 /**
  * @brief Handle sprite upload requests
  */
-static ssize_t sprite_upload_handler(const sprite_upload_packet_t *packet)
+static ssize_t sprite_upload_handler(sprite_conn_ctx_t *ctx, const sprite_upload_packet_t *packet)
 {
-    printk("\n=== Sprite Service: sprite_upload_handler called ===\n");
-    printk("Sprite Service: Upload request for sprite %d\n", packet->sprite_id);
+    LOG_DBG("sprite_upload_handler called");
+    LOG_DBG("Upload request for sprite %d", packet->sprite_id);
     
-    registry_status = REGISTRY_STATUS_BUSY;
-    last_operation = OPERATION_UPLOAD;
+    ctx->registry_status = REGISTRY_STATUS_BUSY;
+    ctx->last_operation = OPERATION_UPLOAD;
     
     /* Validate sprite ID */
     if (packet->sprite_id == SPRITE_ID_INVALID) {
-        printk("Sprite Service: Invalid sprite ID\n");
-        registry_status = REGISTRY_STATUS_ERROR;
+        LOG_WRN("Invalid sprite ID");
+        ctx->registry_status = REGISTRY_STATUS_ERROR;
         return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
     }
     
+    k_mutex_lock(&registry_lock, K_FOREVER);
+    if (registry_reserved) {
+        k_mutex_unlock(&registry_lock);
+        LOG_WRN("Registry reserved, rejecting sprite %d", packet->sprite_id);
+        return BT_GATT_ERR(BT_ATT_ERR_PROCEDURE_IN_PROGRESS);
+    }
+    
     /* Store sprite */
     uint8_t status = store_sprite(packet->sprite_id, packet->bitmap_data, packet->crc16);
+    k_mutex_unlock(&registry_lock);
     
     if (status == SPRITE_STATUS_SUCCESS) {
-        registry_status = REGISTRY_STATUS_READY;
-        printk("Sprite Service: Successfully stored sprite %d\n", packet->sprite_id);
+        ctx->registry_status = REGISTRY_STATUS_READY;
+        ctx->last_sprite_id = packet->sprite_id;
+        LOG_DBG("Successfully stored sprite %d", packet->sprite_id);
         return sizeof(*packet);
     } else {
-        registry_status = REGISTRY_STATUS_ERROR;
-        printk("Sprite Service: Failed to store sprite %d (status: %d)\n", packet->sprite_id, status);
+        ctx->registry_status = REGISTRY_STATUS_ERROR;
+        LOG_ERR("Failed to store sprite %d (status: %d)", packet->sprite_id, status);
         return BT_GATT_ERR(BT_ATT_ERR_UNLIKELY);
     }
 }
@@ -179,13 +216,14 @@ static ssize_t sprite_upload_handler(const sprite_upload_packet_t *packet)
 /**
  * @brief Handle sprite download requests
  */
-static ssize_t sprite_download_request_handler(const sprite_download_request_t *packet)
+static ssize_t sprite_download_request_handler(sprite_conn_ctx_t *ctx,
+                                               const sprite_download_request_t *packet)
 {
-    printk("\n=== Sprite Service: sprite_download_request_handler called ===\n");
-    printk("Sprite Service: Download request for sprite %d\n", packet->sprite_id);
+    LOG_DBG("sprite_download_request_handler called");
+    LOG_DBG("Download request for sprite %d", packet->sprite_id);
     
-    last_operation = OPERATION_DOWNLOAD;
-    last_sprite_id = packet->sprite_id;
+    ctx->last_operation = OPERATION_DOWNLOAD;
+    ctx->last_sprite_id = packet->sprite_id;
     
     /* This is a write-only characteristic that triggers a download response */
     /* The actual response is sent via the download response characteristic */
@@ -196,10 +234,13 @@ static ssize_t sprite_download_request_handler(const sprite_download_request_t *
 /**
  * @brief Handle sprite download response reads
  */
-static ssize_t sprite_download_response_handler(sprite_download_packet_t *response)
+static ssize_t sprite_download_response_handler(sprite_conn_ctx_t *ctx,
+                                                sprite_download_packet_t *response)
 {
-    printk("\n=== Sprite Service: sprite_download_response_handler called ===\n");
-    printk("Sprite Service: Preparing download response for sprite %d\n", last_sprite_id);
+    uint16_t last_sprite_id = ctx->last_sprite_id;
+    
+    LOG_DBG("sprite_download_response_handler called");
+    LOG_DBG("Preparing download response for sprite %d", last_sprite_id);
     
     /* Find sprite */
     sprite_slot_t *slot = find_sprite_slot(last_sprite_id);
@@ -212,15 +253,15 @@ static ssize_t sprite_download_response_handler(sprite_download_packet_t *respon
         response->crc16 = slot->crc16;
         response->status = SPRITE_STATUS_SUCCESS;
         
-        printk("Sprite Service: Returning sprite %d (CRC: 0x%04x)\n", 
-               last_sprite_id, slot->crc16);
+        LOG_DBG("Returning sprite %d (CRC: 0x%04x)", 
+                last_sprite_id, slot->crc16);
     } else {
         /* Sprite not found */
         memset(response->bitmap_data, 0, SPRITE_DATA_SIZE);
         response->crc16 = 0;
         response->status = SPRITE_STATUS_NOT_FOUND;
         
-        printk("Sprite Service: Sprite %d not found\n", last_sprite_id);
+        LOG_WRN("Sprite %d not found", last_sprite_id);
     }
     
     return sizeof(*response);
@@ -229,21 +270,22 @@ static ssize_t sprite_download_response_handler(sprite_download_packet_t *respon
 /**
  * @brief Handle registry status requests
  */
-static ssize_t sprite_registry_status_handler(sprite_registry_status_t *response)
+static ssize_t sprite_registry_status_handler(sprite_conn_ctx_t *ctx,
+                                              sprite_registry_status_t *response)
 {
-    printk("\n=== Sprite Service: sprite_registry_status_handler called ===\n");
-    printk("Sprite Service: Status request\n");
+    LOG_DBG("sprite_registry_status_handler called");
+    LOG_DBG("Status request");
     
     response->total_sprites = sprite_count;
     response->free_slots = SPRITE_MAX_COUNT - sprite_count;
-    response->last_sprite_id = last_sprite_id;
-    response->registry_status = registry_status;
-    response->last_operation = last_operation;
+    response->last_sprite_id = ctx->last_sprite_id;
+    response->registry_status = ctx->registry_status;
+    response->last_operation = ctx->last_operation;
     response->crc_errors = crc_error_count;
     response->reserved = 0;
     
-    printk("Sprite Service: Status - %d sprites, %d free slots, %d CRC errors\n",
-           sprite_count, SPRITE_MAX_COUNT - sprite_count, crc_error_count);
+    LOG_DBG("Status - %d sprites, %d free slots, %d CRC errors",
+            sprite_count, SPRITE_MAX_COUNT - sprite_count, crc_error_count);
     
     return sizeof(*response);
 }
@@ -251,13 +293,14 @@ static ssize_t sprite_registry_status_handler(sprite_registry_status_t *response
 /**
  * @brief Handle sprite verification requests
  */
-static ssize_t sprite_verify_request_handler(const sprite_verify_request_t *packet)
+static ssize_t sprite_verify_request_handler(sprite_conn_ctx_t *ctx,
+                                             const sprite_verify_request_t *packet)
 {
-    printk("\n=== Sprite Service: sprite_verify_request_handler called ===\n");
-    printk("Sprite Service: Verification request for sprite %d\n", packet->sprite_id);
+    LOG_DBG("sprite_verify_request_handler called");
+    LOG_DBG("Verification request for sprite %d", packet->sprite_id);
     
-    last_operation = OPERATION_VERIFY;
-    last_sprite_id = packet->sprite_id;
+    ctx->last_operation = OPERATION_VERIFY;
+    ctx->last_sprite_id = packet->sprite_id;
     
     return sizeof(*packet);
 }
@@ -265,10 +308,13 @@ static ssize_t sprite_verify_request_handler(const sprite_verify_request_t *pack
 /**
  * @brief Handle sprite verification response reads
  */
-static ssize_t sprite_verify_response_handler(sprite_verify_response_t *response)
+static ssize_t sprite_verify_response_handler(sprite_conn_ctx_t *ctx,
+                                              sprite_verify_response_t *response)
 {
-    printk("\n=== Sprite Service: sprite_verify_response_handler called ===\n");
-    printk("Sprite Service: Preparing verification response for sprite %d\n", last_sprite_id);
+    uint16_t last_sprite_id = ctx->last_sprite_id;
+    
+    LOG_DBG("sprite_verify_response_handler called");
+    LOG_DBG("Preparing verification response for sprite %d", last_sprite_id);
     
     sprite_slot_t *slot = find_sprite_slot(last_sprite_id);
     
@@ -284,17 +330,17 @@ static ssize_t sprite_verify_response_handler(sprite_verify_response_t *response
         
         if (calculated_crc == slot->crc16) {
             response->verification_status = VERIFY_STATUS_VALID;
-            printk("Sprite Service: Sprite %d verification PASSED\n", last_sprite_id);
+            LOG_DBG("Sprite %d verification PASSED", last_sprite_id);
         } else {
             response->verification_status = VERIFY_STATUS_INVALID;
-            printk("Sprite Service: Sprite %d verification FAILED (stored: 0x%04x, calculated: 0x%04x)\n",
-                   last_sprite_id, slot->crc16, calculated_crc);
+            LOG_WRN("Sprite %d verification FAILED (stored: 0x%04x, calculated: 0x%04x)",
+                    last_sprite_id, slot->crc16, calculated_crc);
         }
     } else {
         response->stored_crc16 = 0;
         response->calculated_crc16 = 0;
         response->verification_status = VERIFY_STATUS_NOT_FOUND;
-        printk("Sprite Service: Sprite %d not found for verification\n", last_sprite_id);
+        LOG_WRN("Sprite %d not found for verification", last_sprite_id);
     }
     
     return sizeof(*response);
@@ -305,12 +351,12 @@ static ssize_t sprite_verify_response_handler(sprite_verify_response_t *response
  * ============================================================================ */
 
 /* Generate BLE wrappers automatically */
-BLE_WRITE_WRAPPER(sprite_upload_handler, sprite_upload_packet_t)
-BLE_WRITE_WRAPPER(sprite_download_request_handler, sprite_download_request_t)
-BLE_READ_WRAPPER(sprite_download_response_handler, sprite_download_packet_t)
-BLE_READ_WRAPPER(sprite_registry_status_handler, sprite_registry_status_t)
-BLE_WRITE_WRAPPER(sprite_verify_request_handler, sprite_verify_request_t)
-BLE_READ_WRAPPER(sprite_verify_response_handler, sprite_verify_response_t)
+BLE_WRITE_WRAPPER_CTX(sprite_upload_handler, sprite_upload_packet_t, sprite_ctx_get)
+BLE_WRITE_WRAPPER_CTX(sprite_download_request_handler, sprite_download_request_t, sprite_ctx_get)
+BLE_READ_WRAPPER_CTX(sprite_download_response_handler, sprite_download_packet_t, sprite_ctx_get)
+BLE_READ_WRAPPER_CTX(sprite_registry_status_handler, sprite_registry_status_t, sprite_ctx_get)
+BLE_WRITE_WRAPPER_CTX(sprite_verify_request_handler, sprite_verify_request_t, sprite_ctx_get)
+BLE_READ_WRAPPER_CTX(sprite_verify_response_handler, sprite_verify_response_t, sprite_ctx_get)
 
 /* ============================================================================
  * SERVICE DEFINITION
@@ -359,6 +405,19 @@ BT_GATT_SERVICE_DEFINE(sprite_service,
     BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
 );
 
+static void sprite_service_print_stats(void)
+{
+    LOG_INF("  %d sprites, %d free slots, %d CRC errors",
+            sprite_count, SPRITE_MAX_COUNT - sprite_count, crc_error_count);
+}
+
+BLE_SERVICE_DEFINE(sprite, 50,
+    .name = "Sprite Service",
+    .uuid = 0xFFF8,
+    .init = sprite_service_init,
+    .connection = sprite_service_connection_event,
+    .stats = sprite_service_print_stats);
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
@@ -369,45 +428,52 @@ int sprite_service_init(void)
     memset(sprite_registry, 0, sizeof(sprite_registry));
     sprite_count = 0;
     crc_error_count = 0;
-    registry_status = REGISTRY_STATUS_READY;
-    last_operation = OPERATION_NONE;
-    last_sprite_id = SPRITE_ID_INVALID;
-    sprite_conn = NULL;
-    
-    printk("Sprite Service: Initialized\n");
-    printk("  Service UUID: 0xFFF8\n");
-    printk("  Max sprites: %d\n", SPRITE_MAX_COUNT);
-    printk("  Sprite size: %dx%d pixels (%d bytes)\n", 
-           SPRITE_WIDTH, SPRITE_HEIGHT, SPRITE_DATA_SIZE);
-    printk("  Upload packet size: %zu bytes\n", sizeof(sprite_upload_packet_t));
-    printk("  Download packet size: %zu bytes\n", sizeof(sprite_download_packet_t));
-    printk("  Characteristics:\n");
-    printk("    - Upload (0xFFF9): WRITE\n");
-    printk("    - Download Request (0xFFFA): WRITE\n");
-    printk("    - Download Response (0xFFFB): READ + NOTIFY\n");
-    printk("    - Registry Status (0xFFFC): READ + NOTIFY\n");
-    printk("    - Verify Request (0xFFFD): WRITE\n");
-    printk("    - Verify Response (0xFFFE): READ + NOTIFY\n");
+    registry_generation = 0;
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        sprite_ctx_reset(&sprite_ctx[i], NULL);
+    }
+    
+    LOG_INF("Initialized");
+    LOG_INF("  Service UUID: 0xFFF8");
+    LOG_INF("  Max sprites: %d", SPRITE_MAX_COUNT);
+    LOG_INF("  Sprite size: %dx%d pixels (%d bytes)", 
+            SPRITE_WIDTH, SPRITE_HEIGHT, SPRITE_DATA_SIZE);
+    LOG_INF("  Upload packet size: %zu bytes", sizeof(sprite_upload_packet_t));
+    LOG_INF("  Download packet size: %zu bytes", sizeof(sprite_download_packet_t));
+    LOG_INF("  Characteristics:");
+    LOG_INF("    - Upload (0xFFF9): WRITE");
+    LOG_INF("    - Download Request (0xFFFA): WRITE");
+    LOG_INF("    - Download Response (0xFFFB): READ + NOTIFY");
+    LOG_INF("    - Registry Status (0xFFFC): READ + NOTIFY");
+    LOG_INF("    - Verify Request (0xFFFD): WRITE");
+    LOG_INF("    - Verify Response (0xFFFE): READ + NOTIFY");
     
     return 0;
 }
 
 void sprite_service_connection_event(struct bt_conn *conn, bool connected)
 {
+    sprite_conn_ctx_t *ctx = sprite_ctx_get(conn);
+    
+    if (!ctx) {
+        return;
+    }
+    
     if (connected) {
-        printk("Sprite Service: Client connected\n");
-        sprite_conn = conn;
+        LOG_INF("Client connected");
+        sprite_ctx_reset(ctx, conn);
     } else {
-        printk("Sprite Service: Client disconnected\n");
-        if (conn == sprite_conn) {
-            sprite_conn = NULL;
-        }
+        LOG_INF("Client disconnected");
+        sprite_ctx_reset(ctx, NULL);
     }
 }
 
 uint8_t sprite_service_get_registry_status(void)
 {
-    return registry_status;
+    if (registry_reserved) {
+        return REGISTRY_STATUS_BUSY;
+    }
+    return (sprite_count >= SPRITE_MAX_COUNT) ? REGISTRY_STATUS_FULL : REGISTRY_STATUS_READY;
 }
 
 uint16_t sprite_service_get_sprite_count(void)
@@ -415,24 +481,84 @@ uint16_t sprite_service_get_sprite_count(void)
     return sprite_count;
 }
 
+uint16_t sprite_service_get_generation(void)
+{
+    return registry_generation;
+}
+
 bool sprite_service_sprite_exists(uint16_t sprite_id)
 {
     return find_sprite_slot(sprite_id) != NULL;
 }
 
+uint8_t sprite_service_store_sprite(uint16_t sprite_id, const uint8_t *bitmap_data, uint16_t crc16)
+{
+    if (!bitmap_data || sprite_id == SPRITE_ID_INVALID) {
+        return SPRITE_STATUS_INVALID_DATA;
+    }
+    
+    return store_sprite(sprite_id, bitmap_data, crc16);
+}
+
+int sprite_service_read_slot(uint16_t slot, sprite_upload_packet_t *sprite)
+{
+    if (slot >= SPRITE_MAX_COUNT || !sprite) {
+        return -EINVAL;
+    }
+    
+    const sprite_slot_t *entry = &sprite_registry[slot];
+    if (!entry->is_valid) {
+        return -ENOENT;
+    }
+    
+    sprite->sprite_id = entry->sprite_id;
+    memcpy(sprite->bitmap_data, entry->bitmap_data, SPRITE_DATA_SIZE);
+    sprite->crc16 = entry->crc16;
+    return 0;
+}
+
 int sprite_service_clear_registry(void)
 {
-    printk("Sprite Service: Clearing registry\n");
+    LOG_INF("Clearing registry");
     
     memset(sprite_registry, 0, sizeof(sprite_registry));
     sprite_count = 0;
-    last_sprite_id = SPRITE_ID_INVALID;
-    registry_status = REGISTRY_STATUS_READY;
+    registry_generation++;
+    event_bus_publish(EVENT_SPRITE_REGISTRY);
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        sprite_ctx[i].last_sprite_id = SPRITE_ID_INVALID;
+        sprite_ctx[i].registry_status = REGISTRY_STATUS_READY;
+    }
     
-    printk("Sprite Service: Registry cleared\n");
+    LOG_INF("Registry cleared");
     return 0;
 }
 
+int sprite_service_reserve_empty(void)
+{
+    int err = 0;
+    
+    k_mutex_lock(&registry_lock, K_FOREVER);
+    if (registry_reserved) {
+        err = -EBUSY;
+    } else if (sprite_count != 0) {
+        err = -ENOTEMPTY;
+    } else {
+        registry_reserved = true;
+    }
+    k_mutex_unlock(&registry_lock);
+    
+    return err;
+}
+
+void sprite_service_release(void)
+{
+    k_mutex_lock(&registry_lock, K_FOREVER);
+    sprite_service_clear_registry();
+    registry_reserved = false;
+    k_mutex_unlock(&registry_lock);
+}
+
 void sprite_service_get_statistics(uint16_t *total_sprites, uint16_t *free_slots, uint16_t *crc_errors)
 {
     if (total_sprites) *total_sprites = sprite_count;
@@ -186,7 +186,12 @@ void sprite_service_connection_event(struct bt_conn *conn, bool connected);
 
 /**
  * @brief Get sprite registry status
- * @return Current registry status
+ * 
+ * Per-client operation status is reported on the registry status
+ * characteristic; this only reflects the shared registry.
+ * 
+ * @return REGISTRY_STATUS_BUSY while reserved, REGISTRY_STATUS_FULL if no
+ *         slots are free, otherwise REGISTRY_STATUS_READY
  */
 uint8_t sprite_service_get_registry_status(void);
 
@@ -196,6 +201,16 @@ uint8_t sprite_service_get_registry_status(void);
  */
 uint16_t sprite_service_get_sprite_count(void);
 
+/**
+ * @brief Get the registry generation counter
+ * 
+ * Incremented on every store and clear, so a client that cached the
+ * registry can tell whether it changed without reading it back.
+ * 
+ * @return Generation counter (wraps)
+ */
+uint16_t sprite_service_get_generation(void);
+
 /**
  * @brief Check if sprite ID exists in registry
  * @param sprite_id Sprite ID to check
@@ -211,12 +226,54 @@ bool sprite_service_sprite_exists(uint16_t sprite_id);
  */
 uint16_t sprite_service_calculate_crc16(const uint8_t *data, uint16_t length);
 
+/**
+ * @brief Store a sprite in the registry
+ * 
+ * Same path as a BLE upload: verifies the CRC, then updates an existing
+ * sprite with the same ID or takes a free slot.
+ * 
+ * @param sprite_id Sprite ID
+ * @param bitmap_data Bitmap data (SPRITE_DATA_SIZE bytes)
+ * @param crc16 CRC16 checksum of bitmap_data
+ * @return SPRITE_STATUS_* code
+ */
+uint8_t sprite_service_store_sprite(uint16_t sprite_id, const uint8_t *bitmap_data, uint16_t crc16);
+
+/**
+ * @brief Read a registry slot in upload packet format
+ * 
+ * Walking slots 0 to SPRITE_MAX_COUNT - 1 visits every stored sprite,
+ * e.g. to forward the registry to another device.
+ * 
+ * @param slot Slot index
+ * @param sprite Packet to fill in
+ * @return 0 on success, -ENOENT if the slot is empty, -EINVAL if out of range
+ */
+int sprite_service_read_slot(uint16_t slot, sprite_upload_packet_t *sprite);
+
 /**
  * @brief Clear all sprites from registry
  * @return 0 on success, negative error code on failure
  */
 int sprite_service_clear_registry(void);
 
+/**
+ * @brief Reserve the empty registry for on-device use
+ * 
+ * While reserved, BLE uploads fail with BT_ATT_ERR_PROCEDURE_IN_PROGRESS,
+ * so the caller can fill and clear the registry without touching a
+ * client's sprites. Release with sprite_service_release().
+ * 
+ * @return 0 on success, -ENOTEMPTY if the registry holds sprites,
+ *         -EBUSY if it is already reserved
+ */
+int sprite_service_reserve_empty(void);
+
+/**
+ * @brief Clear the registry and end a reservation
+ */
+void sprite_service_release(void);
+
 /**
  * @brief Get registry statistics
  * @param total_sprites Pointer to store total sprite count
@@ -0,0 +1,214 @@
+#include "status_broadcast.h"
+#include "ble_services.h"
+#include "control_service.h"
+#include "dfu_service.h"
+#include "event_bus.h"
+#include "sprite_service.h"
+#include "wasm_service.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+/**
+ * @file status_broadcast.c
+ * @brief Connectionless status broadcast implementation
+ */
+
+LOG_MODULE_REGISTER(status_broadcast, CONFIG_STATUS_BROADCAST_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+static struct bt_le_ext_adv *adv_set;
+static status_broadcast_block_t current_block;
+static bool fast_advertising;
+
+/* Extended PDUs: the name plus the status block do not fit in 31 bytes */
+static const struct bt_le_adv_param adv_param =
+    BT_LE_ADV_PARAM_INIT(BT_LE_ADV_OPT_EXT_ADV | BT_LE_ADV_OPT_CONNECTABLE,
+                         BT_GAP_ADV_FAST_INT_MIN_2, BT_GAP_ADV_FAST_INT_MAX_2, NULL);
+
+/* 30-60 ms instead of 100-150 ms while a bonded client is expected back */
+static const struct bt_le_adv_param fast_adv_param =
+    BT_LE_ADV_PARAM_INIT(BT_LE_ADV_OPT_EXT_ADV | BT_LE_ADV_OPT_CONNECTABLE,
+                         BT_GAP_ADV_FAST_INT_MIN_1, BT_GAP_ADV_FAST_INT_MAX_1, NULL);
+
+/* Service data AD payload: 16-bit UUID followed by the status block */
+static uint8_t service_data[sizeof(uint16_t) + sizeof(status_broadcast_block_t)];
+
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+    BT_DATA(BT_DATA_SVC_DATA16, service_data, sizeof(service_data)),
+};
+
+static void refresh_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(refresh_work, refresh_work_handler);
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void sample_block(status_broadcast_block_t *block)
+{
+    wasm_result_packet_t result;
+    uint32_t dfu_bytes = dfu_service_get_bytes_received();
+
+    memset(block, 0, sizeof(*block));
+    block->version = STATUS_BROADCAST_VERSION;
+    block->device_status = control_service_get_device_status();
+    block->connections = ble_services_get_connection_count();
+    block->wasm_status = wasm_service_get_status();
+    block->registry_generation = sprite_service_get_generation();
+    block->sprite_count = sprite_service_get_sprite_count();
+    block->dfu_state = dfu_service_get_state();
+    block->dfu_kb = MIN(dfu_bytes / 1024, UINT8_MAX);
+
+    if (wasm_service_is_ready()) {
+        block->flags |= STATUS_FLAG_MODULE_LOADED;
+    }
+    if (wasm_service_get_last_result(&result) == 0) {
+        block->flags |= STATUS_FLAG_RESULT_VALID;
+        block->last_result = result.return_value;
+    }
+    if (block->dfu_state != DFU_STATE_IDLE) {
+        block->flags |= STATUS_FLAG_DFU_ACTIVE;
+    }
+    if (sprite_service_get_registry_status() == REGISTRY_STATUS_FULL) {
+        block->flags |= STATUS_FLAG_REGISTRY_FULL;
+    }
+}
+
+/**
+ * @brief Rebuild the status block and push it to the controller if it changed
+ * @return 0 on success or if nothing changed, negative error code on failure
+ */
+static int update_block(void)
+{
+    status_broadcast_block_t block;
+
+    sample_block(&block);
+
+    /* seq is the only field the sample does not fill in */
+    block.seq = current_block.seq;
+    if (memcmp(&block, &current_block, sizeof(block)) == 0) {
+        return 0;
+    }
+
+    block.seq++;
+    current_block = block;
+
+    sys_put_le16(STATUS_BROADCAST_UUID, service_data);
+    memcpy(&service_data[sizeof(uint16_t)], &current_block, sizeof(current_block));
+
+    int err = bt_le_ext_adv_set_data(adv_set, ad, ARRAY_SIZE(ad), NULL, 0);
+    if (err) {
+        return err;
+    }
+
+    LOG_DBG("Status block %d (device %d, wasm %d, generation %d)", current_block.seq,
+            current_block.device_status, current_block.wasm_status,
+            current_block.registry_generation);
+    return 0;
+}
+
+static void refresh_work_handler(struct k_work *work)
+{
+    int err = update_block();
+    if (err) {
+        LOG_WRN("Failed to update advertising data (err %d)", err);
+    }
+    k_work_schedule(&refresh_work, K_MSEC(STATUS_BROADCAST_INTERVAL_MS));
+}
+
+/**
+ * @brief Refresh the block as soon as anything it carries changes
+ */
+static void status_event_handler(uint32_t events)
+{
+    k_work_reschedule(&refresh_work, K_NO_WAIT);
+}
+
+EVENT_SUBSCRIBER_DEFINE(status_broadcast, EVENT_CONNECTION | EVENT_DEVICE_STATUS |
+                        EVENT_WASM_STATUS | EVENT_WASM_RESULT | EVENT_SPRITE_REGISTRY |
+                        EVENT_DFU_STATE, status_event_handler);
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int status_broadcast_init(void)
+{
+    int err = bt_le_ext_adv_create(&adv_param, NULL, &adv_set);
+    if (err) {
+        LOG_ERR("Failed to create advertising set (err %d)", err);
+        return err;
+    }
+
+    /* An all-zero block never matches a sample, so this always sets the data */
+    memset(&current_block, 0, sizeof(current_block));
+    err = update_block();
+    if (err) {
+        LOG_ERR("Failed to set advertising data (err %d)", err);
+        return err;
+    }
+
+    k_work_schedule(&refresh_work, K_MSEC(STATUS_BROADCAST_INTERVAL_MS));
+
+    LOG_INF("Initialized (%zu byte status block, every %d ms)",
+            sizeof(status_broadcast_block_t), STATUS_BROADCAST_INTERVAL_MS);
+    return 0;
+}
+
+int status_broadcast_start(void)
+{
+    if (!adv_set) {
+        return -EINVAL;
+    }
+
+    int err = bt_le_ext_adv_start(adv_set, BT_LE_EXT_ADV_START_DEFAULT);
+    if (err == -EALREADY) {
+        return 0;
+    }
+
+    return err;
+}
+
+int status_broadcast_set_fast(bool fast)
+{
+    if (!adv_set) {
+        return -EINVAL;
+    }
+    if (fast == fast_advertising) {
+        return 0;
+    }
+
+    /* Parameters can only be changed while the set is stopped */
+    bt_le_ext_adv_stop(adv_set);
+
+    int err = bt_le_ext_adv_update_param(adv_set, fast ? &fast_adv_param : &adv_param);
+    if (err) {
+        LOG_WRN("Failed to update advertising parameters (err %d)", err);
+    } else {
+        fast_advertising = fast;
+        LOG_DBG("%s advertising", fast ? "Fast" : "Normal");
+    }
+
+    /* -ENOMEM while all connection slots are in use; recycled() retries */
+    status_broadcast_start();
+    return err;
+}
+
+void status_broadcast_refresh(void)
+{
+    k_work_reschedule(&refresh_work, K_NO_WAIT);
+}
+
+void status_broadcast_get_block(status_broadcast_block_t *block)
+{
+    if (block) {
+        *block = current_block;
+    }
+}
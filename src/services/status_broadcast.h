@@ -0,0 +1,96 @@
+#ifndef STATUS_BROADCAST_H
+#define STATUS_BROADCAST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file status_broadcast.h
+ * @brief Connectionless status broadcast
+ *
+ * Owns the connectable advertising set. It is an extended advertising set
+ * whose service data carries a compact status block, so dashboards can
+ * read the device state from a scan without connecting. The block is
+ * refreshed on every state change event (and on a slow fallback timer)
+ * and only pushed to the controller when it changes.
+ */
+
+/* ============================================================================
+ * STATUS BLOCK
+ * ============================================================================ */
+
+#define STATUS_BROADCAST_UUID           0xFFE0  /* Service data UUID (Control Service) */
+#define STATUS_BROADCAST_VERSION        0x01
+#define STATUS_BROADCAST_INTERVAL_MS    10000   /* Fallback refresh; changes are pushed by events */
+
+/* Status block flags */
+#define STATUS_FLAG_MODULE_LOADED       0x01    /* A WASM module is loaded and runnable */
+#define STATUS_FLAG_RESULT_VALID        0x02    /* last_result holds a real result */
+#define STATUS_FLAG_DFU_ACTIVE          0x04    /* A DFU transfer is in progress */
+#define STATUS_FLAG_REGISTRY_FULL       0x08    /* No free sprite slots */
+
+/**
+ * @brief Status block carried in the advertising service data
+ *
+ * Follows the 16-bit service UUID in the service data AD structure.
+ * Total size: 16 bytes
+ */
+typedef struct {
+    uint8_t version;                ///< STATUS_BROADCAST_VERSION
+    uint8_t seq;                    ///< Incremented whenever the block changes
+    uint8_t device_status;          ///< DEVICE_STATUS_* from the Control Service
+    uint8_t flags;                  ///< STATUS_FLAG_*
+    uint8_t connections;            ///< Active connections
+    uint8_t wasm_status;            ///< WASM_STATUS_*
+    int32_t last_result;            ///< Return value of the last WASM call
+    uint16_t registry_generation;   ///< Sprite registry generation counter
+    uint16_t sprite_count;          ///< Sprites in the registry
+    uint8_t dfu_state;              ///< DFU_STATE_*
+    uint8_t dfu_kb;                 ///< DFU bytes received in KB (saturates at 255)
+} __attribute__((packed)) status_broadcast_block_t;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create the advertising set and start the refresh timer
+ *
+ * Must be called after bt_enable() and ble_services_init().
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int status_broadcast_init(void);
+
+/**
+ * @brief Start advertising
+ *
+ * Connectable advertising stops when a central connects, so this is
+ * called again after each connection and whenever a slot is freed.
+ *
+ * @return 0 on success or if already advertising, negative error code on failure
+ */
+int status_broadcast_start(void);
+
+/**
+ * @brief Switch between the normal and the fast advertising interval
+ *
+ * Restarts the advertising set with the new interval.
+ *
+ * @param fast true for 30-60 ms, false for 100-150 ms
+ * @return 0 on success, negative error code on failure
+ */
+int status_broadcast_set_fast(bool fast);
+
+/**
+ * @brief Refresh the status block now instead of at the next period
+ */
+void status_broadcast_refresh(void);
+
+/**
+ * @brief Get the status block currently being advertised
+ * @param block Block to fill in
+ */
+void status_broadcast_get_block(status_broadcast_block_t *block);
+
+#endif /* STATUS_BROADCAST_H */
@@ -0,0 +1,191 @@
+#include "telemetry.h"
+#include "wasm_service.h"
+#include "time_sync.h"
+#include <zephyr/kernel.h>
+#include <zephyr/net/buf.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/iterable_sections.h>
+#include <string.h>
+
+/**
+ * @file telemetry.c
+ * @brief System telemetry sampling implementation
+ */
+
+LOG_MODULE_REGISTER(telemetry, CONFIG_TELEMETRY_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+/* Name prefixes of the tracked threads, indexed by CONTROL_TELEMETRY_THREAD_* */
+static const char *const tracked_thread_names[CONTROL_TELEMETRY_THREAD_COUNT] = {
+    "BT RX",            /* "BT RX" or "BT RX WQ" depending on the host version */
+    "sysworkq",
+    "wasm_work_thread",
+};
+
+/* Previous runtime stats, used to turn cumulative cycles into load */
+static k_thread_runtime_stats_t prev_system_stats;
+static uint64_t prev_thread_cycles[CONTROL_TELEMETRY_THREAD_COUNT];
+
+/* Scratch state shared with the thread iteration callback */
+typedef struct {
+    control_telemetry_packet_t *packet;
+    uint64_t thread_cycles[CONTROL_TELEMETRY_THREAD_COUNT];
+    uint8_t thread_count;
+} telemetry_walk_t;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint16_t to_permille(uint64_t part, uint64_t whole)
+{
+    if (whole == 0) {
+        return 0;
+    }
+
+    uint64_t permille = (part * 1000) / whole;
+    return (permille > 1000) ? 1000 : (uint16_t)permille;
+}
+
+static int tracked_thread_index(const char *name)
+{
+    if (!name) {
+        return -1;
+    }
+
+    for (int i = 0; i < CONTROL_TELEMETRY_THREAD_COUNT; i++) {
+        if (strncmp(name, tracked_thread_names[i], strlen(tracked_thread_names[i])) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void telemetry_thread_cb(const struct k_thread *thread, void *user_data)
+{
+    telemetry_walk_t *walk = user_data;
+    k_tid_t tid = (k_tid_t)thread;
+
+    walk->thread_count++;
+
+    int index = tracked_thread_index(k_thread_name_get(tid));
+    if (index < 0) {
+        return;
+    }
+
+    control_telemetry_thread_t *record = &walk->packet->threads[index];
+    size_t unused = 0;
+
+    record->stack_size = (uint16_t)MIN(thread->stack_info.size, UINT16_MAX);
+    if (k_thread_stack_space_get(thread, &unused) == 0) {
+        record->stack_unused = (uint16_t)MIN(unused, UINT16_MAX);
+    }
+
+    k_thread_runtime_stats_t stats;
+    if (k_thread_runtime_stats_get(tid, &stats) == 0) {
+        walk->thread_cycles[index] = stats.execution_cycles;
+    }
+}
+
+/**
+ * @brief Sum buffer usage of the Bluetooth host pools
+ *
+ * Pools are told apart by name, which needs CONFIG_NET_BUF_POOL_USAGE.
+ */
+static void sample_bt_buffers(control_telemetry_packet_t *packet)
+{
+    uint32_t tx_total = 0, tx_free = 0, rx_total = 0, rx_free = 0;
+
+    STRUCT_SECTION_FOREACH(net_buf_pool, pool) {
+        const char *name = pool->name;
+        uint32_t avail = atomic_get(&pool->avail_count);
+
+        if (!name) {
+            continue;
+        }
+
+        if (strstr(name, "tx")) {
+            tx_total += pool->buf_count;
+            tx_free += avail;
+        } else if (strstr(name, "rx") || strstr(name, "acl_in") || strstr(name, "evt")) {
+            rx_total += pool->buf_count;
+            rx_free += avail;
+        }
+    }
+
+    packet->bt_tx_bufs_total = MIN(tx_total, UINT8_MAX);
+    packet->bt_tx_bufs_free = MIN(tx_free, UINT8_MAX);
+    packet->bt_rx_bufs_total = MIN(rx_total, UINT8_MAX);
+    packet->bt_rx_bufs_free = MIN(rx_free, UINT8_MAX);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int telemetry_init(void)
+{
+    memset(prev_thread_cycles, 0, sizeof(prev_thread_cycles));
+
+    int err = k_thread_runtime_stats_all_get(&prev_system_stats);
+    if (err) {
+        LOG_ERR("Failed to read runtime stats (err %d)", err);
+        return err;
+    }
+
+    LOG_INF("Initialized (tracking %d threads)", CONTROL_TELEMETRY_THREAD_COUNT);
+    return 0;
+}
+
+int telemetry_sample(control_telemetry_packet_t *packet)
+{
+    if (!packet) {
+        return -EINVAL;
+    }
+
+    memset(packet, 0, sizeof(*packet));
+    packet->uptime_ms = k_uptime_get_32();
+    packet->timestamp_us = time_sync_now_us();
+
+    /* System-wide load: execution_cycles counts idle and non-idle time */
+    k_thread_runtime_stats_t now;
+    int err = k_thread_runtime_stats_all_get(&now);
+    if (err) {
+        LOG_ERR("Failed to read runtime stats (err %d)", err);
+        return err;
+    }
+
+    uint64_t elapsed = now.execution_cycles - prev_system_stats.execution_cycles;
+    packet->cpu_load_permille = to_permille(now.total_cycles - prev_system_stats.total_cycles,
+                                            elapsed);
+    packet->idle_permille = to_permille(now.idle_cycles - prev_system_stats.idle_cycles,
+                                        elapsed);
+    prev_system_stats = now;
+
+    /* Stack scans are slow, so walk threads without holding the scheduler lock */
+    telemetry_walk_t walk = {
+        .packet = packet,
+    };
+    memcpy(walk.thread_cycles, prev_thread_cycles, sizeof(walk.thread_cycles));
+    k_thread_foreach_unlocked(telemetry_thread_cb, &walk);
+
+    for (int i = 0; i < CONTROL_TELEMETRY_THREAD_COUNT; i++) {
+        packet->threads[i].cpu_permille = to_permille(walk.thread_cycles[i] - prev_thread_cycles[i],
+                                                      elapsed);
+        prev_thread_cycles[i] = walk.thread_cycles[i];
+    }
+    packet->thread_count = walk.thread_count;
+
+    uint32_t heap_size, heap_used;
+    wasm_service_get_memory_usage(&heap_size, &heap_used);
+    packet->wasm3_heap_size = heap_size;
+    packet->wasm3_heap_used = heap_used;
+
+    sample_bt_buffers(packet);
+
+    return 0;
+}
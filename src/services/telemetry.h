@@ -0,0 +1,42 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "control_service.h"
+#include <stdint.h>
+
+/**
+ * @file telemetry.h
+ * @brief System telemetry sampling
+ *
+ * Collects CPU load, per-thread stack high-water marks and CPU share,
+ * wasm3 memory usage and Bluetooth buffer pool usage into a single
+ * snapshot that the Control Service exposes over BLE.
+ */
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize telemetry sampling
+ *
+ * Takes the baseline runtime stats so the first sample reports load
+ * since boot instead of garbage.
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int telemetry_init(void);
+
+/**
+ * @brief Take a telemetry sample
+ *
+ * CPU figures are computed against the previous call, so calling this
+ * at a fixed interval gives the load over that interval. timestamp_us is
+ * device time; convert it with time_sync_to_client_us() before sending.
+ *
+ * @param packet Packet to fill in
+ * @return 0 on success, negative error code on failure
+ */
+int telemetry_sample(control_telemetry_packet_t *packet);
+
+#endif /* TELEMETRY_H */
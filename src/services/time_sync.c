@@ -0,0 +1,240 @@
+#include "time_sync.h"
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+/**
+ * @file time_sync.c
+ * @brief NTP-style clock synchronization implementation
+ *
+ * Each exchange yields t1 (client send), t2 (device receive), t3 (device
+ * send) and t4 (client receive, reported with the next request). From
+ * these, offset = ((t1 - t2) + (t4 - t3)) / 2 and rtt = (t4 - t1) - (t3 - t2).
+ * Samples with a round trip close to the best one in the window are
+ * fitted with a least-squares line to get offset and drift.
+ */
+
+LOG_MODULE_REGISTER(time_sync, CONFIG_TIME_SYNC_LOG_LEVEL);
+
+/* ============================================================================
+ * STATIC DATA
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t device_us;     /* t2 of the exchange */
+    int64_t offset_us;      /* Client minus device time */
+    uint32_t rtt_us;        /* Round trip without device processing time */
+} time_sync_sample_t;
+
+typedef struct {
+    /* Exchange waiting for the client's t4 */
+    bool pending_valid;
+    uint64_t pending_t1_us;
+    uint64_t pending_t2_us;
+    uint64_t pending_t3_us;
+
+    /* Completed exchanges, oldest overwritten first */
+    time_sync_sample_t samples[TIME_SYNC_WINDOW];
+    uint8_t sample_count;
+    uint8_t next_sample;
+
+    /* Current estimate */
+    bool offset_valid;
+    bool drift_valid;
+    uint64_t ref_device_us;
+    int64_t offset_us;
+    int32_t drift_ppb;
+    uint32_t best_rtt_us;
+} time_sync_state_t;
+
+static time_sync_state_t sync_state[CONFIG_BT_MAX_CONN];
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static time_sync_state_t *state_for_conn(struct bt_conn *conn)
+{
+    if (!conn) {
+        return NULL;
+    }
+
+    uint8_t index = bt_conn_index(conn);
+    return (index < CONFIG_BT_MAX_CONN) ? &sync_state[index] : NULL;
+}
+
+static void add_sample(time_sync_state_t *state, uint64_t t1, uint64_t t2,
+                       uint64_t t3, uint64_t t4)
+{
+    int64_t rtt = (int64_t)(t4 - t1) - (int64_t)(t3 - t2);
+
+    if (t4 < t1 || rtt < 0) {
+        LOG_DBG("Discarding inconsistent sample (rtt %lld us)", (long long)rtt);
+        return;
+    }
+
+    time_sync_sample_t *sample = &state->samples[state->next_sample];
+    sample->device_us = t2;
+    sample->offset_us = ((int64_t)(t1 - t2) + (int64_t)(t4 - t3)) / 2;
+    sample->rtt_us = (rtt > UINT32_MAX) ? UINT32_MAX : (uint32_t)rtt;
+
+    state->next_sample = (state->next_sample + 1) % TIME_SYNC_WINDOW;
+    if (state->sample_count < TIME_SYNC_WINDOW) {
+        state->sample_count++;
+    }
+}
+
+static void update_estimate(time_sync_state_t *state)
+{
+    if (state->sample_count == 0) {
+        return;
+    }
+
+    /* Queueing delay only ever adds to the round trip, so trust the fastest samples */
+    const time_sync_sample_t *best = &state->samples[0];
+    uint64_t latest_us = 0;
+    for (uint8_t i = 0; i < state->sample_count; i++) {
+        const time_sync_sample_t *sample = &state->samples[i];
+        if (sample->rtt_us < best->rtt_us) {
+            best = sample;
+        }
+        if (sample->device_us > latest_us) {
+            latest_us = sample->device_us;
+        }
+    }
+
+    uint32_t rtt_limit = best->rtt_us * 2;
+    uint8_t used = 0;
+    uint64_t first_us = UINT64_MAX;
+    double sum_x = 0, sum_y = 0;
+    for (uint8_t i = 0; i < state->sample_count; i++) {
+        const time_sync_sample_t *sample = &state->samples[i];
+        if (sample->rtt_us > rtt_limit) {
+            continue;
+        }
+        /* Relative to the best sample to keep the fit well conditioned */
+        sum_x += (double)(int64_t)(sample->device_us - best->device_us);
+        sum_y += (double)(sample->offset_us - best->offset_us);
+        first_us = MIN(first_us, sample->device_us);
+        used++;
+    }
+
+    state->ref_device_us = latest_us;
+    state->best_rtt_us = best->rtt_us;
+    state->offset_valid = true;
+
+    if (used < 2 || latest_us - first_us < TIME_SYNC_MIN_DRIFT_SPAN_US) {
+        state->offset_us = best->offset_us;
+        state->drift_ppb = 0;
+        state->drift_valid = false;
+        return;
+    }
+
+    double mean_x = sum_x / used;
+    double mean_y = sum_y / used;
+    double sxx = 0, sxy = 0;
+    for (uint8_t i = 0; i < state->sample_count; i++) {
+        const time_sync_sample_t *sample = &state->samples[i];
+        if (sample->rtt_us > rtt_limit) {
+            continue;
+        }
+        double dx = (double)(int64_t)(sample->device_us - best->device_us) - mean_x;
+        double dy = (double)(sample->offset_us - best->offset_us) - mean_y;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+
+    double slope = sxy / sxx;
+    double ref_x = (double)(int64_t)(latest_us - best->device_us);
+
+    state->offset_us = best->offset_us + (int64_t)(mean_y + slope * (ref_x - mean_x));
+    state->drift_ppb = (int32_t)(slope * 1e9);
+    state->drift_valid = true;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int time_sync_init(void)
+{
+    memset(sync_state, 0, sizeof(sync_state));
+    LOG_INF("Initialized (%d connections, window %d)",
+            CONFIG_BT_MAX_CONN, TIME_SYNC_WINDOW);
+    return 0;
+}
+
+uint64_t time_sync_now_us(void)
+{
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+int time_sync_handle_request(struct bt_conn *conn,
+                             const control_time_sync_request_t *request,
+                             uint64_t t2_us,
+                             control_time_sync_response_t *response)
+{
+    time_sync_state_t *state = state_for_conn(conn);
+
+    if (!state || !request || !response) {
+        return -EINVAL;
+    }
+
+    if (state->pending_valid && request->prev_client_t4_us != 0) {
+        add_sample(state, state->pending_t1_us, state->pending_t2_us,
+                   state->pending_t3_us, request->prev_client_t4_us);
+        update_estimate(state);
+    }
+
+    memset(response, 0, sizeof(*response));
+    response->seq = request->seq;
+    response->sample_count = state->sample_count;
+    response->flags = (state->offset_valid ? CONTROL_TIME_SYNC_FLAG_OFFSET_VALID : 0) |
+                      (state->drift_valid ? CONTROL_TIME_SYNC_FLAG_DRIFT_VALID : 0);
+    response->client_t1_us = request->client_t1_us;
+    response->device_t2_us = t2_us;
+    response->offset_us = state->offset_us;
+    response->drift_ppb = state->drift_ppb;
+    response->rtt_us = state->best_rtt_us;
+
+    /* Stamp t3 last, right before the caller sends the response */
+    uint64_t t3_us = time_sync_now_us();
+    response->device_t3_us = t3_us;
+
+    state->pending_valid = true;
+    state->pending_t1_us = request->client_t1_us;
+    state->pending_t2_us = t2_us;
+    state->pending_t3_us = t3_us;
+
+    return 0;
+}
+
+bool time_sync_is_synced(struct bt_conn *conn)
+{
+    time_sync_state_t *state = state_for_conn(conn);
+
+    return state && state->offset_valid;
+}
+
+uint64_t time_sync_to_client_us(struct bt_conn *conn, uint64_t device_us)
+{
+    time_sync_state_t *state = state_for_conn(conn);
+
+    if (!state || !state->offset_valid) {
+        return device_us;
+    }
+
+    int64_t elapsed_us = (int64_t)(device_us - state->ref_device_us);
+    int64_t drift_us = (elapsed_us * state->drift_ppb) / 1000000000LL;
+
+    return (uint64_t)((int64_t)device_us + state->offset_us + drift_us);
+}
+
+void time_sync_reset(struct bt_conn *conn)
+{
+    time_sync_state_t *state = state_for_conn(conn);
+
+    if (state) {
+        memset(state, 0, sizeof(*state));
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include "control_service.h"
+#include <zephyr/bluetooth/conn.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file time_sync.h
+ * @brief NTP-style clock synchronization with connected clients
+ *
+ * Estimates offset and drift between each client's clock and the device
+ * clock from request/response exchanges over the Control Service, so that
+ * device timestamps can be reported in the client's timebase.
+ */
+
+/* ============================================================================
+ * CONFIGURATION
+ * ============================================================================ */
+
+#define TIME_SYNC_WINDOW                8           /* Samples kept per connection */
+#define TIME_SYNC_MIN_DRIFT_SPAN_US     1000000     /* Samples must span 1 s for drift */
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize time sync state for all connections
+ * @return 0 on success, negative error code on failure
+ */
+int time_sync_init(void);
+
+/**
+ * @brief Get the device clock used for all timestamps
+ *
+ * 64-bit microseconds since boot, derived from the kernel tick counter so
+ * it never wraps (the 32-bit cycle counter wraps after ~36 h on nRF53).
+ *
+ * @return Device time in microseconds
+ */
+uint64_t time_sync_now_us(void);
+
+/**
+ * @brief Process one sync request and build its response
+ *
+ * Completes the previous exchange with the client's t4, updates the
+ * estimate, and stamps t3 as late as possible, so send the response
+ * immediately after this returns.
+ *
+ * @param conn Connection the request arrived on
+ * @param request Request from the client
+ * @param t2_us Device time the request was received
+ * @param response Response to fill in
+ * @return 0 on success, negative error code on failure
+ */
+int time_sync_handle_request(struct bt_conn *conn,
+                             const control_time_sync_request_t *request,
+                             uint64_t t2_us,
+                             control_time_sync_response_t *response);
+
+/**
+ * @brief Check whether a connection has a usable offset estimate
+ * @param conn Connection handle
+ * @return True if at least one exchange has completed
+ */
+bool time_sync_is_synced(struct bt_conn *conn);
+
+/**
+ * @brief Convert a device timestamp to the client's timebase
+ * @param conn Connection whose clock to convert to
+ * @param device_us Device time in microseconds (time_sync_now_us())
+ * @return Client time in microseconds, or device_us unchanged if not synced
+ */
+uint64_t time_sync_to_client_us(struct bt_conn *conn, uint64_t device_us);
+
+/**
+ * @brief Drop the estimate for a connection
+ * @param conn Connection handle
+ */
+void time_sync_reset(struct bt_conn *conn);
+
+#endif /* TIME_SYNC_H */
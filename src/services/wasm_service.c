@@ -1,9 +1,17 @@
 #include "wasm_service.h"
+#include "app_trace.h"
 #include "ble_packet_handlers.h"
+#include "ble_protocol_gen.h"
 #include "ble_services.h"
-#include <zephyr/sys/printk.h>
+#include "time_sync.h"
+#include "link_profile.h"
+#include "event_bus.h"
+#include "conn_sched.h"
+#include "mem_budget.h"
+#include <zephyr/logging/log.h>
 #include <zephyr/sys/crc.h>
 #include <zephyr/kernel.h>
+#include <zephyr/timing/timing.h>
 #include <string.h>
 
 /* Direct WASM3 includes - no more wrapper */
@@ -20,13 +28,18 @@
  * @brief Custom WASM Service implementation
  */
 
+LOG_MODULE_REGISTER(wasm_service, CONFIG_WASM_SERVICE_LOG_LEVEL);
+
 /* ============================================================================
  * STATIC DATA
  * ============================================================================ */
 
-/* WASM memory buffer - statically allocated for deterministic memory usage */
-static uint8_t wasm_code_buffer[WASM_CODE_BUFFER_SIZE];
+/* WASM code buffer - borrowed from the memory budget when an upload starts and
+ * kept while the module is loaded, since wasm3 refers into it */
+static uint8_t *wasm_code_buffer = NULL;
+static uint32_t wasm_code_capacity = 0;        /* Bytes borrowed for wasm_code_buffer */
 static uint32_t wasm_code_size = 0;
+static uint32_t wasm_code_crc32 = 0;           /* Content hash, lets a relay skip up-to-date peers */
 static uint32_t wasm_bytes_received = 0;
 static uint32_t wasm_total_expected = 0;
 static uint8_t wasm_upload_sequence = 0;
@@ -34,7 +47,7 @@ static uint8_t wasm_upload_sequence = 0;
 /* Service state */
 static uint8_t wasm_status = WASM_STATUS_IDLE;
 static uint8_t wasm_error_code = WASM_ERROR_NONE;
-static struct bt_conn *wasm_conn = NULL;
+static struct bt_conn *upload_owner = NULL;    /* Connection streaming the current upload */
 
 /* Notification state */
 static bool wasm_status_notify_enabled = false;
@@ -45,13 +58,37 @@ static IM3Environment wasm_env = NULL;
 static IM3Runtime wasm_runtime = NULL;
 static IM3Module wasm_module = NULL;
 static bool wasm_runtime_initialized = false;
+static bool wasm_module_loaded = false;        /* wasm_module belongs to the runtime */
+
+/* Other holders of wasm_code_buffer. wasm3 refers into the code from the
+ * queued load until the runtime is torn down; relay workers stream it
+ * between wasm_service_get_module() and wasm_service_put_module(). A new
+ * upload is refused while either holds it, and a reset during a relay
+ * leaves the free to the last reader. */
+K_MUTEX_DEFINE(code_lock);
+static bool wasm_load_pending = false;
+static uint8_t code_readers = 0;
+static uint8_t *retired_code = NULL;
+static uint32_t retired_capacity = 0;
 
 /* WASM3 now uses fixed heap (configured in CMakeLists.txt) */
 
-/* Last execution result */
+BUILD_ASSERT(CONFIG_MEM_BUDGET_WASM_QUOTA >= ROUND_UP(WASM_CODE_BUFFER_SIZE, CONFIG_MEM_BUDGET_BLOCK_SIZE),
+             "WASM quota must hold the largest module");
+
+/* Last execution result from any connection */
 static wasm_result_packet_t last_result;
 static bool last_result_valid = false;
 
+/* Per-connection results - each client reads back its own executions */
+typedef struct {
+    struct bt_conn *conn;
+    wasm_result_packet_t last_result;
+    bool last_result_valid;
+} wasm_conn_ctx_t;
+
+BLE_CONN_CONTEXT_DEFINE(wasm_conn_ctx_t, wasm_ctx)
+
 /* ============================================================================
  * DEDICATED THREAD ARCHITECTURE
  * ============================================================================ */
@@ -60,7 +97,8 @@ static bool last_result_valid = false;
 typedef enum {
     WASM_MSG_LOAD_MODULE,
     WASM_MSG_EXECUTE_FUNCTION,
-    WASM_MSG_RESET
+    WASM_MSG_RESET,
+    WASM_MSG_BENCHMARK
 } wasm_msg_type_t;
 
 /* Work message structure */
@@ -68,16 +106,20 @@ typedef struct {
     wasm_msg_type_t type;
     union {
         struct {
+            struct bt_conn *conn;   /* Requester, referenced; receives the result */
             char function_name[WASM_FUNCTION_NAME_SIZE];
             uint32_t arg_count;
             int32_t args[4];
         } execute;
+        struct {
+            uint32_t iterations;
+        } benchmark;
         /* load_module and reset don't need additional data */
     } data;
 } wasm_work_msg_t;
 
 /* Message queue for WASM processing requests */
-#define WASM_MSGQ_MAX_MSGS 4
+#define WASM_MSGQ_MAX_MSGS WASM_WORK_QUEUE_DEPTH
 #define WASM_MSGQ_MSG_SIZE sizeof(wasm_work_msg_t)
 
 K_MSGQ_DEFINE(wasm_work_queue, WASM_MSGQ_MSG_SIZE, WASM_MSGQ_MAX_MSGS, 4);
@@ -86,15 +128,40 @@ K_MSGQ_DEFINE(wasm_work_queue, WASM_MSGQ_MSG_SIZE, WASM_MSGQ_MAX_MSGS, 4);
 #define WASM_THREAD_STACK_SIZE (16 * 1024)  /* 16KB stack for heavy WASM processing */
 #define WASM_THREAD_PRIORITY 5
 
+/* Call-overhead benchmark: (module (func (export "nop"))) */
+static const uint8_t benchmark_nop_module[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,     /* Magic + version */
+    0x01, 0x04, 0x01, 0x60, 0x00, 0x00,                 /* Type: () -> () */
+    0x03, 0x02, 0x01, 0x00,                             /* Function: type 0 */
+    0x07, 0x07, 0x01, 0x03, 0x6e, 0x6f, 0x70, 0x00, 0x00, /* Export "nop" */
+    0x0a, 0x04, 0x01, 0x02, 0x00, 0x0b                  /* Code: empty body */
+};
+
+#define WASM_BENCHMARK_STACK_SIZE   1024
+#define WASM_BENCHMARK_TIMEOUT_MS   5000
+
+/* Scratch runtime for the benchmark, kept apart from the uploaded module */
+static IM3Environment benchmark_env = NULL;
+static IM3Runtime benchmark_runtime = NULL;
+static IM3Function benchmark_function = NULL;
+static uint32_t benchmark_cycles_per_call = 0;
+static int benchmark_result = 0;
+static K_SEM_DEFINE(benchmark_done, 0, 1);
+
 /* ============================================================================
  * FORWARD DECLARATIONS
  * ============================================================================ */
 static void wasm_work_thread_entry(void *arg1, void *arg2, void *arg3);
 static void notify_status_change(void);
 static int load_wasm_module(void);
-static int execute_wasm_function_internal(const char *function_name, uint32_t arg_count, int32_t *args);
+static int execute_wasm_function_internal(struct bt_conn *conn, const char *function_name,
+                                          uint32_t arg_count, int32_t *args);
+static void publish_result(struct bt_conn *conn);
 static void reset_wasm_service_internal(void);
 static void reset_upload_state(void);
+static void release_upload_owner(void);
+static void free_wasm_runtime(void);
+static int run_call_benchmark(uint32_t iterations);
 
 /* ============================================================================
  * PRIVATE FUNCTIONS
@@ -108,45 +175,58 @@ static void wasm_work_thread_entry(void *arg1, void *arg2, void *arg3)
 {
     wasm_work_msg_t msg;
 
-    printk("WASM Service: Work thread started (stack: %d bytes)\n", WASM_THREAD_STACK_SIZE);
+    LOG_INF("Work thread started (stack: %d bytes)", WASM_THREAD_STACK_SIZE);
 
     while (1) {
         /* Wait for work message */
         if (k_msgq_get(&wasm_work_queue, &msg, K_FOREVER) == 0) {
-            printk("WASM Service: Processing work message type: %d\n", msg.type);
+            APP_TRACE_MSGQ_GET_DONE(&wasm_work_queue);
+            LOG_DBG("Processing work message type: %d", msg.type);
 
             switch (msg.type) {
             case WASM_MSG_LOAD_MODULE:
-                printk("WASM Service: Thread: Loading WASM module...\n");
+                LOG_INF("Thread: Loading WASM module...");
+                /* Long runs start right after a connection event */
+                conn_sched_wait_gap(K_MSEC(CONN_SCHED_FALLBACK_MS));
                 if (load_wasm_module() == 0) {
-                    printk("WASM Service: Thread: WASM module loaded successfully\n");
+                    LOG_INF("Thread: WASM module loaded successfully");
                     wasm_status = WASM_STATUS_LOADED;
                     wasm_error_code = WASM_ERROR_NONE;
                 } else {
-                    printk("WASM Service: Thread: WASM module loading failed\n");
+                    LOG_ERR("Thread: WASM module loading failed");
                     wasm_status = WASM_STATUS_ERROR;
                 }
+                wasm_load_pending = false;
                 notify_status_change();
                 break;
 
             case WASM_MSG_EXECUTE_FUNCTION:
-                printk("WASM Service: Thread: Executing function: %s\n", msg.data.execute.function_name);
-                if (execute_wasm_function_internal(msg.data.execute.function_name,
+                LOG_INF("Thread: Executing function: %s", msg.data.execute.function_name);
+                conn_sched_wait_gap(K_MSEC(CONN_SCHED_FALLBACK_MS));
+                if (execute_wasm_function_internal(msg.data.execute.conn,
+                                                   msg.data.execute.function_name,
                                                    msg.data.execute.arg_count,
                                                    msg.data.execute.args) == 0) {
-                    printk("WASM Service: Thread: Function executed successfully\n");
+                    LOG_INF("Thread: Function executed successfully");
                 } else {
-                    printk("WASM Service: Thread: Function execution failed\n");
+                    LOG_ERR("Thread: Function execution failed");
                 }
+                publish_result(msg.data.execute.conn);
+                bt_conn_unref(msg.data.execute.conn);
                 break;
 
             case WASM_MSG_RESET:
-                printk("WASM Service: Thread: Resetting WASM service...\n");
+                LOG_INF("Thread: Resetting WASM service...");
                 reset_wasm_service_internal();
                 break;
 
+            case WASM_MSG_BENCHMARK:
+                benchmark_result = run_call_benchmark(msg.data.benchmark.iterations);
+                k_sem_give(&benchmark_done);
+                break;
+
             default:
-                printk("WASM Service: Thread: Unknown message type: %d\n", msg.type);
+                LOG_WRN("Thread: Unknown message type: %d", msg.type);
                 break;
             }
         }
@@ -158,26 +238,23 @@ K_THREAD_DEFINE(wasm_work_thread, WASM_THREAD_STACK_SIZE, wasm_work_thread_entry
                 NULL, NULL, NULL, WASM_THREAD_PRIORITY, 0, 0);
 
 /**
- * @brief Send status change notification if enabled
+ * @brief Hand the last result to the connection that requested it
+ *
+ * Skipped if that client disconnected while the function was running, so
+ * a new client reusing the slot never sees it.
  */
-static void notify_status_change(void)
+static void publish_result(struct bt_conn *conn)
 {
-    if (wasm_conn && wasm_status_notify_enabled) {
-        wasm_status_packet_t status_packet = {
-            .status = wasm_status,
-            .error_code = wasm_error_code,
-            .bytes_received = wasm_bytes_received,
-            .total_size = wasm_total_expected,
-            .uptime = k_uptime_get_32(),
-            .reserved = {0}
-        };
-        
-        printk("WASM Service: Notifying status change - Status: %d, Error: %d, Bytes: %d\n",
-               wasm_status, wasm_error_code, wasm_bytes_received);
-        
-        // For now, just log the status change - we'll implement proper notifications later
-        printk("WASM Service: Status change notification would be sent here\n");
+    wasm_conn_ctx_t *ctx = wasm_ctx_get(conn);
+    
+    event_bus_publish(EVENT_WASM_RESULT);
+    
+    if (!ctx || ctx->conn != conn) {
+        return;
     }
+    
+    ctx->last_result = last_result;
+    ctx->last_result_valid = last_result_valid;
 }
 
 /**
@@ -209,20 +286,20 @@ static int ensure_wasm_runtime(void)
     /* Create WASM3 environment */
     wasm_env = m3_NewEnvironment();
     if (!wasm_env) {
-        printk("WASM Service: Failed to create WASM3 environment\n");
+        LOG_ERR("Failed to create WASM3 environment");
         wasm_error_code = WASM_ERROR_LOAD_FAILED;
         return -1;
     }
     
     /* Create WASM3 runtime with 32KB stack for larger WASM modules */
-    printk("WASM Service: Creating WASM3 runtime with stack size: %u bytes\n", 16384);
-    printk("WASM Service: Environment pointer: 0x%08x\n", (uint32_t)wasm_env);
+    LOG_INF("Creating WASM3 runtime with stack size: %u bytes", WASM3_RUNTIME_STACK_SIZE);
+    LOG_DBG("Environment pointer: 0x%08x", (uint32_t)wasm_env);
     
-    wasm_runtime = m3_NewRuntime(wasm_env, 16384, NULL);  // Reduced to 16KB for memory constraints
+    wasm_runtime = m3_NewRuntime(wasm_env, WASM3_RUNTIME_STACK_SIZE, NULL);  // Reduced to 16KB for memory constraints
     if (!wasm_runtime) {
-        printk("WASM Service: Failed to create WASM3 runtime\n");
-        printk("WASM Service: This usually means m3_Malloc failed for the stack allocation\n");
-        printk("WASM Service: Check if d_m3FixedHeap is working correctly\n");
+        LOG_ERR("Failed to create WASM3 runtime");
+        LOG_ERR("This usually means m3_Malloc failed for the stack allocation");
+        LOG_ERR("Check if d_m3FixedHeap is working correctly");
         m3_FreeEnvironment(wasm_env);
         wasm_env = NULL;
         wasm_error_code = WASM_ERROR_LOAD_FAILED;
@@ -232,7 +309,7 @@ static int ensure_wasm_runtime(void)
     /* Note: m3_LinkLibC will be called after module is loaded */
     
     wasm_runtime_initialized = true;
-    printk("WASM Service: WASM3 runtime initialized successfully\n");
+    LOG_INF("WASM3 runtime initialized successfully");
     return 0;
 }
 
@@ -242,7 +319,7 @@ static int ensure_wasm_runtime(void)
 static int load_wasm_module(void)
 {
     if (wasm_code_size == 0) {
-        printk("WASM Service: No WASM code to load\n");
+        LOG_INF("No WASM code to load");
         wasm_error_code = WASM_ERROR_INVALID_PARAMS;
         return -1;
     }
@@ -253,75 +330,86 @@ static int load_wasm_module(void)
         return ret;
     }
     
-    printk("WASM Service: Using WASM3 fixed heap (64KB)\n");
+    LOG_INF("Using WASM3 fixed heap (64KB)");
     
     /* Validate WASM magic number */
     if (!validate_wasm_magic(wasm_code_buffer, wasm_code_size)) {
-        printk("WASM Service: Invalid WASM magic number\n");
-        printk("WASM Service: First 8 bytes: %02x %02x %02x %02x %02x %02x %02x %02x\n",
-               wasm_code_buffer[0], wasm_code_buffer[1], wasm_code_buffer[2], wasm_code_buffer[3],
-               wasm_code_buffer[4], wasm_code_buffer[5], wasm_code_buffer[6], wasm_code_buffer[7]);
+        LOG_WRN("Invalid WASM magic number");
+        LOG_WRN("First 8 bytes: %02x %02x %02x %02x %02x %02x %02x %02x",
+                wasm_code_buffer[0], wasm_code_buffer[1], wasm_code_buffer[2], wasm_code_buffer[3],
+                wasm_code_buffer[4], wasm_code_buffer[5], wasm_code_buffer[6], wasm_code_buffer[7]);
         wasm_error_code = WASM_ERROR_INVALID_MAGIC;
         return -1;
     }
     
-    printk("WASM Service: WASM magic validated, size=%u bytes\n", wasm_code_size);
+    LOG_INF("WASM magic validated, size=%u bytes", wasm_code_size);
     
     /* Parse WASM module using the SAME environment as runtime */
-    printk("WASM Service: Starting WASM module parsing (size: %u bytes)\n", wasm_code_size);
-    printk("WASM Service: Available stack: %u bytes\n", CONFIG_MAIN_STACK_SIZE);
-    printk("WASM Service: WASM3 runtime stack: %u bytes\n", 16384);
+    LOG_INF("Starting WASM module parsing (size: %u bytes)", wasm_code_size);
+    LOG_DBG("Available stack: %u bytes", CONFIG_MAIN_STACK_SIZE);
+    LOG_INF("WASM3 runtime stack: %u bytes", 16384);
     
     /* Validate WASM3 environment */
     if (wasm_env == NULL) {
-        printk("WASM Service: ERROR - wasm_env is NULL!\n");
+        LOG_ERR("wasm_env is NULL!");
         return -1;
     }
-    printk("WASM Service: WASM3 environment validated: 0x%08x\n", (uint32_t)wasm_env);
+    LOG_DBG("WASM3 environment validated: 0x%08x", (uint32_t)wasm_env);
     
     /* Check stack pointer for context validation */
-    printk("WASM Service: Stack pointer: 0x%08x\n", (uint32_t)__builtin_frame_address(0));
+    LOG_DBG("Stack pointer: 0x%08x", (uint32_t)__builtin_frame_address(0));
     
+    APP_TRACE_BEGIN(APP_TRACE_WASM_PARSE, wasm_code_size, 0);
     M3Result result = m3_ParseModule(wasm_env, &wasm_module, wasm_code_buffer, wasm_code_size);
+    APP_TRACE_END(APP_TRACE_WASM_PARSE, wasm_code_size, result != m3Err_none);
     if (result != m3Err_none) {
-        printk("WASM Service: Failed to parse WASM module: %s\n", result);
+        LOG_ERR("Failed to parse WASM module: %s", result);
         wasm_error_code = WASM_ERROR_PARSE_FAILED;
         return -1;
     }
     
-    printk("WASM Service: WASM module parsed successfully\n");
+    LOG_INF("WASM module parsed successfully");
     
     /* Load module into runtime */
+    APP_TRACE_BEGIN(APP_TRACE_WASM_LOAD, wasm_code_size, 0);
     result = m3_LoadModule(wasm_runtime, wasm_module);
+    APP_TRACE_END(APP_TRACE_WASM_LOAD, wasm_code_size, result != m3Err_none);
     if (result != m3Err_none) {
-        printk("WASM Service: Failed to load WASM module: %s\n", result);
+        LOG_ERR("Failed to load WASM module: %s", result);
         wasm_error_code = WASM_ERROR_LOAD_FAILED;
+        /* Not in the runtime, so nothing refers to the code any more */
+        m3_FreeModule(wasm_module);
+        wasm_module = NULL;
         return -1;
     }
+    wasm_module_loaded = true;
     
-    printk("WASM Service: WASM module loaded successfully\n");
+    LOG_INF("WASM module loaded successfully");
     
     /* Compile module */
+    APP_TRACE_BEGIN(APP_TRACE_WASM_COMPILE, wasm_code_size, 0);
     result = m3_CompileModule(wasm_module);
+    APP_TRACE_END(APP_TRACE_WASM_COMPILE, wasm_code_size, result != m3Err_none);
     if (result != m3Err_none) {
-        printk("WASM Service: Failed to compile WASM module: %s\n", result);
+        LOG_ERR("Failed to compile WASM module: %s", result);
         wasm_error_code = WASM_ERROR_COMPILE_FAILED;
         return -1;
     }
     
-    printk("WASM Service: WASM module compiled successfully\n");
+    LOG_INF("WASM module compiled successfully");
     return 0;
 }
 
 /**
  * @brief Internal function to execute WASM function (called by thread)
  */
-static int execute_wasm_function_internal(const char *function_name, uint32_t arg_count, int32_t *args)
+static int execute_wasm_function_internal(struct bt_conn *conn, const char *function_name,
+                                          uint32_t arg_count, int32_t *args)
 {
-    printk("WASM Service: Thread executing function: %s with %u args\n", function_name, arg_count);
+    LOG_INF("Thread executing function: %s with %u args", function_name, arg_count);
     
     /* Record start time */
-    uint32_t start_time = k_uptime_get_32();
+    uint64_t start_time = time_sync_now_us();
     
     /* Execute function using direct WASM3 calls */
     int32_t result_value = 0;
@@ -331,7 +419,7 @@ static int execute_wasm_function_internal(const char *function_name, uint32_t ar
     IM3Function function;
     M3Result find_result = m3_FindFunction(&function, wasm_runtime, function_name);
     if (find_result != m3Err_none) {
-        printk("WASM Service: Function '%s' not found: %s\n", function_name, find_result);
+        LOG_WRN("Function '%s' not found: %s", function_name, find_result);
         last_result.status = WASM_STATUS_ERROR;
         last_result.error_code = WASM_ERROR_FUNCTION_NOT_FOUND;
         last_result_valid = true;
@@ -344,15 +432,13 @@ static int execute_wasm_function_internal(const char *function_name, uint32_t ar
     
     if (arg_count == 0) {
         /* No arguments - use CallV */
-        printk("WASM Service: Calling function with no arguments\n");
+        LOG_DBG("Calling function with no arguments");
+        APP_TRACE_BEGIN(APP_TRACE_WASM_CALL, arg_count, 0);
         call_result = m3_CallV(function);
     } else if (arg_count <= 4) {
         /* Function with arguments - use Call with argument pointers */
-        printk("WASM Service: Calling function with %u arguments: ", arg_count);
-        for (uint32_t i = 0; i < arg_count; i++) {
-            printk("%d ", args[i]);
-        }
-        printk("\n");
+        LOG_DBG("Calling function with %u arguments", arg_count);
+        LOG_HEXDUMP_DBG(args, arg_count * sizeof(args[0]), "Arguments");
         
         /* Prepare argument pointers for WASM3 */
         const void* argptrs[4];
@@ -360,15 +446,17 @@ static int execute_wasm_function_internal(const char *function_name, uint32_t ar
             argptrs[i] = &args[i];
         }
         
+        APP_TRACE_BEGIN(APP_TRACE_WASM_CALL, arg_count, 0);
         call_result = m3_Call(function, arg_count, argptrs);
     } else {
-        printk("WASM Service: Too many arguments (%u > 4)\n", arg_count);
+        LOG_WRN("Too many arguments (%u > 4)", arg_count);
         last_result.status = WASM_STATUS_ERROR;
         last_result.error_code = WASM_ERROR_INVALID_PARAMS;
         last_result_valid = true;
         wasm_status = WASM_STATUS_LOADED;
         return -1;
     }
+    APP_TRACE_END(APP_TRACE_WASM_CALL, arg_count, call_result != m3Err_none);
     
     if (call_result == m3Err_none) {
         /* Get return value if function returns something */
@@ -379,31 +467,32 @@ static int execute_wasm_function_internal(const char *function_name, uint32_t ar
             call_result = m3_GetResults(function, 1, retptrs);
             if (call_result == m3Err_none) {
                 result_value = ret_val;
-                printk("WASM Service: Function returned: %d\n", result_value);
+                LOG_INF("Function returned: %d", result_value);
             } else {
-                printk("WASM Service: Failed to get return value: %s\n", call_result);
+                LOG_ERR("Failed to get return value: %s", call_result);
             }
         }
         ret = 0; /* Success */
     } else {
-        printk("WASM Service: Function call failed: %s\n", call_result);
+        LOG_ERR("Function call failed: %s", call_result);
     }
     
     /* Calculate execution time */
-    uint32_t end_time = k_uptime_get_32();
-    uint32_t execution_time_us = (end_time - start_time) * 1000; /* Convert to microseconds */
+    uint64_t end_time = time_sync_now_us();
+    uint32_t execution_time_us = (uint32_t)(end_time - start_time);
     
     /* Fill result packet */
     last_result.return_value = result_value;
     last_result.execution_time_us = execution_time_us;
+    last_result.timestamp_us = time_sync_to_client_us(conn, end_time);
     
     if (ret == 0) {
-        printk("WASM Service: Function executed successfully, result: %d\n", result_value);
+        LOG_INF("Function executed successfully, result: %d", result_value);
         last_result.status = WASM_STATUS_COMPLETE;
         last_result.error_code = WASM_ERROR_NONE;
         wasm_status = WASM_STATUS_LOADED; /* Ready for next execution */
     } else {
-        printk("WASM Service: Function execution failed\n");
+        LOG_ERR("Function execution failed");
         last_result.status = WASM_STATUS_ERROR;
         wasm_error_code = WASM_ERROR_EXECUTION_FAILED;
         wasm_status = WASM_STATUS_LOADED; /* Still loaded, just execution failed */
@@ -414,37 +503,84 @@ static int execute_wasm_function_internal(const char *function_name, uint32_t ar
 }
 
 /**
- * @brief Internal function to reset WASM service (called by thread)
+ * @brief Time calls to the empty "nop" export (called by thread)
  */
-static void reset_wasm_service_internal(void)
+static int run_call_benchmark(uint32_t iterations)
 {
-    printk("WASM Service: Thread resetting service...\n");
+    M3Result result;
     
-    /* Reset upload state */
-    reset_upload_state();
-    
-    /* Reset WASM3 runtime */
-    if (wasm_module) {
-        m3_FreeModule(wasm_module);
-        wasm_module = NULL;
+    if (!benchmark_function) {
+        IM3Module module;
+        
+        benchmark_env = m3_NewEnvironment();
+        if (!benchmark_env) {
+            LOG_ERR("Benchmark environment allocation failed");
+            return -ENOMEM;
+        }
+        
+        benchmark_runtime = m3_NewRuntime(benchmark_env, WASM_BENCHMARK_STACK_SIZE, NULL);
+        if (!benchmark_runtime) {
+            LOG_ERR("Benchmark runtime allocation failed");
+            m3_FreeEnvironment(benchmark_env);
+            benchmark_env = NULL;
+            return -ENOMEM;
+        }
+        
+        result = m3_ParseModule(benchmark_env, &module, benchmark_nop_module,
+                                sizeof(benchmark_nop_module));
+        if (result == m3Err_none) {
+            result = m3_LoadModule(benchmark_runtime, module);
+        }
+        if (result == m3Err_none) {
+            result = m3_FindFunction(&benchmark_function, benchmark_runtime, "nop");
+        }
+        if (result != m3Err_none) {
+            LOG_ERR("Benchmark module setup failed: %s", result);
+            benchmark_function = NULL;
+            m3_FreeRuntime(benchmark_runtime);
+            benchmark_runtime = NULL;
+            m3_FreeEnvironment(benchmark_env);
+            benchmark_env = NULL;
+            return -EIO;
+        }
     }
     
-    if (wasm_runtime) {
-        m3_FreeRuntime(wasm_runtime);
-        wasm_runtime = NULL;
+    /* First call compiles the function lazily - keep it out of the measurement */
+    result = m3_CallV(benchmark_function);
+    if (result != m3Err_none) {
+        LOG_ERR("Benchmark call failed: %s", result);
+        return -EIO;
     }
     
-    if (wasm_env) {
-        m3_FreeEnvironment(wasm_env);
-        wasm_env = NULL;
+    timing_t start = timing_counter_get();
+    for (uint32_t i = 0; i < iterations; i++) {
+        m3_CallV(benchmark_function);
     }
+    timing_t end = timing_counter_get();
+    
+    benchmark_cycles_per_call = (uint32_t)(timing_cycles_get(&start, &end) / iterations);
+    return 0;
+}
+
+/**
+ * @brief Internal function to reset WASM service (called by thread)
+ */
+static void reset_wasm_service_internal(void)
+{
+    LOG_INF("Thread resetting service...");
+    
+    /* Tear down WASM3 first - the module refers into the code buffer */
+    free_wasm_runtime();
+    
+    /* Reset upload state */
+    reset_upload_state();
     
-    wasm_runtime_initialized = false;
     wasm_status = WASM_STATUS_IDLE;
     wasm_error_code = WASM_ERROR_NONE;
     last_result_valid = false;
+    notify_status_change();
     
-    printk("WASM Service: Service reset complete\n");
+    LOG_INF("Service reset complete");
 }
 
 /**
@@ -452,7 +588,7 @@ static void reset_wasm_service_internal(void)
  */
 static void reset_wasm_service(void)
 {
-    printk("WASM Service: BLE handler requesting service reset\n");
+    LOG_INF("BLE handler requesting service reset");
     
     /* Queue reset to dedicated thread */
     wasm_work_msg_t reset_msg = {
@@ -460,9 +596,64 @@ static void reset_wasm_service(void)
     };
     
     if (k_msgq_put(&wasm_work_queue, &reset_msg, K_NO_WAIT) == 0) {
-        printk("WASM Service: Reset request queued to work thread\n");
+        APP_TRACE_MSGQ_PUT_DONE(&wasm_work_queue);
+        LOG_INF("Reset request queued to work thread");
     } else {
-        printk("WASM Service: ERROR - Failed to queue reset request\n");
+        LOG_ERR("Failed to queue reset request");
+    }
+}
+
+/**
+ * @brief Free the WASM3 module, runtime and environment
+ *
+ * A module loaded into the runtime is freed along with it.
+ */
+static void free_wasm_runtime(void)
+{
+    if (wasm_module && !wasm_module_loaded) {
+        m3_FreeModule(wasm_module);
+    }
+    wasm_module = NULL;
+    wasm_module_loaded = false;
+    
+    if (wasm_runtime) {
+        m3_FreeRuntime(wasm_runtime);
+        wasm_runtime = NULL;
+    }
+    
+    if (wasm_env) {
+        m3_FreeEnvironment(wasm_env);
+        wasm_env = NULL;
+    }
+    
+    wasm_runtime_initialized = false;
+}
+
+/**
+ * @brief Return the code buffer, or leave it to the last relay reader
+ */
+static void release_code_buffer(void)
+{
+    k_mutex_lock(&code_lock, K_FOREVER);
+    if (code_readers > 0 && wasm_code_buffer) {
+        retired_code = wasm_code_buffer;
+        retired_capacity = wasm_code_capacity;
+    } else {
+        mem_budget_free(MEM_BUDGET_WASM, wasm_code_buffer, wasm_code_capacity);
+    }
+    wasm_code_buffer = NULL;
+    wasm_code_capacity = 0;
+    k_mutex_unlock(&code_lock);
+}
+
+/**
+ * @brief Drop upload ownership and leave the bulk link profile
+ */
+static void release_upload_owner(void)
+{
+    if (upload_owner) {
+        link_profile_bulk_end(upload_owner);
+        upload_owner = NULL;
     }
 }
 
@@ -472,14 +663,20 @@ static void reset_wasm_service(void)
 static void reset_upload_state(void)
 {
     wasm_code_size = 0;
+    wasm_code_crc32 = 0;
     wasm_bytes_received = 0;
     wasm_total_expected = 0;
     wasm_upload_sequence = 0;
     wasm_status = WASM_STATUS_IDLE;
     wasm_error_code = WASM_ERROR_NONE;
+    release_upload_owner();
     last_result_valid = false;
-    memset(wasm_code_buffer, 0, sizeof(wasm_code_buffer));
+    release_code_buffer();
     memset(&last_result, 0, sizeof(last_result));
+    for (int i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+        wasm_ctx[i].last_result_valid = false;
+        memset(&wasm_ctx[i].last_result, 0, sizeof(wasm_ctx[i].last_result));
+    }
 }
 
 /* ============================================================================
@@ -489,34 +686,65 @@ static void reset_upload_state(void)
 /**
  * @brief Handle WASM upload packets with variable length support
  */
-static ssize_t wasm_upload_handler(const void *data, uint16_t len)
+static ssize_t wasm_upload_handler(wasm_conn_ctx_t *ctx, const void *data, uint16_t len)
 {
-    printk("\n=== WASM Service: wasm_upload_handler called ===\n");
-    printk("WASM Service: Upload packet received (%d bytes)\n", len);
+    LOG_DBG("wasm_upload_handler called");
+    LOG_DBG("Upload packet received (%d bytes)", len);
     
     if (len < 8) {  // Minimum packet size: cmd(1) + seq(1) + chunk_size(2) + total_size(4)
-        printk("WASM Service: Upload packet too small (%d < 8)\n", len);
+        LOG_WRN("Upload packet too small (%d < 8)", len);
         return -1;
     }
     
     const wasm_upload_packet_t *packet = (const wasm_upload_packet_t *)data;
     
-    printk("WASM Service: Upload packet received (cmd: 0x%02x, seq: %d, size: %d)\n",
-           packet->cmd, packet->sequence, packet->chunk_size);
+    LOG_DBG("Upload packet received (cmd: 0x%02x, seq: %d, size: %d)",
+            packet->cmd, packet->sequence, packet->chunk_size);
+    
+    /* One code buffer: a second client must wait for the running upload */
+    if (upload_owner && upload_owner != ctx->conn) {
+        LOG_WRN("Upload in progress on another connection");
+        return BT_GATT_ERR(BT_ATT_ERR_WRITE_NOT_PERMITTED);
+    }
     
     switch (packet->cmd) {
     case WASM_CMD_START_UPLOAD:
-        printk("WASM Service: Starting new upload (total: %u bytes)\n", packet->total_size);
+        LOG_INF("Starting new upload (total: %u bytes)", packet->total_size);
         
         if (packet->total_size > WASM_CODE_BUFFER_SIZE) {
-            printk("WASM Service: Upload too large (%u > %u)\n", 
-                   packet->total_size, WASM_CODE_BUFFER_SIZE);
+            LOG_WRN("Upload too large (%u > %u)", 
+                    packet->total_size, WASM_CODE_BUFFER_SIZE);
             wasm_error_code = WASM_ERROR_BUFFER_OVERFLOW;
             wasm_status = WASM_STATUS_ERROR;
+            notify_status_change();
+            return -1;
+        }
+        
+        if (packet->total_size == 0) {
+            LOG_WRN("Empty upload");
+            wasm_error_code = WASM_ERROR_INVALID_PARAMS;
             return -1;
         }
         
+        /* wasm3 or a relay still reads the previous module until a reset */
+        if (wasm_load_pending || wasm_module_loaded || code_readers > 0) {
+            LOG_WRN("Previous module still in use, reset first");
+            return BT_GATT_ERR(BT_ATT_ERR_PROCEDURE_IN_PROGRESS);
+        }
+        
         reset_upload_state();
+        
+        if (mem_budget_alloc(MEM_BUDGET_WASM, packet->total_size, (void **)&wasm_code_buffer) != 0) {
+            LOG_WRN("No memory for a %u byte module", packet->total_size);
+            wasm_error_code = WASM_ERROR_NO_MEMORY;
+            wasm_status = WASM_STATUS_ERROR;
+            notify_status_change();
+            return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+        }
+        wasm_code_capacity = packet->total_size;
+        
+        upload_owner = ctx->conn;
+        link_profile_bulk_begin(upload_owner);
         wasm_total_expected = packet->total_size;
         wasm_status = WASM_STATUS_RECEIVING;
         wasm_upload_sequence = 0;
@@ -529,26 +757,27 @@ static ssize_t wasm_upload_handler(const void *data, uint16_t len)
         
     case WASM_CMD_CONTINUE_UPLOAD:
         if (wasm_status != WASM_STATUS_RECEIVING) {
-            printk("WASM Service: Not in receiving state\n");
+            LOG_WRN("Not in receiving state");
             wasm_error_code = WASM_ERROR_INVALID_PARAMS;
             return -1;
         }
         
         /* Verify sequence number */
         if (packet->sequence != wasm_upload_sequence) {
-            printk("WASM Service: Sequence mismatch (expected %d, got %d)\n",
-                   wasm_upload_sequence, packet->sequence);
+            LOG_WRN("Sequence mismatch (expected %d, got %d)",
+                    wasm_upload_sequence, packet->sequence);
             wasm_error_code = WASM_ERROR_INVALID_PARAMS;
             wasm_status = WASM_STATUS_ERROR;
+            notify_status_change();
             return -1;
         }
         
-        /* Check buffer overflow */
-        if (wasm_bytes_received + packet->chunk_size > WASM_CODE_BUFFER_SIZE ||
-            wasm_bytes_received + packet->chunk_size > wasm_total_expected) {
-            printk("WASM Service: Buffer overflow during upload\n");
+        /* Check buffer overflow - the buffer holds exactly the announced size */
+        if (wasm_bytes_received + packet->chunk_size > wasm_code_capacity) {
+            LOG_WRN("Buffer overflow during upload");
             wasm_error_code = WASM_ERROR_BUFFER_OVERFLOW;
             wasm_status = WASM_STATUS_ERROR;
+            notify_status_change();
             return -1;
         }
         
@@ -557,34 +786,35 @@ static ssize_t wasm_upload_handler(const void *data, uint16_t len)
         wasm_bytes_received += packet->chunk_size;
         wasm_upload_sequence++;
         
-        printk("WASM Service: Received chunk %d (%u / %u bytes)\n",
-               packet->sequence, wasm_bytes_received, wasm_total_expected);
+        LOG_DBG("Received chunk %d (%u / %u bytes)",
+                packet->sequence, wasm_bytes_received, wasm_total_expected);
         
         /* Check if upload is complete */
         if (wasm_bytes_received >= wasm_total_expected) {
             wasm_code_size = wasm_bytes_received;
+            wasm_code_crc32 = crc32_ieee(wasm_code_buffer, wasm_code_size);
             wasm_status = WASM_STATUS_RECEIVED;
-            printk("WASM Service: Upload complete (%u bytes), queuing module load...\n", wasm_code_size);
+            release_upload_owner();
+            LOG_INF("Upload complete (%u bytes), queuing module load...", wasm_code_size);
             
             /* Notify status change */
             notify_status_change();
             
             /* Debug: Print first few bytes of received WASM */
-            printk("WASM Service: First 16 bytes received:");
-            for (int i = 0; i < 16 && i < wasm_code_size; i++) {
-                printk(" %02x", wasm_code_buffer[i]);
-            }
-            printk("\n");
+            LOG_HEXDUMP_DBG(wasm_code_buffer, MIN(wasm_code_size, 16), "First 16 bytes received");
             
             /* Queue module loading to dedicated thread instead of doing it here */
             wasm_work_msg_t load_msg = {
                 .type = WASM_MSG_LOAD_MODULE
             };
             
+            wasm_load_pending = true;
             if (k_msgq_put(&wasm_work_queue, &load_msg, K_NO_WAIT) == 0) {
-                printk("WASM Service: Module load queued to work thread\n");
+                APP_TRACE_MSGQ_PUT_DONE(&wasm_work_queue);
+                LOG_INF("Module load queued to work thread");
             } else {
-                printk("WASM Service: ERROR - Failed to queue module load\n");
+                LOG_ERR("Failed to queue module load");
+                wasm_load_pending = false;
                 wasm_status = WASM_STATUS_ERROR;
                 wasm_error_code = WASM_ERROR_LOAD_FAILED;
                 notify_status_change();
@@ -595,22 +825,25 @@ static ssize_t wasm_upload_handler(const void *data, uint16_t len)
     case WASM_CMD_END_UPLOAD:
         if (wasm_status == WASM_STATUS_RECEIVING) {
             wasm_code_size = wasm_bytes_received;
+            wasm_code_crc32 = crc32_ieee(wasm_code_buffer, wasm_code_size);
             wasm_status = WASM_STATUS_RECEIVED;
-            printk("WASM Service: Upload ended by client, loading module...\n");
+            release_upload_owner();
+            LOG_INF("Upload ended by client, loading module...");
             
             if (load_wasm_module() == 0) {
-                printk("WASM Service: WASM module ready for execution\n");
+                LOG_INF("WASM module ready for execution");
             }
+            notify_status_change();
         }
         break;
         
     case WASM_CMD_RESET:
-        printk("WASM Service: Reset command received\n");
+        LOG_INF("Reset command received");
         reset_wasm_service();
         return sizeof(*packet);
         
     default:
-        printk("WASM Service: Unknown upload command: 0x%02x\n", packet->cmd);
+        LOG_WRN("Unknown upload command: 0x%02x", packet->cmd);
         wasm_error_code = WASM_ERROR_INVALID_PARAMS;
         return -1;
     }
@@ -621,39 +854,40 @@ static ssize_t wasm_upload_handler(const void *data, uint16_t len)
 /**
  * @brief Handle WASM execution requests
  */
-static ssize_t wasm_execute_handler(const wasm_execute_packet_t *packet)
+static ssize_t wasm_execute_handler(wasm_conn_ctx_t *ctx, const wasm_execute_packet_t *packet)
 {
-    printk("\n=== WASM Service: wasm_execute_handler called ===\n");
+    LOG_DBG("wasm_execute_handler called");
     
-    printk("WASM Service: Execute request for function '%s' with %u args\n",
-           packet->function_name, packet->arg_count);
+    LOG_DBG("Execute request for function '%s' with %u args",
+            packet->function_name, packet->arg_count);
     
-    /* Clear previous result */
-    memset(&last_result, 0, sizeof(last_result));
-    last_result_valid = false;
+    /* Clear this client's previous result */
+    memset(&ctx->last_result, 0, sizeof(ctx->last_result));
+    ctx->last_result_valid = false;
     
     /* Check if WASM is ready */
     if (wasm_status != WASM_STATUS_LOADED) {
-        printk("WASM Service: WASM not loaded (status: %d)\n", wasm_status);
-        last_result.status = WASM_STATUS_ERROR;
-        last_result.error_code = WASM_ERROR_LOAD_FAILED;
-        last_result_valid = true;
+        LOG_WRN("WASM not loaded (status: %d)", wasm_status);
+        ctx->last_result.status = WASM_STATUS_ERROR;
+        ctx->last_result.error_code = WASM_ERROR_LOAD_FAILED;
+        ctx->last_result_valid = true;
         return sizeof(*packet);
     }
     
     /* Validate function name */
     if (strnlen(packet->function_name, WASM_FUNCTION_NAME_SIZE) >= WASM_FUNCTION_NAME_SIZE) {
-        printk("WASM Service: Function name too long\n");
-        last_result.status = WASM_STATUS_ERROR;
-        last_result.error_code = WASM_ERROR_INVALID_PARAMS;
-        last_result_valid = true;
+        LOG_WRN("Function name too long");
+        ctx->last_result.status = WASM_STATUS_ERROR;
+        ctx->last_result.error_code = WASM_ERROR_INVALID_PARAMS;
+        ctx->last_result_valid = true;
         return sizeof(*packet);
     }
     
     /* Queue function execution to dedicated thread instead of doing it here */
     
     wasm_work_msg_t exec_msg = {
-        .type = WASM_MSG_EXECUTE_FUNCTION
+        .type = WASM_MSG_EXECUTE_FUNCTION,
+        .data.execute.conn = bt_conn_ref(ctx->conn)     /* Released after publish_result() */
     };
     
     /* Copy function name and arguments */
@@ -665,15 +899,19 @@ static ssize_t wasm_execute_handler(const wasm_execute_packet_t *packet)
     }
     
     if (k_msgq_put(&wasm_work_queue, &exec_msg, K_NO_WAIT) == 0) {
-        printk("WASM Service: Function execution queued to work thread\n");
+        APP_TRACE_MSGQ_PUT_DONE(&wasm_work_queue);
+        LOG_INF("Function execution queued to work thread");
         wasm_status = WASM_STATUS_EXECUTING;
+        notify_status_change();
     } else {
-        printk("WASM Service: ERROR - Failed to queue function execution\n");
+        LOG_ERR("Failed to queue function execution");
+        bt_conn_unref(exec_msg.data.execute.conn);
         wasm_status = WASM_STATUS_ERROR;
         wasm_error_code = WASM_ERROR_EXECUTION_FAILED;
-        last_result.status = WASM_STATUS_ERROR;
-        last_result.error_code = WASM_ERROR_EXECUTION_FAILED;
-        last_result_valid = true;
+        notify_status_change();
+        ctx->last_result.status = WASM_STATUS_ERROR;
+        ctx->last_result.error_code = WASM_ERROR_EXECUTION_FAILED;
+        ctx->last_result_valid = true;
     }
     
     return sizeof(*packet);
@@ -684,15 +922,16 @@ static ssize_t wasm_execute_handler(const wasm_execute_packet_t *packet)
  */
 static ssize_t wasm_status_handler(wasm_status_packet_t *response)
 {
-    printk("\n=== WASM Service: wasm_status_handler called ===\n");
-    printk("WASM Service: Status read (status: %d, received: %u/%u bytes)\n",
-           wasm_status, wasm_bytes_received, wasm_total_expected);
+    LOG_DBG("wasm_status_handler called");
+    LOG_DBG("Status read (status: %d, received: %u/%u bytes)",
+            wasm_status, wasm_bytes_received, wasm_total_expected);
     
     response->status = wasm_status;
     response->error_code = wasm_error_code;
     response->bytes_received = wasm_bytes_received;
     response->total_size = wasm_total_expected;
     response->uptime = k_uptime_get() / 1000;
+    response->module_crc32 = wasm_code_crc32;
     memset(response->reserved, 0, sizeof(response->reserved));
     
     return sizeof(*response);
@@ -701,15 +940,15 @@ static ssize_t wasm_status_handler(wasm_status_packet_t *response)
 /**
  * @brief Handle WASM result read requests
  */
-static ssize_t wasm_result_handler(wasm_result_packet_t *response)
+static ssize_t wasm_result_handler(wasm_conn_ctx_t *ctx, wasm_result_packet_t *response)
 {
-    printk("\n=== WASM Service: wasm_result_handler called ===\n");
-    printk("WASM Service: Result read request\n");
+    LOG_DBG("wasm_result_handler called");
+    LOG_DBG("Result read request");
     
-    if (last_result_valid) {
-        *response = last_result;
-        printk("WASM Service: Returning result (status: %d, value: %d)\n",
-               response->status, response->return_value);
+    if (ctx->last_result_valid) {
+        *response = ctx->last_result;
+        LOG_DBG("Returning result (status: %d, value: %d)",
+                response->status, response->return_value);
     } else {
         memset(response, 0, sizeof(*response));
         response->status = WASM_STATUS_IDLE;
@@ -726,15 +965,15 @@ static ssize_t wasm_result_handler(wasm_result_packet_t *response)
 static void wasm_status_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
 {
     wasm_status_notify_enabled = (value == BT_GATT_CCC_NOTIFY);
-    printk("WASM Service: Status notifications %s\n", 
-           wasm_status_notify_enabled ? "enabled" : "disabled");
+    LOG_INF("Status notifications %s", 
+            wasm_status_notify_enabled ? "enabled" : "disabled");
 }
 
 static void wasm_result_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
 {
     wasm_result_notify_enabled = (value == BT_GATT_CCC_NOTIFY);
-    printk("WASM Service: Result notifications %s\n", 
-           wasm_result_notify_enabled ? "enabled" : "disabled");
+    LOG_INF("Result notifications %s", 
+            wasm_result_notify_enabled ? "enabled" : "disabled");
 }
 
 /* ============================================================================
@@ -742,10 +981,12 @@ static void wasm_result_ccc_changed(const struct bt_gatt_attr *attr, uint16_t va
  * ============================================================================ */
 
 /* Generate BLE wrappers automatically */
-BLE_WRITE_WRAPPER_VARIABLE(wasm_upload_handler, 8, 252)  /* Variable length WASM upload packets - limited by BLE MTU */
-BLE_WRITE_WRAPPER(wasm_execute_handler, wasm_execute_packet_t)
+BLE_WRITE_WRAPPER_VARIABLE_CTX(wasm_upload_handler, 8, sizeof(wasm_upload_packet_t),
+                               wasm_upload_packet_validate, wasm_ctx_get)  /* Variable length WASM upload packets - limited by BLE MTU */
+BLE_WRITE_WRAPPER_COMPACT_CTX(wasm_execute_handler, wasm_execute_packet_t,
+                              wasm_execute_packet_decode, wasm_ctx_get)
 BLE_READ_WRAPPER(wasm_status_handler, wasm_status_packet_t)
-BLE_READ_WRAPPER(wasm_result_handler, wasm_result_packet_t)
+BLE_READ_WRAPPER_CTX(wasm_result_handler, wasm_result_packet_t, wasm_ctx_get)
 
 /* ============================================================================
  * SERVICE DEFINITION
@@ -781,44 +1022,102 @@ BT_GATT_SERVICE_DEFINE(wasm_service,
     BT_GATT_CCC(wasm_result_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
 );
 
+/**
+ * @brief Publish a status change and notify subscribed clients
+ *
+ * Called on state transitions only, never per upload chunk.
+ */
+static void notify_status_change(void)
+{
+    event_bus_publish(EVENT_WASM_STATUS);
+    
+    if (!wasm_status_notify_enabled) {
+        return;
+    }
+    
+    wasm_status_packet_t status_packet;
+    const struct bt_gatt_attr *attr = bt_gatt_find_by_uuid(wasm_service.attrs,
+                                                           wasm_service.attr_count,
+                                                           WASM_STATUS_UUID);
+    if (!attr) {
+        return;
+    }
+    
+    wasm_status_handler(&status_packet);
+    LOG_DBG("Notifying status change - Status: %d, Error: %d, Bytes: %d",
+            wasm_status, wasm_error_code, wasm_bytes_received);
+    
+    /* NULL sends to every subscribed connection */
+    int err = bt_gatt_notify(NULL, attr, &status_packet, sizeof(status_packet));
+    if (err && err != -ENOTCONN) {
+        LOG_ERR("Status notification failed (err %d)", err);
+    }
+}
+
+static void wasm_service_print_stats(void)
+{
+    uint32_t heap_size, heap_used;
+    
+    wasm_service_get_memory_usage(&heap_size, &heap_used);
+    LOG_INF("  status %d, error %d, module %u bytes, heap %u / %u bytes",
+            wasm_status, wasm_error_code, wasm_code_size, heap_used, heap_size);
+}
+
+BLE_SERVICE_DEFINE(wasm, 60,
+    .name = "WASM Service",
+    .uuid = 0xFFF7,
+    .init = wasm_service_init,
+    .connection = wasm_service_connection_event,
+    .stats = wasm_service_print_stats);
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
 
 int wasm_service_init(void)
 {
+    memset(wasm_ctx, 0, sizeof(wasm_ctx));
     reset_upload_state();
-    wasm_conn = NULL;
     
     /* Don't initialize WASM3 runtime yet - do it on first use */
     wasm_runtime_initialized = false;
     
-    printk("WASM Service: Initialized\n");
-    printk("  Upload characteristic: WRITE\n");
-    printk("  Execute characteristic: WRITE\n");
-    printk("  Status characteristic: READ + NOTIFY\n");
-    printk("  Result characteristic: READ + NOTIFY\n");
-    printk("  Code buffer size: %d bytes\n", WASM_CODE_BUFFER_SIZE);
-    printk("  Upload chunk size: %d bytes\n", WASM_UPLOAD_CHUNK_SIZE);
-    printk("  WASM3 runtime stack: 16KB\n");
-    printk("  WASM3 fixed heap: 64KB\n");
-    printk("  Status notifications: enabled\n");
-    printk("  Result notifications: enabled\n");
+    LOG_INF("Initialized");
+    LOG_INF("  Upload characteristic: WRITE");
+    LOG_INF("  Execute characteristic: WRITE");
+    LOG_INF("  Status characteristic: READ + NOTIFY");
+    LOG_INF("  Result characteristic: READ + NOTIFY");
+    LOG_INF("  Module size limit: %d bytes (memory budget, %d byte quota)",
+            WASM_CODE_BUFFER_SIZE, CONFIG_MEM_BUDGET_WASM_QUOTA);
+    LOG_INF("  Upload chunk size: %d bytes", WASM_UPLOAD_CHUNK_SIZE);
+    LOG_INF("  WASM3 runtime stack: 16KB");
+    LOG_INF("  WASM3 fixed heap: 64KB");
+    LOG_INF("  Status notifications: enabled");
+    LOG_INF("  Result notifications: enabled");
     
     return 0;
 }
 
 void wasm_service_connection_event(struct bt_conn *conn, bool connected)
 {
+    wasm_conn_ctx_t *ctx = wasm_ctx_get(conn);
+    
+    if (!ctx) {
+        return;
+    }
+    
+    memset(ctx, 0, sizeof(*ctx));
+    
     if (connected) {
-        printk("WASM Service: Client connected\n");
-        wasm_conn = conn;
+        LOG_INF("Client connected");
+        ctx->conn = conn;
     } else {
-        printk("WASM Service: Client disconnected\n");
-        if (conn == wasm_conn) {
-            wasm_conn = NULL;
-            /* Optionally reset state on disconnect */
-            /* reset_upload_state(); */
+        LOG_INF("Client disconnected");
+        if (conn == upload_owner) {
+            /* Half-finished upload can never complete: release the buffer */
+            LOG_WRN("Abandoning upload from disconnected client");
+            upload_owner = NULL;    /* Link is gone, no profile to restore */
+            reset_upload_state();
         }
     }
 }
@@ -845,26 +1144,15 @@ bool wasm_service_is_ready(void)
 
 void wasm_service_reset(void)
 {
-    printk("WASM Service: Resetting state\n");
-    reset_upload_state();
+    LOG_INF("Resetting state");
     
     if (wasm_runtime_initialized) {
-        /* Clean up WASM3 structures */
-        if (wasm_module) {
-            m3_FreeModule(wasm_module);
-            wasm_module = NULL;
-        }
-        if (wasm_runtime) {
-            m3_FreeRuntime(wasm_runtime);
-            wasm_runtime = NULL;
-        }
-        if (wasm_env) {
-            m3_FreeEnvironment(wasm_env);
-            wasm_env = NULL;
-        }
-        wasm_runtime_initialized = false;
-        printk("WASM Service: Runtime cleaned up\n");
+        /* Clean up WASM3 structures before the code they refer into */
+        free_wasm_runtime();
+        LOG_INF("Runtime cleaned up");
     }
+    
+    reset_upload_state();
 }
 
 int wasm_service_execute_function(const char *function_name, 
@@ -876,13 +1164,13 @@ int wasm_service_execute_function(const char *function_name,
         return -EINVAL;
     }
     
-    printk("WASM Service: Direct execution of '%s'\n", function_name);
+    LOG_INF("Direct execution of '%s'", function_name);
     
     /* Find function by name */
     IM3Function function;
     M3Result find_result = m3_FindFunction(&function, wasm_runtime, function_name);
     if (find_result != m3Err_none) {
-        printk("WASM Service: Function '%s' not found: %s\n", function_name, find_result);
+        LOG_WRN("Function '%s' not found: %s", function_name, find_result);
         return -ENOENT;
     }
     
@@ -890,6 +1178,7 @@ int wasm_service_execute_function(const char *function_name,
     M3Result call_result;
     
     if (arg_count == 0) {
+        APP_TRACE_BEGIN(APP_TRACE_WASM_CALL, arg_count, 0);
         call_result = m3_CallV(function);
     } else if (arg_count <= 4) {
         /* Prepare argument pointers */
@@ -897,14 +1186,16 @@ int wasm_service_execute_function(const char *function_name,
         for (uint32_t i = 0; i < arg_count; i++) {
             argptrs[i] = &args[i];
         }
+        APP_TRACE_BEGIN(APP_TRACE_WASM_CALL, arg_count, 0);
         call_result = m3_Call(function, arg_count, argptrs);
     } else {
-        printk("WASM Service: Too many arguments (%u > 4)\n", arg_count);
+        LOG_WRN("Too many arguments (%u > 4)", arg_count);
         return -EINVAL;
     }
+    APP_TRACE_END(APP_TRACE_WASM_CALL, arg_count, call_result != m3Err_none);
     
     if (call_result != m3Err_none) {
-        printk("WASM Service: Direct execution failed: %s\n", call_result);
+        LOG_ERR("Direct execution failed: %s", call_result);
         return -EIO;
     }
     
@@ -917,7 +1208,7 @@ int wasm_service_execute_function(const char *function_name,
             call_result = m3_GetResults(function, 1, retptrs);
             if (call_result == m3Err_none) {
                 *result = ret_val;
-                printk("WASM Service: Direct execution successful, result: %d\n", *result);
+                LOG_INF("Direct execution successful, result: %d", *result);
             }
         }
     }
@@ -941,6 +1232,90 @@ int wasm_service_get_last_result(wasm_result_packet_t *result_packet)
     }
 }
 
+int wasm_service_get_module(const uint8_t **code, uint32_t *size, uint32_t *crc32)
+{
+    if (!code || !size || !crc32) {
+        return -EINVAL;
+    }
+    
+    k_mutex_lock(&code_lock, K_FOREVER);
+    
+    /* A module that failed to load is not worth forwarding */
+    if (wasm_code_size == 0 || wasm_status == WASM_STATUS_RECEIVING ||
+        wasm_status == WASM_STATUS_ERROR) {
+        k_mutex_unlock(&code_lock);
+        return -ENOENT;
+    }
+    
+    code_readers++;
+    *code = wasm_code_buffer;
+    *size = wasm_code_size;
+    *crc32 = wasm_code_crc32;
+    k_mutex_unlock(&code_lock);
+    return 0;
+}
+
+void wasm_service_put_module(void)
+{
+    k_mutex_lock(&code_lock, K_FOREVER);
+    if (code_readers > 0 && --code_readers == 0 && retired_code) {
+        mem_budget_free(MEM_BUDGET_WASM, retired_code, retired_capacity);
+        retired_code = NULL;
+        retired_capacity = 0;
+    }
+    k_mutex_unlock(&code_lock);
+}
+
+void wasm_service_get_memory_usage(uint32_t *heap_size, uint32_t *heap_used)
+{
+    uint32_t used = 0;
+    
+    if (wasm_runtime_initialized && wasm_runtime) {
+        uint32_t memory_size = 0;
+        
+        used = WASM3_RUNTIME_STACK_SIZE;
+        if (m3_GetMemory(wasm_runtime, &memory_size, 0) != NULL) {
+            used += memory_size;
+        }
+    }
+    
+    if (heap_size) {
+        *heap_size = WASM3_FIXED_HEAP_SIZE;
+    }
+    if (heap_used) {
+        *heap_used = used;
+    }
+}
+
+int wasm_service_benchmark_call(uint32_t iterations, uint32_t *cycles_per_call)
+{
+    if (iterations == 0 || !cycles_per_call) {
+        return -EINVAL;
+    }
+    
+    wasm_work_msg_t bench_msg = {
+        .type = WASM_MSG_BENCHMARK,
+        .data.benchmark.iterations = iterations
+    };
+    
+    k_sem_reset(&benchmark_done);
+    if (k_msgq_put(&wasm_work_queue, &bench_msg, K_NO_WAIT) != 0) {
+        LOG_ERR("Failed to queue benchmark");
+        return -EBUSY;
+    }
+    APP_TRACE_MSGQ_PUT_DONE(&wasm_work_queue);
+    
+    if (k_sem_take(&benchmark_done, K_MSEC(WASM_BENCHMARK_TIMEOUT_MS)) != 0) {
+        LOG_WRN("Benchmark timed out");
+        return -ETIMEDOUT;
+    }
+    
+    if (benchmark_result == 0) {
+        *cycles_per_call = benchmark_cycles_per_call;
+    }
+    return benchmark_result;
+}
+
 bool wasm_service_validate_magic(const uint8_t *data, size_t size)
 {
     return validate_wasm_magic(data, size);
@@ -45,6 +45,11 @@ static const struct bt_uuid_16 wasm_result_uuid = BT_UUID_INIT_16(0xFFF3);
 #define WASM_UPLOAD_CHUNK_SIZE      244             /* BLE packet size - headers */
 #define WASM_FUNCTION_NAME_SIZE     32              /* Maximum function name length */
 #define WASM_RESULT_DATA_SIZE       32              /* Maximum result data size */
+#define WASM_WORK_QUEUE_DEPTH       4               /* Uploads and calls waiting for the WASM thread */
+
+/* WASM3 memory configuration */
+#define WASM3_RUNTIME_STACK_SIZE    (16 * 1024)     /* 16KB WASM3 value stack */
+#define WASM3_FIXED_HEAP_SIZE       (64 * 1024)     /* Must match d_m3FixedHeap in CMakeLists.txt */
 
 /* ============================================================================
  * STATUS CODES
@@ -69,9 +74,10 @@ static const struct bt_uuid_16 wasm_result_uuid = BT_UUID_INIT_16(0xFFF3);
 #define WASM_ERROR_FUNCTION_NOT_FOUND   0x06
 #define WASM_ERROR_EXECUTION_FAILED     0x07
 #define WASM_ERROR_INVALID_PARAMS       0x08
+#define WASM_ERROR_NO_MEMORY           0x09    /* Memory budget refused the code buffer */
 
 /* Upload command codes */
-#define WASM_CMD_START_UPLOAD           0x01
+#define WASM_CMD_START_UPLOAD           0x01    /* Refused while a module is loaded - reset first */
 #define WASM_CMD_CONTINUE_UPLOAD        0x02
 #define WASM_CMD_END_UPLOAD             0x03
 #define WASM_CMD_RESET                  0x04
@@ -102,6 +108,11 @@ typedef struct __attribute__((packed)) {
     int32_t  args[4];                                 /* Function arguments (max 4) */
 } wasm_execute_packet_t;
 
+/* Field numbers in the compact encoding (compact_codec.h); arg_count is the
+ * number of args fields, one per argument */
+#define WASM_EXECUTE_FIELD_FUNCTION_NAME    1   /* Bytes, without terminator */
+#define WASM_EXECUTE_FIELD_ARGS             2   /* Zigzag varint, repeated */
+
 /**
  * @brief WASM status packet structure
  * Used for reporting current status and progress
@@ -112,7 +123,8 @@ typedef struct __attribute__((packed)) {
     uint16_t bytes_received;                    /* Bytes received so far */
     uint32_t total_size;                        /* Total expected size */
     uint32_t uptime;                            /* System uptime */
-    uint8_t  reserved[6];                       /* Reserved for future use */
+    uint32_t module_crc32;                      /* CRC-32 of the received module, 0 if none */
+    uint8_t  reserved[2];                       /* Reserved for future use */
 } wasm_status_packet_t;
 
 /**
@@ -125,6 +137,7 @@ typedef struct __attribute__((packed)) {
     int32_t  return_value;                      /* Function return value */
     uint32_t execution_time_us;                 /* Execution time in microseconds */
     uint8_t  result_data[WASM_RESULT_DATA_SIZE]; /* Additional result data */
+    uint64_t timestamp_us;                      /* Completion time in the client timebase */
 } wasm_result_packet_t;
 
 /* ============================================================================
@@ -187,12 +200,56 @@ int wasm_service_execute_function(const char *function_name,
                                  int32_t *result);
 
 /**
- * @brief Get the last execution result
+ * @brief Get the last execution result from any connection
  * @param result_packet Pointer to result packet to fill
  * @return 0 on success, negative error code on failure
  */
 int wasm_service_get_last_result(wasm_result_packet_t *result_packet);
 
+/**
+ * @brief Get the received module and its content hash
+ * 
+ * Takes a reference: the bytes stay valid, and new uploads are refused,
+ * until the matching wasm_service_put_module().
+ * 
+ * @param code Pointer to store the module bytes
+ * @param size Pointer to store the module size
+ * @param crc32 Pointer to store the CRC-32 of the module
+ * @return 0 on success, -ENOENT if no complete module has been received
+ */
+int wasm_service_get_module(const uint8_t **code, uint32_t *size, uint32_t *crc32);
+
+/**
+ * @brief Drop a reference taken by wasm_service_get_module()
+ */
+void wasm_service_put_module(void);
+
+/**
+ * @brief Get approximate WASM3 heap usage
+ * 
+ * The fixed heap is private to wasm3, so usage is estimated as the runtime
+ * stack plus the module's linear memory.
+ * 
+ * @param heap_size Pointer to store the fixed heap size in bytes
+ * @param heap_used Pointer to store the estimated bytes in use
+ */
+void wasm_service_get_memory_usage(uint32_t *heap_size, uint32_t *heap_used);
+
+/**
+ * @brief Measure WASM call overhead for an empty export
+ * 
+ * Runs on the WASM work thread against a built-in module that exports a
+ * single empty function, using a scratch runtime kept separate from the
+ * uploaded module. The scratch runtime is created on first use and kept,
+ * since the WASM3 fixed heap does not reclaim freed memory.
+ * The caller must have started the timing subsystem (timing_start()).
+ * 
+ * @param iterations Number of calls to average over
+ * @param cycles_per_call Pointer to store the average cycles per call
+ * @return 0 on success, negative error code on failure
+ */
+int wasm_service_benchmark_call(uint32_t iterations, uint32_t *cycles_per_call);
+
 /**
  * @brief Validate WASM magic number and basic structure
  * @param data Pointer to WASM bytecode
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+BLE Latency and Throughput Measurements
+
+Helpers behind the ble_latency and ble_throughput fixtures in conftest.py.
+Every measurement of a session is recorded; with --perf-out the records are
+written as JSON in the layout tests/bsim/metrics_json.py uses, so pytest,
+BabbleSim and on-device numbers can be compared side by side.
+"""
+
+import json
+import math
+import subprocess
+import time
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Awaitable, Callable, List
+
+
+def percentile(samples: List[int], percent: int) -> int:
+    """Nearest-rank percentile, as the BabbleSim perf suite computes it"""
+    if not samples:
+        return 0
+    ordered = sorted(samples)
+    return ordered[max(math.ceil(len(ordered) * percent / 100), 1) - 1]
+
+
+@dataclass
+class LatencyResult:
+    """Round-trip times of one repeated GATT operation"""
+    name: str
+    samples_us: List[int]
+
+    @property
+    def p50_us(self) -> int:
+        return percentile(self.samples_us, 50)
+
+    @property
+    def max_us(self) -> int:
+        return percentile(self.samples_us, 100)
+
+    def summary(self) -> dict:
+        return {'samples': len(self.samples_us), 'p50_us': self.p50_us,
+                'p90_us': percentile(self.samples_us, 90), 'p99_us': percentile(self.samples_us, 99),
+                'max_us': self.max_us}
+
+
+@dataclass
+class ThroughputResult:
+    """One burst of writes without response"""
+    name: str
+    bytes: int
+    duration_s: float
+
+    @property
+    def kbps(self) -> float:
+        return self.bytes * 8 / 1000 / self.duration_s
+
+    def summary(self) -> dict:
+        return {'bytes': self.bytes, 'duration_ms': round(self.duration_s * 1000, 3),
+                'throughput_kbps': round(self.kbps, 3)}
+
+
+async def measure_latency(name: str, operation: Callable[[], Awaitable], count: int,
+                          warmup: int = 2) -> LatencyResult:
+    """Await operation count times, after warmup untimed calls"""
+    for _ in range(warmup):
+        await operation()
+
+    samples = []
+    for _ in range(count):
+        start = time.perf_counter_ns()
+        await operation()
+        samples.append((time.perf_counter_ns() - start) // 1000)
+    return LatencyResult(name, samples)
+
+
+async def measure_throughput(client, name: str, char_uuid: str, total_bytes: int, chunk_size: int,
+                             fence: Callable[[], Awaitable]) -> ThroughputResult:
+    """
+    Write total_bytes without response in chunk_size pieces.
+
+    Writes without response complete when queued, so the clock stops after
+    fence(), normally a read, which the device answers only once every
+    write before it has been handled.
+    """
+    chunk = bytes((i % 255) + 1 for i in range(chunk_size))
+    start = time.perf_counter()
+    for offset in range(0, total_bytes, chunk_size):
+        await client.write_gatt_char(char_uuid, chunk[:total_bytes - offset], response=False)
+    await fence()
+    return ThroughputResult(name, total_bytes, time.perf_counter() - start)
+
+
+def git_commit():
+    try:
+        return subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], capture_output=True,
+                              text=True, check=True, cwd=Path(__file__).parent).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+class PerfRecorder:
+    """Collects the measurements of a test session"""
+
+    def __init__(self, mode: str):
+        self.mode = mode
+        self.metrics: List[dict] = []
+
+    def record(self, test: str, result):
+        self.record_values(test, result.name, result.summary())
+
+    def record_values(self, test: str, scenario: str, values: dict):
+        """Record numbers a test read some other way, e.g. from the device"""
+        self.metrics.append({'scenario': scenario, 'test': test, 'mode': self.mode, **values})
+
+    def write(self, path: Path):
+        report = {'suite': 'pytest', 'commit': git_commit(), 'metrics': self.metrics}
+        path.write_text(json.dumps(report, indent=2) + "\n")
@@ -0,0 +1,1622 @@
+"""
+BLE protocol definitions for the tests
+
+Generated by generate_ble_protocol.py from the service headers - do not edit.
+Regenerate after changing a packet struct, characteristic or wrapper macro.
+"""
+
+import struct
+import warnings
+from dataclasses import dataclass, field
+from typing import Any, Callable, ClassVar, Dict, Iterable, Iterator, List, Tuple
+
+from bleak import BleakClient
+
+FINGERPRINT = 0x4048F689  # Matches BLE_PROTOCOL_FINGERPRINT in ble_protocol_gen.h
+
+# ============================================================================
+# CONSTANTS
+# ============================================================================
+
+# app_trace.h
+APP_TRACE_GATT_WRITE = 0
+APP_TRACE_GATT_READ = 1
+APP_TRACE_MSGQ_PUT = 2
+APP_TRACE_MSGQ_GET = 3
+APP_TRACE_WASM_PARSE = 4
+APP_TRACE_WASM_LOAD = 5
+APP_TRACE_WASM_COMPILE = 6
+APP_TRACE_WASM_CALL = 7
+APP_TRACE_FLASH_WRITE = 8
+APP_TRACE_NOTIFY = 9
+APP_TRACE_MARKER_COUNT = 10
+APP_TRACE_MARKER_NAME_LEN = 16
+APP_TRACE_THREAD_NAME_LEN = 16
+APP_TRACE_MAX_THREADS = 16
+APP_TRACE_PHASE_BEGIN = 0
+APP_TRACE_PHASE_END = 1
+APP_TRACE_PHASE_INSTANT = 2
+APP_TRACE_DUMP_MAGIC = 0x43525441
+APP_TRACE_DUMP_VERSION = 1
+
+# broadcast_service.h
+BROADCAST_FRAME_VERSION = 0x01
+BROADCAST_FRAME_PAYLOAD_MAX = 200
+BROADCAST_QUEUE_DEPTH = 8
+BROADCAST_INTERVAL_MS = 100
+BROADCAST_IDLE_TIMEOUT_MS = 5000
+BROADCAST_FRAME_DATA = 0x00
+BROADCAST_FRAME_SPRITE = 0x01
+BROADCAST_FRAME_DISPLAY_LIST = 0x02
+BROADCAST_FRAME_TYPE_COUNT = 3
+BROADCAST_SPRITE_PAYLOAD_SIZE = 34
+BROADCAST_DISPLAY_ENTRY_SIZE = 6
+BROADCAST_AD_UUID = 0xFFD8
+BROADCAST_STATE_IDLE = 0x00
+BROADCAST_STATE_ACTIVE = 0x01
+BROADCAST_STATE_ERROR = 0x02
+
+# compact_codec.h
+COMPACT_ENCODING_LEGACY = 0
+COMPACT_ENCODING_V1 = 1
+COMPACT_ENCODING_LATEST = 1
+COMPACT_WIRE_VARINT = 0
+COMPACT_WIRE_BYTES = 2
+COMPACT_TAG_SHIFT = 3
+COMPACT_VARINT_MAX_SIZE = 10
+
+# control_service.h
+CONTROL_COMMAND_FIELD_CMD_ID = 1
+CONTROL_COMMAND_FIELD_PARAM1 = 2
+CONTROL_COMMAND_FIELD_PARAM2 = 3
+CONTROL_BATCH_MAX_COMMANDS = 30
+CONTROL_BATCH_HEADER_SIZE = 2
+CONTROL_BATCH_RECORD_SIZE = 3
+CONTROL_BATCH_PACKET_MIN_SIZE = 5
+CONTROL_BATCH_PACKET_MAX_SIZE = 92
+CONTROL_BATCH_RESPONSE_HEADER_SIZE = 3
+CONTROL_TELEMETRY_THREAD_BT_RX = 0
+CONTROL_TELEMETRY_THREAD_SYSWORKQ = 1
+CONTROL_TELEMETRY_THREAD_WASM = 2
+CONTROL_TELEMETRY_THREAD_COUNT = 3
+CONTROL_TELEMETRY_INTERVAL_MS = 1000
+CONTROL_BENCHMARK_STATUS_IDLE = 0x00
+CONTROL_BENCHMARK_STATUS_RUNNING = 0x01
+CONTROL_BENCHMARK_STATUS_COMPLETE = 0x02
+CONTROL_BENCHMARK_STATUS_ERROR = 0x03
+CONTROL_BENCHMARK_SKIP_SPRITE = 0x01
+CONTROL_BENCHMARK_SKIP_WASM = 0x02
+CONTROL_BENCHMARK_SKIP_NOTIFY = 0x04
+CONTROL_BENCHMARK_CRC_KB_DEFAULT = 4
+CONTROL_BENCHMARK_CRC_KB_MAX = 64
+CONTROL_TIME_SYNC_FLAG_OFFSET_VALID = 0x01
+CONTROL_TIME_SYNC_FLAG_DRIFT_VALID = 0x02
+CONTROL_HANDLER_STATS_FLAG_RESET = 0x01
+CONTROL_HANDLER_STATS_FLAG_ENABLED = 0x01
+CONTROL_HANDLER_STATS_NAME_LEN = 24
+CONTROL_HANDLER_STATS_PAGE_SIZE = 4
+CONTROL_HANDLER_STATS_HEADER_SIZE = 8
+CONTROL_TRACE_FLAG_FREEZE = 0x01
+CONTROL_TRACE_FLAG_CLEAR = 0x02
+CONTROL_TRACE_FLAG_RESUME = 0x04
+CONTROL_TRACE_FLAG_ENABLED = 0x01
+CONTROL_TRACE_FLAG_FROZEN = 0x02
+CONTROL_TRACE_PAGE_SIZE = 232
+CONTROL_MEMORY_FLAG_RESET_PEAKS = 0x01
+CMD_GET_STATUS = 0x01
+CMD_RESET_DEVICE = 0x02
+CMD_SET_CONFIG = 0x03
+CMD_GET_VERSION = 0x04
+CMD_RUN_BENCHMARK = 0x05
+CMD_SET_LINK_PROFILE = 0x06
+CMD_GET_LINK_INFO = 0x07
+CMD_START_RELAY = 0x08
+CMD_GET_RELAY_STATUS = 0x09
+CMD_SET_TX_SCHEDULING = 0x0A
+CMD_SET_ENCODING = 0x0B
+LINK_INFO_RESULT_PROFILE = 0
+LINK_INFO_RESULT_TX_PHY = 1
+LINK_INFO_RESULT_INTERVAL = 2
+LINK_INFO_RESULT_TX_DATA_LEN = 4
+LINK_INFO_RESULT_MTU = 5
+ENCODING_RESULT_ACTIVE = 0
+ENCODING_RESULT_LATEST = 1
+RELAY_RESULT_STATE = 0
+RELAY_RESULT_UPDATED = 1
+RELAY_RESULT_SKIPPED = 2
+RELAY_RESULT_FAILED = 3
+RELAY_RESULT_ACTIVE = 4
+RELAY_RESULT_ELAPSED_S = 5
+DEVICE_STATUS_IDLE = 0x00
+DEVICE_STATUS_BUSY = 0x01
+DEVICE_STATUS_ERROR = 0x02
+RESPONSE_SUCCESS = 0x00
+RESPONSE_ERROR_INVALID_DATA = 0x01
+RESPONSE_ERROR_BUSY = 0x02
+RESPONSE_ERROR_UNKNOWN_CMD = 0xFF
+
+# data_service.h
+DATA_PACKET_SIZE_MIN = 20
+DATA_PACKET_SIZE_MEDIUM = 47
+DATA_PACKET_SIZE_LARGE = 244
+DATA_PACKET_SIZE_MAX = 244
+TRANSFER_STATUS_IDLE = 0x00
+TRANSFER_STATUS_RECEIVING = 0x01
+TRANSFER_STATUS_COMPLETE = 0x02
+TRANSFER_STATUS_ERROR = 0x03
+DATA_BUFFER_SIZE = 1024
+
+# device_info_service.h
+DEVICE_CAPS_VERSION = 1
+DEVICE_CAP_LARGE_MTU = 1
+DEVICE_CAP_2M_PHY = 2
+DEVICE_CAP_DATA_LEN_EXT = 4
+DEVICE_CAP_CONTROL_BATCH = 8
+DEVICE_CAP_COMPACT_ENCODING = 16
+DEVICE_CAP_HANDLER_STATS = 32
+DEVICE_CAP_TIME_SYNC = 64
+DEVICE_CAP_TELEMETRY = 128
+DEVICE_CAP_TX_SCHEDULING = 256
+DEVICE_CAP_RELAY = 512
+DEVICE_CAP_PERIODIC_BROADCAST = 1024
+DEVICE_CAP_BONDING = 2048
+DEVICE_CAP_WASM = 4096
+DEVICE_CAP_TRACE = 8192
+DEVICE_BUILD_DEBUG = 0x00
+DEVICE_BUILD_SIZE = 0x01
+DEVICE_BUILD_SPEED = 0x02
+
+# dfu_service.h
+DFU_CMD_START_DFU = 0x01
+DFU_CMD_INITIALIZE_DFU = 0x02
+DFU_CMD_RECEIVE_FW = 0x03
+DFU_CMD_VALIDATE_FW = 0x04
+DFU_CMD_ACTIVATE_N_RESET = 0x05
+DFU_RSP_SUCCESS = 0x01
+DFU_RSP_INVALID_STATE = 0x02
+DFU_RSP_NOT_SUPPORTED = 0x03
+DFU_RSP_DATA_SIZE_EXCEEDS = 0x04
+DFU_RSP_CRC_ERROR = 0x05
+DFU_RSP_OPERATION_FAILED = 0x06
+DFU_STATE_IDLE = 0x00
+DFU_STATE_READY = 0x01
+DFU_STATE_RECEIVING = 0x02
+DFU_PAGE_SIZE = 4096
+
+# sprite_service.h
+SPRITE_WIDTH = 16
+SPRITE_HEIGHT = 16
+SPRITE_PIXELS = 256
+SPRITE_DATA_SIZE = 32
+SPRITE_MAX_COUNT = 256
+SPRITE_ID_INVALID = 0xFFFF
+SPRITE_STATUS_SUCCESS = 0x00
+SPRITE_STATUS_NOT_FOUND = 0x01
+SPRITE_STATUS_CRC_ERROR = 0x02
+SPRITE_STATUS_REGISTRY_FULL = 0x03
+SPRITE_STATUS_INVALID_ID = 0x04
+SPRITE_STATUS_INVALID_DATA = 0x05
+REGISTRY_STATUS_READY = 0x00
+REGISTRY_STATUS_BUSY = 0x01
+REGISTRY_STATUS_ERROR = 0x02
+REGISTRY_STATUS_FULL = 0x03
+OPERATION_NONE = 0x00
+OPERATION_UPLOAD = 0x01
+OPERATION_DOWNLOAD = 0x02
+OPERATION_VERIFY = 0x03
+OPERATION_STATUS = 0x04
+VERIFY_STATUS_VALID = 0x00
+VERIFY_STATUS_INVALID = 0x01
+VERIFY_STATUS_NOT_FOUND = 0x02
+VERIFY_STATUS_ERROR = 0x03
+
+# status_broadcast.h
+STATUS_BROADCAST_UUID = 0xFFE0
+STATUS_BROADCAST_VERSION = 0x01
+STATUS_BROADCAST_INTERVAL_MS = 10000
+STATUS_FLAG_MODULE_LOADED = 0x01
+STATUS_FLAG_RESULT_VALID = 0x02
+STATUS_FLAG_DFU_ACTIVE = 0x04
+STATUS_FLAG_REGISTRY_FULL = 0x08
+
+# wasm_service.h
+WASM_CODE_BUFFER_SIZE = 8192
+WASM_UPLOAD_CHUNK_SIZE = 244
+WASM_FUNCTION_NAME_SIZE = 32
+WASM_RESULT_DATA_SIZE = 32
+WASM_WORK_QUEUE_DEPTH = 4
+WASM3_RUNTIME_STACK_SIZE = 16384
+WASM3_FIXED_HEAP_SIZE = 65536
+WASM_STATUS_IDLE = 0x00
+WASM_STATUS_RECEIVING = 0x01
+WASM_STATUS_RECEIVED = 0x02
+WASM_STATUS_LOADED = 0x03
+WASM_STATUS_EXECUTING = 0x04
+WASM_STATUS_COMPLETE = 0x05
+WASM_STATUS_ERROR = 0x06
+WASM_ERROR_NONE = 0x00
+WASM_ERROR_BUFFER_OVERFLOW = 0x01
+WASM_ERROR_INVALID_MAGIC = 0x02
+WASM_ERROR_PARSE_FAILED = 0x03
+WASM_ERROR_LOAD_FAILED = 0x04
+WASM_ERROR_COMPILE_FAILED = 0x05
+WASM_ERROR_FUNCTION_NOT_FOUND = 0x06
+WASM_ERROR_EXECUTION_FAILED = 0x07
+WASM_ERROR_INVALID_PARAMS = 0x08
+WASM_ERROR_NO_MEMORY = 0x09
+WASM_CMD_START_UPLOAD = 0x01
+WASM_CMD_CONTINUE_UPLOAD = 0x02
+WASM_CMD_END_UPLOAD = 0x03
+WASM_CMD_RESET = 0x04
+WASM_EXECUTE_FIELD_FUNCTION_NAME = 1
+WASM_EXECUTE_FIELD_ARGS = 2
+
+# ============================================================================
+# UUIDS
+# ============================================================================
+
+BROADCAST_SERVICE_UUID = "0000ffd8-0000-1000-8000-00805f9b34fb"
+BROADCAST_FRAME_UUID = "0000ffd9-0000-1000-8000-00805f9b34fb"
+BROADCAST_STATUS_UUID = "0000ffda-0000-1000-8000-00805f9b34fb"
+CONTROL_SERVICE_UUID = "0000ffe0-0000-1000-8000-00805f9b34fb"
+CONTROL_COMMAND_UUID = "0000ffe1-0000-1000-8000-00805f9b34fb"
+CONTROL_RESPONSE_UUID = "0000ffe2-0000-1000-8000-00805f9b34fb"
+CONTROL_STATUS_UUID = "0000ffe3-0000-1000-8000-00805f9b34fb"
+CONTROL_BATCH_UUID = "0000ffe4-0000-1000-8000-00805f9b34fb"
+CONTROL_BATCH_RESPONSE_UUID = "0000ffe5-0000-1000-8000-00805f9b34fb"
+CONTROL_TELEMETRY_UUID = "0000ffe6-0000-1000-8000-00805f9b34fb"
+CONTROL_BENCHMARK_UUID = "0000ffe7-0000-1000-8000-00805f9b34fb"
+CONTROL_TIME_SYNC_UUID = "0000ffe8-0000-1000-8000-00805f9b34fb"
+CONTROL_HANDLER_STATS_UUID = "0000ffe9-0000-1000-8000-00805f9b34fb"
+CONTROL_TRACE_UUID = "0000ffea-0000-1000-8000-00805f9b34fb"
+CONTROL_MEMORY_UUID = "0000ffeb-0000-1000-8000-00805f9b34fb"
+DATA_SERVICE_UUID = "0000fff0-0000-1000-8000-00805f9b34fb"
+DATA_UPLOAD_UUID = "0000fff1-0000-1000-8000-00805f9b34fb"
+DATA_DOWNLOAD_UUID = "0000fff2-0000-1000-8000-00805f9b34fb"
+DATA_TRANSFER_STATUS_UUID = "0000fff3-0000-1000-8000-00805f9b34fb"
+DEVICE_INFO_SERVICE_UUID = "0000180a-0000-1000-8000-00805f9b34fb"
+DIS_MANUFACTURER_NAME_UUID = "00002a29-0000-1000-8000-00805f9b34fb"
+DIS_MODEL_NUMBER_UUID = "00002a24-0000-1000-8000-00805f9b34fb"
+DIS_FIRMWARE_REVISION_UUID = "00002a26-0000-1000-8000-00805f9b34fb"
+DIS_HARDWARE_REVISION_UUID = "00002a27-0000-1000-8000-00805f9b34fb"
+DIS_SOFTWARE_REVISION_UUID = "00002a28-0000-1000-8000-00805f9b34fb"
+DEVICE_CAPABILITIES_UUID = "0000ffdc-0000-1000-8000-00805f9b34fb"
+DFU_SERVICE_UUID = "0000fe59-0000-1000-8000-00805f9b34fb"
+DFU_CONTROL_POINT_UUID = "0000ffd0-0000-1000-8000-00805f9b34fb"
+DFU_PACKET_UUID = "0000ffd1-0000-1000-8000-00805f9b34fb"
+SPRITE_SERVICE_UUID = "0000fff8-0000-1000-8000-00805f9b34fb"
+SPRITE_UPLOAD_UUID = "0000fff9-0000-1000-8000-00805f9b34fb"
+SPRITE_DOWNLOAD_REQUEST_UUID = "0000fffa-0000-1000-8000-00805f9b34fb"
+SPRITE_DOWNLOAD_RESPONSE_UUID = "0000fffb-0000-1000-8000-00805f9b34fb"
+SPRITE_REGISTRY_STATUS_UUID = "0000fffc-0000-1000-8000-00805f9b34fb"
+SPRITE_VERIFY_REQUEST_UUID = "0000fffd-0000-1000-8000-00805f9b34fb"
+SPRITE_VERIFY_RESPONSE_UUID = "0000fffe-0000-1000-8000-00805f9b34fb"
+WASM_SERVICE_UUID = "0000fff7-0000-1000-8000-00805f9b34fb"
+WASM_UPLOAD_UUID = "0000fff6-0000-1000-8000-00805f9b34fb"
+WASM_EXECUTE_UUID = "0000fff5-0000-1000-8000-00805f9b34fb"
+WASM_STATUS_UUID = "0000fff4-0000-1000-8000-00805f9b34fb"
+WASM_RESULT_UUID = "0000fff3-0000-1000-8000-00805f9b34fb"
+
+# ============================================================================
+# PACKETS
+# ============================================================================
+
+class Packet:
+    """Base of the generated packet classes
+
+    LAYOUT lists (name, kind, format, length) per field. Kinds: int, pad,
+    count (element count of the list field named in length), str, bytes,
+    ints, packet and packets.
+    """
+
+    SIZE: ClassVar[int] = 0
+    MIN_SIZE: ClassVar[int] = 0        # Shortest valid write
+    HEADER_SIZE: ClassVar[int] = 0     # Bytes ahead of the trailing array
+    VARIABLE: ClassVar[bool] = False   # Trailing array is sent only as far as it is filled
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = ()
+    COMPACT: ClassVar[Tuple[Tuple[str, int], ...]] = ()  # (field, number) in the compact encoding
+
+    def encode(self, encoding: int) -> bytes:
+        """Encode for a connection using encoding (COMPACT_ENCODING_*)"""
+        if encoding != COMPACT_ENCODING_LEGACY and self.COMPACT:
+            return self.pack_compact()
+        return self.pack()
+
+    def pack_compact(self) -> bytes:
+        """Encode as tagged fields, leaving out zero and empty ones (see compact_codec.h)"""
+        layout = {name: (kind, fmt, length) for name, kind, fmt, length in self.LAYOUT}
+        out = bytearray()
+        for name, number in self.COMPACT:
+            kind, fmt, length = layout[name]
+            value = getattr(self, name)
+            if kind in ('str', 'bytes'):
+                value = value.encode() if kind == 'str' else bytes(value)
+                _check_length(self, name, len(value) + (kind == 'str'), length)
+                if value:
+                    out += _varint(number << COMPACT_TAG_SHIFT | COMPACT_WIRE_BYTES)
+                    out += _varint(len(value)) + value
+                continue
+            values = list(value) if kind == 'ints' else [value] if value else []
+            _check_length(self, name, len(values), length or 1)
+            for item in values:
+                out += _varint(number << COMPACT_TAG_SHIFT | COMPACT_WIRE_VARINT)
+                out += _varint(_zigzag(item) if fmt.islower() else int(item))
+        return bytes(out)
+
+    def pack(self) -> bytes:
+        out = bytearray()
+        for index, (name, kind, fmt, length) in enumerate(self.LAYOUT):
+            trailing = self.VARIABLE and index == len(self.LAYOUT) - 1
+            if kind == 'pad':
+                out += bytes(length)
+            elif kind == 'count':
+                out += struct.pack('<' + fmt, len(getattr(self, length)))
+            elif kind == 'int':
+                out += struct.pack('<' + fmt, getattr(self, name))
+            elif kind in ('str', 'bytes'):
+                value = getattr(self, name)
+                value = value.encode() if kind == 'str' else bytes(value)
+                _check_length(self, name, len(value), length)
+                out += value if trailing else value.ljust(length, b'\0')
+            elif kind == 'ints':
+                values = list(getattr(self, name))
+                _check_length(self, name, len(values), length)
+                if not trailing:
+                    values += [0] * (length - len(values))
+                out += struct.pack(f'<{len(values)}{fmt}', *values)
+            elif kind == 'packet':
+                out += getattr(self, name).pack()
+            elif kind == 'packets':
+                items = list(getattr(self, name))
+                _check_length(self, name, len(items), length)
+                if not trailing:
+                    items += [fmt() for _ in range(length - len(items))]
+                out += b''.join(item.pack() for item in items)
+        if len(out) < self.MIN_SIZE:
+            raise ValueError(f"{type(self).__name__}: {len(out)} bytes, need {self.MIN_SIZE}")
+        return bytes(out)
+
+    @classmethod
+    def unpack(cls, data: bytes):
+        data = bytes(data)
+        if len(data) < cls.HEADER_SIZE:
+            raise ValueError(f"{cls.__name__}: {len(data)} bytes, need {cls.HEADER_SIZE}")
+        values: Dict[str, Any] = {}
+        counts: Dict[str, int] = {}
+        offset = 0
+        for name, kind, fmt, length in cls.LAYOUT:
+            if kind == 'pad':
+                offset += length
+            elif kind in ('int', 'count'):
+                (value,) = struct.unpack_from('<' + fmt, data, offset)
+                offset += struct.calcsize(fmt)
+                if kind == 'count':
+                    counts[length] = value
+                else:
+                    values[name] = value
+            elif kind in ('str', 'bytes'):
+                value = data[offset:offset + length]
+                offset += len(value)
+                if kind == 'str':
+                    value = value.split(b'\0', 1)[0].decode('utf-8', errors='replace')
+                values[name] = value
+            elif kind == 'ints':
+                size = struct.calcsize(fmt)
+                n = min(length, (len(data) - offset) // size)
+                values[name] = list(struct.unpack_from(f'<{n}{fmt}', data, offset))
+                offset += n * size
+            elif kind == 'packet':
+                values[name] = fmt.unpack(data[offset:offset + fmt.SIZE])
+                offset += fmt.SIZE
+            elif kind == 'packets':
+                n = min(length, (len(data) - offset) // fmt.SIZE)
+                values[name] = [fmt.unpack(data[offset + i * fmt.SIZE:offset + (i + 1) * fmt.SIZE])
+                                for i in range(n)]
+                offset += n * fmt.SIZE
+        for name, count in counts.items():
+            values[name] = values[name][:count]
+        return cls(**values)
+
+    @classmethod
+    def batches(cls, items: Iterable[Any], **fields) -> Iterator['Packet']:
+        """Split items over as many packets as needed
+
+        Only for packets with a counted trailing array; fields are copied
+        into every packet.
+        """
+        name, capacity = cls._counted_array()
+        items = list(items)
+        for start in range(0, len(items), capacity):
+            yield cls(**fields, **{name: items[start:start + capacity]})
+
+    @classmethod
+    def _counted_array(cls) -> Tuple[str, int]:
+        for _, kind, _, target in cls.LAYOUT:
+            if kind == 'count':
+                for name, _, _, length in cls.LAYOUT:
+                    if name == target:
+                        return name, length
+        raise TypeError(f"{cls.__name__} has no counted array")
+
+
+def _check_length(packet: Packet, name: str, length: int, capacity: int) -> None:
+    if length > capacity:
+        raise ValueError(f"{type(packet).__name__}.{name}: {length} > {capacity}")
+
+
+def _varint(value: int) -> bytes:
+    out = bytearray()
+    while value > 0x7F:
+        out.append(value & 0x7F | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def _zigzag(value: int) -> int:
+    return (value << 1) ^ (value >> 63)
+
+
+@dataclass
+class AppTraceHeader(Packet):
+    """app_trace_header_t, 20 bytes"""
+
+    SIZE: ClassVar[int] = 20
+    MIN_SIZE: ClassVar[int] = 20
+    HEADER_SIZE: ClassVar[int] = 20
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('magic', 'int', 'I', None),
+        ('version', 'int', 'B', None),
+        ('marker_count', 'int', 'B', None),
+        ('thread_count', 'int', 'B', None),
+        ('record_size', 'int', 'B', None),
+        ('timer_freq_hz', 'int', 'I', None),
+        ('record_count', 'int', 'I', None),
+        ('dropped', 'int', 'I', None),
+    )
+
+    magic: int = 0  # APP_TRACE_DUMP_MAGIC
+    version: int = 0  # APP_TRACE_DUMP_VERSION
+    marker_count: int = 0  # Marker names that follow
+    thread_count: int = 0  # Thread entries that follow the names
+    record_size: int = 0  # sizeof(app_trace_record_t)
+    timer_freq_hz: int = 0  # Frequency of the record timestamps
+    record_count: int = 0  # Records in the dump
+    dropped: int = 0  # Records overwritten or lost while frozen
+
+
+@dataclass
+class AppTraceThread(Packet):
+    """app_trace_thread_t, 20 bytes"""
+
+    SIZE: ClassVar[int] = 20
+    MIN_SIZE: ClassVar[int] = 20
+    HEADER_SIZE: ClassVar[int] = 4
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('id', 'int', 'I', None),
+        ('name', 'str', None, 16),
+    )
+
+    id: int = 0  # Thread ID as stored in the records
+    name: str = ''  # Thread name, truncated, NUL terminated
+
+
+@dataclass
+class AppTraceRecord(Packet):
+    """app_trace_record_t, 20 bytes"""
+
+    SIZE: ClassVar[int] = 20
+    MIN_SIZE: ClassVar[int] = 20
+    HEADER_SIZE: ClassVar[int] = 20
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('timestamp', 'int', 'I', None),
+        ('thread', 'int', 'I', None),
+        ('marker', 'int', 'B', None),
+        ('phase', 'int', 'B', None),
+        ('reserved', 'pad', None, 2),
+        ('arg0', 'int', 'I', None),
+        ('arg1', 'int', 'I', None),
+    )
+
+    timestamp: int = 0  # Cycle counter at the marker
+    thread: int = 0  # Thread that hit the marker, 0 in an ISR
+    marker: int = 0  # APP_TRACE_* marker ID
+    phase: int = 0  # APP_TRACE_PHASE_*
+    arg0: int = 0  # Marker specific
+    arg1: int = 0  # Marker specific
+
+
+@dataclass
+class BroadcastFramePacket(Packet):
+    """broadcast_frame_packet_t, 201 bytes"""
+
+    SIZE: ClassVar[int] = 201
+    MIN_SIZE: ClassVar[int] = 2
+    HEADER_SIZE: ClassVar[int] = 1
+    VARIABLE: ClassVar[bool] = True
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('type', 'int', 'B', None),
+        ('payload', 'bytes', None, 200),
+    )
+
+    type: int = 0  # BROADCAST_FRAME_*
+    payload: bytes = b''  # Frame payload
+
+
+@dataclass
+class BroadcastFrameHeader(Packet):
+    """broadcast_frame_header_t, 4 bytes"""
+
+    SIZE: ClassVar[int] = 4
+    MIN_SIZE: ClassVar[int] = 4
+    HEADER_SIZE: ClassVar[int] = 4
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('version', 'int', 'B', None),
+        ('type', 'int', 'B', None),
+        ('seq', 'int', 'H', None),
+    )
+
+    version: int = 0  # BROADCAST_FRAME_VERSION
+    type: int = 0  # BROADCAST_FRAME_*
+    seq: int = 0  # Incremented for every frame put on air
+
+
+@dataclass
+class BroadcastStatusPacket(Packet):
+    """broadcast_status_packet_t, 12 bytes"""
+
+    SIZE: ClassVar[int] = 12
+    MIN_SIZE: ClassVar[int] = 12
+    HEADER_SIZE: ClassVar[int] = 12
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('state', 'int', 'B', None),
+        ('queued', 'int', 'B', None),
+        ('seq', 'int', 'H', None),
+        ('frames_sent', 'int', 'I', None),
+        ('frames_dropped', 'int', 'I', None),
+    )
+
+    state: int = 0  # BROADCAST_STATE_*
+    queued: int = 0  # Frames waiting for a PA event
+    seq: int = 0  # Sequence number of the frame on air
+    frames_sent: int = 0  # Frames put on air since boot
+    frames_dropped: int = 0  # Frames rejected because the queue was full
+
+
+@dataclass
+class ControlCommandPacket(Packet):
+    """control_command_packet_t, 20 bytes"""
+
+    SIZE: ClassVar[int] = 20
+    MIN_SIZE: ClassVar[int] = 20
+    HEADER_SIZE: ClassVar[int] = 20
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('cmd_id', 'int', 'B', None),
+        ('param1', 'int', 'B', None),
+        ('param2', 'int', 'B', None),
+        ('reserved', 'pad', None, 17),
+    )
+    COMPACT: ClassVar[Tuple[Tuple[str, int], ...]] = (
+        ('cmd_id', CONTROL_COMMAND_FIELD_CMD_ID),
+        ('param1', CONTROL_COMMAND_FIELD_PARAM1),
+        ('param2', CONTROL_COMMAND_FIELD_PARAM2),
+    )
+
+    cmd_id: int = 0  # Command identifier (CMD_*)
+    param1: int = 0  # First parameter
+    param2: int = 0  # Second parameter
+
+
+@dataclass
+class ControlResponsePacket(Packet):
+    """control_response_packet_t, 8 bytes"""
+
+    SIZE: ClassVar[int] = 8
+    MIN_SIZE: ClassVar[int] = 8
+    HEADER_SIZE: ClassVar[int] = 2
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('cmd_id', 'int', 'B', None),
+        ('status', 'int', 'B', None),
+        ('result', 'bytes', None, 6),
+    )
+
+    cmd_id: int = 0  # Original command identifier
+    status: int = 0  # Response status (RESPONSE_*)
+    result: bytes = b''  # Response data
+
+
+@dataclass
+class ControlStatusPacket(Packet):
+    """control_status_packet_t, 8 bytes"""
+
+    SIZE: ClassVar[int] = 8
+    MIN_SIZE: ClassVar[int] = 8
+    HEADER_SIZE: ClassVar[int] = 8
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('device_status', 'int', 'B', None),
+        ('uptime', 'int', 'I', None),
+        ('reserved', 'pad', None, 3),
+    )
+
+    device_status: int = 0  # Current device status (DEVICE_STATUS_*)
+    uptime: int = 0  # Device uptime in seconds
+
+
+@dataclass
+class ControlBatchRecord(Packet):
+    """control_batch_record_t, 3 bytes"""
+
+    SIZE: ClassVar[int] = 3
+    MIN_SIZE: ClassVar[int] = 3
+    HEADER_SIZE: ClassVar[int] = 3
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('cmd_id', 'int', 'B', None),
+        ('param1', 'int', 'B', None),
+        ('param2', 'int', 'B', None),
+    )
+
+    cmd_id: int = 0  # Command identifier (CMD_*)
+    param1: int = 0  # First parameter
+    param2: int = 0  # Second parameter
+
+
+@dataclass
+class ControlBatchPacket(Packet):
+    """control_batch_packet_t, 92 bytes"""
+
+    SIZE: ClassVar[int] = 92
+    MIN_SIZE: ClassVar[int] = 5
+    HEADER_SIZE: ClassVar[int] = 2
+    VARIABLE: ClassVar[bool] = True
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('batch_id', 'int', 'B', None),
+        ('count', 'count', 'B', 'records'),
+        ('records', 'packets', ControlBatchRecord, 30),
+    )
+
+    batch_id: int = 0  # Client-chosen tag echoed in the response
+    records: List[ControlBatchRecord] = field(default_factory=list)  # Command records
+
+
+@dataclass
+class ControlBatchResponse(Packet):
+    """control_batch_response_t, 243 bytes"""
+
+    SIZE: ClassVar[int] = 243
+    MIN_SIZE: ClassVar[int] = 243
+    HEADER_SIZE: ClassVar[int] = 3
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('batch_id', 'int', 'B', None),
+        ('count', 'count', 'B', 'results'),
+        ('failed', 'int', 'B', None),
+        ('results', 'packets', ControlResponsePacket, 30),
+    )
+
+    batch_id: int = 0  # Tag copied from the batch command
+    failed: int = 0  # Number of results with a non-success status
+    results: List[ControlResponsePacket] = field(default_factory=list)  # Per-record results
+
+
+@dataclass
+class ControlTelemetryThread(Packet):
+    """control_telemetry_thread_t, 6 bytes"""
+
+    SIZE: ClassVar[int] = 6
+    MIN_SIZE: ClassVar[int] = 6
+    HEADER_SIZE: ClassVar[int] = 6
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('stack_size', 'int', 'H', None),
+        ('stack_unused', 'int', 'H', None),
+        ('cpu_permille', 'int', 'H', None),
+    )
+
+    stack_size: int = 0  # Stack size in bytes
+    stack_unused: int = 0  # Stack bytes never touched since boot
+    cpu_permille: int = 0  # CPU share since the previous sample (0-1000)
+
+
+@dataclass
+class ControlTelemetryPacket(Packet):
+    """control_telemetry_packet_t, 48 bytes"""
+
+    SIZE: ClassVar[int] = 48
+    MIN_SIZE: ClassVar[int] = 48
+    HEADER_SIZE: ClassVar[int] = 48
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('uptime_ms', 'int', 'I', None),
+        ('cpu_load_permille', 'int', 'H', None),
+        ('idle_permille', 'int', 'H', None),
+        ('threads', 'packets', ControlTelemetryThread, 3),
+        ('wasm3_heap_size', 'int', 'I', None),
+        ('wasm3_heap_used', 'int', 'I', None),
+        ('bt_tx_bufs_total', 'int', 'B', None),
+        ('bt_tx_bufs_free', 'int', 'B', None),
+        ('bt_rx_bufs_total', 'int', 'B', None),
+        ('bt_rx_bufs_free', 'int', 'B', None),
+        ('thread_count', 'int', 'B', None),
+        ('reserved', 'pad', None, 1),
+        ('timestamp_us', 'int', 'Q', None),
+    )
+
+    uptime_ms: int = 0  # Sample time in milliseconds since boot
+    cpu_load_permille: int = 0  # Non-idle CPU share (0-1000)
+    idle_permille: int = 0  # Idle CPU share (0-1000)
+    threads: List[ControlTelemetryThread] = field(default_factory=list)  # BT RX, sysworkq, WASM thread
+    wasm3_heap_size: int = 0  # wasm3 fixed heap size in bytes
+    wasm3_heap_used: int = 0  # wasm3 runtime stack + linear memory in bytes
+    bt_tx_bufs_total: int = 0  # BT TX buffers in all TX pools
+    bt_tx_bufs_free: int = 0  # BT TX buffers currently free
+    bt_rx_bufs_total: int = 0  # BT RX buffers in all RX pools
+    bt_rx_bufs_free: int = 0  # BT RX buffers currently free
+    thread_count: int = 0  # Number of threads in the system
+    timestamp_us: int = 0  # Sample time in the client timebase (see time sync)
+
+
+@dataclass
+class ControlBenchmarkResult(Packet):
+    """control_benchmark_result_t, 48 bytes"""
+
+    SIZE: ClassVar[int] = 48
+    MIN_SIZE: ClassVar[int] = 48
+    HEADER_SIZE: ClassVar[int] = 48
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('status', 'int', 'B', None),
+        ('run_id', 'int', 'B', None),
+        ('skipped', 'int', 'B', None),
+        ('crc_kb', 'int', 'B', None),
+        ('timer_freq_hz', 'int', 'I', None),
+        ('crc16_cycles', 'int', 'I', None),
+        ('sprite_store_cycles', 'int', 'I', None),
+        ('sprite_lookup_cycles', 'int', 'I', None),
+        ('wasm_call_cycles', 'int', 'I', None),
+        ('memcpy_cycles', 'int', 'I', None),
+        ('memcpy_bytes', 'int', 'I', None),
+        ('notify_cycles', 'int', 'I', None),
+        ('handler_cycles', 'int', 'I', None),
+        ('timestamp_us', 'int', 'Q', None),
+    )
+
+    status: int = 0  # Run status (CONTROL_BENCHMARK_STATUS_*)
+    run_id: int = 0  # Incremented on every accepted run
+    skipped: int = 0  # Skipped tests (CONTROL_BENCHMARK_SKIP_*)
+    crc_kb: int = 0  # CRC16 input size in KB
+    timer_freq_hz: int = 0  # Cycle counter frequency
+    crc16_cycles: int = 0  # CRC16 over crc_kb KB
+    sprite_store_cycles: int = 0  # Storing 256 sprites into an empty registry
+    sprite_lookup_cycles: int = 0  # Looking up all 256 sprites
+    wasm_call_cycles: int = 0  # One call to an empty WASM export
+    memcpy_cycles: int = 0  # Copying memcpy_bytes bytes
+    memcpy_bytes: int = 0  # Bytes copied in the memcpy test
+    notify_cycles: int = 0  # One bt_gatt_notify() enqueue
+    handler_cycles: int = 0  # One data upload handler call, max-size packet
+    timestamp_us: int = 0  # Completion time in the client timebase (see time sync)
+
+
+@dataclass
+class ControlTimeSyncRequest(Packet):
+    """control_time_sync_request_t, 18 bytes"""
+
+    SIZE: ClassVar[int] = 18
+    MIN_SIZE: ClassVar[int] = 18
+    HEADER_SIZE: ClassVar[int] = 18
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('seq', 'int', 'B', None),
+        ('reserved', 'pad', None, 1),
+        ('client_t1_us', 'int', 'Q', None),
+        ('prev_client_t4_us', 'int', 'Q', None),
+    )
+
+    seq: int = 0  # Client sequence number, echoed in the response
+    client_t1_us: int = 0  # Client send time of this request
+    prev_client_t4_us: int = 0  # Client receive time of the previous response (0 = none)
+
+
+@dataclass
+class ControlTimeSyncResponse(Packet):
+    """control_time_sync_response_t, 44 bytes"""
+
+    SIZE: ClassVar[int] = 44
+    MIN_SIZE: ClassVar[int] = 44
+    HEADER_SIZE: ClassVar[int] = 44
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('seq', 'int', 'B', None),
+        ('flags', 'int', 'B', None),
+        ('sample_count', 'int', 'B', None),
+        ('reserved', 'pad', None, 1),
+        ('client_t1_us', 'int', 'Q', None),
+        ('device_t2_us', 'int', 'Q', None),
+        ('device_t3_us', 'int', 'Q', None),
+        ('offset_us', 'int', 'q', None),
+        ('drift_ppb', 'int', 'i', None),
+        ('rtt_us', 'int', 'I', None),
+    )
+
+    seq: int = 0  # Sequence number from the request
+    flags: int = 0  # CONTROL_TIME_SYNC_FLAG_*
+    sample_count: int = 0  # Completed exchanges in the estimate window
+    client_t1_us: int = 0  # Echo of the request's client_t1_us
+    device_t2_us: int = 0  # Device receive time of the request
+    device_t3_us: int = 0  # Device send time of this response
+    offset_us: int = 0  # Estimated client minus device time
+    drift_ppb: int = 0  # Estimated client clock rate relative to the device
+    rtt_us: int = 0  # Round trip of the best sample in the window
+
+
+@dataclass
+class ControlHandlerStatsSelect(Packet):
+    """control_handler_stats_select_t, 2 bytes"""
+
+    SIZE: ClassVar[int] = 2
+    MIN_SIZE: ClassVar[int] = 2
+    HEADER_SIZE: ClassVar[int] = 2
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('first', 'int', 'B', None),
+        ('flags', 'int', 'B', None),
+    )
+
+    first: int = 0  # Index of the first entry on the page
+    flags: int = 0  # CONTROL_HANDLER_STATS_FLAG_RESET
+
+
+@dataclass
+class ControlHandlerStatsEntry(Packet):
+    """control_handler_stats_entry_t, 56 bytes"""
+
+    SIZE: ClassVar[int] = 56
+    MIN_SIZE: ClassVar[int] = 56
+    HEADER_SIZE: ClassVar[int] = 40
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('name', 'str', None, 24),
+        ('calls', 'int', 'I', None),
+        ('bytes', 'int', 'I', None),
+        ('errors', 'int', 'I', None),
+        ('max_cycles', 'int', 'I', None),
+        ('hist', 'ints', 'H', 8),
+    )
+
+    name: str = ''  # Handler name, truncated to fit, NUL terminated
+    calls: int = 0  # ATT requests served
+    bytes: int = 0  # Payload bytes written or read
+    errors: int = 0  # ATT error returns
+    max_cycles: int = 0  # Slowest call
+    hist: List[int] = field(default_factory=list)  # Cycle histogram
+
+
+@dataclass
+class ControlHandlerStatsPage(Packet):
+    """control_handler_stats_page_t, 232 bytes"""
+
+    SIZE: ClassVar[int] = 232
+    MIN_SIZE: ClassVar[int] = 232
+    HEADER_SIZE: ClassVar[int] = 8
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('total', 'int', 'B', None),
+        ('first', 'int', 'B', None),
+        ('count', 'count', 'B', 'entries'),
+        ('flags', 'int', 'B', None),
+        ('timer_freq_hz', 'int', 'I', None),
+        ('entries', 'packets', ControlHandlerStatsEntry, 4),
+    )
+
+    total: int = 0  # Entries in the table
+    first: int = 0  # Index of entries[0]
+    flags: int = 0  # CONTROL_HANDLER_STATS_FLAG_ENABLED
+    timer_freq_hz: int = 0  # Cycle counter frequency
+    entries: List[ControlHandlerStatsEntry] = field(default_factory=list)
+
+
+@dataclass
+class ControlTraceSelect(Packet):
+    """control_trace_select_t, 5 bytes"""
+
+    SIZE: ClassVar[int] = 5
+    MIN_SIZE: ClassVar[int] = 5
+    HEADER_SIZE: ClassVar[int] = 5
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('offset', 'int', 'I', None),
+        ('flags', 'int', 'B', None),
+    )
+
+    offset: int = 0  # Offset of the first dump byte on the page
+    flags: int = 0  # CONTROL_TRACE_FLAG_FREEZE / CLEAR / RESUME
+
+
+@dataclass
+class ControlTracePage(Packet):
+    """control_trace_page_t, 244 bytes"""
+
+    SIZE: ClassVar[int] = 244
+    MIN_SIZE: ClassVar[int] = 244
+    HEADER_SIZE: ClassVar[int] = 12
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('total_len', 'int', 'I', None),
+        ('offset', 'int', 'I', None),
+        ('flags', 'int', 'B', None),
+        ('reserved', 'pad', None, 3),
+        ('data', 'bytes', None, 232),
+    )
+
+    total_len: int = 0  # Bytes in the dump
+    offset: int = 0  # Offset of data[0] in the dump
+    flags: int = 0  # CONTROL_TRACE_FLAG_ENABLED / FROZEN
+    data: bytes = b''  # Dump bytes
+
+
+@dataclass
+class ControlMemorySelect(Packet):
+    """control_memory_select_t, 1 bytes"""
+
+    SIZE: ClassVar[int] = 1
+    MIN_SIZE: ClassVar[int] = 1
+    HEADER_SIZE: ClassVar[int] = 1
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('flags', 'int', 'B', None),
+    )
+
+    flags: int = 0  # CONTROL_MEMORY_FLAG_RESET_PEAKS
+
+
+@dataclass
+class ControlMemoryClient(Packet):
+    """control_memory_client_t, 24 bytes"""
+
+    SIZE: ClassVar[int] = 24
+    MIN_SIZE: ClassVar[int] = 24
+    HEADER_SIZE: ClassVar[int] = 24
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('name', 'str', None, 8),
+        ('quota', 'int', 'I', None),
+        ('used', 'int', 'I', None),
+        ('peak', 'int', 'I', None),
+        ('failures', 'int', 'H', None),
+        ('reserved', 'pad', None, 2),
+    )
+
+    name: str = ''  # Client name, NUL terminated
+    quota: int = 0  # Bytes the client may hold
+    used: int = 0  # Bytes held now, in whole blocks
+    peak: int = 0  # Most bytes held at once
+    failures: int = 0  # Borrows refused, saturates at 0xFFFF
+
+
+@dataclass
+class ControlMemoryPacket(Packet):
+    """control_memory_packet_t, 88 bytes"""
+
+    SIZE: ClassVar[int] = 88
+    MIN_SIZE: ClassVar[int] = 88
+    HEADER_SIZE: ClassVar[int] = 16
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('pool_size', 'int', 'I', None),
+        ('used', 'int', 'I', None),
+        ('peak', 'int', 'I', None),
+        ('block_size', 'int', 'H', None),
+        ('count', 'count', 'B', 'clients'),
+        ('reserved', 'pad', None, 1),
+        ('clients', 'packets', ControlMemoryClient, 3),
+    )
+
+    pool_size: int = 0  # Bytes in the pool
+    used: int = 0  # Bytes borrowed now
+    peak: int = 0  # Most bytes borrowed at once
+    block_size: int = 0  # Allocation unit
+    clients: List[ControlMemoryClient] = field(default_factory=list)
+
+
+@dataclass
+class DataUploadPacket(Packet):
+    """data_upload_packet_t, 244 bytes"""
+
+    SIZE: ClassVar[int] = 244
+    MIN_SIZE: ClassVar[int] = 1
+    HEADER_SIZE: ClassVar[int] = 0
+    VARIABLE: ClassVar[bool] = True
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('data', 'bytes', None, 244),
+    )
+
+    data: bytes = b''  # Data payload (up to 244 bytes)
+
+
+@dataclass
+class DataDownloadPacket(Packet):
+    """data_download_packet_t, 244 bytes"""
+
+    SIZE: ClassVar[int] = 244
+    MIN_SIZE: ClassVar[int] = 244
+    HEADER_SIZE: ClassVar[int] = 0
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('data', 'bytes', None, 244),
+    )
+
+    data: bytes = b''  # Data payload (up to 244 bytes)
+
+
+@dataclass
+class DataTransferStatusPacket(Packet):
+    """data_transfer_status_packet_t, 6 bytes"""
+
+    SIZE: ClassVar[int] = 6
+    MIN_SIZE: ClassVar[int] = 6
+    HEADER_SIZE: ClassVar[int] = 6
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('transfer_status', 'int', 'B', None),
+        ('buffer_size', 'int', 'H', None),
+        ('reserved', 'pad', None, 3),
+    )
+
+    transfer_status: int = 0  # Transfer status (TRANSFER_STATUS_*)
+    buffer_size: int = 0  # Bytes of the last upload held for echo
+
+
+@dataclass
+class DeviceInfoString(Packet):
+    """device_info_string_t, 64 bytes"""
+
+    SIZE: ClassVar[int] = 64
+    MIN_SIZE: ClassVar[int] = 64
+    HEADER_SIZE: ClassVar[int] = 0
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('text', 'str', None, 64),
+    )
+
+    text: str = ''  # Null-terminated string (up to 63 chars + null)
+
+
+@dataclass
+class DeviceCapabilities(Packet):
+    """device_capabilities_t, 32 bytes"""
+
+    SIZE: ClassVar[int] = 32
+    MIN_SIZE: ClassVar[int] = 32
+    HEADER_SIZE: ClassVar[int] = 32
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('version', 'int', 'B', None),
+        ('build_profile', 'int', 'B', None),
+        ('max_mtu', 'int', 'H', None),
+        ('features', 'int', 'I', None),
+        ('protocol_fingerprint', 'int', 'I', None),
+        ('max_module_size', 'int', 'I', None),
+        ('max_upload_chunk', 'int', 'H', None),
+        ('sprite_capacity', 'int', 'H', None),
+        ('encodings', 'int', 'B', None),
+        ('max_connections', 'int', 'B', None),
+        ('batch_max_commands', 'int', 'B', None),
+        ('broadcast_queue_depth', 'int', 'B', None),
+        ('wasm_queue_depth', 'int', 'B', None),
+        ('reserved', 'pad', None, 7),
+    )
+
+    version: int = 0  # DEVICE_CAPS_VERSION
+    build_profile: int = 0  # DEVICE_BUILD_* optimization level
+    max_mtu: int = 0  # Largest ATT MTU accepted
+    features: int = 0  # DEVICE_CAP_* bitmap
+    protocol_fingerprint: int = 0  # BLE_PROTOCOL_FINGERPRINT of the packet layouts
+    max_module_size: int = 0  # Largest WASM module in bytes
+    max_upload_chunk: int = 0  # Largest data in one WASM or data upload write
+    sprite_capacity: int = 0  # Sprite registry slots
+    encodings: int = 0  # Bit n set if COMPACT_ENCODING n is supported
+    max_connections: int = 0  # Simultaneous centrals
+    batch_max_commands: int = 0  # Records per control batch write
+    broadcast_queue_depth: int = 0  # Broadcast frames queued ahead of PA events
+    wasm_queue_depth: int = 0  # WASM requests queued ahead of the runtime
+
+
+@dataclass
+class DfuControlPacket(Packet):
+    """dfu_control_packet_t, 20 bytes"""
+
+    SIZE: ClassVar[int] = 20
+    MIN_SIZE: ClassVar[int] = 20
+    HEADER_SIZE: ClassVar[int] = 1
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('command', 'int', 'B', None),
+        ('param', 'bytes', None, 19),
+    )
+
+    command: int = 0  # DFU command opcode (DFU_CMD_*)
+    param: bytes = b''  # Command parameters (up to 19 bytes)
+
+
+@dataclass
+class DfuPacket(Packet):
+    """dfu_packet_t, 20 bytes"""
+
+    SIZE: ClassVar[int] = 20
+    MIN_SIZE: ClassVar[int] = 1
+    HEADER_SIZE: ClassVar[int] = 0
+    VARIABLE: ClassVar[bool] = True
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('data', 'bytes', None, 20),
+    )
+
+    data: bytes = b''  # Firmware data chunk (up to 20 bytes)
+
+
+@dataclass
+class SpriteUploadPacket(Packet):
+    """sprite_upload_packet_t, 36 bytes"""
+
+    SIZE: ClassVar[int] = 36
+    MIN_SIZE: ClassVar[int] = 36
+    HEADER_SIZE: ClassVar[int] = 36
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('sprite_id', 'int', 'H', None),
+        ('bitmap_data', 'bytes', None, 32),
+        ('crc16', 'int', 'H', None),
+    )
+
+    sprite_id: int = 0  # Sprite ID (0-65535)
+    bitmap_data: bytes = b''  # 16x16 monochrome bitmap (32 bytes)
+    crc16: int = 0  # CRC16 checksum of bitmap_data
+
+
+@dataclass
+class SpriteDownloadRequest(Packet):
+    """sprite_download_request_t, 2 bytes"""
+
+    SIZE: ClassVar[int] = 2
+    MIN_SIZE: ClassVar[int] = 2
+    HEADER_SIZE: ClassVar[int] = 2
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('sprite_id', 'int', 'H', None),
+    )
+
+    sprite_id: int = 0  # Requested sprite ID
+
+
+@dataclass
+class SpriteDownloadPacket(Packet):
+    """sprite_download_packet_t, 37 bytes"""
+
+    SIZE: ClassVar[int] = 37
+    MIN_SIZE: ClassVar[int] = 37
+    HEADER_SIZE: ClassVar[int] = 37
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('sprite_id', 'int', 'H', None),
+        ('bitmap_data', 'bytes', None, 32),
+        ('crc16', 'int', 'H', None),
+        ('status', 'int', 'B', None),
+    )
+
+    sprite_id: int = 0  # Sprite ID
+    bitmap_data: bytes = b''  # 16x16 monochrome bitmap (32 bytes)
+    crc16: int = 0  # CRC16 checksum of bitmap_data
+    status: int = 0  # Status (SPRITE_STATUS_*)
+
+
+@dataclass
+class SpriteRegistryStatus(Packet):
+    """sprite_registry_status_t, 12 bytes"""
+
+    SIZE: ClassVar[int] = 12
+    MIN_SIZE: ClassVar[int] = 12
+    HEADER_SIZE: ClassVar[int] = 12
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('total_sprites', 'int', 'H', None),
+        ('free_slots', 'int', 'H', None),
+        ('last_sprite_id', 'int', 'H', None),
+        ('registry_status', 'int', 'B', None),
+        ('last_operation', 'int', 'B', None),
+        ('crc_errors', 'int', 'H', None),
+        ('reserved', 'pad', None, 2),
+    )
+
+    total_sprites: int = 0  # Total sprites in registry
+    free_slots: int = 0  # Available sprite slots
+    last_sprite_id: int = 0  # Last uploaded sprite ID
+    registry_status: int = 0  # Registry status (REGISTRY_STATUS_*)
+    last_operation: int = 0  # Last operation performed
+    crc_errors: int = 0  # Total CRC errors encountered
+
+
+@dataclass
+class SpriteVerifyRequest(Packet):
+    """sprite_verify_request_t, 2 bytes"""
+
+    SIZE: ClassVar[int] = 2
+    MIN_SIZE: ClassVar[int] = 2
+    HEADER_SIZE: ClassVar[int] = 2
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('sprite_id', 'int', 'H', None),
+    )
+
+    sprite_id: int = 0  # Sprite ID to verify
+
+
+@dataclass
+class SpriteVerifyResponse(Packet):
+    """sprite_verify_response_t, 8 bytes"""
+
+    SIZE: ClassVar[int] = 8
+    MIN_SIZE: ClassVar[int] = 8
+    HEADER_SIZE: ClassVar[int] = 8
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('sprite_id', 'int', 'H', None),
+        ('stored_crc16', 'int', 'H', None),
+        ('calculated_crc16', 'int', 'H', None),
+        ('verification_status', 'int', 'B', None),
+        ('reserved', 'pad', None, 1),
+    )
+
+    sprite_id: int = 0  # Verified sprite ID
+    stored_crc16: int = 0  # CRC16 stored with sprite
+    calculated_crc16: int = 0  # CRC16 calculated from current data
+    verification_status: int = 0  # Verification result (VERIFY_STATUS_*)
+
+
+@dataclass
+class StatusBroadcastBlock(Packet):
+    """status_broadcast_block_t, 16 bytes"""
+
+    SIZE: ClassVar[int] = 16
+    MIN_SIZE: ClassVar[int] = 16
+    HEADER_SIZE: ClassVar[int] = 16
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('version', 'int', 'B', None),
+        ('seq', 'int', 'B', None),
+        ('device_status', 'int', 'B', None),
+        ('flags', 'int', 'B', None),
+        ('connections', 'int', 'B', None),
+        ('wasm_status', 'int', 'B', None),
+        ('last_result', 'int', 'i', None),
+        ('registry_generation', 'int', 'H', None),
+        ('sprite_count', 'int', 'H', None),
+        ('dfu_state', 'int', 'B', None),
+        ('dfu_kb', 'int', 'B', None),
+    )
+
+    version: int = 0  # STATUS_BROADCAST_VERSION
+    seq: int = 0  # Incremented whenever the block changes
+    device_status: int = 0  # DEVICE_STATUS_* from the Control Service
+    flags: int = 0  # STATUS_FLAG_*
+    connections: int = 0  # Active connections
+    wasm_status: int = 0  # WASM_STATUS_*
+    last_result: int = 0  # Return value of the last WASM call
+    registry_generation: int = 0  # Sprite registry generation counter
+    sprite_count: int = 0  # Sprites in the registry
+    dfu_state: int = 0  # DFU_STATE_*
+    dfu_kb: int = 0  # DFU bytes received in KB (saturates at 255)
+
+
+@dataclass
+class WasmUploadPacket(Packet):
+    """wasm_upload_packet_t, 252 bytes"""
+
+    SIZE: ClassVar[int] = 252
+    MIN_SIZE: ClassVar[int] = 8
+    HEADER_SIZE: ClassVar[int] = 8
+    VARIABLE: ClassVar[bool] = True
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('cmd', 'int', 'B', None),
+        ('sequence', 'int', 'B', None),
+        ('chunk_size', 'int', 'H', None),
+        ('total_size', 'int', 'I', None),
+        ('data', 'bytes', None, 244),
+    )
+
+    cmd: int = 0  # Upload command
+    sequence: int = 0  # Packet sequence number
+    chunk_size: int = 0  # Size of data in this chunk
+    total_size: int = 0  # Total WASM binary size (in first packet)
+    data: bytes = b''  # WASM bytecode chunk
+
+
+@dataclass
+class WasmExecutePacket(Packet):
+    """wasm_execute_packet_t, 52 bytes"""
+
+    SIZE: ClassVar[int] = 52
+    MIN_SIZE: ClassVar[int] = 52
+    HEADER_SIZE: ClassVar[int] = 36
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('function_name', 'str', None, 32),
+        ('arg_count', 'count', 'I', 'args'),
+        ('args', 'ints', 'i', 4),
+    )
+    COMPACT: ClassVar[Tuple[Tuple[str, int], ...]] = (
+        ('function_name', WASM_EXECUTE_FIELD_FUNCTION_NAME),
+        ('args', WASM_EXECUTE_FIELD_ARGS),
+    )
+
+    function_name: str = ''  # Function to call
+    args: List[int] = field(default_factory=list)  # Function arguments (max 4)
+
+
+@dataclass
+class WasmStatusPacket(Packet):
+    """wasm_status_packet_t, 18 bytes"""
+
+    SIZE: ClassVar[int] = 18
+    MIN_SIZE: ClassVar[int] = 18
+    HEADER_SIZE: ClassVar[int] = 18
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('status', 'int', 'B', None),
+        ('error_code', 'int', 'B', None),
+        ('bytes_received', 'int', 'H', None),
+        ('total_size', 'int', 'I', None),
+        ('uptime', 'int', 'I', None),
+        ('module_crc32', 'int', 'I', None),
+        ('reserved', 'pad', None, 2),
+    )
+
+    status: int = 0  # Current WASM status
+    error_code: int = 0  # Last error code
+    bytes_received: int = 0  # Bytes received so far
+    total_size: int = 0  # Total expected size
+    uptime: int = 0  # System uptime
+    module_crc32: int = 0  # CRC-32 of the received module, 0 if none
+
+
+@dataclass
+class WasmResultPacket(Packet):
+    """wasm_result_packet_t, 50 bytes"""
+
+    SIZE: ClassVar[int] = 50
+    MIN_SIZE: ClassVar[int] = 50
+    HEADER_SIZE: ClassVar[int] = 50
+    LAYOUT: ClassVar[Tuple[Tuple[str, str, Any, Any], ...]] = (
+        ('status', 'int', 'B', None),
+        ('error_code', 'int', 'B', None),
+        ('return_value', 'int', 'i', None),
+        ('execution_time_us', 'int', 'I', None),
+        ('result_data', 'bytes', None, 32),
+        ('timestamp_us', 'int', 'Q', None),
+    )
+
+    status: int = 0  # Execution status
+    error_code: int = 0  # Error code if failed
+    return_value: int = 0  # Function return value
+    execution_time_us: int = 0  # Execution time in microseconds
+    result_data: bytes = b''  # Additional result data
+    timestamp_us: int = 0  # Completion time in the client timebase
+
+
+# ============================================================================
+# CLIENT
+# ============================================================================
+
+class BLEProtocolClient:
+    """Typed access to every characteristic of a connected BleakClient"""
+
+    def __init__(self, client: BleakClient):
+        self.client = client
+        self.encoding = COMPACT_ENCODING_LEGACY     # Every connection starts out legacy
+        self.capabilities = None
+
+    async def configure(self) -> 'DeviceCapabilities':
+        """Read the device capabilities once and switch to the best paths it supports"""
+        self.capabilities = await self.read_device_capabilities()
+        if self.capabilities.protocol_fingerprint != FINGERPRINT:
+            warnings.warn(f"Firmware protocol 0x{self.capabilities.protocol_fingerprint:08X}, "
+                          f"client generated for 0x{FINGERPRINT:08X}")
+        if self.capabilities.encodings & (1 << COMPACT_ENCODING_LATEST):
+            await self.set_encoding(COMPACT_ENCODING_LATEST)
+        return self.capabilities
+
+    async def set_encoding(self, encoding: int) -> int:
+        """Switch this connection's writes to encoding (CMD_SET_ENCODING)
+
+        Returns the highest encoding the firmware supports.
+        """
+        await self.write_control_command(ControlCommandPacket(cmd_id=CMD_SET_ENCODING,
+                                                              param1=encoding))
+        response = await self.read_control_response()
+        if response.cmd_id != CMD_SET_ENCODING or response.status != RESPONSE_SUCCESS:
+            raise ValueError(f"Encoding {encoding} refused (status {response.status})")
+        self.encoding = response.result[ENCODING_RESULT_ACTIVE]
+        return response.result[ENCODING_RESULT_LATEST]
+
+    async def _read(self, uuid: str, packet_type):
+        return packet_type.unpack(await self.client.read_gatt_char(uuid))
+
+    async def _write(self, uuid: str, packet: Packet, response: bool) -> None:
+        await self.client.write_gatt_char(uuid, packet.encode(self.encoding), response=response)
+
+    async def _write_batches(self, uuid: str, packet_type, items, response: bool,
+                             fields: Dict[str, Any]) -> int:
+        count = 0
+        for packet in packet_type.batches(items, **fields):
+            await self._write(uuid, packet, response)
+            count += 1
+        return count
+
+    async def _subscribe(self, uuid: str, packet_type, callback: Callable[[Any], None]) -> None:
+        await self.client.start_notify(uuid, lambda _, data: callback(packet_type.unpack(data)))
+
+    async def write_broadcast_frame(self, packet: BroadcastFramePacket, response: bool = True) -> None:
+        await self._write(BROADCAST_FRAME_UUID, packet, response)
+
+    async def read_broadcast_status(self) -> BroadcastStatusPacket:
+        return await self._read(BROADCAST_STATUS_UUID, BroadcastStatusPacket)
+
+    async def write_control_command(self, packet: ControlCommandPacket, response: bool = True) -> None:
+        await self._write(CONTROL_COMMAND_UUID, packet, response)
+
+    async def read_control_response(self) -> ControlResponsePacket:
+        return await self._read(CONTROL_RESPONSE_UUID, ControlResponsePacket)
+
+    async def subscribe_control_response(self, callback: Callable[[ControlResponsePacket], None]) -> None:
+        await self._subscribe(CONTROL_RESPONSE_UUID, ControlResponsePacket, callback)
+
+    async def unsubscribe_control_response(self) -> None:
+        await self.client.stop_notify(CONTROL_RESPONSE_UUID)
+
+    async def read_control_status(self) -> ControlStatusPacket:
+        return await self._read(CONTROL_STATUS_UUID, ControlStatusPacket)
+
+    async def subscribe_control_status(self, callback: Callable[[ControlStatusPacket], None]) -> None:
+        await self._subscribe(CONTROL_STATUS_UUID, ControlStatusPacket, callback)
+
+    async def unsubscribe_control_status(self) -> None:
+        await self.client.stop_notify(CONTROL_STATUS_UUID)
+
+    async def write_control_batch(self, packet: ControlBatchPacket, response: bool = True) -> None:
+        await self._write(CONTROL_BATCH_UUID, packet, response)
+
+    async def write_control_batch_all(self, records: Iterable[ControlBatchRecord], response: bool = True,
+                               **fields) -> int:
+        """Write records in as few packets as possible, return the packet count"""
+        return await self._write_batches(CONTROL_BATCH_UUID, ControlBatchPacket, records, response, fields)
+
+    async def read_control_batch_response(self) -> ControlBatchResponse:
+        return await self._read(CONTROL_BATCH_RESPONSE_UUID, ControlBatchResponse)
+
+    async def subscribe_control_batch_response(self, callback: Callable[[ControlBatchResponse], None]) -> None:
+        await self._subscribe(CONTROL_BATCH_RESPONSE_UUID, ControlBatchResponse, callback)
+
+    async def unsubscribe_control_batch_response(self) -> None:
+        await self.client.stop_notify(CONTROL_BATCH_RESPONSE_UUID)
+
+    async def read_control_telemetry(self) -> ControlTelemetryPacket:
+        return await self._read(CONTROL_TELEMETRY_UUID, ControlTelemetryPacket)
+
+    async def subscribe_control_telemetry(self, callback: Callable[[ControlTelemetryPacket], None]) -> None:
+        await self._subscribe(CONTROL_TELEMETRY_UUID, ControlTelemetryPacket, callback)
+
+    async def unsubscribe_control_telemetry(self) -> None:
+        await self.client.stop_notify(CONTROL_TELEMETRY_UUID)
+
+    async def read_control_benchmark(self) -> ControlBenchmarkResult:
+        return await self._read(CONTROL_BENCHMARK_UUID, ControlBenchmarkResult)
+
+    async def subscribe_control_benchmark(self, callback: Callable[[ControlBenchmarkResult], None]) -> None:
+        await self._subscribe(CONTROL_BENCHMARK_UUID, ControlBenchmarkResult, callback)
+
+    async def unsubscribe_control_benchmark(self) -> None:
+        await self.client.stop_notify(CONTROL_BENCHMARK_UUID)
+
+    async def read_control_time_sync(self) -> ControlTimeSyncResponse:
+        return await self._read(CONTROL_TIME_SYNC_UUID, ControlTimeSyncResponse)
+
+    async def write_control_time_sync(self, packet: ControlTimeSyncRequest, response: bool = True) -> None:
+        await self._write(CONTROL_TIME_SYNC_UUID, packet, response)
+
+    async def subscribe_control_time_sync(self, callback: Callable[[ControlTimeSyncResponse], None]) -> None:
+        await self._subscribe(CONTROL_TIME_SYNC_UUID, ControlTimeSyncResponse, callback)
+
+    async def unsubscribe_control_time_sync(self) -> None:
+        await self.client.stop_notify(CONTROL_TIME_SYNC_UUID)
+
+    async def read_control_handler_stats(self) -> ControlHandlerStatsPage:
+        return await self._read(CONTROL_HANDLER_STATS_UUID, ControlHandlerStatsPage)
+
+    async def write_control_handler_stats(self, packet: ControlHandlerStatsSelect, response: bool = True) -> None:
+        await self._write(CONTROL_HANDLER_STATS_UUID, packet, response)
+
+    async def read_control_trace(self) -> ControlTracePage:
+        return await self._read(CONTROL_TRACE_UUID, ControlTracePage)
+
+    async def write_control_trace(self, packet: ControlTraceSelect, response: bool = True) -> None:
+        await self._write(CONTROL_TRACE_UUID, packet, response)
+
+    async def read_control_memory(self) -> ControlMemoryPacket:
+        return await self._read(CONTROL_MEMORY_UUID, ControlMemoryPacket)
+
+    async def write_control_memory(self, packet: ControlMemorySelect, response: bool = True) -> None:
+        await self._write(CONTROL_MEMORY_UUID, packet, response)
+
+    async def write_data_upload(self, packet: DataUploadPacket, response: bool = True) -> None:
+        await self._write(DATA_UPLOAD_UUID, packet, response)
+
+    async def read_data_download(self) -> DataDownloadPacket:
+        return await self._read(DATA_DOWNLOAD_UUID, DataDownloadPacket)
+
+    async def subscribe_data_download(self, callback: Callable[[DataDownloadPacket], None]) -> None:
+        await self._subscribe(DATA_DOWNLOAD_UUID, DataDownloadPacket, callback)
+
+    async def unsubscribe_data_download(self) -> None:
+        await self.client.stop_notify(DATA_DOWNLOAD_UUID)
+
+    async def read_data_transfer_status(self) -> DataTransferStatusPacket:
+        return await self._read(DATA_TRANSFER_STATUS_UUID, DataTransferStatusPacket)
+
+    async def subscribe_data_transfer_status(self, callback: Callable[[DataTransferStatusPacket], None]) -> None:
+        await self._subscribe(DATA_TRANSFER_STATUS_UUID, DataTransferStatusPacket, callback)
+
+    async def unsubscribe_data_transfer_status(self) -> None:
+        await self.client.stop_notify(DATA_TRANSFER_STATUS_UUID)
+
+    async def read_dis_manufacturer_name(self) -> DeviceInfoString:
+        return await self._read(DIS_MANUFACTURER_NAME_UUID, DeviceInfoString)
+
+    async def read_dis_model_number(self) -> DeviceInfoString:
+        return await self._read(DIS_MODEL_NUMBER_UUID, DeviceInfoString)
+
+    async def read_dis_firmware_revision(self) -> DeviceInfoString:
+        return await self._read(DIS_FIRMWARE_REVISION_UUID, DeviceInfoString)
+
+    async def read_dis_hardware_revision(self) -> DeviceInfoString:
+        return await self._read(DIS_HARDWARE_REVISION_UUID, DeviceInfoString)
+
+    async def read_dis_software_revision(self) -> DeviceInfoString:
+        return await self._read(DIS_SOFTWARE_REVISION_UUID, DeviceInfoString)
+
+    async def read_device_capabilities(self) -> DeviceCapabilities:
+        return await self._read(DEVICE_CAPABILITIES_UUID, DeviceCapabilities)
+
+    async def write_dfu_control_point(self, packet: DfuControlPacket, response: bool = True) -> None:
+        await self._write(DFU_CONTROL_POINT_UUID, packet, response)
+
+    async def write_dfu_packet(self, packet: DfuPacket, response: bool = False) -> None:
+        await self._write(DFU_PACKET_UUID, packet, response)
+
+    async def write_sprite_upload(self, packet: SpriteUploadPacket, response: bool = True) -> None:
+        await self._write(SPRITE_UPLOAD_UUID, packet, response)
+
+    async def write_sprite_download_request(self, packet: SpriteDownloadRequest, response: bool = True) -> None:
+        await self._write(SPRITE_DOWNLOAD_REQUEST_UUID, packet, response)
+
+    async def read_sprite_download_response(self) -> SpriteDownloadPacket:
+        return await self._read(SPRITE_DOWNLOAD_RESPONSE_UUID, SpriteDownloadPacket)
+
+    async def subscribe_sprite_download_response(self, callback: Callable[[SpriteDownloadPacket], None]) -> None:
+        await self._subscribe(SPRITE_DOWNLOAD_RESPONSE_UUID, SpriteDownloadPacket, callback)
+
+    async def unsubscribe_sprite_download_response(self) -> None:
+        await self.client.stop_notify(SPRITE_DOWNLOAD_RESPONSE_UUID)
+
+    async def read_sprite_registry_status(self) -> SpriteRegistryStatus:
+        return await self._read(SPRITE_REGISTRY_STATUS_UUID, SpriteRegistryStatus)
+
+    async def subscribe_sprite_registry_status(self, callback: Callable[[SpriteRegistryStatus], None]) -> None:
+        await self._subscribe(SPRITE_REGISTRY_STATUS_UUID, SpriteRegistryStatus, callback)
+
+    async def unsubscribe_sprite_registry_status(self) -> None:
+        await self.client.stop_notify(SPRITE_REGISTRY_STATUS_UUID)
+
+    async def write_sprite_verify_request(self, packet: SpriteVerifyRequest, response: bool = True) -> None:
+        await self._write(SPRITE_VERIFY_REQUEST_UUID, packet, response)
+
+    async def read_sprite_verify_response(self) -> SpriteVerifyResponse:
+        return await self._read(SPRITE_VERIFY_RESPONSE_UUID, SpriteVerifyResponse)
+
+    async def subscribe_sprite_verify_response(self, callback: Callable[[SpriteVerifyResponse], None]) -> None:
+        await self._subscribe(SPRITE_VERIFY_RESPONSE_UUID, SpriteVerifyResponse, callback)
+
+    async def unsubscribe_sprite_verify_response(self) -> None:
+        await self.client.stop_notify(SPRITE_VERIFY_RESPONSE_UUID)
+
+    async def write_wasm_upload(self, packet: WasmUploadPacket, response: bool = True) -> None:
+        await self._write(WASM_UPLOAD_UUID, packet, response)
+
+    async def write_wasm_execute(self, packet: WasmExecutePacket, response: bool = True) -> None:
+        await self._write(WASM_EXECUTE_UUID, packet, response)
+
+    async def read_wasm_status(self) -> WasmStatusPacket:
+        return await self._read(WASM_STATUS_UUID, WasmStatusPacket)
+
+    async def subscribe_wasm_status(self, callback: Callable[[WasmStatusPacket], None]) -> None:
+        await self._subscribe(WASM_STATUS_UUID, WasmStatusPacket, callback)
+
+    async def unsubscribe_wasm_status(self) -> None:
+        await self.client.stop_notify(WASM_STATUS_UUID)
+
+    async def read_wasm_result(self) -> WasmResultPacket:
+        return await self._read(WASM_RESULT_UUID, WasmResultPacket)
+
+    async def subscribe_wasm_result(self, callback: Callable[[WasmResultPacket], None]) -> None:
+        await self._subscribe(WASM_RESULT_UUID, WasmResultPacket, callback)
+
+    async def unsubscribe_wasm_result(self) -> None:
+        await self.client.stop_notify(WASM_RESULT_UUID)
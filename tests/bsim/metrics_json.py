@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+Collect BabbleSim METRICS lines into JSON
+
+Testers print one line per measurement, e.g.
+
+    METRICS scenario=data_stream bytes=57344 duration_ms=2710 p50_us=30012 ...
+
+This reads the tester logs and writes the lines as a list of objects, with
+numeric values as numbers, plus the suite name and the commit measured.
+
+    python3 metrics_json.py perf_suite perf_suite/central.log -o perf_suite/results.json
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+METRICS_RE = re.compile(r'METRICS ((?:\S+=\S+\s*)+)$')
+
+
+def parse_value(text):
+    """Integers and decimals become numbers, anything else stays a string"""
+    for convert in (int, float):
+        try:
+            return convert(text)
+        except ValueError:
+            pass
+    return text
+
+
+def parse_metrics(lines):
+    """Return one dict per METRICS line, in log order"""
+    results = []
+    for line in lines:
+        match = METRICS_RE.search(line.rstrip())
+        if match:
+            pairs = (item.split('=', 1) for item in match.group(1).split())
+            results.append({key: parse_value(value) for key, value in pairs})
+    return results
+
+
+def git_commit():
+    try:
+        return subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], capture_output=True,
+                              text=True, check=True, cwd=Path(__file__).parent).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('suite', help="Name recorded in the output")
+    parser.add_argument('logs', nargs='+', type=Path, help="Tester logs")
+    parser.add_argument('-o', '--output', type=Path, help="JSON output (default stdout)")
+    args = parser.parse_args()
+
+    results = []
+    for log in args.logs:
+        results += parse_metrics(log.read_text(errors='replace').splitlines())
+
+    report = json.dumps({'suite': args.suite, 'commit': git_commit(), 'metrics': results},
+                        indent=2)
+    if args.output:
+        args.output.write_text(report + "\n")
+        print(f"Wrote {len(results)} results to {args.output}")
+    else:
+        print(report)
+    return 0 if results else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
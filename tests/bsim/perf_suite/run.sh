@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+#
+# End-to-end performance suite in BabbleSim
+#
+# Device 0 runs the firmware and device 1 is a central that runs the WASM
+# upload / execute, sprite atlas, data streaming and DFU scenarios over one
+# connection. Each scenario prints a METRICS line with throughput, latency
+# percentiles and firmware CPU load; the lines are also written as JSON.
+#
+# Usage: ./run.sh [scenario ...]
+#        OUTPUT=results.json ./run.sh wasm_upload wasm_execute
+
+set -ue
+
+: "${ZEPHYR_BASE:?ZEPHYR_BASE must be set}"
+: "${BSIM_OUT_PATH:?BSIM_OUT_PATH must be set}"
+: "${BSIM_COMPONENTS_PATH:?BSIM_COMPONENTS_PATH must be set}"
+
+test_dir=$(cd "$(dirname "$0")" && pwd)
+repo_dir=$(cd "${test_dir}/../../.." && pwd)
+bin_dir=${BSIM_OUT_PATH}/bin
+
+SIM_LENGTH=${SIM_LENGTH:-300e6}
+OUTPUT=${OUTPUT:-${test_dir}/results.json}
+FIRMWARE_BOARD=${FIRMWARE_BOARD:-nrf5340bsim_nrf5340_cpuapp}
+TESTER_BOARD=${TESTER_BOARD:-nrf52_bsim}
+simulation_id=perf_suite
+
+firmware_exe=${bin_dir}/bs_${FIRMWARE_BOARD}_my5340_app
+tester_exe=${bin_dir}/bs_${TESTER_BOARD}_perf_suite
+
+west build -p auto -b "${FIRMWARE_BOARD}" -d "${repo_dir}/build_bsim" "${repo_dir}"
+cp "${repo_dir}/build_bsim/zephyr/zephyr.exe" "${firmware_exe}"
+
+west build -p auto -b "${TESTER_BOARD}" -d "${test_dir}/build" "${test_dir}"
+cp "${test_dir}/build/zephyr/zephyr.exe" "${tester_exe}"
+
+cd "${bin_dir}"
+pids=()
+
+# The firmware never passes or fails on its own; it runs until the
+# simulation ends
+"${firmware_exe}" -s=${simulation_id} -d=0 -rs=1 > "${test_dir}/firmware.log" 2>&1 &
+
+"${tester_exe}" -s=${simulation_id} -d=1 -rs=2 -testid=central ${1+-argstest "$@"} \
+    > "${test_dir}/central.log" 2>&1 &
+pids+=($!)
+
+./bs_2G4_phy_v1 -s=${simulation_id} -D=2 -sim_length="${SIM_LENGTH}" &
+pids+=($!)
+
+rc=0
+for pid in "${pids[@]}"; do
+    wait "${pid}" || rc=1
+done
+wait
+
+grep -h "METRICS" "${test_dir}/central.log" || true
+python3 "${test_dir}/../metrics_json.py" perf_suite "${test_dir}/central.log" -o "${OUTPUT}" || rc=1
+exit ${rc}
@@ -0,0 +1,838 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bstests.h"
+#include "bsim_args_runner.h"
+
+#include "control_service.h"
+#include "data_service.h"
+#include "dfu_service.h"
+#include "sprite_service.h"
+#include "wasm_service.h"
+
+/**
+ * @file main.c
+ * @brief BabbleSim end-to-end performance suite
+ *
+ * Device 0 runs the firmware and device 1 is a scripted central. The
+ * central connects once and runs each scenario in turn over real
+ * simulated radio timing:
+ *
+ * - wasm_upload:  module padded to MODULE_SIZE, written without response,
+ *                 until the WASM status reports it loaded
+ * - wasm_execute: add() calls, each timed from the execute write to the
+ *                 first result read that carries its return value
+ * - sprite_atlas: a full atlas of sprites, one write with response each
+ * - data_stream:  a burst written without response, then timed writes
+ *                 with response; data_read times downloads
+ * - dfu:          a mock image through the DFU control point and packets
+ *
+ * Each scenario prints one METRICS line with byte count, duration,
+ * throughput, latency percentiles and the firmware's CPU load over the
+ * scenario, read from Control telemetry. run.sh turns the lines into JSON.
+ */
+
+/* ============================================================================
+ * TEST PARAMETERS
+ * ============================================================================ */
+
+#define FIRMWARE_NAME           "Dan5340BLE"
+#define MODULE_SIZE             4096    /* Bytes of the uploaded module */
+#define EXECUTE_CALLS           100
+#define ATLAS_SPRITES           128
+#define STREAM_SIZE             (32 * 1024)
+#define LATENCY_SAMPLES         100     /* Timed writes and reads per data scenario */
+#define DFU_IMAGE_SIZE          (16 * 1024)
+#define CONN_INTERVAL           24      /* 30 ms, in 1.25 ms units */
+#define POLL_INTERVAL_MS        10
+#define RESULT_TIMEOUT_MS       5000
+#define WAIT_TIME_S             300     /* Simulated time before the test is failed */
+
+#define MAX_SAMPLES             MAX(MAX(EXECUTE_CALLS, ATLAS_SPRITES), LATENCY_SAMPLES)
+
+extern enum bst_result_t bst_result;
+
+#define FAIL(...)                                       \
+    do {                                                \
+        bst_result = Failed;                            \
+        bs_trace_error_time_line(__VA_ARGS__);          \
+    } while (0)
+
+#define PASS(...)                                       \
+    do {                                                \
+        bst_result = Passed;                            \
+        bs_trace_info_time(1, __VA_ARGS__);             \
+    } while (0)
+
+/* ============================================================================
+ * MODULE
+ * ============================================================================ */
+
+/* add(i32, i32) -> i32, exported as "add" */
+static const uint8_t add_module[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,
+    0x01, 0x07, 0x01, 0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f,
+    0x03, 0x02, 0x01, 0x00,
+    0x07, 0x07, 0x01, 0x03, 'a', 'd', 'd', 0x00, 0x00,
+    0x0a, 0x09, 0x01, 0x07, 0x00, 0x20, 0x00, 0x20, 0x01, 0x6a, 0x0b,
+};
+
+static uint8_t module[MODULE_SIZE];
+
+/**
+ * @brief Pad the add module with a custom section up to MODULE_SIZE
+ *
+ * The runtime skips custom sections, so the module still loads while the
+ * transfer is as long as a realistic application module.
+ */
+static void build_module(void)
+{
+    static const char name[] = "pad";
+    uint32_t offset = sizeof(add_module);
+    /* Section id, 2-byte LEB128 size, name length, name */
+    uint32_t section_size = MODULE_SIZE - offset - 3;
+
+    memcpy(module, add_module, sizeof(add_module));
+    module[offset++] = 0x00;
+    module[offset++] = 0x80 | (section_size & 0x7F);
+    module[offset++] = section_size >> 7;
+    module[offset++] = sizeof(name) - 1;
+    memcpy(&module[offset], name, sizeof(name) - 1);
+    offset += sizeof(name) - 1;
+    memset(&module[offset], 0xA5, MODULE_SIZE - offset);
+}
+
+/* ============================================================================
+ * METRICS
+ * ============================================================================ */
+
+typedef struct {
+    uint32_t samples[MAX_SAMPLES];
+    uint16_t count;
+} latency_t;
+
+static latency_t latency;
+static int64_t scenario_start_us;
+
+static int64_t now_us(void)
+{
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+static void latency_add(latency_t *lat, int64_t start_us)
+{
+    if (lat->count < ARRAY_SIZE(lat->samples)) {
+        lat->samples[lat->count++] = now_us() - start_us;
+    }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile; sorts the samples in place
+ */
+static uint32_t latency_percentile(latency_t *lat, int percent)
+{
+    if (lat->count == 0) {
+        return 0;
+    }
+    qsort(lat->samples, lat->count, sizeof(lat->samples[0]), compare_u32);
+    return lat->samples[DIV_ROUND_UP(lat->count * percent, 100) - 1];
+}
+
+/* ============================================================================
+ * CONNECTION
+ * ============================================================================ */
+
+enum {
+    CHRC_WASM_UPLOAD,
+    CHRC_WASM_EXECUTE,
+    CHRC_WASM_STATUS,
+    CHRC_WASM_RESULT,
+    CHRC_SPRITE_UPLOAD,
+    CHRC_SPRITE_STATUS,
+    CHRC_DATA_UPLOAD,
+    CHRC_DATA_DOWNLOAD,
+    CHRC_DATA_STATUS,
+    CHRC_DFU_CONTROL,
+    CHRC_DFU_PACKET,
+    CHRC_TELEMETRY,
+    CHRC_MEMORY,
+    CHRC_COUNT,
+};
+
+static struct {
+    const struct bt_uuid *uuid;
+    uint16_t handle;
+} chrcs[CHRC_COUNT] = {
+    [CHRC_WASM_UPLOAD] = { WASM_UPLOAD_UUID },
+    [CHRC_WASM_EXECUTE] = { WASM_EXECUTE_UUID },
+    [CHRC_WASM_STATUS] = { WASM_STATUS_UUID },
+    [CHRC_WASM_RESULT] = { WASM_RESULT_UUID },
+    [CHRC_SPRITE_UPLOAD] = { SPRITE_UPLOAD_UUID },
+    [CHRC_SPRITE_STATUS] = { SPRITE_REGISTRY_STATUS_UUID },
+    [CHRC_DATA_UPLOAD] = { DATA_UPLOAD_UUID },
+    [CHRC_DATA_DOWNLOAD] = { DATA_DOWNLOAD_UUID },
+    [CHRC_DATA_STATUS] = { DATA_TRANSFER_STATUS_UUID },
+    [CHRC_DFU_CONTROL] = { DFU_CONTROL_POINT_UUID },
+    [CHRC_DFU_PACKET] = { DFU_PACKET_UUID },
+    [CHRC_TELEMETRY] = { CONTROL_TELEMETRY_UUID },
+    [CHRC_MEMORY] = { CONTROL_MEMORY_UUID },
+};
+
+static struct bt_conn *fw_conn;
+static uint8_t gatt_err;
+static uint8_t read_buf[BT_ATT_MAX_ATTRIBUTE_LEN];
+static uint16_t read_len;
+
+static K_SEM_DEFINE(connected_sem, 0, 1);
+static K_SEM_DEFINE(gatt_sem, 0, 1);
+
+static bool match_name(struct bt_data *data, void *user_data)
+{
+    bool *found = user_data;
+
+    if (data->type == BT_DATA_NAME_COMPLETE &&
+        data->data_len == strlen(FIRMWARE_NAME) &&
+        memcmp(data->data, FIRMWARE_NAME, data->data_len) == 0) {
+        *found = true;
+        return false;
+    }
+    return true;
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+                         struct net_buf_simple *ad)
+{
+    bool found = false;
+    int err;
+
+    if (fw_conn) {
+        return;
+    }
+
+    bt_data_parse(ad, match_name, &found);
+    if (!found) {
+        return;
+    }
+
+    err = bt_le_scan_stop();
+    if (err) {
+        FAIL("Failed to stop scanning (err %d)\n", err);
+        return;
+    }
+
+    err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN,
+                            BT_LE_CONN_PARAM(CONN_INTERVAL, CONN_INTERVAL, 0, 400), &fw_conn);
+    if (err) {
+        FAIL("Failed to connect (err %d)\n", err);
+    }
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    if (err) {
+        FAIL("Connection failed (err 0x%02x)\n", err);
+        return;
+    }
+    k_sem_give(&connected_sem);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    if (bst_result != Passed) {
+        FAIL("Disconnected during the suite (reason 0x%02x)\n", reason);
+    }
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+};
+
+static void mtu_exchanged(struct bt_conn *conn, uint8_t err,
+                          struct bt_gatt_exchange_params *params)
+{
+    gatt_err = err;
+    k_sem_give(&gatt_sem);
+}
+
+static uint8_t discover_func(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                             struct bt_gatt_discover_params *params)
+{
+    if (!attr) {
+        k_sem_give(&gatt_sem);
+        return BT_GATT_ITER_STOP;
+    }
+
+    const struct bt_gatt_chrc *chrc = attr->user_data;
+
+    for (int i = 0; i < CHRC_COUNT; i++) {
+        if (bt_uuid_cmp(chrc->uuid, chrcs[i].uuid) == 0) {
+            chrcs[i].handle = chrc->value_handle;
+        }
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t read_func(struct bt_conn *conn, uint8_t err, struct bt_gatt_read_params *params,
+                         const void *data, uint16_t length)
+{
+    gatt_err = err;
+    if (!err && data) {
+        read_len = MIN(length, sizeof(read_buf));
+        memcpy(read_buf, data, read_len);
+    }
+    k_sem_give(&gatt_sem);
+    return BT_GATT_ITER_STOP;
+}
+
+static void write_func(struct bt_conn *conn, uint8_t err, struct bt_gatt_write_params *params)
+{
+    gatt_err = err;
+    k_sem_give(&gatt_sem);
+}
+
+/**
+ * @brief Read a characteristic into @p out
+ *
+ * A read also fences: it completes after every write queued before it.
+ */
+static int gatt_read(int chrc, void *out, uint16_t size)
+{
+    static struct bt_gatt_read_params read_params;
+
+    read_params.func = read_func;
+    read_params.handle_count = 1;
+    read_params.single.handle = chrcs[chrc].handle;
+    read_params.single.offset = 0;
+
+    read_len = 0;
+    int err = bt_gatt_read(fw_conn, &read_params);
+    if (err) {
+        return err;
+    }
+    k_sem_take(&gatt_sem, K_FOREVER);
+    if (out) {
+        memset(out, 0, size);
+        memcpy(out, read_buf, MIN(read_len, size));
+    }
+    return gatt_err;
+}
+
+static int gatt_write(int chrc, const void *data, uint16_t len)
+{
+    static struct bt_gatt_write_params write_params;
+
+    write_params.func = write_func;
+    write_params.handle = chrcs[chrc].handle;
+    write_params.offset = 0;
+    write_params.data = data;
+    write_params.length = len;
+
+    int err = bt_gatt_write(fw_conn, &write_params);
+    if (err) {
+        return err;
+    }
+    k_sem_take(&gatt_sem, K_FOREVER);
+    return gatt_err;
+}
+
+static int gatt_write_nr(int chrc, const void *data, uint16_t len)
+{
+    return bt_gatt_write_without_response(fw_conn, chrcs[chrc].handle, data, len, false);
+}
+
+static int connect_to_firmware(void)
+{
+    static struct bt_gatt_exchange_params mtu_params = { .func = mtu_exchanged };
+    static struct bt_gatt_discover_params discover_params;
+    int err;
+
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, device_found);
+    if (err) {
+        FAIL("Scanning failed to start (err %d)\n", err);
+        return err;
+    }
+    k_sem_take(&connected_sem, K_FOREVER);
+
+    err = bt_gatt_exchange_mtu(fw_conn, &mtu_params);
+    if (err) {
+        FAIL("MTU exchange failed to start (err %d)\n", err);
+        return err;
+    }
+    k_sem_take(&gatt_sem, K_FOREVER);
+
+    discover_params.uuid = NULL;
+    discover_params.func = discover_func;
+    discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+    discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+    discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+    err = bt_gatt_discover(fw_conn, &discover_params);
+    if (err) {
+        FAIL("Discovery failed to start (err %d)\n", err);
+        return err;
+    }
+    k_sem_take(&gatt_sem, K_FOREVER);
+
+    for (int i = 0; i < CHRC_COUNT; i++) {
+        if (!chrcs[i].handle) {
+            FAIL("Characteristic %d not found\n", i);
+            return -ENOENT;
+        }
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * SCENARIO FRAME
+ * ============================================================================ */
+
+/**
+ * @brief Start a scenario
+ *
+ * The telemetry read restarts the firmware's CPU load window, so the load
+ * read in scenario_end() covers exactly this scenario.
+ */
+static int scenario_begin(void)
+{
+    memset(&latency, 0, sizeof(latency));
+
+    int err = gatt_read(CHRC_TELEMETRY, NULL, 0);
+    if (err) {
+        FAIL("Telemetry read failed (err %d)\n", err);
+        return err;
+    }
+    scenario_start_us = now_us();
+    return 0;
+}
+
+/**
+ * @brief End a scenario and print its METRICS line
+ * @param extra Additional " key=value" pairs, may be empty
+ */
+static int scenario_end(const char *name, uint32_t bytes, const char *extra)
+{
+    int64_t duration_us = MAX(now_us() - scenario_start_us, 1);
+    control_telemetry_packet_t telemetry;
+
+    int err = gatt_read(CHRC_TELEMETRY, &telemetry, sizeof(telemetry));
+    if (err) {
+        FAIL("Telemetry read failed (err %d)\n", err);
+        return err;
+    }
+
+    printk("METRICS scenario=%s bytes=%u duration_ms=%u throughput_kbps=%u "
+           "samples=%u p50_us=%u p90_us=%u p99_us=%u max_us=%u cpu_permille=%u%s\n",
+           name, bytes, (uint32_t)(duration_us / 1000),
+           (uint32_t)((uint64_t)bytes * 8 * 1000 / duration_us),
+           latency.count, latency_percentile(&latency, 50), latency_percentile(&latency, 90),
+           latency_percentile(&latency, 99), latency_percentile(&latency, 100),
+           telemetry.cpu_load_permille, extra);
+    return 0;
+}
+
+/* ============================================================================
+ * SCENARIOS
+ * ============================================================================ */
+
+static int run_wasm_upload(void)
+{
+    static wasm_upload_packet_t packet;
+    const uint16_t header = offsetof(wasm_upload_packet_t, data);
+    uint16_t chunk_max = MIN(bt_gatt_get_mtu(fw_conn) - 3 - header, WASM_UPLOAD_CHUNK_SIZE);
+    wasm_status_packet_t status;
+    uint8_t sequence = 0;
+    int64_t sent_us;
+    char extra[32];
+    int err;
+
+    if (scenario_begin()) {
+        return -EIO;
+    }
+
+    for (uint32_t offset = 0; offset < MODULE_SIZE; offset += packet.chunk_size) {
+        packet.cmd = (offset == 0) ? WASM_CMD_START_UPLOAD : WASM_CMD_CONTINUE_UPLOAD;
+        packet.sequence = sequence++;
+        packet.chunk_size = MIN(chunk_max, MODULE_SIZE - offset);
+        packet.total_size = MODULE_SIZE;
+        memcpy(packet.data, &module[offset], packet.chunk_size);
+
+        err = gatt_write_nr(CHRC_WASM_UPLOAD, &packet, header + packet.chunk_size);
+        if (err) {
+            FAIL("Upload write failed (err %d)\n", err);
+            return err;
+        }
+    }
+    sent_us = now_us();
+
+    while (1) {
+        err = gatt_read(CHRC_WASM_STATUS, &status, sizeof(status));
+        if (err) {
+            FAIL("WASM status read failed (err %d)\n", err);
+            return err;
+        }
+        if (status.status == WASM_STATUS_ERROR) {
+            FAIL("Module failed to load (error %u)\n", status.error_code);
+            return -EIO;
+        }
+        if (status.status == WASM_STATUS_LOADED) {
+            break;
+        }
+        k_sleep(K_MSEC(POLL_INTERVAL_MS));
+    }
+
+    /* Time from the last chunk leaving the queue until the module is usable */
+    snprintk(extra, sizeof(extra), " load_ms=%u", (uint32_t)((now_us() - sent_us) / 1000));
+    return scenario_end("wasm_upload", MODULE_SIZE, extra);
+}
+
+static int run_wasm_execute(void)
+{
+    static wasm_execute_packet_t packet = {
+        .function_name = "add",
+        .arg_count = 2,
+    };
+    wasm_result_packet_t result;
+    uint64_t execution_us = 0;
+    char extra[48];
+    int err;
+
+    if (scenario_begin()) {
+        return -EIO;
+    }
+
+    for (int i = 0; i < EXECUTE_CALLS; i++) {
+        /* Each call returns a value no earlier call did, so a stale result is never taken */
+        packet.args[0] = i;
+        packet.args[1] = 1000;
+
+        int64_t start_us = now_us();
+
+        err = gatt_write(CHRC_WASM_EXECUTE, &packet, sizeof(packet));
+        if (err) {
+            FAIL("Execute write failed (err %d)\n", err);
+            return err;
+        }
+
+        /* Results are not notified; read back to back until this call's shows up */
+        do {
+            err = gatt_read(CHRC_WASM_RESULT, &result, sizeof(result));
+            if (err) {
+                FAIL("Result read failed (err %d)\n", err);
+                return err;
+            }
+            if (result.status == WASM_STATUS_ERROR) {
+                FAIL("add(%d, 1000) failed (error %u)\n", i, result.error_code);
+                return -EIO;
+            }
+            if (now_us() - start_us > RESULT_TIMEOUT_MS * 1000LL) {
+                FAIL("No result for add(%d, 1000)\n", i);
+                return -ETIMEDOUT;
+            }
+        } while (result.status != WASM_STATUS_COMPLETE || result.return_value != i + 1000);
+
+        latency_add(&latency, start_us);
+        execution_us += result.execution_time_us;
+    }
+
+    snprintk(extra, sizeof(extra), " calls=%u exec_avg_us=%u", EXECUTE_CALLS,
+             (uint32_t)(execution_us / EXECUTE_CALLS));
+    return scenario_end("wasm_execute", EXECUTE_CALLS * sizeof(packet), extra);
+}
+
+static int run_sprite_atlas(void)
+{
+    static sprite_upload_packet_t packet;
+    sprite_registry_status_t status;
+    int err;
+
+    if (scenario_begin()) {
+        return -EIO;
+    }
+
+    for (int i = 0; i < ATLAS_SPRITES; i++) {
+        packet.sprite_id = i;
+        for (int j = 0; j < SPRITE_DATA_SIZE; j++) {
+            packet.bitmap_data[j] = i ^ (j * 37);
+        }
+        /* CRC-16/CCITT as sprite_service_calculate_crc16() computes it */
+        packet.crc16 = crc16_itu_t(0xFFFF, packet.bitmap_data, SPRITE_DATA_SIZE);
+
+        int64_t start_us = now_us();
+
+        err = gatt_write(CHRC_SPRITE_UPLOAD, &packet, sizeof(packet));
+        if (err) {
+            FAIL("Sprite %d write failed (err %d)\n", i, err);
+            return err;
+        }
+        latency_add(&latency, start_us);
+    }
+
+    err = gatt_read(CHRC_SPRITE_STATUS, &status, sizeof(status));
+    if (err || status.total_sprites < ATLAS_SPRITES || status.crc_errors) {
+        FAIL("Registry holds %u sprites, %u CRC errors\n", status.total_sprites, status.crc_errors);
+        return -EIO;
+    }
+
+    return scenario_end("sprite_atlas", ATLAS_SPRITES * sizeof(packet), "");
+}
+
+static int run_data_stream(void)
+{
+    static uint8_t chunk[DATA_PACKET_SIZE_MAX];
+    uint16_t chunk_size = MIN(bt_gatt_get_mtu(fw_conn) - 3, DATA_PACKET_SIZE_MAX);
+    data_transfer_status_packet_t status;
+    uint32_t bytes = 0;
+    int err;
+
+    for (int i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = i + 1;
+    }
+
+    if (scenario_begin()) {
+        return -EIO;
+    }
+
+    for (uint32_t offset = 0; offset < STREAM_SIZE; offset += chunk_size) {
+        err = gatt_write_nr(CHRC_DATA_UPLOAD, chunk, MIN(chunk_size, STREAM_SIZE - offset));
+        if (err) {
+            FAIL("Stream write failed (err %d)\n", err);
+            return err;
+        }
+    }
+    bytes += STREAM_SIZE;
+
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        int64_t start_us = now_us();
+
+        err = gatt_write(CHRC_DATA_UPLOAD, chunk, chunk_size);
+        if (err) {
+            FAIL("Data write failed (err %d)\n", err);
+            return err;
+        }
+        latency_add(&latency, start_us);
+        bytes += chunk_size;
+    }
+
+    err = gatt_read(CHRC_DATA_STATUS, &status, sizeof(status));
+    if (err || status.transfer_status == TRANSFER_STATUS_ERROR) {
+        FAIL("Data transfer failed (err %d, status %u)\n", err, status.transfer_status);
+        return -EIO;
+    }
+
+    err = scenario_end("data_stream", bytes, "");
+    if (err || scenario_begin()) {
+        return -EIO;
+    }
+
+    bytes = 0;
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        int64_t start_us = now_us();
+
+        err = gatt_read(CHRC_DATA_DOWNLOAD, NULL, 0);
+        if (err) {
+            FAIL("Data read failed (err %d)\n", err);
+            return err;
+        }
+        latency_add(&latency, start_us);
+        bytes += read_len;
+    }
+
+    return scenario_end("data_read", bytes, "");
+}
+
+static int dfu_command(uint8_t command)
+{
+    dfu_control_packet_t packet = { .command = command };
+
+    int err = gatt_write(CHRC_DFU_CONTROL, &packet, sizeof(packet));
+    if (err) {
+        FAIL("DFU command 0x%02x failed (err %d)\n", command, err);
+    }
+    return err;
+}
+
+static int run_dfu(void)
+{
+    dfu_packet_t packet;
+    int err;
+
+    /* Legacy packets drop trailing zeros, so the image has none */
+    memset(packet.data, 0xA5, sizeof(packet.data));
+
+    if (scenario_begin()) {
+        return -EIO;
+    }
+
+    if (dfu_command(DFU_CMD_START_DFU) || dfu_command(DFU_CMD_RECEIVE_FW)) {
+        return -EIO;
+    }
+
+    for (uint32_t offset = 0; offset < DFU_IMAGE_SIZE; offset += sizeof(packet)) {
+        err = gatt_write_nr(CHRC_DFU_PACKET, &packet, sizeof(packet));
+        if (err) {
+            FAIL("DFU packet write failed (err %d)\n", err);
+            return err;
+        }
+    }
+
+    /* Validate runs after every queued packet, so it also ends the transfer */
+    if (dfu_command(DFU_CMD_VALIDATE_FW) || dfu_command(DFU_CMD_ACTIVATE_N_RESET)) {
+        return -EIO;
+    }
+
+    return scenario_end("dfu", ROUND_UP(DFU_IMAGE_SIZE, sizeof(packet)), "");
+}
+
+/**
+ * @brief Report the shared pool peaks the scenarios reached
+ */
+static int report_memory(void)
+{
+    control_memory_packet_t memory;
+
+    int err = gatt_read(CHRC_MEMORY, &memory, sizeof(memory));
+    if (err) {
+        FAIL("Memory read failed (err %d)\n", err);
+        return err;
+    }
+
+    printk("METRICS scenario=memory pool_bytes=%u pool_peak=%u", memory.pool_size, memory.peak);
+    for (int i = 0; i < MIN(memory.count, ARRAY_SIZE(memory.clients)); i++) {
+        char name[MEM_BUDGET_NAME_LEN + 1] = { 0 };
+
+        memcpy(name, memory.clients[i].name, MEM_BUDGET_NAME_LEN);
+        printk(" %s_peak=%u %s_refused=%u", name, memory.clients[i].peak,
+               name, memory.clients[i].failures);
+    }
+    printk("\n");
+    return 0;
+}
+
+/* ============================================================================
+ * CENTRAL
+ * ============================================================================ */
+
+static const struct {
+    const char *name;
+    int (*run)(void);
+} scenarios[] = {
+    { "wasm_upload", run_wasm_upload },
+    { "wasm_execute", run_wasm_execute },   /* Needs the module from wasm_upload */
+    { "sprite_atlas", run_sprite_atlas },
+    { "data_stream", run_data_stream },
+    { "dfu", run_dfu },
+};
+
+static uint32_t selected = BIT_MASK(ARRAY_SIZE(scenarios));
+
+static void central_args(int argc, char *argv[])
+{
+    /* -argstest [scenario ...], all of them by default */
+    if (argc == 0) {
+        return;
+    }
+
+    selected = 0;
+    for (int i = 0; i < argc; i++) {
+        for (int j = 0; j < ARRAY_SIZE(scenarios); j++) {
+            if (strcmp(argv[i], scenarios[j].name) == 0) {
+                selected |= BIT(j);
+            }
+        }
+    }
+}
+
+static void central_main(void)
+{
+    int err;
+
+    build_module();
+
+    err = bt_enable(NULL);
+    if (err) {
+        FAIL("Bluetooth init failed (err %d)\n", err);
+        return;
+    }
+
+    if (connect_to_firmware()) {
+        return;
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(scenarios); i++) {
+        if (!(selected & BIT(i))) {
+            continue;
+        }
+        printk("Running %s\n", scenarios[i].name);
+        if (scenarios[i].run()) {
+            return;
+        }
+    }
+
+    if (report_memory()) {
+        return;
+    }
+
+    PASS("Performance suite completed\n");
+}
+
+/* ============================================================================
+ * TEST REGISTRATION
+ * ============================================================================ */
+
+static void test_init(void)
+{
+    bst_ticker_set_next_tick_absolute(WAIT_TIME_S * 1e6);
+    bst_result = In_progress;
+}
+
+static void test_tick(bs_time_t hw_device_time)
+{
+    if (bst_result != Passed) {
+        FAIL("Test did not pass within %d seconds\n", WAIT_TIME_S);
+    }
+}
+
+static const struct bst_test_instance test_defs[] = {
+    {
+        .test_id = "central",
+        .test_descr = "Run the performance scenarios against one firmware device",
+        .test_args_f = central_args,
+        .test_pre_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = central_main,
+    },
+    BSTEST_END_MARKER
+};
+
+static struct bst_test_list *test_perf_suite_install(struct bst_test_list *tests)
+{
+    return bst_add_tests(tests, test_defs);
+}
+
+bst_test_install_t test_installers[] = {
+    test_perf_suite_install,
+    NULL
+};
+
+int main(void)
+{
+    bst_main();
+    return 0;
+}
@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+#
+# Periodic advertising frame broadcast in BabbleSim
+#
+# Device 0 runs the firmware, device 1 the feeder central, and devices
+# 2..N+1 are receivers synced to the periodic advertising train. Each
+# tester prints a METRICS line; the run fails if any device fails.
+#
+# Usage: RECEIVERS=8 ./run.sh
+
+set -ue
+
+: "${ZEPHYR_BASE:?ZEPHYR_BASE must be set}"
+: "${BSIM_OUT_PATH:?BSIM_OUT_PATH must be set}"
+: "${BSIM_COMPONENTS_PATH:?BSIM_COMPONENTS_PATH must be set}"
+
+test_dir=$(cd "$(dirname "$0")" && pwd)
+repo_dir=$(cd "${test_dir}/../../.." && pwd)
+bin_dir=${BSIM_OUT_PATH}/bin
+
+RECEIVERS=${RECEIVERS:-4}
+SIM_LENGTH=${SIM_LENGTH:-120e6}
+FIRMWARE_BOARD=${FIRMWARE_BOARD:-nrf5340bsim_nrf5340_cpuapp}
+TESTER_BOARD=${TESTER_BOARD:-nrf52_bsim}
+simulation_id=periodic_broadcast
+
+firmware_exe=${bin_dir}/bs_${FIRMWARE_BOARD}_my5340_app
+tester_exe=${bin_dir}/bs_${TESTER_BOARD}_periodic_broadcast
+
+west build -p auto -b "${FIRMWARE_BOARD}" -d "${repo_dir}/build_bsim" "${repo_dir}"
+cp "${repo_dir}/build_bsim/zephyr/zephyr.exe" "${firmware_exe}"
+
+west build -p auto -b "${TESTER_BOARD}" -d "${test_dir}/build" "${test_dir}"
+cp "${test_dir}/build/zephyr/zephyr.exe" "${tester_exe}"
+
+cd "${bin_dir}"
+pids=()
+
+"${firmware_exe}" -s=${simulation_id} -d=0 -rs=1 > "${test_dir}/firmware.log" 2>&1 &
+pids+=($!)
+
+"${tester_exe}" -s=${simulation_id} -d=1 -rs=2 -testid=feeder > "${test_dir}/feeder.log" 2>&1 &
+pids+=($!)
+
+for i in $(seq 1 "${RECEIVERS}"); do
+    device=$((i + 1))
+    "${tester_exe}" -s=${simulation_id} -d=${device} -rs=$((device + 1)) -testid=receiver \
+        > "${test_dir}/receiver_${i}.log" 2>&1 &
+    pids+=($!)
+done
+
+./bs_2G4_phy_v1 -s=${simulation_id} -D=$((RECEIVERS + 2)) -sim_length="${SIM_LENGTH}" &
+pids+=($!)
+
+rc=0
+for pid in "${pids[@]}"; do
+    wait "${pid}" || rc=1
+done
+
+grep -h "METRICS" "${test_dir}"/feeder.log "${test_dir}"/receiver_*.log || true
+exit ${rc}
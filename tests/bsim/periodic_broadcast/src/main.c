@@ -0,0 +1,457 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bstests.h"
+#include "bsim_args_runner.h"
+
+#include "broadcast_service.h"
+
+/**
+ * @file main.c
+ * @brief BabbleSim roles for the periodic advertising frame broadcast
+ *
+ * Device 0 runs the firmware. The "feeder" connects to it and writes
+ * FRAME_COUNT data frames to the Broadcast Frame characteristic; every
+ * "receiver" syncs to the periodic advertising train and reports frames
+ * received, frames lost and payload throughput on a METRICS line.
+ */
+
+/* ============================================================================
+ * TEST PARAMETERS
+ * ============================================================================ */
+
+#define FIRMWARE_NAME           "Dan5340BLE"
+#define FRAME_COUNT             200     /* Frames written by the feeder */
+#define FRAME_PAYLOAD_SIZE      BROADCAST_FRAME_PAYLOAD_MAX
+#define MAX_LOSS_PERCENT        5       /* Receivers fail above this loss */
+#define WAIT_TIME_S             120     /* Simulated time before a test is failed */
+
+extern enum bst_result_t bst_result;
+
+#define FAIL(...)                                       \
+    do {                                                \
+        bst_result = Failed;                            \
+        bs_trace_error_time_line(__VA_ARGS__);          \
+    } while (0)
+
+#define PASS(...)                                       \
+    do {                                                \
+        bst_result = Passed;                            \
+        bs_trace_info_time(1, __VA_ARGS__);             \
+    } while (0)
+
+/* ============================================================================
+ * FEEDER
+ * ============================================================================ */
+
+static struct bt_conn *feeder_conn;
+static uint16_t frame_handle;
+static uint8_t write_err;
+
+static K_SEM_DEFINE(connected_sem, 0, 1);
+static K_SEM_DEFINE(mtu_sem, 0, 1);
+static K_SEM_DEFINE(discovered_sem, 0, 1);
+static K_SEM_DEFINE(write_sem, 0, 1);
+
+static bool match_name(struct bt_data *data, void *user_data)
+{
+    bool *found = user_data;
+
+    if (data->type == BT_DATA_NAME_COMPLETE &&
+        data->data_len == strlen(FIRMWARE_NAME) &&
+        memcmp(data->data, FIRMWARE_NAME, data->data_len) == 0) {
+        *found = true;
+        return false;
+    }
+    return true;
+}
+
+static void feeder_device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+                                struct net_buf_simple *ad)
+{
+    bool found = false;
+    int err;
+
+    if (feeder_conn) {
+        return;
+    }
+
+    bt_data_parse(ad, match_name, &found);
+    if (!found) {
+        return;
+    }
+
+    err = bt_le_scan_stop();
+    if (err) {
+        FAIL("Failed to stop scanning (err %d)\n", err);
+        return;
+    }
+
+    err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, BT_LE_CONN_PARAM_DEFAULT,
+                            &feeder_conn);
+    if (err) {
+        FAIL("Failed to connect (err %d)\n", err);
+    }
+}
+
+static void feeder_connected(struct bt_conn *conn, uint8_t err)
+{
+    if (err) {
+        FAIL("Connection failed (err 0x%02x)\n", err);
+        return;
+    }
+    k_sem_give(&connected_sem);
+}
+
+BT_CONN_CB_DEFINE(feeder_conn_callbacks) = {
+    .connected = feeder_connected,
+};
+
+static void mtu_exchanged(struct bt_conn *conn, uint8_t err,
+                          struct bt_gatt_exchange_params *params)
+{
+    if (err) {
+        FAIL("MTU exchange failed (err 0x%02x)\n", err);
+        return;
+    }
+    k_sem_give(&mtu_sem);
+}
+
+static uint8_t discover_func(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                             struct bt_gatt_discover_params *params)
+{
+    if (attr) {
+        const struct bt_gatt_chrc *chrc = attr->user_data;
+
+        frame_handle = chrc->value_handle;
+    }
+    k_sem_give(&discovered_sem);
+    return BT_GATT_ITER_STOP;
+}
+
+static void write_func(struct bt_conn *conn, uint8_t err, struct bt_gatt_write_params *params)
+{
+    write_err = err;
+    k_sem_give(&write_sem);
+}
+
+static void feeder_main(void)
+{
+    static struct bt_gatt_exchange_params mtu_params = { .func = mtu_exchanged };
+    static struct bt_gatt_discover_params discover_params;
+    static struct bt_gatt_write_params write_params;
+    static uint8_t frame[1 + FRAME_PAYLOAD_SIZE];
+    uint32_t retries = 0;
+    int err;
+
+    err = bt_enable(NULL);
+    if (err) {
+        FAIL("Bluetooth init failed (err %d)\n", err);
+        return;
+    }
+
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, feeder_device_found);
+    if (err) {
+        FAIL("Scanning failed to start (err %d)\n", err);
+        return;
+    }
+
+    k_sem_take(&connected_sem, K_FOREVER);
+
+    err = bt_gatt_exchange_mtu(feeder_conn, &mtu_params);
+    if (err) {
+        FAIL("MTU exchange failed to start (err %d)\n", err);
+        return;
+    }
+    k_sem_take(&mtu_sem, K_FOREVER);
+
+    discover_params.uuid = BROADCAST_FRAME_UUID;
+    discover_params.func = discover_func;
+    discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+    discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+    discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+    err = bt_gatt_discover(feeder_conn, &discover_params);
+    if (err) {
+        FAIL("Discovery failed to start (err %d)\n", err);
+        return;
+    }
+    k_sem_take(&discovered_sem, K_FOREVER);
+
+    if (!frame_handle) {
+        FAIL("Broadcast Frame characteristic not found\n");
+        return;
+    }
+
+    for (uint32_t i = 0; i < FRAME_COUNT; i++) {
+        frame[0] = BROADCAST_FRAME_DATA;
+        for (uint32_t j = 0; j < FRAME_PAYLOAD_SIZE; j++) {
+            frame[1 + j] = (uint8_t)(i + j);
+        }
+
+        write_params.func = write_func;
+        write_params.handle = frame_handle;
+        write_params.offset = 0;
+        write_params.data = frame;
+        write_params.length = sizeof(frame);
+
+        /* A full queue is reported as insufficient resources: back off for
+         * half an interval and let the device put the next frame on air */
+        do {
+            err = bt_gatt_write(feeder_conn, &write_params);
+            if (err) {
+                FAIL("Write failed to start (err %d)\n", err);
+                return;
+            }
+            k_sem_take(&write_sem, K_FOREVER);
+
+            if (write_err == BT_ATT_ERR_INSUFFICIENT_RESOURCES) {
+                retries++;
+                k_sleep(K_MSEC(BROADCAST_INTERVAL_MS / 2));
+            } else if (write_err) {
+                FAIL("Frame %u rejected (err 0x%02x)\n", i, write_err);
+                return;
+            }
+        } while (write_err);
+    }
+
+    printk("METRICS role=feeder frames=%u retries=%u\n", FRAME_COUNT, retries);
+    PASS("Feeder wrote %u frames\n", FRAME_COUNT);
+}
+
+/* ============================================================================
+ * RECEIVER
+ * ============================================================================ */
+
+typedef struct {
+    bool started;
+    uint16_t first_seq;
+    uint16_t last_seq;
+    uint32_t received;
+    uint32_t bytes;
+    int64_t first_ms;
+    int64_t last_ms;
+} receiver_stats_t;
+
+static struct bt_le_per_adv_sync *sync;
+static receiver_stats_t stats;
+static bool stream_done;
+
+static K_SEM_DEFINE(synced_sem, 0, 1);
+static K_SEM_DEFINE(done_sem, 0, 1);
+
+static bool match_train(struct bt_data *data, void *user_data)
+{
+    bool *found = user_data;
+
+    if (data->type == BT_DATA_SVC_DATA16 && data->data_len >= sizeof(uint16_t) &&
+        sys_get_le16(data->data) == BROADCAST_AD_UUID) {
+        *found = true;
+        return false;
+    }
+    return true;
+}
+
+static void receiver_scan_recv(const struct bt_le_scan_recv_info *info,
+                               struct net_buf_simple *buf)
+{
+    struct bt_le_per_adv_sync_param param = { 0 };
+    bool found = false;
+    int err;
+
+    if (sync || info->interval == 0) {
+        return;
+    }
+
+    bt_data_parse(buf, match_train, &found);
+    if (!found) {
+        return;
+    }
+
+    bt_addr_le_copy(&param.addr, info->addr);
+    param.sid = info->sid;
+    param.skip = 0;
+    param.timeout = 100;    /* 1 s in 10 ms units */
+
+    err = bt_le_per_adv_sync_create(&param, &sync);
+    if (err) {
+        FAIL("Failed to create sync (err %d)\n", err);
+    }
+}
+
+static struct bt_le_scan_cb receiver_scan_cb = {
+    .recv = receiver_scan_recv,
+};
+
+static void handle_frame(uint16_t seq, uint16_t len)
+{
+    int64_t now = k_uptime_get();
+
+    if (!stats.started) {
+        stats.started = true;
+        stats.first_seq = seq;
+        stats.first_ms = now;
+    } else if (seq == stats.last_seq) {
+        return;     /* Repeated until the next frame is queued */
+    }
+
+    stats.last_seq = seq;
+    stats.last_ms = now;
+    stats.received++;
+    stats.bytes += len;
+
+    if (seq == FRAME_COUNT && !stream_done) {
+        stream_done = true;
+        k_sem_give(&done_sem);
+    }
+}
+
+static bool parse_frame(struct bt_data *data, void *user_data)
+{
+    const uint16_t header_len = sizeof(uint16_t) + sizeof(broadcast_frame_header_t);
+    const broadcast_frame_header_t *header;
+
+    if (data->type != BT_DATA_SVC_DATA16 || data->data_len < header_len ||
+        sys_get_le16(data->data) != BROADCAST_AD_UUID) {
+        return true;
+    }
+
+    header = (const broadcast_frame_header_t *)&data->data[sizeof(uint16_t)];
+    if (header->version != BROADCAST_FRAME_VERSION) {
+        FAIL("Unexpected frame version %u\n", header->version);
+        return false;
+    }
+
+    handle_frame(sys_le16_to_cpu(header->seq), data->data_len - header_len);
+    return false;
+}
+
+static void receiver_synced(struct bt_le_per_adv_sync *s,
+                            struct bt_le_per_adv_sync_synced_info *info)
+{
+    k_sem_give(&synced_sem);
+}
+
+static void receiver_term(struct bt_le_per_adv_sync *s,
+                          const struct bt_le_per_adv_sync_term_info *info)
+{
+    if (!stream_done) {
+        FAIL("Sync lost before the last frame (reason 0x%02x)\n", info->reason);
+    }
+}
+
+static void receiver_recv(struct bt_le_per_adv_sync *s,
+                          const struct bt_le_per_adv_sync_recv_info *info,
+                          struct net_buf_simple *buf)
+{
+    bt_data_parse(buf, parse_frame, NULL);
+}
+
+static struct bt_le_per_adv_sync_cb receiver_sync_cb = {
+    .synced = receiver_synced,
+    .term = receiver_term,
+    .recv = receiver_recv,
+};
+
+static void receiver_main(void)
+{
+    int err;
+
+    err = bt_enable(NULL);
+    if (err) {
+        FAIL("Bluetooth init failed (err %d)\n", err);
+        return;
+    }
+
+    bt_le_scan_cb_register(&receiver_scan_cb);
+    bt_le_per_adv_sync_cb_register(&receiver_sync_cb);
+
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, NULL);
+    if (err) {
+        FAIL("Scanning failed to start (err %d)\n", err);
+        return;
+    }
+
+    if (k_sem_take(&synced_sem, K_SECONDS(WAIT_TIME_S / 2)) != 0) {
+        FAIL("No periodic advertising train found\n");
+        return;
+    }
+    bt_le_scan_stop();
+
+    k_sem_take(&done_sem, K_FOREVER);
+
+    /* Frames are counted from the first one seen after sync */
+    uint32_t expected = FRAME_COUNT - stats.first_seq + 1;
+    uint32_t lost = expected - stats.received;
+    uint32_t loss_pct = lost * 100 / expected;
+    int64_t elapsed_ms = MAX(stats.last_ms - stats.first_ms, 1);
+    uint32_t throughput_bps = (uint32_t)(stats.bytes * 8 * 1000 / elapsed_ms);
+
+    printk("METRICS role=receiver device=%u first_seq=%u frames=%u lost=%u "
+           "loss_pct=%u throughput_bps=%u\n",
+           get_device_nbr(), stats.first_seq, stats.received, lost,
+           loss_pct, throughput_bps);
+
+    if (loss_pct > MAX_LOSS_PERCENT) {
+        FAIL("Lost %u of %u frames\n", lost, expected);
+        return;
+    }
+    PASS("Received %u of %u frames\n", stats.received, expected);
+}
+
+/* ============================================================================
+ * TEST REGISTRATION
+ * ============================================================================ */
+
+static void test_init(void)
+{
+    bst_ticker_set_next_tick_absolute(WAIT_TIME_S * 1e6);
+    bst_result = In_progress;
+}
+
+static void test_tick(bs_time_t hw_device_time)
+{
+    if (bst_result != Passed) {
+        FAIL("Test did not pass within %d seconds\n", WAIT_TIME_S);
+    }
+}
+
+static const struct bst_test_instance test_defs[] = {
+    {
+        .test_id = "feeder",
+        .test_descr = "Connect to the firmware and write frames to broadcast",
+        .test_pre_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = feeder_main,
+    },
+    {
+        .test_id = "receiver",
+        .test_descr = "Sync to the periodic advertising train and count frames",
+        .test_pre_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = receiver_main,
+    },
+    BSTEST_END_MARKER
+};
+
+static struct bst_test_list *test_periodic_broadcast_install(struct bst_test_list *tests)
+{
+    return bst_add_tests(tests, test_defs);
+}
+
+bst_test_install_t test_installers[] = {
+    test_periodic_broadcast_install,
+    NULL
+};
+
+int main(void)
+{
+    bst_main();
+    return 0;
+}
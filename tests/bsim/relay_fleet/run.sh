@@ -0,0 +1,69 @@
+#!/usr/bin/env bash
+#
+# Relay distribution time across a fleet in BabbleSim
+#
+# Devices 0..N-1 run the firmware and device N is the seeder: it uploads a
+# module to one device, starts a relay and reports on a METRICS line how
+# long it took until every device had the module loaded. The run fails if
+# a relay link stored a bond on any device.
+#
+# Usage: FLEET_SIZE=8 HOPS=2 ./run.sh
+
+set -ue
+
+: "${ZEPHYR_BASE:?ZEPHYR_BASE must be set}"
+: "${BSIM_OUT_PATH:?BSIM_OUT_PATH must be set}"
+: "${BSIM_COMPONENTS_PATH:?BSIM_COMPONENTS_PATH must be set}"
+
+test_dir=$(cd "$(dirname "$0")" && pwd)
+repo_dir=$(cd "${test_dir}/../../.." && pwd)
+bin_dir=${BSIM_OUT_PATH}/bin
+
+FLEET_SIZE=${FLEET_SIZE:-4}
+HOPS=${HOPS:-2}
+SIM_LENGTH=${SIM_LENGTH:-180e6}
+FIRMWARE_BOARD=${FIRMWARE_BOARD:-nrf5340bsim_nrf5340_cpuapp}
+TESTER_BOARD=${TESTER_BOARD:-nrf52_bsim}
+simulation_id=relay_fleet
+
+firmware_exe=${bin_dir}/bs_${FIRMWARE_BOARD}_my5340_app
+tester_exe=${bin_dir}/bs_${TESTER_BOARD}_relay_fleet
+
+west build -p auto -b "${FIRMWARE_BOARD}" -d "${repo_dir}/build_bsim" "${repo_dir}"
+cp "${repo_dir}/build_bsim/zephyr/zephyr.exe" "${firmware_exe}"
+
+west build -p auto -b "${TESTER_BOARD}" -d "${test_dir}/build" "${test_dir}"
+cp "${test_dir}/build/zephyr/zephyr.exe" "${tester_exe}"
+
+cd "${bin_dir}"
+pids=()
+
+# The firmware devices never pass or fail on their own; they run until the
+# simulation ends
+for device in $(seq 0 $((FLEET_SIZE - 1))); do
+    "${firmware_exe}" -s=${simulation_id} -d=${device} -rs=$((device + 1)) \
+        > "${test_dir}/firmware_${device}.log" 2>&1 &
+done
+
+"${tester_exe}" -s=${simulation_id} -d=${FLEET_SIZE} -rs=$((FLEET_SIZE + 1)) -testid=seeder \
+    -argstest ${FLEET_SIZE} ${HOPS} > "${test_dir}/seeder.log" 2>&1 &
+pids+=($!)
+
+./bs_2G4_phy_v1 -s=${simulation_id} -D=$((FLEET_SIZE + 1)) -sim_length="${SIM_LENGTH}" &
+pids+=($!)
+
+rc=0
+for pid in "${pids[@]}"; do
+    wait "${pid}" || rc=1
+done
+wait
+
+grep -h "METRICS" "${test_dir}/seeder.log" || true
+
+# Every device starts without bonds and only relay links pair, so the bond
+# count must still be zero ("Paired with <addr> (not bonded, 0 bonds)")
+if grep -H "Paired with .* (bonded" "${test_dir}"/firmware_*.log; then
+    echo "Relay links stored bonds"
+    rc=1
+fi
+exit ${rc}
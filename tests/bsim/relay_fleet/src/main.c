@@ -0,0 +1,489 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/byteorder.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bstests.h"
+#include "bsim_args_runner.h"
+
+#include "control_service.h"
+#include "relay.h"
+#include "status_broadcast.h"
+#include "wasm_service.h"
+
+/**
+ * @file main.c
+ * @brief BabbleSim seeder for the central-role relay
+ *
+ * Devices 0..N-1 run the firmware with nothing loaded. The "seeder"
+ * connects to one of them, uploads a WASM module padded to MODULE_SIZE,
+ * starts a relay with the given hop count and disconnects. It then
+ * watches the status broadcasts until every firmware device reports a
+ * loaded module and prints the distribution time on a METRICS line.
+ */
+
+/* ============================================================================
+ * TEST PARAMETERS
+ * ============================================================================ */
+
+#define FIRMWARE_NAME           "Dan5340BLE"
+#define MODULE_SIZE             4096    /* Bytes uploaded to the first device */
+#define DEFAULT_FLEET_SIZE      4
+#define DEFAULT_HOPS            2
+#define POLL_INTERVAL_MS        100
+#define WAIT_TIME_S             180     /* Simulated time before a test is failed */
+
+extern enum bst_result_t bst_result;
+
+#define FAIL(...)                                       \
+    do {                                                \
+        bst_result = Failed;                            \
+        bs_trace_error_time_line(__VA_ARGS__);          \
+    } while (0)
+
+#define PASS(...)                                       \
+    do {                                                \
+        bst_result = Passed;                            \
+        bs_trace_info_time(1, __VA_ARGS__);             \
+    } while (0)
+
+static uint8_t fleet_size = DEFAULT_FLEET_SIZE;
+static uint8_t hops = DEFAULT_HOPS;
+
+/* ============================================================================
+ * MODULE
+ * ============================================================================ */
+
+/* add(i32, i32) -> i32, exported as "add" */
+static const uint8_t add_module[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,
+    0x01, 0x07, 0x01, 0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f,
+    0x03, 0x02, 0x01, 0x00,
+    0x07, 0x07, 0x01, 0x03, 'a', 'd', 'd', 0x00, 0x00,
+    0x0a, 0x09, 0x01, 0x07, 0x00, 0x20, 0x00, 0x20, 0x01, 0x6a, 0x0b,
+};
+
+static uint8_t module[MODULE_SIZE];
+
+/**
+ * @brief Pad the add module with a custom section up to MODULE_SIZE
+ *
+ * The runtime skips custom sections, so the module still loads while the
+ * transfer is as long as a realistic application module.
+ */
+static void build_module(void)
+{
+    static const char name[] = "pad";
+    uint32_t offset = sizeof(add_module);
+    /* Section id, 2-byte LEB128 size, name length, name */
+    uint32_t section_size = MODULE_SIZE - offset - 3;
+
+    memcpy(module, add_module, sizeof(add_module));
+    module[offset++] = 0x00;
+    module[offset++] = 0x80 | (section_size & 0x7F);
+    module[offset++] = section_size >> 7;
+    module[offset++] = sizeof(name) - 1;
+    memcpy(&module[offset], name, sizeof(name) - 1);
+    offset += sizeof(name) - 1;
+    memset(&module[offset], 0xA5, MODULE_SIZE - offset);
+}
+
+/* ============================================================================
+ * SEED CONNECTION
+ * ============================================================================ */
+
+static struct bt_conn *seed_conn;
+static uint16_t upload_handle;
+static uint16_t status_handle;
+static uint16_t command_handle;
+static uint8_t gatt_err;
+static wasm_status_packet_t peer_status;
+
+static K_SEM_DEFINE(connected_sem, 0, 1);
+static K_SEM_DEFINE(disconnected_sem, 0, 1);
+static K_SEM_DEFINE(gatt_sem, 0, 1);
+
+static bool match_name(struct bt_data *data, void *user_data)
+{
+    bool *found = user_data;
+
+    if (data->type == BT_DATA_NAME_COMPLETE &&
+        data->data_len == strlen(FIRMWARE_NAME) &&
+        memcmp(data->data, FIRMWARE_NAME, data->data_len) == 0) {
+        *found = true;
+        return false;
+    }
+    return true;
+}
+
+static void seed_device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+                              struct net_buf_simple *ad)
+{
+    bool found = false;
+    int err;
+
+    if (seed_conn) {
+        return;
+    }
+
+    bt_data_parse(ad, match_name, &found);
+    if (!found) {
+        return;
+    }
+
+    err = bt_le_scan_stop();
+    if (err) {
+        FAIL("Failed to stop scanning (err %d)\n", err);
+        return;
+    }
+
+    err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, BT_LE_CONN_PARAM_DEFAULT, &seed_conn);
+    if (err) {
+        FAIL("Failed to connect (err %d)\n", err);
+    }
+}
+
+static void seed_connected(struct bt_conn *conn, uint8_t err)
+{
+    if (err) {
+        FAIL("Connection failed (err 0x%02x)\n", err);
+        return;
+    }
+    k_sem_give(&connected_sem);
+}
+
+static void seed_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    k_sem_give(&disconnected_sem);
+}
+
+BT_CONN_CB_DEFINE(seed_conn_callbacks) = {
+    .connected = seed_connected,
+    .disconnected = seed_disconnected,
+};
+
+static void mtu_exchanged(struct bt_conn *conn, uint8_t err,
+                          struct bt_gatt_exchange_params *params)
+{
+    gatt_err = err;
+    k_sem_give(&gatt_sem);
+}
+
+static uint8_t discover_func(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                             struct bt_gatt_discover_params *params)
+{
+    if (!attr) {
+        k_sem_give(&gatt_sem);
+        return BT_GATT_ITER_STOP;
+    }
+
+    const struct bt_gatt_chrc *chrc = attr->user_data;
+
+    if (bt_uuid_cmp(chrc->uuid, WASM_UPLOAD_UUID) == 0) {
+        upload_handle = chrc->value_handle;
+    } else if (bt_uuid_cmp(chrc->uuid, WASM_STATUS_UUID) == 0) {
+        status_handle = chrc->value_handle;
+    } else if (bt_uuid_cmp(chrc->uuid, CONTROL_COMMAND_UUID) == 0) {
+        command_handle = chrc->value_handle;
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t read_func(struct bt_conn *conn, uint8_t err, struct bt_gatt_read_params *params,
+                         const void *data, uint16_t length)
+{
+    gatt_err = err;
+    if (!err && data) {
+        memcpy(&peer_status, data, MIN(length, sizeof(peer_status)));
+    }
+    k_sem_give(&gatt_sem);
+    return BT_GATT_ITER_STOP;
+}
+
+static void write_func(struct bt_conn *conn, uint8_t err, struct bt_gatt_write_params *params)
+{
+    gatt_err = err;
+    k_sem_give(&gatt_sem);
+}
+
+static int read_wasm_status(void)
+{
+    static struct bt_gatt_read_params read_params;
+
+    read_params.func = read_func;
+    read_params.handle_count = 1;
+    read_params.single.handle = status_handle;
+    read_params.single.offset = 0;
+
+    int err = bt_gatt_read(seed_conn, &read_params);
+    if (err) {
+        return err;
+    }
+    k_sem_take(&gatt_sem, K_FOREVER);
+    return gatt_err;
+}
+
+static int connect_to_seed(void)
+{
+    static struct bt_gatt_exchange_params mtu_params = { .func = mtu_exchanged };
+    static struct bt_gatt_discover_params discover_params;
+    int err;
+
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, seed_device_found);
+    if (err) {
+        FAIL("Scanning failed to start (err %d)\n", err);
+        return err;
+    }
+    k_sem_take(&connected_sem, K_FOREVER);
+
+    err = bt_gatt_exchange_mtu(seed_conn, &mtu_params);
+    if (err) {
+        FAIL("MTU exchange failed to start (err %d)\n", err);
+        return err;
+    }
+    k_sem_take(&gatt_sem, K_FOREVER);
+
+    discover_params.uuid = NULL;
+    discover_params.func = discover_func;
+    discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+    discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+    discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+    err = bt_gatt_discover(seed_conn, &discover_params);
+    if (err) {
+        FAIL("Discovery failed to start (err %d)\n", err);
+        return err;
+    }
+    k_sem_take(&gatt_sem, K_FOREVER);
+
+    if (!upload_handle || !status_handle || !command_handle) {
+        FAIL("WASM or Control Service characteristics not found\n");
+        return -ENOENT;
+    }
+    return 0;
+}
+
+static int upload_module(void)
+{
+    static wasm_upload_packet_t packet;
+    const uint16_t header = offsetof(wasm_upload_packet_t, data);
+    uint16_t chunk_max = MIN(bt_gatt_get_mtu(seed_conn) - 3 - header, WASM_UPLOAD_CHUNK_SIZE);
+    uint8_t sequence = 0;
+    int err;
+
+    for (uint32_t offset = 0; offset < MODULE_SIZE; offset += packet.chunk_size) {
+        packet.cmd = (offset == 0) ? WASM_CMD_START_UPLOAD : WASM_CMD_CONTINUE_UPLOAD;
+        packet.sequence = sequence++;
+        packet.chunk_size = MIN(chunk_max, MODULE_SIZE - offset);
+        packet.total_size = MODULE_SIZE;
+        memcpy(packet.data, &module[offset], packet.chunk_size);
+
+        err = bt_gatt_write_without_response(seed_conn, upload_handle, &packet,
+                                             header + packet.chunk_size, false);
+        if (err) {
+            FAIL("Upload write failed (err %d)\n", err);
+            return err;
+        }
+    }
+
+    while (1) {
+        k_sleep(K_MSEC(POLL_INTERVAL_MS));
+
+        err = read_wasm_status();
+        if (err) {
+            FAIL("WASM status read failed (err %d)\n", err);
+            return err;
+        }
+        if (peer_status.status == WASM_STATUS_ERROR) {
+            FAIL("Seed device failed to load the module (error %u)\n", peer_status.error_code);
+            return -EIO;
+        }
+        if (peer_status.status == WASM_STATUS_LOADED) {
+            return 0;
+        }
+    }
+}
+
+static int start_relay(void)
+{
+    static struct bt_gatt_write_params write_params;
+    static control_command_packet_t command;
+
+    command.cmd_id = CMD_START_RELAY;
+    command.param1 = RELAY_CONTENT_WASM;
+    command.param2 = hops;
+
+    write_params.func = write_func;
+    write_params.handle = command_handle;
+    write_params.offset = 0;
+    write_params.data = &command;
+    write_params.length = sizeof(command);
+
+    int err = bt_gatt_write(seed_conn, &write_params);
+    if (err) {
+        return err;
+    }
+    k_sem_take(&gatt_sem, K_FOREVER);
+    return gatt_err;
+}
+
+/* ============================================================================
+ * FLEET OBSERVER
+ * ============================================================================ */
+
+static bt_addr_le_t loaded_devices[RELAY_MAX_PEERS];
+static uint8_t loaded_count;
+static int64_t relay_start_ms;
+
+static K_SEM_DEFINE(fleet_sem, 0, 1);
+
+static bool match_loaded(struct bt_data *data, void *user_data)
+{
+    bool *loaded = user_data;
+    status_broadcast_block_t block;
+
+    if (data->type != BT_DATA_SVC_DATA16 ||
+        data->data_len != sizeof(uint16_t) + sizeof(block) ||
+        sys_get_le16(data->data) != STATUS_BROADCAST_UUID) {
+        return true;
+    }
+
+    memcpy(&block, &data->data[sizeof(uint16_t)], sizeof(block));
+    *loaded = block.version == STATUS_BROADCAST_VERSION &&
+              (block.flags & STATUS_FLAG_MODULE_LOADED);
+    return false;
+}
+
+static void fleet_device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+                               struct net_buf_simple *ad)
+{
+    bool loaded = false;
+
+    bt_data_parse(ad, match_loaded, &loaded);
+    if (!loaded || loaded_count >= fleet_size) {
+        return;
+    }
+
+    for (int i = 0; i < loaded_count; i++) {
+        if (bt_addr_le_cmp(&loaded_devices[i], addr) == 0) {
+            return;
+        }
+    }
+
+    bt_addr_le_copy(&loaded_devices[loaded_count++], addr);
+    printk("Device %u of %u loaded after %lld ms\n", loaded_count, fleet_size,
+           k_uptime_get() - relay_start_ms);
+
+    if (loaded_count == fleet_size) {
+        k_sem_give(&fleet_sem);
+    }
+}
+
+/* ============================================================================
+ * SEEDER
+ * ============================================================================ */
+
+static void seeder_args(int argc, char *argv[])
+{
+    /* -argstest <fleet size> <hops> */
+    if (argc > 0) {
+        fleet_size = CLAMP(atoi(argv[0]), 1, RELAY_MAX_PEERS);
+    }
+    if (argc > 1) {
+        hops = atoi(argv[1]);
+    }
+}
+
+static void seeder_main(void)
+{
+    int err;
+
+    build_module();
+
+    err = bt_enable(NULL);
+    if (err) {
+        FAIL("Bluetooth init failed (err %d)\n", err);
+        return;
+    }
+
+    if (connect_to_seed() || upload_module()) {
+        return;
+    }
+
+    relay_start_ms = k_uptime_get();
+    err = start_relay();
+    if (err) {
+        FAIL("Relay command failed (err %d)\n", err);
+        return;
+    }
+
+    /* The seed device needs its connection slots for the relay */
+    bt_conn_disconnect(seed_conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    k_sem_take(&disconnected_sem, K_FOREVER);
+    bt_conn_unref(seed_conn);
+
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, fleet_device_found);
+    if (err) {
+        FAIL("Scanning failed to start (err %d)\n", err);
+        return;
+    }
+
+    k_sem_take(&fleet_sem, K_FOREVER);
+    bt_le_scan_stop();
+
+    int64_t distribution_ms = k_uptime_get() - relay_start_ms;
+
+    printk("METRICS role=seeder devices=%u hops=%u module_bytes=%u distribution_ms=%lld\n",
+           fleet_size, hops, MODULE_SIZE, distribution_ms);
+    PASS("Module reached %u devices in %lld ms\n", fleet_size, distribution_ms);
+}
+
+/* ============================================================================
+ * TEST REGISTRATION
+ * ============================================================================ */
+
+static void test_init(void)
+{
+    bst_ticker_set_next_tick_absolute(WAIT_TIME_S * 1e6);
+    bst_result = In_progress;
+}
+
+static void test_tick(bs_time_t hw_device_time)
+{
+    if (bst_result != Passed) {
+        FAIL("Test did not pass within %d seconds\n", WAIT_TIME_S);
+    }
+}
+
+static const struct bst_test_instance test_defs[] = {
+    {
+        .test_id = "seeder",
+        .test_descr = "Seed one device with a module and time the relay through the fleet",
+        .test_args_f = seeder_args,
+        .test_pre_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = seeder_main,
+    },
+    BSTEST_END_MARKER
+};
+
+static struct bst_test_list *test_relay_fleet_install(struct bst_test_list *tests)
+{
+    return bst_add_tests(tests, test_defs);
+}
+
+bst_test_install_t test_installers[] = {
+    test_relay_fleet_install,
+    NULL
+};
+
+int main(void)
+{
+    bst_main();
+    return 0;
+}
@@ -4,6 +4,11 @@ Simple Pytest Configuration
 
 Provides basic BLE connection and serial monitoring fixtures without 
 competing with pytest's built-in assertion and testing mechanisms.
+
+With --virtual the suites run against the native_sim firmware on a virtual
+controller instead of a board (see virtual_device.py); serial_capture then
+reads the firmware's output. ble_latency and ble_throughput time GATT
+operations in either mode; --perf-out writes the numbers as JSON.
 """
 
 import pytest
@@ -18,6 +23,9 @@ from bleak import BleakClient, BleakScanner
 from typing import List, Optional
 from collections import namedtuple
 
+from ble_perf import PerfRecorder, measure_latency, measure_throughput
+from virtual_device import DEFAULT_CONTROLLER, DEFAULT_PORT, VirtualDevice
+
 # Test configuration
 DEVICE_NAME = "Dan5340BLE"
 SERIAL_PORT = "/dev/tty.usbmodem0010500306563"
@@ -143,18 +151,75 @@ class SerialCapture:
         """Clear captured data"""
         self.captured_lines = []
 
+class FirmwareLogCapture(SerialCapture):
+    """SerialCapture over the output of the native_sim firmware (--virtual)"""
+    
+    def __init__(self, device: VirtualDevice):
+        super().__init__(port=str(device.exe))
+        self.device = device
+        self._next_line = 0
+    
+    def start_capture(self):
+        """Capture firmware lines from now on"""
+        if self.capturing:
+            return
+        self.captured_lines = []
+        self._next_line = len(self.device.lines)
+        self.capturing = True
+    
+    def stop_capture(self):
+        """Stop capturing, keeping what was captured"""
+        self._collect()
+        self.capturing = False
+    
+    def readouterr(self) -> SerialResult:
+        if self.capturing:
+            time.sleep(0.05)
+        self._collect()
+        return super().readouterr()
+    
+    def get_lines(self) -> List[str]:
+        self._collect()
+        return super().get_lines()
+    
+    def _collect(self):
+        if self.capturing:
+            self.captured_lines += self.device.lines[self._next_line:]
+            self._next_line = len(self.device.lines)
+
+@pytest.fixture(scope="session")
+def virtual_device(request):
+    """native_sim firmware on a virtual controller with --virtual, else None"""
+    exe = request.config.getoption("--virtual")
+    if not exe:
+        yield None
+        return
+    
+    logger.info(f"🖥️ Starting virtual device {exe}...")
+    device = VirtualDevice(Path(exe), request.config.getoption("--virtual-port"),
+                           request.config.getoption("--virtual-controller"))
+    device.start()
+    logger.info(f"✅ Virtual device advertising on {device.adapter}")
+    
+    yield device
+    
+    device.stop()
+
 @pytest_asyncio.fixture(scope="session")
-async def ble_setup():
+async def ble_setup(virtual_device):
     """Setup BLE connection once per test session"""
     logger.info("🚀 Setting up session-scoped BLE connection...")
     
+    # The virtual controller is its own BlueZ adapter
+    adapter = {'adapter': virtual_device.adapter} if virtual_device else {}
+    
     # Log the event loop for debugging
     loop = asyncio.get_running_loop()
     logger.info(f"🔄 Session fixture using event loop: {id(loop)}")
     
     # Discover device
     logger.info(f"🔍 Scanning for BLE device: {DEVICE_NAME}...")
-    devices = await BleakScanner.discover(timeout=DISCOVERY_TIMEOUT)
+    devices = await BleakScanner.discover(timeout=DISCOVERY_TIMEOUT, **adapter)
     device = None
     
     for d in devices:
@@ -168,7 +233,7 @@ async def ble_setup():
     
     # Connect to device
     logger.info(f"🔗 Connecting to {device.address}...")
-    client = BleakClient(device.address)
+    client = BleakClient(device.address, **adapter)
     await client.connect(timeout=CONNECTION_TIMEOUT)
     
     if not client.is_connected:
@@ -216,7 +281,7 @@ def ble_characteristics(ble_setup):
     return ble_setup['characteristics']
 
 @pytest.fixture
-def serial_capture():
+def serial_capture(virtual_device):
     """
     Provides serial capture functionality similar to capsys.
     
@@ -229,6 +294,12 @@ def serial_capture():
             result = serial_capture.readouterr()
             assert "WASM uploaded" in result.out
     """
+    if virtual_device:
+        capture = FirmwareLogCapture(virtual_device)
+        yield capture
+        capture.stop_capture()
+        return
+    
     if not Path(SERIAL_PORT).exists():
         logger.warning(f"⚠️ Serial port {SERIAL_PORT} not found")
         return None
@@ -240,11 +311,73 @@ def serial_capture():
     # Cleanup
     capture.stop_capture()
 
+@pytest.fixture(scope="session")
+def perf_recorder(request, virtual_device):
+    """Measurements of the session, written to --perf-out at the end"""
+    recorder = PerfRecorder('virtual' if virtual_device else 'hardware')
+    
+    yield recorder
+    
+    output = request.config.getoption("--perf-out")
+    if output and recorder.metrics:
+        recorder.write(Path(output))
+        logger.info(f"📊 Wrote {len(recorder.metrics)} measurements to {output}")
+
+@pytest.fixture
+def ble_latency(request, perf_recorder):
+    """
+    Time a GATT operation repeatedly and record its latency percentiles.
+    
+    Usage:
+        async def test_something(ble_client, ble_latency):
+            result = await ble_latency("data_read",
+                                       lambda: ble_client.read_gatt_char(DATA_DOWNLOAD_UUID))
+            assert result.p50_us < 100_000
+    """
+    async def measure(name, operation, count=50):
+        result = await measure_latency(name, operation, count)
+        perf_recorder.record(request.node.name, result)
+        logger.info(f"⏱️ {name}: {result.summary()}")
+        return result
+    
+    return measure
+
+@pytest.fixture
+def ble_throughput(request, ble_client, perf_recorder):
+    """
+    Stream writes without response and record the throughput.
+    
+    Usage:
+        result = await ble_throughput("data_stream", DATA_UPLOAD_UUID, 16 * 1024,
+                                      fence=lambda: ble_client.read_gatt_char(DATA_TRANSFER_STATUS_UUID))
+    """
+    async def measure(name, char_uuid, total_bytes, fence, chunk_size=None):
+        chunk_size = chunk_size or min(ble_client.mtu_size - 3, 244)
+        result = await measure_throughput(ble_client, name, char_uuid, total_bytes, chunk_size, fence)
+        perf_recorder.record(request.node.name, result)
+        logger.info(f"📈 {name}: {result.summary()}")
+        return result
+    
+    return measure
+
 # Pytest hooks for setup/teardown
+def pytest_addoption(parser):
+    """Virtual device and measurement options"""
+    group = parser.getgroup("nrf5340", "nRF5340 BLE device")
+    group.addoption("--virtual", metavar="EXE",
+                    help="Run against this native_sim firmware on a virtual controller")
+    group.addoption("--virtual-port", type=int, default=DEFAULT_PORT,
+                    help="TCP port between the firmware and the virtual controller")
+    group.addoption("--virtual-controller", default=DEFAULT_CONTROLLER,
+                    help="Virtual controller command; {port} is replaced by --virtual-port")
+    group.addoption("--perf-out", metavar="JSON",
+                    help="Write ble_latency / ble_throughput measurements here")
+
 def pytest_configure(config):
     """Pytest configuration hook"""
     config.addinivalue_line("markers", "ble: BLE tests")
     config.addinivalue_line("markers", "wasm: WASM service tests")
     config.addinivalue_line("markers", "sprite: Sprite service tests") 
     config.addinivalue_line("markers", "slow: Slow running tests")
-    config.addinivalue_line("markers", "serial: Tests that require serial monitoring")
\ No newline at end of file
+    config.addinivalue_line("markers", "serial: Tests that require serial monitoring")
+    config.addinivalue_line("markers", "perf: Latency and throughput measurements")
\ No newline at end of file
@@ -0,0 +1,311 @@
+#!/usr/bin/env python3
+"""
+Benchmark Runner and Regression Check for nRF5340 Performance Numbers
+
+Collects the JSON written by the performance producers, compares every
+metric against a baseline kept in the repository and fails when one moved
+the wrong way by more than its noise model allows:
+
+    pytest --perf-out       ble_latency / ble_throughput and the firmware self-benchmark
+                            (groups pytest-hardware, pytest-virtual)
+    bsim/perf_suite/run.sh  BabbleSim end-to-end scenarios (group perf_suite)
+
+    # Run producers, then compare against baselines/<group>.json
+    python3 perf_baseline.py run --bsim --virtual ../build_native/zephyr/zephyr.exe
+
+    # Compare or rebaseline from result files; several runs give mean and spread
+    python3 perf_baseline.py compare perf.json ../tests/bsim/perf_suite/results.json
+    python3 perf_baseline.py update run1.json run2.json run3.json
+
+Metrics are named <scenario>.<field>, e.g. data_stream.throughput_kbps.
+baselines/noise.json gives each metric a direction and a noise model,
+first matching rule wins:
+
+    relative  allowed change is tolerance x baseline mean
+    absolute  allowed change is tolerance, in the metric's unit
+    stddev    allowed change is k x baseline standard deviation, at least
+              floor x baseline mean
+    ignore    descriptive values such as byte counts
+"""
+
+import argparse
+import fnmatch
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, List, Optional
+
+TESTS_DIR = Path(__file__).resolve().parent
+BASELINE_DIR = TESTS_DIR / 'baselines'
+NOISE_FILE = BASELINE_DIR / 'noise.json'
+BSIM_PERF_SUITE = TESTS_DIR / 'bsim' / 'perf_suite' / 'run.sh'
+BASELINE_SCHEMA = 1
+
+# Entry keys that label a measurement rather than measure something
+LABEL_KEYS = {'scenario', 'test', 'mode'}
+
+
+@dataclass
+class NoiseModel:
+    model: str = 'relative'
+    direction: str = 'lower'        # Which way is better
+    tolerance: float = 0.10
+    k: float = 3.0
+    floor: float = 0.0
+
+    def allowed(self, mean: float, stdev: float) -> float:
+        """Change from the baseline mean still counted as noise"""
+        if self.model == 'absolute':
+            return self.tolerance
+        if self.model == 'stddev':
+            return max(self.k * stdev, self.floor * abs(mean))
+        return self.tolerance * abs(mean)
+
+
+@dataclass
+class Finding:
+    group: str
+    metric: str
+    verdict: str                    # ok, regressed, improved, new, missing
+    current: Optional[float] = None
+    baseline: Optional[float] = None
+    allowed: Optional[float] = None
+
+    def describe(self) -> str:
+        if self.verdict == 'new':
+            return f"{self.current:g} (no baseline)"
+        if self.verdict == 'missing':
+            return f"baseline {self.baseline:g}, not measured"
+        change = self.current - self.baseline
+        percent = f" ({change / self.baseline:+.1%})" if self.baseline else ""
+        return f"{self.baseline:g} -> {self.current:g}{percent}, noise +/-{self.allowed:g}"
+
+
+# ============================================================================
+# RESULTS
+# ============================================================================
+
+def group_name(report: dict, entry: dict) -> str:
+    """pytest results split by mode, since board and virtual numbers differ"""
+    mode = entry.get('mode')
+    return f"{report['suite']}-{mode}" if mode else report['suite']
+
+
+def collect_samples(reports: List[dict]) -> Dict[str, Dict[str, List[float]]]:
+    """Numeric values per group and metric, one sample per report entry"""
+    groups: Dict[str, Dict[str, List[float]]] = {}
+    for report in reports:
+        for entry in report.get('metrics', []):
+            metrics = groups.setdefault(group_name(report, entry), {})
+            for key, value in entry.items():
+                if key in LABEL_KEYS or isinstance(value, bool) or not isinstance(value, (int, float)):
+                    continue
+                metrics.setdefault(f"{entry.get('scenario', 'unnamed')}.{key}", []).append(value)
+    return groups
+
+
+def load_reports(paths: List[Path]) -> List[dict]:
+    return [json.loads(path.read_text()) for path in paths]
+
+
+# ============================================================================
+# BASELINES
+# ============================================================================
+
+def load_noise(path: Path) -> dict:
+    return json.loads(path.read_text()) if path.exists() else {}
+
+
+def noise_for(noise: dict, group: str, metric: str) -> NoiseModel:
+    """First rule whose pattern matches <group>/<metric> or <metric>"""
+    settings = dict(noise.get('default', {}))
+    for rule in noise.get('rules', []):
+        pattern = rule['match']
+        if fnmatch.fnmatchcase(metric, pattern) or fnmatch.fnmatchcase(f"{group}/{metric}", pattern):
+            settings.update({k: v for k, v in rule.items() if k != 'match'})
+            break
+    return NoiseModel(**settings)
+
+
+def baseline_path(directory: Path, group: str) -> Path:
+    return directory / f"{group}.json"
+
+
+def load_baseline(directory: Path, group: str) -> Optional[dict]:
+    path = baseline_path(directory, group)
+    if not path.exists():
+        return None
+    baseline = json.loads(path.read_text())
+    if baseline.get('schema') != BASELINE_SCHEMA:
+        raise ValueError(f"{path}: schema {baseline.get('schema')}, expected {BASELINE_SCHEMA}")
+    return baseline
+
+
+def build_baseline(group: str, samples: Dict[str, List[float]], commit: Optional[str],
+                   previous: Optional[dict]) -> dict:
+    """Mean and spread per metric; the revision counts rebaselines of the group"""
+    return {
+        'schema': BASELINE_SCHEMA,
+        'group': group,
+        'revision': (previous or {}).get('revision', 0) + 1,
+        'commit': commit,
+        'metrics': {
+            metric: {'mean': round(statistics.fmean(values), 3),
+                     'stdev': round(statistics.stdev(values), 3) if len(values) > 1 else 0.0,
+                     'samples': len(values)}
+            for metric, values in sorted(samples.items())
+        },
+    }
+
+
+# ============================================================================
+# COMPARISON
+# ============================================================================
+
+def compare_group(group: str, samples: Dict[str, List[float]], baseline: Optional[dict],
+                  noise: dict, scale: float = 1.0) -> List[Finding]:
+    findings = []
+    reference = (baseline or {}).get('metrics', {})
+
+    for metric, values in sorted(samples.items()):
+        model = noise_for(noise, group, metric)
+        if model.model == 'ignore':
+            continue
+        current = statistics.fmean(values)
+        if metric not in reference:
+            findings.append(Finding(group, metric, 'new', current=current))
+            continue
+
+        mean = reference[metric]['mean']
+        allowed = model.allowed(mean, reference[metric].get('stdev', 0.0)) * scale
+        worse = current - mean if model.direction == 'lower' else mean - current
+
+        if worse > allowed:
+            verdict = 'regressed'
+        elif -worse > allowed:
+            verdict = 'improved'
+        else:
+            verdict = 'ok'
+        findings.append(Finding(group, metric, verdict, current, mean, allowed))
+
+    for metric, entry in sorted(reference.items()):
+        if metric not in samples and noise_for(noise, group, metric).model != 'ignore':
+            findings.append(Finding(group, metric, 'missing', baseline=entry['mean']))
+    return findings
+
+
+def print_findings(findings: List[Finding], verbose: bool):
+    for finding in findings:
+        if verbose or finding.verdict != 'ok':
+            print(f"{finding.verdict.upper():9} {finding.group}/{finding.metric}: {finding.describe()}")
+
+    counts = {}
+    for finding in findings:
+        counts[finding.verdict] = counts.get(finding.verdict, 0) + 1
+    print(", ".join(f"{count} {verdict}" for verdict, count in sorted(counts.items())) or "No metrics")
+
+
+# ============================================================================
+# PRODUCERS
+# ============================================================================
+
+def git_commit():
+    try:
+        return subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], capture_output=True,
+                              text=True, check=True, cwd=TESTS_DIR).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def run_producers(args, out_dir: Path) -> List[Path]:
+    """Run each requested producer args.repeat times; return the result files"""
+    results = []
+    for run in range(args.repeat):
+        if args.bsim:
+            output = out_dir / f"bsim_{run}.json"
+            subprocess.run([str(BSIM_PERF_SUITE)], check=True, env={**os.environ, 'OUTPUT': str(output)})
+            results.append(output)
+        if args.board or args.virtual:
+            output = out_dir / f"pytest_{run}.json"
+            command = [sys.executable, '-m', 'pytest', '-m', 'perf', '--perf-out', str(output)]
+            if args.virtual:
+                command += ['--virtual', str(Path(args.virtual).resolve())]
+            subprocess.run(command, check=True, cwd=TESTS_DIR)
+            results.append(output)
+    return results
+
+
+# ============================================================================
+# MAIN
+# ============================================================================
+
+def compare(paths: List[Path], args) -> int:
+    noise = load_noise(args.noise)
+    findings = []
+    for group, samples in sorted(collect_samples(load_reports(paths)).items()):
+        findings += compare_group(group, samples, load_baseline(args.baseline_dir, group), noise,
+                                  args.scale)
+
+    print_findings(findings, args.verbose)
+    if args.json_out:
+        args.json_out.write_text(json.dumps([vars(f) for f in findings], indent=2) + "\n")
+    return 1 if any(f.verdict == 'regressed' for f in findings) else 0
+
+
+def update(paths: List[Path], args) -> int:
+    args.baseline_dir.mkdir(parents=True, exist_ok=True)
+    commit = git_commit()
+    for group, samples in sorted(collect_samples(load_reports(paths)).items()):
+        path = baseline_path(args.baseline_dir, group)
+        baseline = build_baseline(group, samples, commit, load_baseline(args.baseline_dir, group))
+        path.write_text(json.dumps(baseline, indent=2) + "\n")
+        print(f"Wrote {path} (revision {baseline['revision']}, {len(samples)} metrics)")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('--baseline-dir', type=Path, default=BASELINE_DIR, help="Baseline directory")
+    parser.add_argument('--noise', type=Path, default=NOISE_FILE, help="Noise model rules")
+    parser.add_argument('--scale', type=float, default=1.0,
+                        help="Multiply every allowed change, e.g. 2 on a busy machine")
+    parser.add_argument('-v', '--verbose', action='store_true', help="Also list metrics within noise")
+    parser.add_argument('--json-out', type=Path, help="Write the findings as JSON")
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    run = commands.add_parser('run', help="Run producers, then compare (or --update)")
+    run.add_argument('--bsim', action='store_true', help="BabbleSim perf suite")
+    run.add_argument('--virtual', metavar='EXE', help="pytest -m perf against native_sim")
+    run.add_argument('--board', action='store_true', help="pytest -m perf against the board")
+    run.add_argument('--repeat', type=int, default=1, help="Runs per producer")
+    run.add_argument('--keep', type=Path, metavar='DIR', help="Keep the result files here")
+    run.add_argument('--update', action='store_true', help="Rebaseline instead of comparing")
+
+    for name, text in (('compare', "Compare result files against the baselines"),
+                       ('update', "Write baselines from result files")):
+        sub = commands.add_parser(name, help=text)
+        sub.add_argument('results', nargs='+', type=Path, help="Result JSON files")
+
+    args = parser.parse_args()
+
+    if args.command == 'compare':
+        return compare(args.results, args)
+    if args.command == 'update':
+        return update(args.results, args)
+
+    if not (args.bsim or args.virtual or args.board):
+        parser.error("run needs at least one of --bsim, --virtual, --board")
+    with tempfile.TemporaryDirectory() as scratch:
+        out_dir = args.keep or Path(scratch)
+        out_dir.mkdir(parents=True, exist_ok=True)
+        results = run_producers(args, out_dir)
+        return update(results, args) if args.update else compare(results, args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -7,6 +7,9 @@ General BLE connection and discovery tests
 
 import pytest
 import asyncio
+import struct
+import time
+from bleak import BleakClient, BleakScanner
 
 # All expected service UUIDs
 EXPECTED_SERVICES = [
@@ -15,9 +18,19 @@ EXPECTED_SERVICES = [
     "0000fff0-0000-1000-8000-00805f9b34fb",  # Data Service
     "0000fe59-0000-1000-8000-00805f9b34fb",  # DFU Service
     "0000fff8-0000-1000-8000-00805f9b34fb",  # Sprite Service
+    "0000ffd8-0000-1000-8000-00805f9b34fb",  # Broadcast Service
     "0000fff7-0000-1000-8000-00805f9b34fb",  # WASM Service
 ]
 
+# Status broadcast carried in the advertising service data
+STATUS_BROADCAST_UUID = "0000ffe0-0000-1000-8000-00805f9b34fb"
+STATUS_BLOCK_FORMAT = '<BBBBBBiHHBB'  # 16 bytes, see status_broadcast.h
+
+# Bonded reconnect: GET_STATUS on the control command characteristic
+CONTROL_COMMAND_UUID = "0000ffe1-0000-1000-8000-00805f9b34fb"
+GET_STATUS_COMMAND = struct.pack('<BBB17x', 0x01, 0, 0)
+RECONNECT_TARGET_S = 1.0
+
 
 def test_ble_connection_established(ble_client):
     """Test that BLE connection is established"""
@@ -108,3 +121,67 @@ def test_characteristic_count_reasonable(ble_services, ble_characteristics):
     
     # But not an unreasonable number (< 100)
     assert len(ble_characteristics) < 100
+
+
+@pytest.mark.asyncio
+async def test_status_broadcast_advertised(ble_client):
+    """Test that the status block can be read from a scan without connecting"""
+    block = None
+
+    # Advertising resumes while connected because more connection slots are free
+    devices = await BleakScanner.discover(timeout=5.0, return_adv=True)
+    for device, adv in devices.values():
+        if STATUS_BROADCAST_UUID in adv.service_data:
+            block = adv.service_data[STATUS_BROADCAST_UUID]
+            break
+
+    assert block is not None, "No advertisement with the status broadcast found"
+    assert len(block) == struct.calcsize(STATUS_BLOCK_FORMAT)
+
+    (version, seq, device_status, flags, connections, wasm_status,
+     last_result, registry_generation, sprite_count,
+     dfu_state, dfu_kb) = struct.unpack(STATUS_BLOCK_FORMAT, block)
+
+    assert version == 0x01
+    assert connections >= 1  # The session connection is still up
+    assert dfu_state == 0 or flags & 0x04
+
+
+
+async def reconnect_and_write(client):
+    """Reconnect and return the seconds until the first write is acknowledged"""
+    start = time.perf_counter()
+    await client.connect(timeout=10.0)
+    await client.write_gatt_char(CONTROL_COMMAND_UUID, GET_STATUS_COMMAND, response=True)
+    return time.perf_counter() - start
+
+
+@pytest.mark.slow
+@pytest.mark.asyncio
+async def test_bonded_reconnect_time(ble_client):
+    """Measure reconnect-to-first-write before and after bonding
+    
+    Unbonded, every connection runs full service discovery. Once bonded
+    the host keeps the attribute handles (the database hash has not
+    changed), and the device advertises at the fast interval while the
+    bonded client is away, so a reconnect skips both costs. The session
+    connection is left connected again.
+    """
+    try:
+        await ble_client.pair()
+    except NotImplementedError:
+        pass  # CoreBluetooth pairs on the device's security request by itself
+    
+    # The fast advertising window opens when a bonded client disconnects
+    reconnect_s = []
+    for _ in range(3):
+        await ble_client.disconnect()
+        await asyncio.sleep(1.0)
+        reconnect_s.append(await reconnect_and_write(ble_client))
+    
+    best = min(reconnect_s)
+    print(f"\nBonded reconnect to first write: "
+          f"{', '.join(f'{t * 1000:.0f}' for t in reconnect_s)} ms")
+    
+    assert ble_client.is_connected
+    assert best < RECONNECT_TARGET_S
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+BLE Performance Tests
+
+Latency and throughput of GATT round trips through the Data Service. On a
+board the numbers depend on the radio and the host adapter; with --virtual
+the native_sim firmware runs on a virtual controller and they are repeatable
+enough to compare between commits:
+
+    pytest test_ble_performance.py --virtual ../build_native/zephyr/zephyr.exe --perf-out perf.json
+"""
+
+import pytest
+
+import ble_protocol as proto
+from ble_perf import percentile
+
+SAMPLES = 50
+STREAM_SIZE = 16 * 1024
+
+
+def data_payload(ble_client):
+    """Largest Data Service packet the MTU allows"""
+    size = min(ble_client.mtu_size - 3, proto.DATA_PACKET_SIZE_MAX)
+    return bytes((i % 255) + 1 for i in range(size))
+
+
+@pytest.mark.unit
+def test_percentile_nearest_rank():
+    """Percentiles match the BabbleSim perf suite's nearest-rank definition"""
+    samples = list(range(100, 0, -1))
+    assert [percentile(samples, p) for p in (50, 90, 99, 100)] == [50, 90, 99, 100]
+    assert percentile([7], 99) == 7
+    assert percentile([], 50) == 0
+
+
+@pytest.mark.perf
+@pytest.mark.asyncio
+async def test_data_write_latency(ble_client, ble_latency):
+    """Write with response, timed until the device acknowledges"""
+    payload = data_payload(ble_client)
+
+    result = await ble_latency(
+        "data_write", lambda: ble_client.write_gatt_char(proto.DATA_UPLOAD_UUID, payload, response=True),
+        count=SAMPLES)
+
+    assert len(result.samples_us) == SAMPLES
+    assert 0 < result.p50_us <= result.max_us
+
+
+@pytest.mark.perf
+@pytest.mark.asyncio
+async def test_data_read_latency(ble_client, ble_latency):
+    """Download reads echo the last upload"""
+    payload = data_payload(ble_client)
+    await ble_client.write_gatt_char(proto.DATA_UPLOAD_UUID, payload, response=True)
+
+    result = await ble_latency(
+        "data_read", lambda: ble_client.read_gatt_char(proto.DATA_DOWNLOAD_UUID), count=SAMPLES)
+
+    assert len(result.samples_us) == SAMPLES
+    assert bytes(await ble_client.read_gatt_char(proto.DATA_DOWNLOAD_UUID)) == payload
+
+
+@pytest.mark.perf
+@pytest.mark.asyncio
+async def test_data_stream_throughput(ble_client, ble_throughput):
+    """Writes without response, fenced by a transfer status read"""
+    result = await ble_throughput(
+        "data_stream", proto.DATA_UPLOAD_UUID, STREAM_SIZE,
+        fence=lambda: ble_client.read_gatt_char(proto.DATA_TRANSFER_STATUS_UUID))
+
+    status = proto.DataTransferStatusPacket.unpack(
+        bytes(await ble_client.read_gatt_char(proto.DATA_TRANSFER_STATUS_UUID)))
+    assert status.transfer_status == proto.TRANSFER_STATUS_COMPLETE
+    assert result.kbps > 0
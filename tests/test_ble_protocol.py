@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+Generated Protocol Tests
+
+Checks that ble_protocol.py and ble_protocol_gen.h match the service headers
+and that the generated packet classes encode the wire format. Runs without
+a device.
+"""
+
+import subprocess
+import sys
+from pathlib import Path
+
+import pytest
+
+import ble_protocol as proto
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+
+
+@pytest.mark.unit
+def test_generated_protocol_current():
+    """Generated files must be regenerated with every header change"""
+    result = subprocess.run([sys.executable, 'generate_ble_protocol.py', '--check'],
+                            cwd=REPO_ROOT, capture_output=True, text=True)
+
+    assert result.returncode == 0, result.stderr
+    assert f"0x{proto.FINGERPRINT:08X}" in result.stdout
+
+
+@pytest.mark.unit
+def test_fixed_packets_padded():
+    """Fixed-size writes are padded to sizeof() like the firmware expects"""
+    command = proto.ControlCommandPacket(cmd_id=proto.CMD_GET_STATUS).pack()
+    assert command == bytes([proto.CMD_GET_STATUS]) + bytes(19)
+
+    execute = proto.WasmExecutePacket(function_name="add", args=[2, -3]).pack()
+    assert len(execute) == proto.WasmExecutePacket.SIZE == 52
+    assert execute[:4] == b"add\0"
+    assert execute[32:36] == (2).to_bytes(4, 'little')  # arg_count from args
+    assert execute[36:44] == (2).to_bytes(4, 'little') + (-3).to_bytes(4, 'little', signed=True)
+    assert execute[44:] == bytes(8)
+
+
+@pytest.mark.unit
+def test_variable_packets_round_trip():
+    """Variable writes carry only the filled part of the trailing array"""
+    records = [proto.ControlBatchRecord(cmd_id=proto.CMD_GET_STATUS),
+               proto.ControlBatchRecord(cmd_id=proto.CMD_SET_LINK_PROFILE, param1=1)]
+    data = proto.ControlBatchPacket(batch_id=0x42, records=records).pack()
+
+    assert data == bytes([0x42, 2, proto.CMD_GET_STATUS, 0, 0, proto.CMD_SET_LINK_PROFILE, 1, 0])
+    assert proto.ControlBatchPacket.unpack(data).records == records
+
+    with pytest.raises(ValueError):
+        proto.ControlBatchPacket(records=[]).pack()  # Below the wrapper's minimum
+
+    upload = proto.WasmUploadPacket(cmd=proto.WASM_CMD_START_UPLOAD, chunk_size=3,
+                                    total_size=3, data=b"abc").pack()
+    assert len(upload) == 8 + 3
+
+
+@pytest.mark.unit
+def test_batches_split_at_capacity():
+    """Batching helper fills packets up to CONTROL_BATCH_MAX_COMMANDS"""
+    records = [proto.ControlBatchRecord(cmd_id=proto.CMD_GET_STATUS)] * 65
+    packets = list(proto.ControlBatchPacket.batches(records, batch_id=7))
+
+    assert [len(p.records) for p in packets] == [proto.CONTROL_BATCH_MAX_COMMANDS,
+                                                 proto.CONTROL_BATCH_MAX_COMMANDS, 5]
+    assert all(p.batch_id == 7 for p in packets)
+    assert all(len(p.pack()) <= proto.ControlBatchPacket.SIZE for p in packets)
+
+
+@pytest.mark.unit
+def test_short_reads_decoded():
+    """Reads shorter than sizeof() decode up to the received length"""
+    empty = proto.ControlBatchResponse.unpack(bytes([9, 0, 0]))
+    assert (empty.batch_id, empty.results) == (9, [])
+
+    assert proto.DeviceInfoString.unpack(b"Nordic").text == "Nordic"
+
+    with pytest.raises(ValueError):
+        proto.ControlStatusPacket.unpack(bytes(4))
+
+
+@pytest.mark.unit
+def test_compact_encoding():
+    """Compact writes carry only the fields that are set, as tagged varints"""
+    command = proto.ControlCommandPacket(cmd_id=proto.CMD_SET_LINK_PROFILE, param1=2)
+    assert command.pack_compact() == bytes([0x08, proto.CMD_SET_LINK_PROFILE, 0x10, 2])
+    assert command.encode(proto.COMPACT_ENCODING_LEGACY) == command.pack()
+    assert command.encode(proto.COMPACT_ENCODING_V1) == command.pack_compact()
+
+    # Name as bytes field 1, each argument as zigzag varint field 2
+    execute = proto.WasmExecutePacket(function_name="add", args=[2, -3, 300])
+    assert execute.pack_compact() == b"\x0a\x03add" + bytes([0x10, 4, 0x10, 5, 0x10, 0xd8, 0x04])
+
+    with pytest.raises(ValueError):
+        proto.WasmExecutePacket(function_name="f" * proto.WASM_FUNCTION_NAME_SIZE).pack_compact()
+    with pytest.raises(ValueError):
+        proto.WasmExecutePacket(function_name="f", args=[0] * 5).pack_compact()
+
+    # No compact field numbers: sent as is, without padding
+    assert proto.DfuPacket(data=b"\x01\x00").encode(proto.COMPACT_ENCODING_V1) == b"\x01\x00"
+
+
+@pytest.mark.unit
+def test_compact_bytes_per_operation():
+    """Compact encoding is smaller for every service with mostly unused bytes"""
+    operations = {
+        'control command': proto.ControlCommandPacket(cmd_id=proto.CMD_GET_STATUS),
+        'wasm execute': proto.WasmExecutePacket(function_name="fibonacci", args=[20]),
+        'dfu chunk': proto.DfuPacket(data=bytes(range(1, 8))),
+    }
+
+    print(f"\n{'operation':<16} {'legacy':>6} {'compact':>7}  (ATT payload bytes)")
+    for name, packet in operations.items():
+        legacy = len(packet.pack().ljust(packet.SIZE, b'\0'))
+        compact = len(packet.encode(proto.COMPACT_ENCODING_V1))
+        print(f"{name:<16} {legacy:>6} {compact:>7}")
+        assert compact < legacy
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Broadcast Service Tests
+
+Frame submission and status over GATT. Receiving the periodic advertising
+train needs a scanner that can sync to it, which bleak cannot do; the
+receiver side is covered by the BabbleSim test in bsim/periodic_broadcast.
+"""
+
+import pytest
+import asyncio
+import struct
+from bleak.exc import BleakError
+
+# Broadcast Service UUIDs
+BROADCAST_SERVICE_UUID = "0000ffd8-0000-1000-8000-00805f9b34fb"
+BROADCAST_FRAME_UUID = "0000ffd9-0000-1000-8000-00805f9b34fb"
+BROADCAST_STATUS_UUID = "0000ffda-0000-1000-8000-00805f9b34fb"
+
+# Frame types
+FRAME_DATA = 0x00
+FRAME_SPRITE = 0x01
+FRAME_DISPLAY_LIST = 0x02
+
+# Status: state, queued, seq, frames_sent, frames_dropped
+STATUS_FORMAT = '<BBHII'
+STATE_ACTIVE = 0x01
+
+FRAME_INTERVAL = 0.1  # One frame per periodic advertising event
+
+
+async def read_status(ble_client, ble_characteristics):
+    data = await ble_client.read_gatt_char(ble_characteristics[BROADCAST_STATUS_UUID])
+    assert len(data) == struct.calcsize(STATUS_FORMAT)
+    return struct.unpack(STATUS_FORMAT, data)
+
+
+def test_broadcast_service_exists(ble_services, ble_characteristics):
+    """Test broadcast service and characteristics are discovered"""
+    assert BROADCAST_SERVICE_UUID in ble_services
+    assert BROADCAST_FRAME_UUID in ble_characteristics
+    assert BROADCAST_STATUS_UUID in ble_characteristics
+
+
+@pytest.mark.asyncio
+async def test_broadcast_frames_go_on_air(ble_client, ble_characteristics):
+    """Test that queued frames are sent in order, one per interval"""
+    frame_char = ble_characteristics[BROADCAST_FRAME_UUID]
+
+    _, _, seq_before, sent_before, _ = await read_status(ble_client, ble_characteristics)
+
+    sprite = struct.pack('<H', 7) + bytes(range(32))
+    display_list = struct.pack('<Hhh', 7, 10, 20) + struct.pack('<Hhh', 7, 30, 20)
+    frames = [
+        bytes([FRAME_DATA]) + b"frame broadcast test",
+        bytes([FRAME_SPRITE]) + sprite,
+        bytes([FRAME_DISPLAY_LIST]) + display_list,
+    ]
+    for frame in frames:
+        await ble_client.write_gatt_char(frame_char, frame, response=True)
+
+    await asyncio.sleep(FRAME_INTERVAL * (len(frames) + 2))
+
+    state, queued, seq, sent, _ = await read_status(ble_client, ble_characteristics)
+    assert state == STATE_ACTIVE
+    assert queued == 0
+    assert sent - sent_before == len(frames)
+    assert (seq - seq_before) & 0xFFFF == len(frames)
+
+
+@pytest.mark.asyncio
+async def test_broadcast_rejects_malformed_frames(ble_client, ble_characteristics):
+    """Test that unknown types and wrong sprite sizes are rejected"""
+    frame_char = ble_characteristics[BROADCAST_FRAME_UUID]
+
+    with pytest.raises(BleakError):
+        await ble_client.write_gatt_char(frame_char, bytes([0x7F, 0x00]), response=True)
+
+    with pytest.raises(BleakError):
+        await ble_client.write_gatt_char(frame_char, bytes([FRAME_SPRITE]) + bytes(10),
+                                         response=True)
+
+    with pytest.raises(BleakError):
+        await ble_client.write_gatt_char(frame_char, bytes([FRAME_DATA]) + bytes(201),
+                                         response=True)
+
+
+@pytest.mark.asyncio
+async def test_broadcast_queue_overflow_counts_drops(ble_client, ble_characteristics):
+    """Test that frames beyond the queue depth are dropped and counted"""
+    frame_char = ble_characteristics[BROADCAST_FRAME_UUID]
+
+    _, _, _, _, dropped_before = await read_status(ble_client, ble_characteristics)
+
+    # Without response the writes arrive much faster than one per interval
+    for i in range(20):
+        await ble_client.write_gatt_char(frame_char, bytes([FRAME_DATA, i]), response=False)
+
+    await asyncio.sleep(FRAME_INTERVAL * 12)
+
+    _, queued, _, _, dropped = await read_status(ble_client, ble_characteristics)
+    assert queued == 0
+    assert dropped > dropped_before
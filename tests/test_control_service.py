@@ -7,7 +7,13 @@ Tests for BLE Control Service (0xFFE0) - handles device control commands
 
 import pytest
 import asyncio
+import binascii
+import statistics
 import struct
+import time
+
+import ble_protocol as proto
+import trace_tool
 
 # Service UUIDs
 CONTROL_SERVICE_UUID = "0000ffe0-0000-1000-8000-00805f9b34fb"
@@ -15,6 +21,141 @@ CONTROL_SERVICE_UUID = "0000ffe0-0000-1000-8000-00805f9b34fb"
 # Characteristic UUIDs
 CONTROL_COMMAND_UUID = "0000ffe1-0000-1000-8000-00805f9b34fb"
 CONTROL_RESPONSE_UUID = "0000ffe2-0000-1000-8000-00805f9b34fb"
+CONTROL_STATUS_UUID = "0000ffe3-0000-1000-8000-00805f9b34fb"
+CONTROL_BATCH_UUID = "0000ffe4-0000-1000-8000-00805f9b34fb"
+CONTROL_BATCH_RESPONSE_UUID = "0000ffe5-0000-1000-8000-00805f9b34fb"
+CONTROL_TELEMETRY_UUID = "0000ffe6-0000-1000-8000-00805f9b34fb"
+
+# control_telemetry_packet_t: uptime, load, idle, 3 x (stack size, unused, cpu),
+# wasm3 heap size/used, BT TX/RX total/free, thread count, reserved, timestamp
+TELEMETRY_FORMAT = '<IHH' + 'HHH' * 3 + 'II' + 'BBBBBx' + 'Q'
+TELEMETRY_THREADS = ('bt_rx', 'sysworkq', 'wasm')
+
+CONTROL_BENCHMARK_UUID = "0000ffe7-0000-1000-8000-00805f9b34fb"
+CMD_RUN_BENCHMARK = 0x05
+
+# control_benchmark_result_t
+BENCHMARK_FORMAT = '<BBBBIIIIIIIIIQ'
+BENCHMARK_FIELDS = ('status', 'run_id', 'skipped', 'crc_kb', 'timer_freq_hz', 'crc16_cycles',
+                    'sprite_store_cycles', 'sprite_lookup_cycles', 'wasm_call_cycles',
+                    'memcpy_cycles', 'memcpy_bytes', 'notify_cycles', 'handler_cycles',
+                    'timestamp_us')
+BENCHMARK_STATUS_COMPLETE = 0x02
+BENCHMARK_SKIP_SPRITE = 0x01
+
+CONTROL_TIME_SYNC_UUID = "0000ffe8-0000-1000-8000-00805f9b34fb"
+
+# control_time_sync_request_t / control_time_sync_response_t
+TIME_SYNC_REQUEST_FORMAT = '<BxQQ'
+TIME_SYNC_RESPONSE_FORMAT = '<BBBxQQQqiI'
+TIME_SYNC_FIELDS = ('seq', 'flags', 'sample_count', 'client_t1_us', 'device_t2_us',
+                    'device_t3_us', 'offset_us', 'drift_ppb', 'rtt_us')
+TIME_SYNC_FLAG_OFFSET_VALID = 0x01
+
+CONTROL_HANDLER_STATS_UUID = "0000ffe9-0000-1000-8000-00805f9b34fb"
+# control_handler_stats_page_t header: total, first, count, flags, timer_freq_hz
+HANDLER_STATS_HEADER_FORMAT = '<BBBBI'
+# control_handler_stats_entry_t: name, calls, bytes, errors, max_cycles, 8 histogram buckets
+HANDLER_STATS_ENTRY_FORMAT = '<24sIIII8H'
+HANDLER_STATS_FLAG_RESET = 0x01
+HANDLER_STATS_FLAG_ENABLED = 0x01
+
+CMD_SET_LINK_PROFILE = 0x06
+CMD_GET_LINK_INFO = 0x07
+LINK_PROFILES = {'bulk': 0x00, 'low-latency': 0x01, 'low-power': 0x02}
+CMD_RESET_DEVICE = 0x02
+STATUS_PUSH_LATENCY = 0.5  # Event bus coalescing window plus a few connection events
+CMD_START_RELAY = 0x08
+CMD_GET_RELAY_STATUS = 0x09
+RELAY_CONTENT_SPRITES = 0x02
+RELAY_STATES = (0x00, 0x01, 0x02, 0x03)  # Idle, scanning, forwarding, done
+CMD_SET_TX_SCHEDULING = 0x0A
+TX_SCHEDULING_JITTER_SLACK_MS = 5.0  # Client stack and clock sync noise
+CMD_SET_ENCODING = 0x0B
+RESPONSE_SUCCESS = 0x00
+RESPONSE_ERROR_INVALID_DATA = 0x01
+
+DATA_UPLOAD_UUID = "0000fff1-0000-1000-8000-00805f9b34fb"
+SPRITE_UPLOAD_UUID = "0000fff9-0000-1000-8000-00805f9b34fb"
+
+
+def client_now_us():
+    """Client clock used for time sync, in microseconds"""
+    return time.time_ns() // 1000
+
+
+async def sync_clock(ble_client, ble_characteristics, exchanges=8, interval=0.2):
+    """Run NTP-style exchanges with the device and return the last response as a dict"""
+    sync_char = ble_characteristics[CONTROL_TIME_SYNC_UUID]
+    responses = asyncio.Queue()
+    
+    def on_notify(_sender, data):
+        # t4 is taken as early as possible, before any parsing
+        t4 = client_now_us()
+        responses.put_nowait((t4, dict(zip(TIME_SYNC_FIELDS,
+                                          struct.unpack(TIME_SYNC_RESPONSE_FORMAT, bytes(data))))))
+    
+    await ble_client.start_notify(sync_char, on_notify)
+    try:
+        prev_t4 = 0
+        response = None
+        for seq in range(exchanges):
+            request = struct.pack(TIME_SYNC_REQUEST_FORMAT, seq, client_now_us(), prev_t4)
+            await ble_client.write_gatt_char(sync_char, request, response=False)
+            prev_t4, response = await asyncio.wait_for(responses.get(), timeout=2.0)
+            assert response['seq'] == seq
+            await asyncio.sleep(interval)
+        
+        # One last request so the device folds in the final t4
+        request = struct.pack(TIME_SYNC_REQUEST_FORMAT, exchanges, client_now_us(), prev_t4)
+        await ble_client.write_gatt_char(sync_char, request, response=False)
+        _, response = await asyncio.wait_for(responses.get(), timeout=2.0)
+    finally:
+        await ble_client.stop_notify(sync_char)
+    
+    return response
+
+
+def build_batch(batch_id, commands):
+    """Pack (cmd_id, param1, param2) tuples into a control_batch_packet_t"""
+    packet = struct.pack('<BB', batch_id, len(commands))
+    for cmd_id, param1, param2 in commands:
+        packet += struct.pack('<BBB', cmd_id, param1, param2)
+    return packet
+
+
+def parse_batch_response(data):
+    """Unpack a control_batch_response_t into (batch_id, failed, [(cmd_id, status, result)])"""
+    batch_id, count, failed = struct.unpack('<BBB', data[:3])
+    results = []
+    for i in range(count):
+        offset = 3 + i * 8
+        cmd_id, status = struct.unpack('<BB', data[offset:offset + 2])
+        results.append((cmd_id, status, bytes(data[offset + 2:offset + 8])))
+    return batch_id, failed, results
+
+
+def parse_telemetry(data):
+    """Unpack a control_telemetry_packet_t into a dict"""
+    assert len(data) == struct.calcsize(TELEMETRY_FORMAT)
+    fields = struct.unpack(TELEMETRY_FORMAT, data)
+    telemetry = {
+        'uptime_ms': fields[0],
+        'cpu_load_permille': fields[1],
+        'idle_permille': fields[2],
+        'wasm3_heap_size': fields[12],
+        'wasm3_heap_used': fields[13],
+        'bt_tx_bufs_total': fields[14],
+        'bt_tx_bufs_free': fields[15],
+        'bt_rx_bufs_total': fields[16],
+        'bt_rx_bufs_free': fields[17],
+        'thread_count': fields[18],
+        'timestamp_us': fields[19],
+    }
+    for i, name in enumerate(TELEMETRY_THREADS):
+        size, unused, cpu = fields[3 + i * 3:6 + i * 3]
+        telemetry[name] = {'stack_size': size, 'stack_unused': unused, 'cpu_permille': cpu}
+    return telemetry
 
 
 def test_control_service_exists(ble_services, ble_characteristics):
@@ -71,3 +212,634 @@ async def test_control_service_commands(ble_client, ble_services, ble_characteri
         for cmd in test_commands:
             await ble_client.write_gatt_char(command_char, cmd)
             await asyncio.sleep(0.05)
+
+
+@pytest.mark.asyncio
+async def test_control_status_pushed_on_change(ble_client, ble_characteristics):
+    """Test that a device status change is notified right away instead of polled"""
+    
+    status_char = ble_characteristics[CONTROL_STATUS_UUID]
+    received = asyncio.Event()
+    statuses = []
+    
+    def on_notify(_sender, data):
+        statuses.append(struct.unpack('<BI3x', bytes(data)))
+        received.set()
+    
+    await ble_client.start_notify(status_char, on_notify)
+    try:
+        start = time.perf_counter()
+        await ble_client.write_gatt_char(ble_characteristics[CONTROL_COMMAND_UUID],
+                                         struct.pack('<BBB17x', CMD_RESET_DEVICE, 0, 0))
+        await asyncio.wait_for(received.wait(), timeout=STATUS_PUSH_LATENCY * 4)
+        latency = time.perf_counter() - start
+    finally:
+        await ble_client.stop_notify(status_char)
+    
+    print(f"\nStatus pushed after {latency * 1000:.0f} ms")
+    device_status, uptime_s = statuses[-1]
+    assert device_status == 0x00  # Reset sets the device idle
+    assert latency < STATUS_PUSH_LATENCY
+
+@pytest.mark.asyncio
+async def test_control_status_repeated_reads(ble_client, ble_characteristics):
+    """Test that cached status reads stay current across an uptime tick"""
+    
+    status_char = ble_characteristics[CONTROL_STATUS_UUID]
+    start = time.perf_counter()
+    reads = []
+    
+    while time.perf_counter() - start < 2.5:
+        reads.append(struct.unpack('<BI3x', bytes(await ble_client.read_gatt_char(status_char))))
+    
+    uptimes = [uptime_s for _, uptime_s in reads]
+    assert uptimes == sorted(uptimes)
+    # A value cached past the second boundary would hold the uptime back
+    assert uptimes[-1] - uptimes[0] >= 2
+    assert len({device_status for device_status, _ in reads}) == 1
+
+@pytest.mark.asyncio
+async def test_control_batch_single_notification(ble_client, ble_characteristics, serial_capture):
+    """Test that a batch of commands returns all results in one notification"""
+    
+    assert CONTROL_BATCH_UUID in ble_characteristics
+    assert CONTROL_BATCH_RESPONSE_UUID in ble_characteristics
+    
+    batch_char = ble_characteristics[CONTROL_BATCH_UUID]
+    response_char = ble_characteristics[CONTROL_BATCH_RESPONSE_UUID]
+    
+    commands = [
+        (0x01, 0x00, 0x00),  # CMD_GET_STATUS
+        (0x03, 0x42, 0x00),  # CMD_SET_CONFIG
+        (0x04, 0x00, 0x00),  # CMD_GET_VERSION
+        (0x7E, 0x00, 0x00),  # Unknown command - must fail without aborting the batch
+    ]
+    
+    notifications = []
+    received = asyncio.Event()
+    
+    def on_notify(_sender, data):
+        notifications.append(bytes(data))
+        received.set()
+    
+    await ble_client.start_notify(response_char, on_notify)
+    try:
+        with serial_capture:
+            await ble_client.write_gatt_char(batch_char, build_batch(0x5A, commands), response=True)
+            await asyncio.wait_for(received.wait(), timeout=2.0)
+    finally:
+        await ble_client.stop_notify(response_char)
+    
+    assert len(notifications) == 1
+    batch_id, failed, results = parse_batch_response(notifications[0])
+    assert batch_id == 0x5A
+    assert failed == 1
+    assert [r[0] for r in results] == [c[0] for c in commands]
+    assert results[2][2][:3] == bytes([1, 0, 0])  # Version 1.0.0
+    assert results[3][1] == 0xFF                   # RESPONSE_ERROR_UNKNOWN_CMD
+    
+    # The same results must be readable for clients that do not subscribe
+    data = await ble_client.read_gatt_char(response_char)
+    assert parse_batch_response(data) == (batch_id, failed, results)
+
+
+@pytest.mark.asyncio
+async def test_control_batch_rejects_length_mismatch(ble_client, ble_characteristics):
+    """Test that a batch whose count disagrees with its length is rejected"""
+    
+    batch_char = ble_characteristics[CONTROL_BATCH_UUID]
+    
+    # Header claims 3 records but only 2 follow
+    packet = struct.pack('<BB', 0x01, 3) + struct.pack('<BBBBBB', 0x01, 0, 0, 0x04, 0, 0)
+    
+    with pytest.raises(Exception):
+        await ble_client.write_gatt_char(batch_char, packet, response=True)
+
+
+@pytest.mark.asyncio
+async def test_control_telemetry_read(ble_client, ble_characteristics):
+    """Test that a telemetry snapshot reports sane stack, CPU and buffer figures"""
+    
+    assert CONTROL_TELEMETRY_UUID in ble_characteristics
+    telemetry_char = ble_characteristics[CONTROL_TELEMETRY_UUID]
+    
+    telemetry = parse_telemetry(await ble_client.read_gatt_char(telemetry_char))
+    
+    assert telemetry['uptime_ms'] > 0
+    assert telemetry['cpu_load_permille'] + telemetry['idle_permille'] <= 1000
+    assert telemetry['thread_count'] >= len(TELEMETRY_THREADS)
+    assert telemetry['wasm3_heap_size'] == 64 * 1024
+    assert telemetry['bt_tx_bufs_free'] <= telemetry['bt_tx_bufs_total']
+    assert telemetry['bt_rx_bufs_free'] <= telemetry['bt_rx_bufs_total']
+    
+    # Every tracked thread must be found and must not have overflowed
+    for name in TELEMETRY_THREADS:
+        thread = telemetry[name]
+        assert thread['stack_size'] > 0, f"{name} thread not found"
+        assert 0 < thread['stack_unused'] < thread['stack_size']
+    assert telemetry['sysworkq']['stack_size'] == 16384
+    assert telemetry['wasm']['stack_size'] == 16384
+
+
+@pytest.mark.asyncio
+async def test_control_telemetry_streams(ble_client, ble_characteristics):
+    """Test that subscribing to telemetry yields periodic notifications"""
+    
+    telemetry_char = ble_characteristics[CONTROL_TELEMETRY_UUID]
+    samples = []
+    
+    def on_notify(_sender, data):
+        samples.append(parse_telemetry(bytes(data)))
+    
+    await ble_client.start_notify(telemetry_char, on_notify)
+    try:
+        await asyncio.sleep(3.5)
+    finally:
+        await ble_client.stop_notify(telemetry_char)
+    
+    # One sample on subscribe, then one per second
+    assert len(samples) >= 3
+    uptimes = [s['uptime_ms'] for s in samples]
+    assert uptimes == sorted(uptimes)
+    for earlier, later in zip(uptimes, uptimes[1:]):
+        assert 800 <= later - earlier <= 1500
+
+
+async def run_benchmark(ble_client, ble_characteristics, crc_kb):
+    """Run the on-device benchmark suite and return the final result as a dict"""
+    command_char = ble_characteristics[CONTROL_COMMAND_UUID]
+    benchmark_char = ble_characteristics[CONTROL_BENCHMARK_UUID]
+    
+    done = asyncio.Event()
+    results = []
+    
+    def on_notify(_sender, data):
+        result = dict(zip(BENCHMARK_FIELDS, struct.unpack(BENCHMARK_FORMAT, bytes(data))))
+        # In-progress packets are sent while timing notification enqueue cost
+        if result['status'] == BENCHMARK_STATUS_COMPLETE:
+            results.append(result)
+            done.set()
+    
+    await ble_client.start_notify(benchmark_char, on_notify)
+    try:
+        await ble_client.write_gatt_char(command_char,
+                                         struct.pack('<BBB17x', CMD_RUN_BENCHMARK, crc_kb, 0))
+        await asyncio.wait_for(done.wait(), timeout=15.0)
+    finally:
+        await ble_client.stop_notify(benchmark_char)
+    
+    return results[0]
+
+
+@pytest.mark.perf
+@pytest.mark.asyncio
+async def test_control_benchmark_command(request, ble_client, ble_characteristics, perf_recorder):
+    """Test that the benchmark command returns cycle counts for every test"""
+    
+    assert CONTROL_BENCHMARK_UUID in ble_characteristics
+    
+    result = await run_benchmark(ble_client, ble_characteristics, crc_kb=4)
+    perf_recorder.record_values(request.node.name, "firmware_benchmark",
+                                {k: v for k, v in result.items()
+                                 if k.endswith('_cycles') or k in ('crc_kb', 'memcpy_bytes', 'timer_freq_hz')})
+    
+    assert result['crc_kb'] == 4
+    assert result['timer_freq_hz'] > 0
+    assert result['crc16_cycles'] > 0
+    assert result['wasm_call_cycles'] > 0
+    assert result['memcpy_cycles'] > 0
+    assert result['memcpy_bytes'] > 0
+    assert result['notify_cycles'] > 0
+    assert result['handler_cycles'] > 0
+    if not result['skipped'] & BENCHMARK_SKIP_SPRITE:
+        assert result['sprite_store_cycles'] > 0
+        assert result['sprite_lookup_cycles'] > 0
+    
+    # Larger CRC input must cost proportionally more
+    larger = await run_benchmark(ble_client, ble_characteristics, crc_kb=16)
+    assert larger['run_id'] == (result['run_id'] + 1) & 0xFF
+    assert 3.0 < larger['crc16_cycles'] / result['crc16_cycles'] < 5.0
+
+
+@pytest.mark.asyncio
+async def test_control_time_sync(ble_client, ble_characteristics):
+    """Test that the device estimates the client clock offset"""
+    
+    assert CONTROL_TIME_SYNC_UUID in ble_characteristics
+    
+    response = await sync_clock(ble_client, ble_characteristics)
+    
+    assert response['flags'] & TIME_SYNC_FLAG_OFFSET_VALID
+    assert response['sample_count'] >= 2
+    assert response['device_t2_us'] <= response['device_t3_us']
+    
+    # The device's view of our clock must agree with our own clock to within a round trip
+    device_t2_as_client = response['device_t2_us'] + response['offset_us']
+    assert abs(device_t2_as_client - response['client_t1_us']) < response['rtt_us'] + 50000
+    
+    # Crystal drift between two clocks is at most a few hundred ppm
+    assert abs(response['drift_ppb']) < 1000000
+
+
+@pytest.mark.asyncio
+async def test_control_telemetry_in_client_timebase(ble_client, ble_characteristics):
+    """Test that telemetry timestamps use the client clock once synchronized"""
+    
+    await sync_clock(ble_client, ble_characteristics)
+    
+    before = client_now_us()
+    telemetry = parse_telemetry(
+        await ble_client.read_gatt_char(ble_characteristics[CONTROL_TELEMETRY_UUID]))
+    after = client_now_us()
+    
+    assert before - 50000 <= telemetry['timestamp_us'] <= after + 50000
+
+
+async def read_handler_stats(ble_client, ble_characteristics, reset=False):
+    """Page through the handler stats table and return (flags, {name: entry})"""
+    stats_char = ble_characteristics[CONTROL_HANDLER_STATS_UUID]
+    header_size = struct.calcsize(HANDLER_STATS_HEADER_FORMAT)
+    entry_size = struct.calcsize(HANDLER_STATS_ENTRY_FORMAT)
+    
+    await ble_client.write_gatt_char(stats_char,
+                                     struct.pack('<BB', 0, HANDLER_STATS_FLAG_RESET if reset else 0),
+                                     response=True)
+    entries = {}
+    first = 0
+    while True:
+        data = bytes(await ble_client.read_gatt_char(stats_char))
+        total, page_first, count, flags, _ = struct.unpack_from(HANDLER_STATS_HEADER_FORMAT, data)
+        assert page_first == first
+        assert len(data) == header_size + count * entry_size
+        for i in range(count):
+            fields = struct.unpack_from(HANDLER_STATS_ENTRY_FORMAT, data, header_size + i * entry_size)
+            name = fields[0].rstrip(b'\0').decode()
+            entries[name] = {'calls': fields[1], 'bytes': fields[2], 'errors': fields[3],
+                             'max_cycles': fields[4], 'hist': fields[5:]}
+        first += count
+        if count == 0 or first >= total:
+            return flags, entries
+        await ble_client.write_gatt_char(stats_char, struct.pack('<BB', first, 0), response=True)
+
+
+async def control_command(ble_client, ble_characteristics, cmd_id, param1=0, param2=0):
+    """Send one control command and return (status, result) from the response characteristic"""
+    await ble_client.write_gatt_char(ble_characteristics[CONTROL_COMMAND_UUID],
+                                     struct.pack('<BBB17x', cmd_id, param1, param2))
+    data = await ble_client.read_gatt_char(ble_characteristics[CONTROL_RESPONSE_UUID])
+    assert data[0] == cmd_id
+    return data[1], bytes(data[2:8])
+
+
+async def set_link_profile(ble_client, ble_characteristics, profile, settle=1.0):
+    """Request a link profile and return the link info once the procedures settled"""
+    status, result = await control_command(ble_client, ble_characteristics,
+                                           CMD_SET_LINK_PROFILE, profile)
+    assert status == RESPONSE_SUCCESS
+    assert result[0] == profile
+    
+    # PHY, data length and interval updates take a few connection events each
+    await asyncio.sleep(settle)
+    
+    status, result = await control_command(ble_client, ble_characteristics, CMD_GET_LINK_INFO)
+    assert status == RESPONSE_SUCCESS
+    profile_id, tx_phy, interval, tx_data_len, mtu = struct.unpack('<BBHBB', result)
+    return {'profile': profile_id, 'tx_phy': tx_phy, 'interval_ms': interval * 1.25,
+            'tx_data_len': tx_data_len, 'mtu': mtu}
+
+
+@pytest.mark.asyncio
+async def test_control_handler_stats(ble_client, ble_characteristics):
+    """Test that the wrapper macros count calls, bytes and errors per characteristic"""
+    
+    flags, _ = await read_handler_stats(ble_client, ble_characteristics, reset=True)
+    if not flags & HANDLER_STATS_FLAG_ENABLED:
+        pytest.skip("Built without CONFIG_BLE_HANDLER_STATS")
+    
+    status_char = ble_characteristics[CONTROL_STATUS_UUID]
+    for _ in range(5):
+        await ble_client.read_gatt_char(status_char)
+    await control_command(ble_client, ble_characteristics, CMD_RESET_DEVICE)
+    # Too short for a command packet: rejected by the wrapper
+    with pytest.raises(Exception):
+        await ble_client.write_gatt_char(ble_characteristics[CONTROL_COMMAND_UUID], b'\x01',
+                                         response=True)
+    
+    _, entries = await read_handler_stats(ble_client, ble_characteristics)
+    
+    status = entries['control_status_handler']
+    assert status['calls'] == 5
+    assert status['bytes'] == 5 * 8
+    assert status['errors'] == 0
+    
+    command = entries['control_command_handler']
+    assert command['calls'] == 2
+    assert command['errors'] == 1
+    assert command['bytes'] == 20
+    
+    for entry in entries.values():
+        assert sum(entry['hist']) == entry['calls']
+
+
+@pytest.mark.asyncio
+async def test_control_link_profile_rejects_unknown(ble_client, ble_characteristics):
+    """Test that an unknown link profile is refused"""
+    
+    status, _ = await control_command(ble_client, ble_characteristics, CMD_SET_LINK_PROFILE, 0x7F)
+    assert status == RESPONSE_ERROR_INVALID_DATA
+
+
+@pytest.mark.slow
+@pytest.mark.asyncio
+async def test_control_link_profiles(ble_client, ble_characteristics):
+    """Measure upload throughput and notification cost under each link profile"""
+    
+    upload_char = ble_characteristics[DATA_UPLOAD_UUID]
+    chunk = bytes(i % 256 for i in range(min(ble_client.mtu_size - 3, 244)))
+    chunks = 40
+    
+    report = {}
+    try:
+        for name, profile in LINK_PROFILES.items():
+            info = await set_link_profile(ble_client, ble_characteristics, profile)
+            assert info['profile'] == profile
+            
+            # Write with response: every chunk costs at least one connection event
+            start = time.perf_counter()
+            for _ in range(chunks):
+                await ble_client.write_gatt_char(upload_char, chunk, response=True)
+            elapsed = time.perf_counter() - start
+            
+            benchmark = await run_benchmark(ble_client, ble_characteristics, crc_kb=1)
+            report[name] = dict(info,
+                                kbps=len(chunk) * chunks * 8 / elapsed / 1000,
+                                write_ms=elapsed * 1000 / chunks,
+                                notify_us=benchmark['notify_cycles'] * 1e6 / benchmark['timer_freq_hz'])
+    finally:
+        await set_link_profile(ble_client, ble_characteristics, LINK_PROFILES['low-latency'], settle=0)
+    
+    print(f"\n{'profile':<12} {'phy':>3} {'int ms':>7} {'dle':>4} {'mtu':>4} "
+          f"{'kbit/s':>7} {'ms/write':>8} {'notify us':>9}")
+    for name, row in report.items():
+        print(f"{name:<12} {row['tx_phy']:>3} {row['interval_ms']:>7.2f} {row['tx_data_len']:>4} "
+              f"{row['mtu']:>4} {row['kbps']:>7.1f} {row['write_ms']:>8.2f} {row['notify_us']:>9.1f}")
+    
+    # Round trips are bounded by the interval, so the long-interval profile must be slowest
+    assert report['low-power']['write_ms'] > report['low-latency']['write_ms']
+
+
+@pytest.mark.asyncio
+async def test_control_tx_scheduling_rejects_invalid(ble_client, ble_characteristics):
+    """Test that TX scheduling only takes on or off"""
+    
+    status, _ = await control_command(ble_client, ble_characteristics, CMD_SET_TX_SCHEDULING, 2)
+    assert status == RESPONSE_ERROR_INVALID_DATA
+
+
+@pytest.mark.slow
+@pytest.mark.asyncio
+async def test_control_tx_scheduling(ble_client, ble_characteristics):
+    """Compare telemetry latency jitter and upload throughput with notifications
+    filled at arbitrary times and just before each connection event"""
+    
+    _, result = await control_command(ble_client, ble_characteristics, CMD_SET_TX_SCHEDULING, 1)
+    if not result[0]:
+        pytest.skip("Built without CONFIG_CONN_SCHED_RADIO_NOTIFICATION")
+    
+    await sync_clock(ble_client, ble_characteristics)
+    
+    telemetry_char = ble_characteristics[CONTROL_TELEMETRY_UUID]
+    upload_char = ble_characteristics[DATA_UPLOAD_UUID]
+    chunk = bytes(i % 256 for i in range(min(ble_client.mtu_size - 3, 244)))
+    chunks = 40
+    
+    report = {}
+    try:
+        for name, enabled in (('unaligned', 0), ('aligned', 1)):
+            status, result = await control_command(ble_client, ble_characteristics,
+                                                   CMD_SET_TX_SCHEDULING, enabled)
+            assert status == RESPONSE_SUCCESS
+            assert result[0] == enabled
+            
+            latencies = []
+            
+            def on_notify(_sender, data):
+                # Sample to arrival, both in the client timebase
+                arrival = client_now_us()
+                latencies.append((arrival - parse_telemetry(bytes(data))['timestamp_us']) / 1000)
+            
+            await ble_client.start_notify(telemetry_char, on_notify)
+            try:
+                # Uploads keep the link busy while telemetry streams
+                start = time.perf_counter()
+                for _ in range(chunks):
+                    await ble_client.write_gatt_char(upload_char, chunk, response=True)
+                elapsed = time.perf_counter() - start
+                await asyncio.sleep(max(0.0, 10.0 - elapsed))
+            finally:
+                await ble_client.stop_notify(telemetry_char)
+            
+            report[name] = {'samples': len(latencies),
+                            'median_ms': statistics.median(latencies),
+                            'jitter_ms': statistics.pstdev(latencies),
+                            'kbps': len(chunk) * chunks * 8 / elapsed / 1000}
+    finally:
+        await control_command(ble_client, ble_characteristics, CMD_SET_TX_SCHEDULING, 1)
+    
+    print(f"\n{'mode':<10} {'samples':>7} {'median ms':>9} {'jitter ms':>9} {'kbit/s':>7}")
+    for name, row in report.items():
+        print(f"{name:<10} {row['samples']:>7} {row['median_ms']:>9.2f} "
+              f"{row['jitter_ms']:>9.2f} {row['kbps']:>7.1f}")
+    
+    for row in report.values():
+        assert row['samples'] >= 8
+    # Aligned samples are taken a fixed lead time before the event that sends them
+    assert report['aligned']['jitter_ms'] <= report['unaligned']['jitter_ms'] + TX_SCHEDULING_JITTER_SLACK_MS
+
+
+@pytest.mark.asyncio
+async def test_control_relay_rejects_empty_content(ble_client, ble_characteristics):
+    """Test that a relay with nothing selected to forward is refused"""
+    
+    status, _ = await control_command(ble_client, ble_characteristics, CMD_START_RELAY, 0x00, 1)
+    assert status == RESPONSE_ERROR_INVALID_DATA
+
+
+@pytest.mark.asyncio
+async def test_control_relay_status(ble_client, ble_characteristics):
+    """Test that relay progress can be read at any time"""
+    
+    status, result = await control_command(ble_client, ble_characteristics, CMD_GET_RELAY_STATUS)
+    assert status == RESPONSE_SUCCESS
+    state, updated, skipped, failed, active, elapsed_s = result
+    assert state in RELAY_STATES
+    assert active <= 3  # CONFIG_BT_MAX_CONN - 1 outgoing connections
+
+
+@pytest.mark.slow
+@pytest.mark.asyncio
+async def test_control_relay_runs_to_completion(ble_client, ble_characteristics):
+    """Relay the sprite registry and wait for the scan rounds to finish
+    
+    Without peers in range the run ends after one empty scan round. Relaying
+    to a fleet is covered by the BabbleSim test in bsim/relay_fleet.
+    """
+    
+    # Make sure there is at least one sprite to forward
+    bitmap = bytes(range(32))
+    sprite = struct.pack('<H', 0x0101) + bitmap + struct.pack('<H', binascii.crc_hqx(bitmap, 0xFFFF))
+    await ble_client.write_gatt_char(ble_characteristics[SPRITE_UPLOAD_UUID], sprite, response=True)
+    
+    status, _ = await control_command(ble_client, ble_characteristics, CMD_START_RELAY,
+                                      RELAY_CONTENT_SPRITES, 0)
+    assert status == RESPONSE_SUCCESS
+    
+    for _ in range(60):
+        await asyncio.sleep(1.0)
+        status, result = await control_command(ble_client, ble_characteristics,
+                                                CMD_GET_RELAY_STATUS)
+        if result[0] == RELAY_STATES[3]:
+            break
+    else:
+        pytest.fail("Relay did not finish")
+    
+    print(f"\nRelay: {result[1]} updated, {result[2]} skipped, {result[3]} failed "
+          f"in {result[5]} s")
+
+
+@pytest.mark.asyncio
+async def test_control_encoding_rejects_unknown(ble_client, ble_characteristics):
+    """Test that an unsupported encoding is refused and the connection stays legacy"""
+    
+    status, result = await control_command(ble_client, ble_characteristics, CMD_SET_ENCODING, 0xFF)
+    assert status == RESPONSE_ERROR_INVALID_DATA
+    assert result[proto.ENCODING_RESULT_ACTIVE] == proto.COMPACT_ENCODING_LEGACY
+    assert result[proto.ENCODING_RESULT_LATEST] >= proto.COMPACT_ENCODING_V1
+
+
+@pytest.mark.asyncio
+async def test_control_compact_encoding(ble_client, ble_characteristics):
+    """Compare the bytes written per operation with the legacy and compact encodings"""
+    
+    flags, _ = await read_handler_stats(ble_client, ble_characteristics, reset=True)
+    if not flags & HANDLER_STATS_FLAG_ENABLED:
+        pytest.skip("Built without CONFIG_BLE_HANDLER_STATS")
+    
+    command_char = ble_characteristics[CONTROL_COMMAND_UUID]
+    operations = {
+        'control_command_handler': (command_char, proto.ControlCommandPacket(cmd_id=proto.CMD_GET_STATUS)),
+        'wasm_execute_handler': (ble_characteristics[proto.WASM_EXECUTE_UUID],
+                                 proto.WasmExecutePacket(function_name="add", args=[2, 3])),
+    }
+    rounds = 5
+    encoding = proto.COMPACT_ENCODING_LEGACY
+    
+    async def set_encoding(new_encoding):
+        # Sent in the encoding in use until the response confirms the switch
+        packet = proto.ControlCommandPacket(cmd_id=CMD_SET_ENCODING, param1=new_encoding)
+        await ble_client.write_gatt_char(command_char, packet.encode(encoding), response=True)
+        response = proto.ControlResponsePacket.unpack(
+            await ble_client.read_gatt_char(ble_characteristics[CONTROL_RESPONSE_UUID]))
+        assert response.status == RESPONSE_SUCCESS
+        assert response.result[proto.ENCODING_RESULT_ACTIVE] == new_encoding
+        return new_encoding
+    
+    report = {}
+    try:
+        for mode in (proto.COMPACT_ENCODING_LEGACY, proto.COMPACT_ENCODING_V1):
+            encoding = await set_encoding(mode)
+            await read_handler_stats(ble_client, ble_characteristics, reset=True)
+            for _ in range(rounds):
+                for char, packet in operations.values():
+                    await ble_client.write_gatt_char(char, packet.encode(encoding), response=True)
+            _, entries = await read_handler_stats(ble_client, ble_characteristics)
+            for name in operations:
+                assert entries[name]['calls'] == rounds
+                assert entries[name]['errors'] == 0
+            report[mode] = {name: entries[name]['bytes'] / rounds for name in operations}
+    finally:
+        encoding = await set_encoding(proto.COMPACT_ENCODING_LEGACY)
+    
+    legacy = report[proto.COMPACT_ENCODING_LEGACY]
+    compact = report[proto.COMPACT_ENCODING_V1]
+    print(f"\n{'handler':<24} {'legacy':>6} {'compact':>7}  (bytes per write, plus 3 ATT header)")
+    for name in operations:
+        print(f"{name:<24} {legacy[name]:>6.1f} {compact[name]:>7.1f}")
+    
+    assert legacy['control_command_handler'] == proto.ControlCommandPacket.SIZE
+    assert legacy['wasm_execute_handler'] == proto.WasmExecutePacket.SIZE
+    for name in operations:
+        assert compact[name] < legacy[name]
+
+
+@pytest.mark.asyncio
+async def test_control_trace(ble_client, ble_characteristics):
+    """Test that the trace ring records GATT handler slices and downloads intact"""
+    client = proto.BLEProtocolClient(ble_client)
+    
+    # Empty ring, recording
+    await client.write_control_trace(proto.ControlTraceSelect(
+        flags=proto.CONTROL_TRACE_FLAG_CLEAR | proto.CONTROL_TRACE_FLAG_RESUME))
+    page = await client.read_control_trace()
+    if not page.flags & proto.CONTROL_TRACE_FLAG_ENABLED:
+        pytest.skip("Built without CONFIG_APP_TRACE")
+    assert not page.flags & proto.CONTROL_TRACE_FLAG_FROZEN
+    assert page.total_len == 0
+    
+    reads = 5
+    for _ in range(reads):
+        await ble_client.read_gatt_char(ble_characteristics[CONTROL_STATUS_UUID])
+    
+    trace = trace_tool.parse_dump(await trace_tool.download_trace(client))
+    
+    gatt_reads = [e for e in trace.events if e.name == 'gatt_read']
+    begins = [e for e in gatt_reads if e.phase == proto.APP_TRACE_PHASE_BEGIN]
+    ends = [e for e in gatt_reads if e.phase == proto.APP_TRACE_PHASE_END]
+    # The status reads, plus the trace page reads of the download itself
+    assert len(begins) >= reads
+    assert len(ends) >= reads
+    assert trace.dropped == 0
+    assert all(e.thread in trace.threads for e in trace.events)
+    assert [e.cycles for e in trace.events] == sorted(e.cycles for e in trace.events)
+    
+    chrome = trace_tool.to_chrome_json(trace)
+    slices = [e for e in chrome['traceEvents'] if e['ph'] == 'E']
+    assert len(slices) >= reads
+    
+    # Recording again after the download
+    page = await client.read_control_trace()
+    assert not page.flags & proto.CONTROL_TRACE_FLAG_FROZEN
+
+
+@pytest.mark.asyncio
+async def test_control_memory(ble_client, ble_characteristics):
+    """Test that services borrow from the shared pool and report usage and peaks"""
+    client = proto.BLEProtocolClient(ble_client)
+    
+    await client.write_control_memory(proto.ControlMemorySelect(
+        flags=proto.CONTROL_MEMORY_FLAG_RESET_PEAKS))
+    before = await client.read_control_memory()
+    clients = {c.name: c for c in before.clients}
+    
+    assert before.count == len(before.clients)
+    assert set(clients) == {'wasm', 'data', 'dfu'}
+    assert before.pool_size % before.block_size == 0
+    assert before.used == sum(c.used for c in before.clients)
+    assert before.peak == before.used
+    for c in before.clients:
+        assert c.used <= c.quota
+        assert c.peak == c.used
+        assert c.failures == 0
+    
+    # An upload keeps an echo buffer until disconnect and borrows nothing per write
+    await client.write_data_upload(proto.DataUploadPacket(data=b'budget' * 10))
+    await client.write_data_upload(proto.DataUploadPacket(data=b'budget' * 10))
+    after = await client.read_control_memory()
+    data_before = clients['data']
+    data_after = next(c for c in after.clients if c.name == 'data')
+    
+    assert data_after.used >= proto.DATA_BUFFER_SIZE
+    assert data_after.used <= data_before.used + proto.DATA_BUFFER_SIZE
+    assert data_after.peak == data_after.used
+    assert after.peak >= after.used
+    assert after.used == sum(c.used for c in after.clients)
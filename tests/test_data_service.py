@@ -5,6 +5,7 @@ Data Service Tests
 Tests for BLE Data Service (0xFFF0) - handles data upload/download operations
 """
 
+import os
 import pytest
 import asyncio
 import logging
@@ -18,6 +19,20 @@ DATA_SERVICE_UUID = "0000fff0-0000-1000-8000-00805f9b34fb"
 DATA_UPLOAD_UUID = "0000fff1-0000-1000-8000-00805f9b34fb"
 DATA_DOWNLOAD_UUID = "0000fff2-0000-1000-8000-00805f9b34fb"
 
+# Per-packet traces are debug level and compiled out by default. Build with
+# CONFIG_DATA_SERVICE_LOG_LEVEL_DBG=y and set DATA_SERVICE_DEBUG_LOGS=1 to check them.
+DEBUG_LOGS = os.environ.get("DATA_SERVICE_DEBUG_LOGS") == "1"
+
+
+def assert_upload_logged(serial_output, length):
+    """Check the upload handler's debug trace for a packet of the given length"""
+    if not DEBUG_LOGS:
+        return
+    assert "data_service: data_upload_handler called" in serial_output
+    assert f"data_service: Upload received {length} bytes" in serial_output
+    assert "data_service: Transfer complete" in serial_output
+    assert f"data_service: Saved {length} bytes for echo" in serial_output
+
 
 def test_data_service_exists(ble_services, ble_characteristics):
     """Test that Data Service is discovered"""
@@ -56,10 +71,7 @@ async def test_data_service_small_packet(ble_client, ble_services, ble_character
     # Verify expected serial output from upload workflow
     serial_result = serial_capture.readouterr()
     serial_output = serial_result.out
-    assert "=== Data Service: data_upload_handler called ===" in serial_output
-    assert f"Data Service: Upload received {len(test_data)} bytes" in serial_output
-    assert "Data Service: Transfer complete" in serial_output
-    assert f"Data Service: Saved {len(test_data)} bytes for echo" in serial_output
+    assert_upload_logged(serial_output, len(test_data))
 
 
 @pytest.mark.parametrize("packet_size", [16, 32, 64, 128, 200])
@@ -87,9 +99,7 @@ async def test_data_service_large_packets(ble_client, ble_services, ble_characte
     # Verify expected serial output for this packet size
     serial_result = serial_capture.readouterr()
     serial_output = serial_result.out
-    assert f"Data Service: Upload received {packet_size} bytes" in serial_output
-    assert f"Data Service: Saved {packet_size} bytes for echo" in serial_output
-    assert "Data Service: Transfer complete" in serial_output
+    assert_upload_logged(serial_output, packet_size)
 
 
 @pytest.mark.asyncio
@@ -117,10 +127,7 @@ async def test_data_service_round_trip(ble_client, ble_services, ble_characteris
     # Verify round-trip workflow in serial output
     serial_result = serial_capture.readouterr()
     serial_output = serial_result.out
-    assert "=== Data Service: data_upload_handler called ===" in serial_output
-    assert f"Data Service: Upload received {len(test_data)} bytes" in serial_output
-    assert "Data Service: Transfer complete" in serial_output
-    assert f"Data Service: Saved {len(test_data)} bytes for echo" in serial_output
+    assert_upload_logged(serial_output, len(test_data))
 
 
 @pytest.mark.asyncio
@@ -147,10 +154,8 @@ async def test_data_service_packet_processing(ble_client, ble_services, ble_char
     serial_result = serial_capture.readouterr()
     serial_output = serial_result.out
 
-    assert "=== Data Service: data_upload_handler called ===" in serial_output
-    assert f"Data Service: Upload received {len(test_data)} bytes" in serial_output
-    assert "Data Service: Transfer complete" in serial_output
-    assert f"Data Service: Saved {len(test_data)} bytes for echo" in serial_output
+    assert_upload_logged(serial_output, len(test_data))
     # Verify data processing occurred
-    assert f"Data Service: Processing {len(test_data)} bytes of data" in serial_output
+    if DEBUG_LOGS:
+        assert f"data_service: Processing {len(test_data)} bytes of data" in serial_output
 
@@ -7,6 +7,8 @@ Tests for BLE Device Information Service (0x180A)
 
 import pytest
 
+import ble_protocol as proto
+
 # Service UUIDs
 DEVICE_INFO_SERVICE_UUID = "0000180a-0000-1000-8000-00805f9b34fb"
 
@@ -16,6 +18,7 @@ MODEL_NUMBER_UUID = "00002a24-0000-1000-8000-00805f9b34fb"
 FIRMWARE_REVISION_UUID = "00002a26-0000-1000-8000-00805f9b34fb"
 HARDWARE_REVISION_UUID = "00002a27-0000-1000-8000-00805f9b34fb"
 SOFTWARE_REVISION_UUID = "00002a28-0000-1000-8000-00805f9b34fb"
+DEVICE_CAPABILITIES_UUID = "0000ffdc-0000-1000-8000-00805f9b34fb"
 
 
 def test_device_info_service_exists(ble_services):
@@ -44,3 +47,52 @@ async def test_device_info_characteristics_properties(ble_client, ble_characteri
     data = await ble_client.read_gatt_char(char)
     value = data.decode('utf-8').strip('\x00')
     assert len(value) > 0
+
+
+@pytest.mark.asyncio
+async def test_device_capabilities(ble_client, ble_characteristics):
+    """Test that the capabilities match this firmware and the generated client"""
+    assert DEVICE_CAPABILITIES_UUID in ble_characteristics
+    
+    data = await ble_client.read_gatt_char(ble_characteristics[DEVICE_CAPABILITIES_UUID])
+    assert len(data) == proto.DeviceCapabilities.SIZE
+    caps = proto.DeviceCapabilities.unpack(data)
+    
+    assert caps.version == proto.DEVICE_CAPS_VERSION
+    assert caps.protocol_fingerprint == proto.FINGERPRINT, "Regenerate ble_protocol.py or reflash"
+    assert caps.build_profile in (proto.DEVICE_BUILD_DEBUG, proto.DEVICE_BUILD_SIZE,
+                                  proto.DEVICE_BUILD_SPEED)
+    
+    # Features every build has, limits from the headers
+    required = (proto.DEVICE_CAP_CONTROL_BATCH | proto.DEVICE_CAP_COMPACT_ENCODING |
+                proto.DEVICE_CAP_WASM)
+    assert caps.features & required == required
+    assert caps.encodings & (1 << proto.COMPACT_ENCODING_LEGACY)
+    assert caps.encodings & (1 << proto.COMPACT_ENCODING_V1)
+    assert caps.max_module_size == proto.WASM_CODE_BUFFER_SIZE
+    assert caps.sprite_capacity == proto.SPRITE_MAX_COUNT
+    assert caps.batch_max_commands == proto.CONTROL_BATCH_MAX_COMMANDS
+    assert caps.broadcast_queue_depth == proto.BROADCAST_QUEUE_DEPTH
+    assert caps.wasm_queue_depth == proto.WASM_WORK_QUEUE_DEPTH
+    assert caps.max_connections >= 1
+    
+    if caps.features & proto.DEVICE_CAP_LARGE_MTU:
+        assert caps.max_mtu > 23
+        assert ble_client.mtu_size <= caps.max_mtu
+
+
+@pytest.mark.asyncio
+async def test_device_capabilities_configure_client(ble_client):
+    """Test that the generated client configures itself from the capabilities"""
+    client = proto.BLEProtocolClient(ble_client)
+    try:
+        caps = await client.configure()
+        assert client.encoding == proto.COMPACT_ENCODING_LATEST
+        
+        # Writes now go out compact and still execute
+        await client.write_control_command(proto.ControlCommandPacket(cmd_id=proto.CMD_GET_VERSION))
+        response = await client.read_control_response()
+        assert (response.cmd_id, response.status) == (proto.CMD_GET_VERSION, proto.RESPONSE_SUCCESS)
+    finally:
+        await client.set_encoding(proto.COMPACT_ENCODING_LEGACY)
+    assert caps.version == proto.DEVICE_CAPS_VERSION
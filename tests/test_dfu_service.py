@@ -43,7 +43,7 @@ def test_dfu_service_mock_implementation(ble_services, ble_characteristics):
     assert DFU_SERVICE_UUID in ble_services
     
     # Verify service was properly initialized
-    # From serial log: "DFU Service: Initialized (mock implementation)"
+    # From serial log: "dfu_service: Initialized (mock implementation)"
     # Test passes if service exists and was discovered successfully
 
 
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Benchmark Baseline Tests
+
+Checks how perf_baseline.py groups results, applies the noise models in
+baselines/noise.json and decides what counts as a regression. Runs without
+a device.
+"""
+
+import json
+
+import pytest
+
+import perf_baseline
+from perf_baseline import NOISE_FILE, build_baseline, collect_samples, compare_group, noise_for
+
+BSIM_REPORT = {
+    'suite': 'perf_suite',
+    'commit': 'abc1234',
+    'metrics': [
+        {'scenario': 'data_stream', 'bytes': 57344, 'throughput_kbps': 120, 'p50_us': 30000,
+         'max_us': 45000, 'cpu_permille': 10},
+        {'scenario': 'memory', 'pool_bytes': 16384, 'pool_peak': 8192},
+    ],
+}
+
+PYTEST_REPORT = {
+    'suite': 'pytest',
+    'commit': 'abc1234',
+    'metrics': [
+        {'scenario': 'data_write', 'test': 'test_data_write_latency', 'mode': 'virtual',
+         'samples': 50, 'p50_us': 900},
+        {'scenario': 'firmware_benchmark', 'test': 'test_control_benchmark_command',
+         'mode': 'hardware', 'crc16_cycles': 100000},
+    ],
+}
+
+
+def verdicts(findings):
+    return {f.metric: f.verdict for f in findings}
+
+
+@pytest.mark.unit
+def test_collect_samples_groups_by_suite_and_mode():
+    """Board and virtual pytest numbers never share a baseline"""
+    groups = collect_samples([BSIM_REPORT, PYTEST_REPORT, BSIM_REPORT])
+
+    assert set(groups) == {'perf_suite', 'pytest-virtual', 'pytest-hardware'}
+    assert groups['perf_suite']['data_stream.throughput_kbps'] == [120, 120]
+    assert groups['pytest-virtual'] == {'data_write.samples': [50], 'data_write.p50_us': [900]}
+    assert 'firmware_benchmark.test' not in groups['pytest-hardware']
+
+
+@pytest.mark.unit
+def test_noise_rules_first_match_wins():
+    """The shipped rules give each kind of metric its own model"""
+    noise = json.loads(NOISE_FILE.read_text())
+
+    assert noise_for(noise, 'perf_suite', 'data_stream.bytes').model == 'ignore'
+    assert noise_for(noise, 'perf_suite', 'data_stream.throughput_kbps').direction == 'higher'
+    assert noise_for(noise, 'perf_suite', 'data_stream.max_us').floor == 0.25
+    assert noise_for(noise, 'perf_suite', 'data_stream.p50_us').floor == 0.10
+    assert noise_for(noise, 'pytest-hardware', 'firmware_benchmark.crc16_cycles').tolerance == 0.02
+    assert noise_for(noise, 'perf_suite', 'memory.pool_peak').model == 'absolute'
+    assert noise_for(noise, 'perf_suite', 'unknown.metric').model == 'relative'
+
+
+@pytest.mark.unit
+def test_regressions_follow_direction_and_noise():
+    """Slower latency and lower throughput regress; the same change the other way improves"""
+    noise = json.loads(NOISE_FILE.read_text())
+    runs = [[118, 120, 122], [29000, 30000, 31000]]
+    baseline = build_baseline('perf_suite', {'data_stream.throughput_kbps': runs[0],
+                                             'data_stream.p50_us': runs[1]}, 'abc1234', None)
+
+    within = compare_group('perf_suite', {'data_stream.throughput_kbps': [115],
+                                          'data_stream.p50_us': [32000]}, baseline, noise)
+    assert verdicts(within) == {'data_stream.throughput_kbps': 'ok', 'data_stream.p50_us': 'ok'}
+
+    worse = compare_group('perf_suite', {'data_stream.throughput_kbps': [100],
+                                         'data_stream.p50_us': [40000]}, baseline, noise)
+    assert verdicts(worse) == {'data_stream.throughput_kbps': 'regressed',
+                               'data_stream.p50_us': 'regressed'}
+
+    better = compare_group('perf_suite', {'data_stream.throughput_kbps': [140],
+                                          'data_stream.p50_us': [20000]}, baseline, noise)
+    assert verdicts(better) == {'data_stream.throughput_kbps': 'improved',
+                                'data_stream.p50_us': 'improved'}
+
+    # --scale widens every allowance
+    assert verdicts(compare_group('perf_suite', {'data_stream.p50_us': [40000]}, baseline, noise,
+                                  scale=4.0))['data_stream.p50_us'] == 'ok'
+
+
+@pytest.mark.unit
+def test_single_run_baseline_uses_floor():
+    """With one sample there is no spread, so the floor alone sets the allowance"""
+    noise = json.loads(NOISE_FILE.read_text())
+    baseline = build_baseline('perf_suite', {'data_stream.p50_us': [30000]}, None, None)
+
+    assert baseline['metrics']['data_stream.p50_us'] == {'mean': 30000, 'stdev': 0.0, 'samples': 1}
+    findings = compare_group('perf_suite', {'data_stream.p50_us': [32999]}, baseline, noise)
+    assert findings[0].verdict == 'ok'
+    assert findings[0].allowed == pytest.approx(3000)
+
+
+@pytest.mark.unit
+def test_new_and_missing_metrics_do_not_fail():
+    """Only regressions fail; added or dropped metrics are reported"""
+    noise = json.loads(NOISE_FILE.read_text())
+    baseline = build_baseline('perf_suite', {'dfu.throughput_kbps': [40]}, None, None)
+
+    findings = compare_group('perf_suite', {'sprite_atlas.p50_us': [5000]}, baseline, noise)
+    assert verdicts(findings) == {'sprite_atlas.p50_us': 'new', 'dfu.throughput_kbps': 'missing'}
+
+
+@pytest.mark.unit
+def test_update_then_compare(tmp_path, capsys):
+    """update writes versioned baselines that compare reads back"""
+    results = tmp_path / 'results.json'
+    results.write_text(json.dumps(BSIM_REPORT))
+    args = type('Args', (), {'baseline_dir': tmp_path / 'baselines', 'noise': NOISE_FILE,
+                             'scale': 1.0, 'verbose': True, 'json_out': None})
+
+    assert perf_baseline.update([results], args) == 0
+    assert perf_baseline.update([results], args) == 0
+    baseline = json.loads((tmp_path / 'baselines' / 'perf_suite.json').read_text())
+    assert baseline['schema'] == perf_baseline.BASELINE_SCHEMA
+    assert baseline['revision'] == 2
+
+    assert perf_baseline.compare([results], args) == 0
+
+    slower = dict(BSIM_REPORT, metrics=[dict(BSIM_REPORT['metrics'][0], p50_us=60000)])
+    results.write_text(json.dumps(slower))
+    assert perf_baseline.compare([results], args) == 1
+    assert "REGRESSED perf_suite/data_stream.p50_us" in capsys.readouterr().out
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Trace Tool Tests
+
+Checks that trace_tool.py decodes trace dumps the way app_trace.c lays them
+out and converts them to Chrome JSON and CTF. Runs without a device.
+"""
+
+import re
+import struct
+from pathlib import Path
+
+import pytest
+
+import ble_protocol as proto
+import trace_tool
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+
+MARKERS = ['gatt_write', 'gatt_read', 'msgq_put', 'msgq_get', 'wasm_parse', 'wasm_load',
+           'wasm_compile', 'wasm_call', 'flash_write', 'notify']
+
+BT_RX = 0x20001000
+WORKER = 0x20002000
+
+
+def make_dump(records, threads=((BT_RX, "BT RX"), (WORKER, "wasm_work_thread")), dropped=0):
+    """Build a dump like app_trace_dump_read() returns"""
+    header = proto.AppTraceHeader(magic=proto.APP_TRACE_DUMP_MAGIC,
+                                  version=proto.APP_TRACE_DUMP_VERSION,
+                                  marker_count=len(MARKERS), thread_count=len(threads),
+                                  record_size=proto.AppTraceRecord.SIZE, timer_freq_hz=1_000_000,
+                                  record_count=len(records), dropped=dropped)
+    data = header.pack()
+    data += b"".join(name.encode().ljust(proto.APP_TRACE_MARKER_NAME_LEN, b'\0') for name in MARKERS)
+    data += b"".join(proto.AppTraceThread(id=tid, name=name).pack() for tid, name in threads)
+    for timestamp, thread, marker, phase, arg0, arg1 in records:
+        data += proto.AppTraceRecord(timestamp=timestamp, thread=thread,
+                                     marker=MARKERS.index(marker), phase=phase,
+                                     arg0=arg0, arg1=arg1).pack()
+    return data
+
+
+B, E, I = proto.APP_TRACE_PHASE_BEGIN, proto.APP_TRACE_PHASE_END, proto.APP_TRACE_PHASE_INSTANT
+
+
+@pytest.mark.unit
+def test_marker_names_match_firmware():
+    """The tool decodes names from the dump; the IDs it special-cases must exist"""
+    source = (REPO_ROOT / 'src/services/app_trace.c').read_text()
+    assert re.findall(r'= MARKER\("(\w+)"\)', source) == MARKERS
+    assert proto.APP_TRACE_MARKER_COUNT == len(MARKERS)
+    assert set(trace_tool.SYMBOL_MARKERS) <= set(MARKERS)
+
+
+@pytest.mark.unit
+def test_parse_dump_unwraps_timestamps():
+    """Records come out oldest first with the 32-bit counter unwrapped"""
+    dump = make_dump([
+        (0xFFFFFF00, BT_RX, 'gatt_write', B, 0x1235, 20),
+        (0x00000010, BT_RX, 'gatt_write', E, 0x1235, 20),
+        (0x00000020, BT_RX, 'msgq_put', I, 0x20003000, 1),
+    ], dropped=3)
+    trace = trace_tool.parse_dump(dump)
+
+    assert [e.cycles for e in trace.events] == [0xFFFFFF00, 0x100000010, 0x100000020]
+    assert [e.name for e in trace.events] == ['gatt_write', 'gatt_write', 'msgq_put']
+    assert trace.threads[BT_RX] == "BT RX"
+    assert trace.dropped == 3
+
+    with pytest.raises(ValueError):
+        trace_tool.parse_dump(dump[:-1])
+    with pytest.raises(ValueError):
+        trace_tool.parse_dump(bytes(len(dump)))
+
+
+@pytest.mark.unit
+def test_chrome_json_slices():
+    """Handlers are named from the ELF, orphan ends dropped, queues become counters"""
+    dump = make_dump([
+        (100, WORKER, 'wasm_call', E, 0, 0),            # Begin overwritten in the ring
+        (200, BT_RX, 'gatt_write', B, 0x1235, 52),
+        (250, BT_RX, 'msgq_put', I, 0x20003000, 1),
+        (300, BT_RX, 'gatt_write', E, 0x1235, 52),
+        (400, WORKER, 'msgq_get', I, 0x20003000, 0),
+        (500, WORKER, 'wasm_call', B, 2, 0),
+    ])
+    symbols = {0x1234: 'wasm_execute_handler_ble_impl', 0x20003000: 'wasm_work_queue'}
+    chrome = trace_tool.to_chrome_json(trace_tool.parse_dump(dump), symbols)
+    events = [e for e in chrome['traceEvents'] if e['ph'] != 'M']
+
+    assert [(e['name'], e['ph']) for e in events] == [
+        ('wasm_execute_handler', 'B'),
+        ('msgq_put', 'i'), ('wasm_work_queue', 'C'),
+        ('wasm_execute_handler', 'E'),
+        ('msgq_get', 'i'), ('wasm_work_queue', 'C'),
+        ('wasm_call', 'B'),
+    ]
+    assert events[0]['ts'] == pytest.approx(100.0)          # us since the first record
+    assert events[2]['args'] == {'queued': 1}
+
+    names = {e['tid']: e['args']['name'] for e in chrome['traceEvents'] if e['name'] == 'thread_name'}
+    assert names[BT_RX] == "BT RX"
+
+
+@pytest.mark.unit
+def test_ctf_output(tmp_path):
+    """CTF output has one event class per marker and packs every record"""
+    dump = make_dump([
+        (200, BT_RX, 'gatt_read', B, 0x1235, 0),
+        (300, BT_RX, 'gatt_read', E, 0x1235, 8),
+    ])
+    trace_tool.write_ctf(trace_tool.parse_dump(dump), tmp_path)
+
+    metadata = (tmp_path / 'metadata').read_text()
+    assert metadata.startswith("/* CTF 1.8 */")
+    assert 'name = "gatt_read";' in metadata
+    assert 'freq = 1000000;' in metadata
+
+    stream = (tmp_path / 'stream').read_bytes()
+    assert struct.unpack_from('<I', stream)[0] == trace_tool.CTF_MAGIC
+    record = struct.calcsize('<QBBI') + len(b"BT RX\0") + 8
+    assert len(stream) == 4 + 2 * record
+    assert struct.unpack_from('<QBBI', stream, 4 + record) == (300, 0, E, BT_RX)
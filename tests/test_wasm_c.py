@@ -74,10 +74,10 @@ async def test_c_wasm_example(ble_client, ble_characteristics, serial_capture):
         print(f"📱 C WASM serial output:\n{serial_output.out}")
         
         # Assert on expected serial lines
-        assert "WASM Service: WASM magic validated" in serial_output.out, "Should see WASM validation"
-        assert "WASM Service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
-        assert "WASM Service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
-        assert "WASM Service: WASM module ready for execution" in serial_output.out, "Should see module ready"
+        assert "wasm_service: WASM magic validated" in serial_output.out, "Should see WASM validation"
+        assert "wasm_service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
+        assert "wasm_service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
+        assert "wasm_service: WASM module ready for execution" in serial_output.out, "Should see module ready"
         
         # Test the results
         assert result1 == 99, f"getNumber() expected 99, got {result1}"
@@ -28,10 +28,10 @@ async def test_minimal_wat_wasm(ble_client, ble_characteristics, serial_capture)
     print(f"📱 Minimal WAT serial output:\n{serial_output}")
     
     # Assert on expected serial lines
-    assert "WASM Service: WASM magic validated" in serial_output.out, "Should see WASM validation"
-    assert "WASM Service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
-    assert "WASM Service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
-    assert "WASM Service: WASM module ready for execution" in serial_output.out, "Should see module ready"
+    assert "wasm_service: WASM magic validated" in serial_output.out, "Should see WASM validation"
+    assert "wasm_service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
+    assert "wasm_service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
+    assert "wasm_service: WASM module ready for execution" in serial_output.out, "Should see module ready"
     
     # Test the result
     assert result == 42, f"Expected 42, got {result}"
@@ -62,10 +62,10 @@ async def test_simple_no_memory_wat_wasm(ble_client, ble_characteristics, serial
     print(f"📱 Simple no-memory WAT serial output:\n{serial_output}")
     
     # Assert on expected serial lines
-    assert "WASM Service: WASM magic validated" in serial_output.out, "Should see WASM validation"
-    assert "WASM Service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
-    assert "WASM Service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
-    assert "WASM Service: WASM module ready for execution" in serial_output.out, "Should see module ready"
+    assert "wasm_service: WASM magic validated" in serial_output.out, "Should see WASM validation"
+    assert "wasm_service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
+    assert "wasm_service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
+    assert "wasm_service: WASM module ready for execution" in serial_output.out, "Should see module ready"
     
     # Test the results
     assert result1 == 99, f"get_number() expected 99, got {result1}"
@@ -100,10 +100,10 @@ async def test_medium_wat_wasm(ble_client, ble_characteristics, serial_capture):
     print(f"📱 Medium WAT serial output:\n{serial_output}")
     
     # Assert on expected serial lines
-    assert "WASM Service: WASM magic validated" in serial_output.out, "Should see WASM validation"
-    assert "WASM Service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
-    assert "WASM Service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
-    assert "WASM Service: WASM module ready for execution" in serial_output.out, "Should see module ready"
+    assert "wasm_service: WASM magic validated" in serial_output.out, "Should see WASM validation"
+    assert "wasm_service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
+    assert "wasm_service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
+    assert "wasm_service: WASM module ready for execution" in serial_output.out, "Should see module ready"
     
     # Test the results
     assert result1 == 99, f"get_number() expected 99, got {result1}"
@@ -136,10 +136,10 @@ async def test_large_wat_wasm(ble_client, ble_characteristics, serial_capture):
     print(f"📱 Large WAT serial output:\n{serial_output}")
     
     # Assert on expected serial lines
-    assert "WASM Service: WASM magic validated" in serial_output.out, "Should see WASM validation"
-    assert "WASM Service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
-    assert "WASM Service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
-    assert "WASM Service: WASM module ready for execution" in serial_output.out, "Should see module ready"
+    assert "wasm_service: WASM magic validated" in serial_output.out, "Should see WASM validation"
+    assert "wasm_service: Module loaded into runtime successfully" in serial_output.out, "Should see module loaded"
+    assert "wasm_service: Module compilation completed successfully" in serial_output.out, "Should see compilation success"
+    assert "wasm_service: WASM module ready for execution" in serial_output.out, "Should see module ready"
     
     # Test the results
     assert result1 == 99, f"get_number() expected 99, got {result1}"
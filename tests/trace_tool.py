@@ -0,0 +1,368 @@
+#!/usr/bin/env python3
+"""
+Trace Tool for nRF5340 Device
+
+Downloads the app_trace ring (CONFIG_APP_TRACE) through the Control Service
+trace characteristic and converts it, or a Zephyr CTF trace recorded with
+CONFIG_TRACING_CTF (e.g. the native_sim channel0_0 file), into a Chrome JSON
+trace for ui.perfetto.dev / chrome://tracing. Ring dumps can also be written
+as a CTF trace for babeltrace2.
+
+    # Download from the device, symbolize handlers and queues with the ELF
+    python3 trace_tool.py --device -o trace.json --elf ../build/zephyr/zephyr.elf
+
+    # Convert a saved dump, and to CTF as well
+    python3 trace_tool.py trace.bin -o trace.json --ctf-out trace_ctf/
+
+    # Convert a Zephyr CTF directory (metadata + stream files, needs bt2)
+    python3 trace_tool.py --ctf trace_native/ -o trace.json
+"""
+
+import argparse
+import asyncio
+import json
+import struct
+import subprocess
+import sys
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional
+
+import ble_protocol as proto
+
+DEVICE_NAME = "Dan5340BLE"
+
+PHASE_NAMES = {proto.APP_TRACE_PHASE_BEGIN: 'B',
+               proto.APP_TRACE_PHASE_END: 'E',
+               proto.APP_TRACE_PHASE_INSTANT: 'i'}
+
+# Markers whose arg0 is an address, and the suffix the firmware symbol carries
+SYMBOL_MARKERS = {'gatt_write': '_ble_impl', 'gatt_read': '_ble_impl',
+                  'msgq_put': '', 'msgq_get': ''}
+QUEUE_MARKERS = ('msgq_put', 'msgq_get')
+
+
+@dataclass
+class TraceEvent:
+    """One marker, with the timestamp unwrapped"""
+    cycles: int
+    thread: int
+    name: str
+    phase: int
+    arg0: int
+    arg1: int
+
+
+@dataclass
+class Trace:
+    """Markers from either source, oldest first"""
+    timer_freq_hz: int
+    events: List[TraceEvent] = field(default_factory=list)
+    threads: Dict[int, str] = field(default_factory=dict)
+    dropped: int = 0
+
+
+# ============================================================================
+# SOURCES
+# ============================================================================
+
+def parse_dump(data: bytes) -> Trace:
+    """Decode a trace dump as read from the trace characteristic"""
+    header = proto.AppTraceHeader.unpack(data)
+    if header.magic != proto.APP_TRACE_DUMP_MAGIC:
+        raise ValueError(f"Not a trace dump (magic 0x{header.magic:08X})")
+    if header.version != proto.APP_TRACE_DUMP_VERSION:
+        raise ValueError(f"Trace dump version {header.version}, "
+                         f"expected {proto.APP_TRACE_DUMP_VERSION}")
+
+    offset = proto.AppTraceHeader.SIZE
+    names = []
+    for _ in range(header.marker_count):
+        raw = data[offset:offset + proto.APP_TRACE_MARKER_NAME_LEN]
+        names.append(raw.split(b'\0', 1)[0].decode())
+        offset += proto.APP_TRACE_MARKER_NAME_LEN
+
+    trace = Trace(timer_freq_hz=header.timer_freq_hz, dropped=header.dropped)
+    trace.threads[0] = "ISR"
+    for _ in range(header.thread_count):
+        thread = proto.AppTraceThread.unpack(data[offset:offset + proto.AppTraceThread.SIZE])
+        trace.threads[thread.id] = thread.name or f"0x{thread.id:08x}"
+        offset += proto.AppTraceThread.SIZE
+
+    expected = offset + header.record_count * header.record_size
+    if len(data) < expected:
+        raise ValueError(f"Trace dump truncated: {len(data)} bytes, header says {expected}")
+
+    # Timestamps are 32-bit cycles; they only go backwards when the counter wraps
+    wraps = 0
+    previous = None
+    for i in range(header.record_count):
+        start = offset + i * header.record_size
+        record = proto.AppTraceRecord.unpack(data[start:start + proto.AppTraceRecord.SIZE])
+        if previous is not None and record.timestamp < previous:
+            wraps += 1
+        previous = record.timestamp
+        name = names[record.marker] if record.marker < len(names) else f"marker_{record.marker}"
+        trace.events.append(TraceEvent(cycles=(wraps << 32) + record.timestamp,
+                                       thread=record.thread, name=name, phase=record.phase,
+                                       arg0=record.arg0, arg1=record.arg1))
+    return trace
+
+
+def load_zephyr_ctf(path: Path) -> Trace:
+    """Collect the named events of a Zephyr CTF trace (babeltrace2 Python bindings)"""
+    import bt2
+
+    suffixes = {':B': proto.APP_TRACE_PHASE_BEGIN, ':E': proto.APP_TRACE_PHASE_END}
+    trace = Trace(timer_freq_hz=1_000_000_000)   # ns_from_origin
+    thread = 0
+
+    for msg in bt2.TraceCollectionMessageIterator(str(path)):
+        if type(msg) is not bt2._EventMessageConst:
+            continue
+        event = msg.event
+        if event.name == 'thread_switched_in':
+            thread = int(event.payload_field['thread_id'])
+            trace.threads.setdefault(thread, str(event.payload_field['name']))
+        elif event.name == 'named_event':
+            name = str(event.payload_field['name'])
+            phase = suffixes.get(name[-2:], proto.APP_TRACE_PHASE_INSTANT)
+            if phase != proto.APP_TRACE_PHASE_INSTANT:
+                name = name[:-2]
+            trace.events.append(TraceEvent(cycles=msg.default_clock_snapshot.ns_from_origin,
+                                           thread=thread, name=name, phase=phase,
+                                           arg0=int(event.payload_field['arg0']),
+                                           arg1=int(event.payload_field['arg1'])))
+    return trace
+
+
+async def download_trace(client: proto.BLEProtocolClient, resume: bool = True,
+                         clear: bool = False) -> bytes:
+    """Freeze the ring, read the dump page by page, then optionally record again"""
+    select = proto.ControlTraceSelect(offset=0, flags=proto.CONTROL_TRACE_FLAG_FREEZE)
+    await client.write_control_trace(select)
+
+    dump = b''
+    while True:
+        page = await client.read_control_trace()
+        if not page.flags & proto.CONTROL_TRACE_FLAG_ENABLED:
+            raise RuntimeError("Firmware built without CONFIG_APP_TRACE")
+        if page.offset != len(dump):
+            raise RuntimeError(f"Page at {page.offset}, expected {len(dump)}")
+        dump += page.data
+        if not page.data or len(dump) >= page.total_len:
+            break
+        await client.write_control_trace(proto.ControlTraceSelect(offset=len(dump)))
+
+    flags = (proto.CONTROL_TRACE_FLAG_CLEAR if clear else 0) | \
+            (proto.CONTROL_TRACE_FLAG_RESUME if resume else 0)
+    if flags:
+        await client.write_control_trace(proto.ControlTraceSelect(offset=0, flags=flags))
+    return dump
+
+
+async def download_from_device(name: str, **kwargs) -> bytes:
+    """Connect to the device by name and download its trace"""
+    from bleak import BleakClient, BleakScanner
+
+    device = await BleakScanner.find_device_by_name(name)
+    if device is None:
+        raise RuntimeError(f"BLE device '{name}' not found")
+    async with BleakClient(device) as ble:
+        return await download_trace(proto.BLEProtocolClient(ble), **kwargs)
+
+
+# ============================================================================
+# SYMBOLS
+# ============================================================================
+
+def load_symbols(elf: Path, nm: str = 'nm') -> Dict[int, str]:
+    """Map addresses to symbol names, Thumb bit cleared and truncated to 32 bits"""
+    output = subprocess.run([nm, '--defined-only', str(elf)], check=True,
+                            capture_output=True, text=True).stdout
+    symbols = {}
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) == 3:
+            symbols[int(parts[0], 16) & 0xFFFFFFFE] = parts[2]
+    return symbols
+
+
+def symbolize(event: TraceEvent, symbols: Dict[int, str]) -> Optional[str]:
+    """Name of the handler or queue a marker refers to"""
+    suffix = SYMBOL_MARKERS.get(event.name)
+    if suffix is None:
+        return None
+    symbol = symbols.get(event.arg0 & 0xFFFFFFFE)
+    if symbol and suffix and symbol.endswith(suffix):
+        symbol = symbol[:-len(suffix)]
+    return symbol
+
+
+# ============================================================================
+# OUTPUTS
+# ============================================================================
+
+def to_chrome_json(trace: Trace, symbols: Optional[Dict[int, str]] = None) -> dict:
+    """Chrome trace event format, which Perfetto imports as is
+
+    GATT markers are named after their handler when symbols are given.
+    Ends whose begin was overwritten in the ring are dropped, so every
+    slice shown is complete or still open at the end of the trace.
+    """
+    symbols = symbols or {}
+    events = [{'name': 'process_name', 'ph': 'M', 'pid': 0, 'args': {'name': 'nRF5340'}}]
+    for tid, name in sorted(trace.threads.items()):
+        events.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': tid,
+                       'args': {'name': name}})
+
+    open_slices: Dict[int, List[str]] = {}
+    base = trace.events[0].cycles if trace.events else 0
+    for event in trace.events:
+        ts = (event.cycles - base) * 1e6 / trace.timer_freq_hz
+        target = symbolize(event, symbols)
+        name = target if target and event.name.startswith('gatt_') else event.name
+        args = {'arg0': event.arg0, 'arg1': event.arg1}
+        if target:
+            args['target'] = target
+
+        stack = open_slices.setdefault(event.thread, [])
+        if event.phase == proto.APP_TRACE_PHASE_BEGIN:
+            stack.append(name)
+        elif event.phase == proto.APP_TRACE_PHASE_END:
+            if name not in stack:
+                continue
+            del stack[len(stack) - 1 - stack[::-1].index(name)]
+
+        record = {'name': name, 'cat': event.name, 'ph': PHASE_NAMES.get(event.phase, 'i'),
+                  'ts': ts, 'pid': 0, 'tid': event.thread, 'args': args}
+        if event.phase == proto.APP_TRACE_PHASE_INSTANT:
+            record['s'] = 't'
+        events.append(record)
+
+        if event.name in QUEUE_MARKERS:
+            queue = target or f"0x{event.arg0:08x}"
+            events.append({'name': queue, 'ph': 'C', 'ts': ts, 'pid': 0,
+                           'args': {'queued': event.arg1}})
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ns',
+            'otherData': {'dropped': trace.dropped, 'timer_freq_hz': trace.timer_freq_hz}}
+
+
+CTF_MAGIC = 0xC1FC1FC1
+
+CTF_METADATA = """/* CTF 1.8 */
+
+typealias integer {{ size = 8; align = 8; signed = false; }} := uint8_t;
+typealias integer {{ size = 32; align = 8; signed = false; }} := uint32_t;
+typealias integer {{ size = 64; align = 8; signed = false; }} := uint64_t;
+
+trace {{
+    major = 1;
+    minor = 8;
+    byte_order = le;
+    packet.header := struct {{
+        uint32_t magic;
+    }};
+}};
+
+clock {{
+    name = cycles;
+    freq = {freq};
+}};
+
+typealias integer {{
+    size = 64; align = 8; signed = false;
+    map = clock.cycles.value;
+}} := cycles_t;
+
+typealias enum : uint8_t {{ begin = 0, end = 1, instant = 2 }} := phase_t;
+
+stream {{
+    event.header := struct {{
+        cycles_t timestamp;
+        uint8_t id;
+    }};
+}};
+"""
+
+CTF_EVENT = """
+event {{
+    name = "{name}";
+    id = {id};
+    fields := struct {{
+        phase_t phase;
+        uint32_t thread_id;
+        string thread;
+        uint32_t arg0;
+        uint32_t arg1;
+    }};
+}};
+"""
+
+
+def write_ctf(trace: Trace, out_dir: Path) -> None:
+    """Write the markers as a CTF 1.8 trace, one event class per marker"""
+    names = sorted({event.name for event in trace.events})
+    ids = {name: index for index, name in enumerate(names)}
+
+    out_dir.mkdir(parents=True, exist_ok=True)
+    metadata = CTF_METADATA.format(freq=trace.timer_freq_hz)
+    metadata += "".join(CTF_EVENT.format(name=name, id=ids[name]) for name in names)
+    (out_dir / 'metadata').write_text(metadata)
+
+    stream = bytearray(struct.pack('<I', CTF_MAGIC))
+    for event in trace.events:
+        thread = trace.threads.get(event.thread, f"0x{event.thread:08x}")
+        stream += struct.pack('<QBBI', event.cycles, ids[event.name], event.phase, event.thread)
+        stream += thread.encode() + b'\0'
+        stream += struct.pack('<II', event.arg0, event.arg1)
+    (out_dir / 'stream').write_bytes(bytes(stream))
+
+
+# ============================================================================
+# MAIN
+# ============================================================================
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('dump', nargs='?', type=Path, help="Trace dump read from the device")
+    source.add_argument('--device', nargs='?', const=DEVICE_NAME, metavar='NAME',
+                        help=f"Download the trace over BLE (default name {DEVICE_NAME})")
+    source.add_argument('--ctf', type=Path, metavar='DIR', help="Zephyr CTF trace directory")
+    parser.add_argument('-o', '--output', type=Path, help="Chrome / Perfetto JSON output")
+    parser.add_argument('--ctf-out', type=Path, metavar='DIR', help="CTF output directory")
+    parser.add_argument('--save', type=Path, help="Keep the downloaded dump")
+    parser.add_argument('--clear', action='store_true', help="Empty the ring after downloading")
+    parser.add_argument('--elf', type=Path, help="Firmware ELF to name handlers and queues")
+    parser.add_argument('--nm', default='nm', help="nm that reads the firmware ELF")
+    args = parser.parse_args()
+
+    if args.ctf:
+        trace = load_zephyr_ctf(args.ctf)
+        if args.ctf_out:
+            parser.error("--ctf input is already CTF; open it with babeltrace2 directly")
+    else:
+        if args.device:
+            data = asyncio.run(download_from_device(args.device, clear=args.clear))
+            if args.save:
+                args.save.write_bytes(data)
+        else:
+            data = args.dump.read_bytes()
+        trace = parse_dump(data)
+
+    symbols = load_symbols(args.elf, args.nm) if args.elf else {}
+    print(f"{len(trace.events)} markers, {len(trace.threads)} threads, {trace.dropped} dropped")
+
+    if args.output:
+        args.output.write_text(json.dumps(to_chrome_json(trace, symbols)))
+        print(f"Wrote {args.output} (open in ui.perfetto.dev)")
+    if args.ctf_out:
+        write_ctf(trace, args.ctf_out)
+        print(f"Wrote {args.ctf_out} (babeltrace2 {args.ctf_out})")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
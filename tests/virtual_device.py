@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""
+Virtual Device for the nRF5340 BLE Test Suites
+
+Runs the firmware built for native_sim against a virtual Bluetooth
+controller, so the pytest suites and wasm_client.py run unchanged on a
+Linux box without a board or radio:
+
+    zephyr.exe --bt-dev=127.0.0.1:9000  -- HCI over TCP --+
+                                                          +-- bumble-controllers
+    Bleak -> BlueZ hciN                 -- /dev/vhci -----+   (two controllers, one link)
+
+Build the firmware once, then either let pytest start everything or keep a
+device up for other tools:
+
+    west build -b native_sim -d build_native
+    pytest --virtual ../build_native/zephyr/zephyr.exe
+    python3 virtual_device.py ../build_native/zephyr/zephyr.exe
+
+The controller needs write access to /dev/vhci and a running bluetoothd.
+Any controller that accepts the firmware on a TCP port and shows up as a
+new BlueZ adapter works; pass its command with --controller, with {port}
+where the firmware should connect.
+"""
+
+import argparse
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from pathlib import Path
+from typing import List, Optional
+
+DEFAULT_PORT = 9000
+DEFAULT_CONTROLLER = "bumble-controllers tcp-server:_:{port} vhci"
+ADAPTER_TIMEOUT = 10.0
+READY_TIMEOUT = 15.0
+READY_LINE = "Advertising successfully started"
+SYSFS_BLUETOOTH = Path("/sys/class/bluetooth")
+
+
+def list_adapters() -> set:
+    """BlueZ adapters present, e.g. {'hci0'}"""
+    if not SYSFS_BLUETOOTH.exists():
+        return set()
+    return {p.name for p in SYSFS_BLUETOOTH.iterdir() if re.fullmatch(r'hci\d+', p.name)}
+
+
+class VirtualDevice:
+    """
+    Virtual controller plus native_sim firmware, started and stopped together.
+
+    Firmware output (console and logs) is collected line by line, so tests
+    can check it the way they check the serial port of a board.
+    """
+
+    def __init__(self, exe: Path, port: int = DEFAULT_PORT,
+                 controller: str = DEFAULT_CONTROLLER, log_path: Optional[Path] = None):
+        self.exe = Path(exe)
+        self.port = port
+        self.controller_cmd = shlex.split(controller.format(port=port))
+        self.log_path = log_path
+        self.adapter: Optional[str] = None
+        self.lines: List[str] = []
+        self._lines_changed = threading.Condition()
+        self._controller: Optional[subprocess.Popen] = None
+        self._controller_log = None
+        self._firmware: Optional[subprocess.Popen] = None
+        self._reader: Optional[threading.Thread] = None
+
+    def __enter__(self):
+        self.start()
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.stop()
+
+    def start(self):
+        """Start the controller, wait for its adapter, then boot the firmware"""
+        if not self.exe.exists():
+            raise FileNotFoundError(f"{self.exe} not found - build with: west build -b native_sim")
+
+        before = list_adapters()
+        self._controller_log = tempfile.TemporaryFile('w+')
+        self._controller = subprocess.Popen(self.controller_cmd, stdout=self._controller_log,
+                                            stderr=subprocess.STDOUT, text=True)
+        self.adapter = self._wait_for_adapter(before)
+        # bluetoothd leaves new adapters off unless AutoEnable is set
+        try:
+            subprocess.run(['btmgmt', '--index', self.adapter[3:], 'power', 'on'],
+                           capture_output=True, timeout=5)
+        except (OSError, subprocess.TimeoutExpired):
+            pass
+
+        # The UART on stdout, so console and log lines come through the pipe
+        self._firmware = subprocess.Popen([str(self.exe), f'--bt-dev=127.0.0.1:{self.port}',
+                                           '-uart_stdinout'],
+                                          stdin=subprocess.DEVNULL, stdout=subprocess.PIPE,
+                                          stderr=subprocess.STDOUT, text=True, errors='replace')
+        self._reader = threading.Thread(target=self._read_output, daemon=True)
+        self._reader.start()
+
+        if not self.wait_for(READY_LINE, READY_TIMEOUT):
+            self.stop()
+            raise RuntimeError("Firmware did not start advertising:\n" + "\n".join(self.lines[-20:]))
+
+    def stop(self):
+        """Stop the firmware, then the controller"""
+        for process in (self._firmware, self._controller):
+            if process and process.poll() is None:
+                process.terminate()
+                try:
+                    process.wait(timeout=5)
+                except subprocess.TimeoutExpired:
+                    process.kill()
+        self._firmware = self._controller = None
+
+    def is_running(self) -> bool:
+        return bool(self._firmware) and self._firmware.poll() is None
+
+    def wait_for(self, text: str, timeout: float, start: int = 0) -> bool:
+        """Wait for a firmware line containing text, from line index start on"""
+        deadline = time.monotonic() + timeout
+        with self._lines_changed:
+            while True:
+                if any(text in line for line in self.lines[start:]):
+                    return True
+                remaining = deadline - time.monotonic()
+                if remaining <= 0 or (self._firmware and self._firmware.poll() is not None):
+                    return False
+                self._lines_changed.wait(remaining)
+
+    def _wait_for_adapter(self, before: set) -> str:
+        deadline = time.monotonic() + ADAPTER_TIMEOUT
+        while time.monotonic() < deadline:
+            if self._controller.poll() is not None:
+                self._controller_log.seek(0)
+                raise RuntimeError(f"Controller exited: {self._controller_log.read().strip()}")
+            added = sorted(list_adapters() - before)
+            if added:
+                return added[0]
+            time.sleep(0.1)
+        self.stop()
+        raise RuntimeError("No virtual adapter appeared - is /dev/vhci writable?")
+
+    def _read_output(self):
+        log = self.log_path.open('w') if self.log_path else None
+        try:
+            for line in self._firmware.stdout:
+                line = line.rstrip()
+                if log:
+                    log.write(line + "\n")
+                    log.flush()
+                with self._lines_changed:
+                    self.lines.append(line)
+                    self._lines_changed.notify_all()
+        finally:
+            if log:
+                log.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('exe', type=Path, help="native_sim firmware (build_native/zephyr/zephyr.exe)")
+    parser.add_argument('--port', type=int, default=DEFAULT_PORT, help="HCI TCP port")
+    parser.add_argument('--controller', default=DEFAULT_CONTROLLER,
+                        help=f"Controller command (default: {DEFAULT_CONTROLLER})")
+    parser.add_argument('--log', type=Path, help="Also write the firmware output here")
+    args = parser.parse_args()
+
+    with VirtualDevice(args.exe, args.port, args.controller, args.log) as device:
+        print(f"Firmware advertising on {device.adapter}; Ctrl-C to stop")
+        shown = 0
+        try:
+            while device.is_running():
+                time.sleep(0.2)
+                for line in device.lines[shown:]:
+                    print(line)
+                shown = len(device.lines)
+        except KeyboardInterrupt:
+            pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
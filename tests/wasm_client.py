@@ -5,10 +5,11 @@ A clean client library for uploading and executing WASM modules via BLE.
 """
 
 import asyncio
-import struct
 from typing import Optional, List
 from bleak import BleakClient
 
+import ble_protocol as proto
+
 
 class WASMClientError(Exception):
     """Base exception for WASM client errors"""
@@ -29,17 +30,17 @@ class WASMClient:
     """Client for uploading and executing WASM modules via BLE"""
     
     # WASM Service UUIDs
-    WASM_SERVICE_UUID = "0000fff7-0000-1000-8000-00805f9b34fb"
-    WASM_UPLOAD_UUID = "0000fff6-0000-1000-8000-00805f9b34fb"
-    WASM_EXECUTE_UUID = "0000fff5-0000-1000-8000-00805f9b34fb"
-    WASM_STATUS_UUID = "0000fff4-0000-1000-8000-00805f9b34fb"
-    WASM_RESULT_UUID = "0000fff3-0000-1000-8000-00805f9b34fb"
+    WASM_SERVICE_UUID = proto.WASM_SERVICE_UUID
+    WASM_UPLOAD_UUID = proto.WASM_UPLOAD_UUID
+    WASM_EXECUTE_UUID = proto.WASM_EXECUTE_UUID
+    WASM_STATUS_UUID = proto.WASM_STATUS_UUID
+    WASM_RESULT_UUID = proto.WASM_RESULT_UUID
     
     # Command codes
-    CMD_START_UPLOAD = 0x01
-    CMD_CONTINUE_UPLOAD = 0x02
-    CMD_FINISH_UPLOAD = 0x03
-    CMD_RESET = 0x04
+    CMD_START_UPLOAD = proto.WASM_CMD_START_UPLOAD
+    CMD_CONTINUE_UPLOAD = proto.WASM_CMD_CONTINUE_UPLOAD
+    CMD_FINISH_UPLOAD = proto.WASM_CMD_END_UPLOAD
+    CMD_RESET = proto.WASM_CMD_RESET
     
     def __init__(self, ble_client: BleakClient, ble_characteristics: dict):
         """Initialize WASM client with BLE connection"""
@@ -66,6 +67,9 @@ class WASMClient:
         Raises:
             WASMUploadError: If upload fails
         """
+        # The device refuses a new upload while the previous module is loaded
+        await self.reset()
+        
         # Upload chunks
         for offset in range(0, len(wasm_data), chunk_size):
             chunk = wasm_data[offset:offset + chunk_size]
@@ -78,7 +82,8 @@ class WASMClient:
                 cmd = self.CMD_CONTINUE_UPLOAD
                 total_size = 0
             
-            packet = struct.pack('<BBHI', cmd, sequence, len(chunk), total_size) + chunk
+            packet = proto.WasmUploadPacket(cmd=cmd, sequence=sequence, chunk_size=len(chunk),
+                                            total_size=total_size, data=chunk).pack()
             
             try:
                 await self.ble_client.write_gatt_char(self.upload_char, packet, response=True)
@@ -90,6 +95,28 @@ class WASMClient:
         # Wait for processing
         await asyncio.sleep(0.5)
     
+    async def reset(self, timeout: float = 5.0) -> None:
+        """
+        Unload the current module and wait until the service is idle
+        
+        Raises:
+            WASMClientError: If the service does not return to idle
+        """
+        status = proto.WasmStatusPacket.unpack(await self.ble_client.read_gatt_char(self.status_char))
+        if status.status == proto.WASM_STATUS_IDLE:
+            return
+        
+        packet = proto.WasmUploadPacket(cmd=self.CMD_RESET).pack()
+        await self.ble_client.write_gatt_char(self.upload_char, packet, response=True)
+        
+        deadline = asyncio.get_running_loop().time() + timeout
+        while asyncio.get_running_loop().time() < deadline:
+            await asyncio.sleep(0.1)
+            status = proto.WasmStatusPacket.unpack(await self.ble_client.read_gatt_char(self.status_char))
+            if status.status == proto.WASM_STATUS_IDLE:
+                return
+        raise WASMClientError(f"WASM service did not reset (status {status.status})")
+    
     async def execute_function(self, function_name: str, args: List[int] = None) -> int:
         """
         Execute a WASM function
@@ -107,19 +134,9 @@ class WASMClient:
         if args is None:
             args = []  # Default to no arguments
         
-        # Create execute packet: function name + arg count + args
-        function_name_bytes = function_name.encode('utf-8')
-        function_name_padded = function_name_bytes.ljust(32, b'\x00')
-        arg_count = len(args)
-        
-        # Pack the execute packet - firmware always expects 4 args array
-        # even when arg_count is 0
-        execute_packet = function_name_padded + struct.pack('<I', arg_count) + struct.pack('<iiii',
-            args[0] if len(args) > 0 else 0,
-            args[1] if len(args) > 1 else 0,
-            args[2] if len(args) > 2 else 0,
-            args[3] if len(args) > 3 else 0
-        )
+        # The firmware always expects the full 4-entry args array;
+        # arg_count is filled in from args
+        execute_packet = proto.WasmExecutePacket(function_name=function_name, args=args).pack()
         
         try:
             # Write to execute characteristic
@@ -132,57 +149,15 @@ class WASMClient:
             if not self.result_char:
                 raise WASMExecutionError("Result characteristic not found")
             
-            result = await self.ble_client.read_gatt_char(self.result_char)
-            
-            # Debug: print the raw result data
-            print(f"🔍 Raw result data: {result.hex()}")
-            print(f"🔍 Result length: {len(result)} bytes")
+            result = proto.WasmResultPacket.unpack(await self.ble_client.read_gatt_char(self.result_char))
+            print(f"🔍 Result: status={result.status}, error={result.error_code}, "
+                  f"value={result.return_value}, {result.execution_time_us} us")
             
-            # Try different parsing approaches based on the data
-            if len(result) >= 6:
-                # Maybe it's status + error + value format
-                status, error_code, return_value = struct.unpack('<BBI', result[:6])
-                print(f"🔍 Parsed as status={status}, error={error_code}, value={return_value}")
-                
-                # Check if this is an error response
-                if status == 6:  # WASM_STATUS_ERROR
-                    # Look for the actual return value elsewhere in the response
-                    # Maybe it's after the error information
-                    if len(result) >= 10:
-                        # Try reading 4 bytes starting at position 6
-                        actual_value = struct.unpack('<i', result[6:10])[0]
-                        print(f"🔍 Found value after error info: {actual_value}")
-                        return actual_value
-                    else:
-                        raise WASMExecutionError(f"Execution failed with error {error_code}")
-                elif status == 5:  # WASM_STATUS_COMPLETE
-                    return return_value
-                else:
-                    print(f"⚠️ Unexpected status: {status}")
-                    # Still try to extract a value if possible
-                    return return_value
-            elif len(result) >= 5:
-                # Maybe it's status + value format
-                status, return_value = struct.unpack('<BI', result[:5])
-                print(f"🔍 Parsed as status={status}, value={return_value}")
-                return return_value
-            elif len(result) >= 4:
-                # Maybe it's just the value, but at a different offset
-                # Try reading from different positions
-                value1 = struct.unpack('<i', result[:4])[0]
-                print(f"🔍 First 4 bytes as i32: {value1}")
-                
-                if len(result) >= 8:
-                    value2 = struct.unpack('<i', result[4:8])[0]
-                    print(f"🔍 Next 4 bytes as i32: {value2}")
-                    
-                    # If the second value looks more reasonable, use it
-                    if abs(value2 - 42) < abs(value1 - 42):
-                        return value2
-                
-                return value1
-            else:
-                raise WASMExecutionError(f"Unexpected result length: {len(result)}")
+            if result.status == proto.WASM_STATUS_ERROR:
+                raise WASMExecutionError(f"Execution failed with error {result.error_code}")
+            if result.status != proto.WASM_STATUS_COMPLETE:
+                print(f"⚠️ Unexpected status: {result.status}")
+            return result.return_value
                 
         except Exception as e:
             if isinstance(e, WASMExecutionError):